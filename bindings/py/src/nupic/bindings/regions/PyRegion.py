@@ -186,6 +186,18 @@ class PyRegion(object):
     return self.compute(inputs, DictReadOnlyWrapper(outputs))
 
 
+  def computeModifiesState(self):
+    """Whether :meth:`compute` may change the state saved by :meth:`write`.
+
+    Incremental network checkpoints skip regions whose state is unchanged.
+    Override this to return ``False`` while the region is only inferring,
+    e.g. when learning is turned off.
+
+    :returns: (bool) ``True`` by default
+    """
+    return True
+
+
   def getOutputElementCount(self, name):
     """
     If the region has multiple nodes (all must have the same output
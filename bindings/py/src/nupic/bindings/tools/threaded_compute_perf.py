@@ -0,0 +1,112 @@
+#!/usr/bin/env python
+# ----------------------------------------------------------------------
+# Numenta Platform for Intelligent Computing (NuPIC)
+# Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+# with Numenta, Inc., for a separate license for this software code, the
+# following terms and conditions apply:
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero Public License version 3 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+# See the GNU Affero Public License for more details.
+#
+# You should have received a copy of the GNU Affero Public License
+# along with this program.  If not, see http://www.gnu.org/licenses.
+#
+# http://numenta.org/licenses/
+# ----------------------------------------------------------------------
+
+
+"""Measures how compute() of independent models scales with Python threads.
+
+SpatialPooler, TemporalMemory and Cells4 compute, and Network.run, release
+the GIL while the C++ code runs, so the throughput of N threads, each
+driving its own model, should approach N times that of one thread.
+"""
+
+import sys
+import threading
+import time
+
+import numpy
+
+from nupic.bindings.algorithms import SpatialPooler, TemporalMemory
+
+
+
+_NUM_RECORDS = 200
+_NUM_INPUTS = 100
+_INPUT_SIZE = 1024
+_NUM_COLUMNS = 2048
+
+
+
+def _makeInputs(rng):
+  inputs = []
+  for _ in xrange(_NUM_INPUTS):
+    dense = numpy.zeros(_INPUT_SIZE, dtype="uint32")
+    dense[rng.choice(_INPUT_SIZE, 20, replace=False)] = 1
+    inputs.append(dense)
+  return inputs
+
+
+
+class _Model(object):
+  """A SpatialPooler feeding a TemporalMemory."""
+
+  def __init__(self, seed):
+    self.sp = SpatialPooler(inputDimensions=(_INPUT_SIZE,),
+                            columnDimensions=(_NUM_COLUMNS,),
+                            globalInhibition=True,
+                            seed=seed)
+    self.tm = TemporalMemory(columnDimensions=(_NUM_COLUMNS,),
+                             cellsPerColumn=8,
+                             seed=seed)
+    self.activeArray = numpy.zeros(_NUM_COLUMNS, dtype="uint32")
+
+
+  def run(self, inputs):
+    for i in xrange(_NUM_RECORDS):
+      self.sp.compute(inputs[i % _NUM_INPUTS], True, self.activeArray)
+      self.tm.compute(self.activeArray.nonzero()[0], True)
+
+
+
+def _measure(numThreads, inputs):
+  """Returns the records per second of numThreads models, one per thread."""
+  models = [_Model(seed=42 + i) for i in xrange(numThreads)]
+  threads = [threading.Thread(target=model.run, args=(inputs,))
+             for model in models]
+
+  start = time.time()
+  for thread in threads:
+    thread.start()
+  for thread in threads:
+    thread.join()
+  elapsed = time.time() - start
+
+  return numThreads * _NUM_RECORDS / elapsed
+
+
+
+def main(maxThreads):
+  inputs = _makeInputs(numpy.random.RandomState(42))
+
+  baseline = None
+  numThreads = 1
+  while numThreads <= maxThreads:
+    recordsPerSecond = _measure(numThreads, inputs)
+    if baseline is None:
+      baseline = recordsPerSecond
+    print "%2d threads: %8.1f records/s, %.2fx" % (
+      numThreads, recordsPerSecond, recordsPerSecond / baseline)
+    numThreads *= 2
+
+
+
+if __name__ == "__main__":
+  main(int(sys.argv[1]) if len(sys.argv) > 1 else 8)
@@ -160,6 +160,33 @@ class NetworkTest(unittest.TestCase):
       self.fail("Unable to iterate network links.")
 
 
+  def testProfilingSnapshot(self):
+    network = engine.Network()
+    network.addRegion("region1", "TestNode", "")
+    network.addRegion("region2", "TestNode", "")
+    region1 = network.getRegions().getByName("region1")
+    region1.setDimensions(engine.Dimensions([1, 1]))
+    network.link("region1", "region2", "UniformLink", "")
+    network.initialize()
+
+    network.resetProfiling()
+    network.enableProfiling()
+    network.run(4)
+    network.disableProfiling()
+
+    entries = dict((entry.name, entry)
+                   for entry in network.getProfilingSnapshot())
+    compute = entries["Region.region2.compute"]
+    self.assertFalse(compute.isCounter)
+    self.assertEqual(compute.count, 4)
+    self.assertLessEqual(compute.p50, compute.p99)
+    self.assertLessEqual(compute.p99, compute.p999)
+
+    linkBytes = entries["Link.region1.bottomUpOut-->region2.bottomUpIn.bytes"]
+    self.assertTrue(linkBytes.isCounter)
+    self.assertEqual(linkBytes.count, 4)
+
+
   def testNetworkLinkTypeValidation(self):
     """
     This tests whether the links source and destination dtypes match
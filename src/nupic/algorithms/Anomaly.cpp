@@ -21,7 +21,9 @@
  */
 
 #include <algorithm>
+#include <iomanip>
 #include <iterator>
+#include <limits>
 #include <numeric>
 #include <set>
 #include <vector>
@@ -38,6 +40,43 @@ namespace algorithms {
 
 namespace anomaly {
 
+static inline UInt popCount(UInt64 word) {
+#if defined(__GNUC__)
+  return (UInt)__builtin_popcountll(word);
+#else
+  UInt count = 0;
+  for (; word; count++) {
+    word &= word - 1;
+  }
+  return count;
+#endif
+}
+
+/**
+ * Number of distinct values in both sorted arrays.
+ */
+static UInt countOverlap(const UInt *a, const UInt *aEnd, const UInt *b,
+                         const UInt *bEnd) {
+  UInt overlap = 0;
+  while (a != aEnd && b != bEnd) {
+    if (*a < *b) {
+      a++;
+    } else if (*b < *a) {
+      b++;
+    } else {
+      const UInt value = *a;
+      overlap++;
+      while (a != aEnd && *a == value) {
+        a++;
+      }
+      while (b != bEnd && *b == value) {
+        b++;
+      }
+    }
+  }
+  return overlap;
+}
+
 Real32 computeRawAnomalyScore(const vector<UInt> &active,
                               const vector<UInt> &predicted) {
   // Return 0 if no active columns are present
@@ -45,6 +84,12 @@ Real32 computeRawAnomalyScore(const vector<UInt> &active,
     return 0.0f;
   }
 
+  if (is_sorted(active.begin(), active.end()) &&
+      is_sorted(predicted.begin(), predicted.end())) {
+    return computeRawAnomalyScore(active.data(), (UInt)active.size(),
+                                  predicted.data(), (UInt)predicted.size());
+  }
+
   set<UInt> active_{active.begin(), active.end()};
   set<UInt> predicted_{predicted.begin(), predicted.end()};
   vector<UInt> predictedActiveCols;
@@ -56,6 +101,56 @@ Real32 computeRawAnomalyScore(const vector<UInt> &active,
   return (active.size() - predictedActiveCols.size()) / Real32(active.size());
 }
 
+Real32 computeRawAnomalyScore(const UInt *active, UInt activeSize,
+                              const UInt *predicted, UInt predictedSize) {
+  if (activeSize == 0) {
+    return 0.0f;
+  }
+
+  const UInt overlap = countOverlap(active, active + activeSize, predicted,
+                                    predicted + predictedSize);
+  return (activeSize - overlap) / Real32(activeSize);
+}
+
+Real32 computeRawAnomalyScoreDense(const UInt64 *active,
+                                   const UInt64 *predicted, UInt numWords) {
+  UInt numActive = 0, overlap = 0;
+  for (UInt i = 0; i < numWords; i++) {
+    numActive += popCount(active[i]);
+    overlap += popCount(active[i] & predicted[i]);
+  }
+
+  if (numActive == 0) {
+    return 0.0f;
+  }
+  return (numActive - overlap) / Real32(numActive);
+}
+
+void computeRawAnomalyScores(UInt numStreams, const UInt *active,
+                             const UInt *activeOffsets, const UInt *predicted,
+                             const UInt *predictedOffsets, Real32 *scores) {
+  for (UInt s = 0; s < numStreams; s++) {
+    const UInt activeBegin = activeOffsets[s];
+    const UInt predictedBegin = predictedOffsets[s];
+    NTA_ASSERT(activeOffsets[s + 1] >= activeBegin);
+    NTA_ASSERT(predictedOffsets[s + 1] >= predictedBegin);
+
+    scores[s] = computeRawAnomalyScore(
+        active + activeBegin, activeOffsets[s + 1] - activeBegin,
+        predicted + predictedBegin, predictedOffsets[s + 1] - predictedBegin);
+  }
+}
+
+void computeRawAnomalyScoresDense(UInt numStreams, UInt numWords,
+                                  const UInt64 *active,
+                                  const UInt64 *predicted, Real32 *scores) {
+  for (UInt s = 0; s < numStreams; s++) {
+    const size_t offset = (size_t)s * numWords;
+    scores[s] = computeRawAnomalyScoreDense(active + offset,
+                                            predicted + offset, numWords);
+  }
+}
+
 Anomaly::Anomaly(UInt slidingWindowSize, AnomalyMode mode,
                  Real32 binaryAnomalyThreshold)
     : binaryThreshold_(binaryAnomalyThreshold) {
@@ -65,10 +160,6 @@ Anomaly::Anomaly(UInt slidingWindowSize, AnomalyMode mode,
   if (slidingWindowSize > 0) {
     movingAverage_.reset(new nupic::util::MovingAverage(slidingWindowSize));
   }
-
-  // Not implemented. Fail.
-  NTA_ASSERT(mode_ == AnomalyMode::PURE)
-      << "C++ Anomaly implemented only for PURE mode!";
 }
 
 Real32 Anomaly::compute(const vector<UInt> &active,
@@ -81,10 +172,11 @@ Real32 Anomaly::compute(const vector<UInt> &active,
     score = anomalyScore;
     break;
   case AnomalyMode::LIKELIHOOD:
+    score = (Real32)likelihood_.anomalyProbability(anomalyScore, inputValue);
+    break;
   case AnomalyMode::WEIGHTED:
-    // Not implemented. Fail
-    NTA_ASSERT(mode_ == AnomalyMode::PURE)
-        << "C++ Anomaly implemented only for PURE mode!";
+    score = anomalyScore *
+            (Real32)likelihood_.anomalyProbability(anomalyScore, inputValue);
     break;
   }
 
@@ -99,6 +191,55 @@ Real32 Anomaly::compute(const vector<UInt> &active,
   return score;
 }
 
+void Anomaly::save(ostream &outStream) const {
+  outStream << "Anomaly" << endl;
+  const std::streamsize precision = outStream.precision();
+  outStream << std::setprecision(std::numeric_limits<Real32>::max_digits10);
+  outStream << (int)mode_ << " " << binaryThreshold_ << " "
+            << (movingAverage_ ? 1 : 0) << endl;
+  if (movingAverage_) {
+    movingAverage_->save(outStream);
+  }
+  likelihood_.save(outStream);
+  outStream << "~Anomaly" << endl;
+  outStream.precision(precision);
+}
+
+void Anomaly::load(istream &inStream) {
+  string marker;
+  inStream >> marker;
+  NTA_CHECK(marker == "Anomaly");
+
+  int mode, hasMovingAverage;
+  inStream >> mode >> binaryThreshold_ >> hasMovingAverage;
+  mode_ = (AnomalyMode)mode;
+  if (hasMovingAverage) {
+    movingAverage_.reset(new nupic::util::MovingAverage(1));
+    movingAverage_->load(inStream);
+  } else {
+    movingAverage_.reset();
+  }
+  likelihood_.load(inStream);
+
+  inStream >> marker;
+  NTA_CHECK(marker == "~Anomaly");
+}
+
+bool Anomaly::operator==(const Anomaly &other) const {
+  if (mode_ != other.mode_ || binaryThreshold_ != other.binaryThreshold_ ||
+      likelihood_ != other.likelihood_) {
+    return false;
+  }
+  if (movingAverage_ && other.movingAverage_) {
+    return *movingAverage_ == *other.movingAverage_;
+  }
+  return !movingAverage_ && !other.movingAverage_;
+}
+
+bool Anomaly::operator!=(const Anomaly &other) const {
+  return !operator==(other);
+}
+
 } // namespace anomaly
 
 } // namespace algorithms
@@ -23,7 +23,9 @@
 #ifndef NUPIC_ALGORITHMS_ANOMALY_HPP
 #define NUPIC_ALGORITHMS_ANOMALY_HPP
 
+#include <iostream>
 #include <memory> // Needed for smart pointer templates
+#include <nupic/algorithms/AnomalyLikelihood.hpp>
 #include <nupic/types/Types.hpp>
 #include <nupic/utils/MovingAverage.hpp> // Needed for for smart pointer templates
 #include <vector>
@@ -51,6 +53,62 @@ namespace anomaly {
 Real32 computeRawAnomalyScore(const std::vector<UInt> &active,
                               const std::vector<UInt> &predicted);
 
+/**
+ * Computes the raw anomaly score of sorted column indices, without
+ * allocating.
+ *
+ * @param active: sorted array of active column indices
+ * @param activeSize: number of active columns
+ * @param predicted: sorted array of column indices predicted in prev step
+ * @param predictedSize: number of predicted columns
+ * @return anomaly score 0..1 (Real32)
+ */
+Real32 computeRawAnomalyScore(const UInt *active, UInt activeSize,
+                              const UInt *predicted, UInt predictedSize);
+
+/**
+ * Computes the raw anomaly score of columns given as bitmasks, where bit
+ * i % 64 of word i / 64 is set iff column i is on.
+ *
+ * @param active: bitmask of the active columns
+ * @param predicted: bitmask of the columns predicted in prev step
+ * @param numWords: number of 64 bit words in each bitmask
+ * @return anomaly score 0..1 (Real32)
+ */
+Real32 computeRawAnomalyScoreDense(const UInt64 *active,
+                                   const UInt64 *predicted, UInt numWords);
+
+/**
+ * Computes the raw anomaly scores of many streams in one call.
+ *
+ * The sorted column indices of all the streams are concatenated; those of
+ * stream s are [offsets[s], offsets[s + 1]).
+ *
+ * @param numStreams: number of streams
+ * @param active: active column indices of all the streams
+ * @param activeOffsets: numStreams + 1 offsets into active
+ * @param predicted: predicted column indices of all the streams
+ * @param predictedOffsets: numStreams + 1 offsets into predicted
+ * @param scores: receives numStreams anomaly scores
+ */
+void computeRawAnomalyScores(UInt numStreams, const UInt *active,
+                             const UInt *activeOffsets, const UInt *predicted,
+                             const UInt *predictedOffsets, Real32 *scores);
+
+/**
+ * Computes the raw anomaly scores of many streams given as bitmasks, each
+ * numWords long and stored one after the other.
+ *
+ * @param numStreams: number of streams
+ * @param numWords: number of 64 bit words in each bitmask
+ * @param active: bitmasks of the active columns
+ * @param predicted: bitmasks of the predicted columns
+ * @param scores: receives numStreams anomaly scores
+ */
+void computeRawAnomalyScoresDense(UInt numStreams, UInt numWords,
+                                  const UInt64 *active,
+                                  const UInt64 *predicted, Real32 *scores);
+
 enum class AnomalyMode { PURE, LIKELIHOOD, WEIGHTED };
 
 class Anomaly {
@@ -61,10 +119,9 @@ public:
    * Supported modes:
    *    PURE - the raw anomaly score as computed by computeRawAnomalyScore
    *    LIKELIHOOD - uses the AnomalyLikelihood class on top of the raw
-   *        anomaly scores (not implemented in C++)
+   *        anomaly scores
    *    WEIGHTED - multiplies the likelihood result with the raw anomaly
-   *        score that was used to generate the likelihood (not
-   *        implemented in C++)
+   *        score that was used to generate the likelihood
    *
    *    @param slidingWindowSize (optional) - how many elements are
    *        summed up; enables moving average on final anomaly score;
@@ -93,9 +150,12 @@ public:
    * @param active: array of active column indices
    * @param predicted: array of columns indices predicted in this step
    *        (used for anomaly in step T+1)
-   * @param inputValue: (optional) value of current input to encoders
-   *                    (eg "cat" for category encoder)
-   *                    (used in anomaly-likelihood)
+   * @param inputValue: value of current input to encoders
+   *                    (eg "cat" for category encoder). Required in the
+   *                    LIKELIHOOD and WEIGHTED modes: the likelihood
+   *                    models the history of these values, and left at the
+   *                    default it sees no variance and stays near 0.5.
+   *                    Ignored in PURE mode.
    * @param timestamp: (optional) date timestamp when the sample occured
    *                   (used in anomaly-likelihood)
    * @return the computed anomaly score; Real32 0..1
@@ -104,10 +164,17 @@ public:
                  const std::vector<UInt> &predicted, Real64 inputValue = 0,
                  UInt timestamp = 0);
 
+  void save(std::ostream &outStream) const;
+  void load(std::istream &inStream);
+
+  bool operator==(const Anomaly &other) const;
+  bool operator!=(const Anomaly &other) const;
+
 private:
   AnomalyMode mode_;
   Real32 binaryThreshold_;
   std::unique_ptr<nupic::util::MovingAverage> movingAverage_;
+  AnomalyLikelihood likelihood_;
 };
 } // namespace anomaly
 } // namespace algorithms
@@ -0,0 +1,194 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+
+#include "nupic/algorithms/AnomalyLikelihood.hpp"
+#include "nupic/utils/Log.hpp"
+
+using namespace std;
+using nupic::util::MovingAverage;
+
+namespace nupic {
+
+namespace algorithms {
+
+namespace anomaly {
+
+// Lower bounds on the estimated distribution, and the variance of the input
+// values under which the metric is taken to be flat.
+static const Real64 MIN_MEAN = 0.03;
+static const Real64 MIN_VARIANCE = 0.0003;
+static const Real64 MIN_VALUE_VARIANCE = 1.5e-5;
+
+// Likelihoods at or under RED_THRESHOLD are only reported if the previous
+// unfiltered one was not; otherwise they are damped to YELLOW_THRESHOLD.
+static const Real64 RED_THRESHOLD = 1e-5;
+static const Real64 YELLOW_THRESHOLD = 1e-3;
+
+AnomalyLikelihood::AnomalyLikelihood(UInt learningPeriod,
+                                     UInt estimationSamples,
+                                     UInt historicWindowSize,
+                                     UInt reestimationPeriod,
+                                     UInt aggregationWindow)
+    : learningPeriod_(learningPeriod), estimationSamples_(estimationSamples),
+      reestimationPeriod_(reestimationPeriod), iteration_(0),
+      hasDistribution_(false), mean_(0), stdev_(0), prevLikelihood_(0.5),
+      averagedScores_(aggregationWindow), scoreHistory_(historicWindowSize),
+      valueHistory_(historicWindowSize) {
+  NTA_CHECK(reestimationPeriod > 0) << "reestimationPeriod must be > 0";
+}
+
+UInt AnomalyLikelihood::getProbationaryPeriod() const {
+  return learningPeriod_ + estimationSamples_;
+}
+
+UInt AnomalyLikelihood::getIteration() const { return iteration_; }
+
+void AnomalyLikelihood::estimateDistribution_() {
+  if (scoreHistory_.getSlidingWindow().empty() ||
+      valueHistory_.getCurrentVariance() < MIN_VALUE_VARIANCE) {
+    // The null distribution: every score is about as likely.
+    mean_ = 0.5;
+    stdev_ = 1e3;
+  } else {
+    mean_ = max((Real64)scoreHistory_.getCurrentAvg(), MIN_MEAN);
+    stdev_ = sqrt(max(scoreHistory_.getCurrentVariance(), MIN_VARIANCE));
+  }
+  hasDistribution_ = true;
+
+  // Python rescores the whole history under the new distribution; only the
+  // last likelihood matters for filtering the next one.
+  if (iteration_ > 0) {
+    prevLikelihood_ = tailProbability_(averagedScores_.getCurrentAvg());
+  }
+}
+
+Real64 AnomalyLikelihood::tailProbability_(Real64 x) const {
+  if (x < mean_) {
+    x = 2 * mean_ - x;
+  }
+  const Real64 z = (x - mean_) / stdev_;
+  return 0.5 * erfc(z / 1.4142);
+}
+
+Real64 AnomalyLikelihood::anomalyProbability(Real64 rawScore, Real64 value) {
+  Real64 likelihood = 0.5;
+  Real64 averagedScore;
+
+  if (iteration_ < getProbationaryPeriod()) {
+    averagedScore = averagedScores_.compute((Real32)rawScore);
+  } else {
+    if (!hasDistribution_ || iteration_ % reestimationPeriod_ == 0) {
+      estimateDistribution_();
+    }
+
+    averagedScore = averagedScores_.compute((Real32)rawScore);
+    const Real64 tail = tailProbability_(averagedScore);
+    Real64 filtered = tail;
+    if (tail <= RED_THRESHOLD && prevLikelihood_ <= RED_THRESHOLD) {
+      filtered = YELLOW_THRESHOLD;
+    }
+    // Like Python's _filterLikelihoods, compare with the unfiltered value
+    prevLikelihood_ = tail;
+    likelihood = 1.0 - filtered;
+  }
+
+  if (iteration_ >= learningPeriod_) {
+    scoreHistory_.compute((Real32)averagedScore);
+    valueHistory_.compute((Real32)value);
+  }
+  iteration_++;
+
+  return likelihood;
+}
+
+void AnomalyLikelihood::save(ostream &outStream) const {
+  outStream << "AnomalyLikelihood" << endl;
+  const std::streamsize precision = outStream.precision();
+  outStream << std::setprecision(std::numeric_limits<Real64>::max_digits10);
+  outStream << learningPeriod_ << " " << estimationSamples_ << " "
+            << reestimationPeriod_ << " " << iteration_ << " "
+            << hasDistribution_ << " " << mean_ << " " << stdev_ << " "
+            << prevLikelihood_ << endl;
+  averagedScores_.save(outStream);
+  scoreHistory_.save(outStream);
+  valueHistory_.save(outStream);
+  outStream << "~AnomalyLikelihood" << endl;
+  outStream.precision(precision);
+}
+
+void AnomalyLikelihood::load(istream &inStream) {
+  string marker;
+  inStream >> marker;
+  NTA_CHECK(marker == "AnomalyLikelihood");
+
+  inStream >> learningPeriod_ >> estimationSamples_ >> reestimationPeriod_ >>
+      iteration_ >> hasDistribution_ >> mean_ >> stdev_ >> prevLikelihood_;
+  averagedScores_.load(inStream);
+  scoreHistory_.load(inStream);
+  valueHistory_.load(inStream);
+
+  inStream >> marker;
+  NTA_CHECK(marker == "~AnomalyLikelihood");
+}
+
+bool AnomalyLikelihood::operator==(const AnomalyLikelihood &other) const {
+  return learningPeriod_ == other.learningPeriod_ &&
+         estimationSamples_ == other.estimationSamples_ &&
+         reestimationPeriod_ == other.reestimationPeriod_ &&
+         iteration_ == other.iteration_ &&
+         hasDistribution_ == other.hasDistribution_ &&
+         mean_ == other.mean_ && stdev_ == other.stdev_ &&
+         prevLikelihood_ == other.prevLikelihood_ &&
+         averagedScores_ == other.averagedScores_ &&
+         scoreHistory_ == other.scoreHistory_ &&
+         valueHistory_ == other.valueHistory_;
+}
+
+bool AnomalyLikelihood::operator!=(const AnomalyLikelihood &other) const {
+  return !operator==(other);
+}
+
+void computeAnomalyLikelihoods(vector<AnomalyLikelihood> &streams,
+                               const vector<Real64> &rawScores,
+                               const vector<Real64> &values,
+                               vector<Real64> &likelihoods) {
+  NTA_CHECK(rawScores.size() == streams.size())
+      << "Expected one raw score per stream";
+  NTA_CHECK(values.size() == streams.size())
+      << "Expected one value per stream";
+
+  likelihoods.resize(streams.size());
+  for (size_t i = 0; i < streams.size(); i++) {
+    likelihoods[i] = streams[i].anomalyProbability(rawScores[i], values[i]);
+  }
+}
+
+} // namespace anomaly
+
+} // namespace algorithms
+
+} // namespace nupic
@@ -0,0 +1,133 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef NUPIC_ALGORITHMS_ANOMALY_LIKELIHOOD_HPP
+#define NUPIC_ALGORITHMS_ANOMALY_LIKELIHOOD_HPP
+
+#include <iostream>
+#include <vector>
+
+#include <nupic/types/Types.hpp>
+#include <nupic/utils/MovingAverage.hpp>
+
+namespace nupic {
+
+namespace algorithms {
+
+namespace anomaly {
+
+/**
+ * Streaming anomaly likelihood, ported from nupic.algorithms.
+ * anomaly_likelihood.AnomalyLikelihood.
+ *
+ * Models the distribution of recent (averaged) raw anomaly scores as a
+ * normal distribution and reports how unusual the current score is under
+ * it. The Python version keeps every record of the history and rescans it
+ * each time the distribution is re-estimated. Here the history is kept as
+ * rolling statistics, so every record, re-estimations included, costs
+ * O(1):
+ *
+ *  - the raw scores are smoothed over the last aggregationWindow records
+ *  - the mean and variance of the smoothed scores and of the input values
+ *    are kept over the last historicWindowSize records, leaving out the
+ *    first learningPeriod records of the stream
+ *
+ * The only difference from Python is in the first aggregationWindow
+ * records of a history that has wrapped: Python averages them over a
+ * partial window, whereas here they carry their original averages.
+ */
+class AnomalyLikelihood {
+public:
+  /**
+   * @param learningPeriod records at the start of the stream left out of
+   *        the statistics, while the model is still learning
+   * @param estimationSamples records used to estimate the first
+   *        distribution, after the learning period
+   * @param historicWindowSize how many records the statistics cover
+   * @param reestimationPeriod how often, in records, the distribution is
+   *        re-estimated
+   * @param aggregationWindow how many raw scores are averaged
+   */
+  AnomalyLikelihood(UInt learningPeriod = 288, UInt estimationSamples = 100,
+                    UInt historicWindowSize = 8640,
+                    UInt reestimationPeriod = 100, UInt aggregationWindow = 10);
+
+  /**
+   * Compute the probability that the current raw score is anomalous.
+   *
+   * @param rawScore the raw anomaly score of this record, 0..1
+   * @param value the input value of this record; the likelihood stays at
+   *        0.5 while the values hardly vary
+   * @return the anomaly likelihood, 0..1; 0.5 during the probationary
+   *         period
+   */
+  Real64 anomalyProbability(Real64 rawScore, Real64 value = 0);
+
+  /**
+   * Number of records after which likelihoods are reported.
+   */
+  UInt getProbationaryPeriod() const;
+  UInt getIteration() const;
+
+  void save(std::ostream &outStream) const;
+  void load(std::istream &inStream);
+
+  bool operator==(const AnomalyLikelihood &other) const;
+  bool operator!=(const AnomalyLikelihood &other) const;
+
+private:
+  void estimateDistribution_();
+  Real64 tailProbability_(Real64 x) const;
+
+  UInt learningPeriod_;
+  UInt estimationSamples_;
+  UInt reestimationPeriod_;
+  UInt iteration_;
+
+  bool hasDistribution_;
+  Real64 mean_;
+  Real64 stdev_;
+  Real64 prevLikelihood_;
+
+  nupic::util::MovingAverage averagedScores_;
+  nupic::util::MovingAverage scoreHistory_;
+  nupic::util::MovingAverage valueHistory_;
+};
+
+/**
+ * Score one record for each of many independent streams.
+ *
+ * @param streams one AnomalyLikelihood per stream
+ * @param rawScores the raw anomaly score of each stream
+ * @param values the input value of each stream
+ * @param likelihoods receives the likelihood of each stream
+ */
+void computeAnomalyLikelihoods(std::vector<AnomalyLikelihood> &streams,
+                               const std::vector<Real64> &rawScores,
+                               const std::vector<Real64> &values,
+                               std::vector<Real64> &likelihoods);
+
+} // namespace anomaly
+} // namespace algorithms
+} // namespace nupic
+
+#endif // NUPIC_ALGORITHMS_ANOMALY_LIKELIHOOD_HPP
@@ -26,7 +26,14 @@
 using namespace nupic::algorithms::Cells4;
 using namespace nupic;
 
-Cell::Cell() : _segments(0), _freeSegments(0) {}
+Cell::Cell() : _segments(0), _freeSegments(0), _synapsePool(nullptr) {}
+
+//------------------------------------------------------------------------------
+void Cell::setSynapsePool(SynapsePool *pool) {
+  _synapsePool = pool;
+  for (Segment &segment : _segments)
+    segment.setSynapsePool(pool);
+}
 
 //------------------------------------------------------------------------------
 /**
@@ -91,7 +98,7 @@ UInt Cell::getFreeSegment(const Segment::InSynapses &synapses,
   NTA_ASSERT(_segments[segIdx].empty()); // important in case we push_back
 
   _segments[segIdx] = Segment(synapses, initFrequency, sequenceSegmentFlag,
-                              permConnected, iteration);
+                              permConnected, iteration, _synapsePool);
 
   return segIdx;
 }
@@ -124,6 +131,7 @@ void Cell::read(CellProto::Reader &proto) {
   _freeSegments.resize(0);
   for (UInt i = 0; i < segmentsProto.size(); ++i) {
     auto segProto = segmentsProto[i];
+    _segments[i].setSynapsePool(_synapsePool);
     _segments[i].read(segProto);
     if (_segments[i].empty()) {
       _freeSegments.push_back(i);
@@ -151,6 +159,7 @@ void Cell::load(std::istream &inStream) {
   _freeSegments.resize(0);
 
   for (UInt i = 0; i != (UInt)n; ++i) {
+    _segments[i].setSynapsePool(_synapsePool);
     _segments[i].load(inStream);
     if (_segments[i].empty())
       _freeSegments.push_back(i);
@@ -50,11 +50,18 @@ class Cell : Serializable<CellProto> {
 private:
   std::vector<Segment> _segments;  // both 'active' and 'inactive' segments
   std::vector<UInt> _freeSegments; // slots of the 'inactive' segments
+  SynapsePool *_synapsePool;       // owned by the Cells4, null for the heap
 
 public:
   //--------------------------------------------------------------------------------
   Cell();
 
+  //--------------------------------------------------------------------------------
+  /**
+   * Sets the pool the synapses of this cell's segments are allocated from.
+   */
+  void setSynapsePool(SynapsePool *pool);
+
   //--------------------------------------------------------------------------------
   bool empty() const { return _segments.size() == _freeSegments.size(); }
 
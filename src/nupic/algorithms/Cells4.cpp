@@ -23,6 +23,7 @@
 #include <nupic/utils/Random.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <iomanip>
 #include <iostream>
 #include <limits> // numeric_limits
@@ -43,6 +44,7 @@
 #include <nupic/os/Timer.hpp>
 #include <nupic/proto/Cells4.capnp.h>
 #include <nupic/utils/Log.hpp>
+#include <nupic/utils/ThreadPool.hpp>
 
 using namespace nupic::algorithms::Cells4;
 
@@ -73,8 +75,9 @@ Cells4::Cells4(UInt nColumns, UInt nCellsPerCol, UInt activationThreshold,
                Real permConnected, Real permMax, Real permDec, Real permInc,
                Real globalDecay, bool doPooling, int seed, bool initFromCpp,
                bool checkSynapseConsistency)
-    : _rng(seed < 0 ? rand() : seed) {
+    : _rng(seed < 0 ? rand() : seed), _synapsePool(new SynapsePool()) {
   _version = VERSION;
+  _threadPool = std::make_shared<nupic::util::ThreadPool>(1);
   initialize(nColumns, nCellsPerCol, activationThreshold, minThreshold,
              newSynapseCount, segUpdateValidDuration, permInitial,
              permConnected, permMax, permDec, permInc, globalDecay, doPooling,
@@ -221,7 +224,9 @@ void Cells4::addOutSynapses(UInt dstCellIdx, UInt dstSegIdx, It newSynapse,
   for (; newSynapse != newSynapsesEnd; ++newSynapse) {
     UInt srcCellIdx = *newSynapse;
     OutSynapse newOutSyn(dstCellIdx, dstSegIdx);
-    NTA_ASSERT(not_in(newOutSyn, _outSynapses[srcCellIdx]));
+    NTA_ASSERT(std::find(_outSynapses[srcCellIdx].begin(),
+                         _outSynapses[srcCellIdx].end(),
+                         newOutSyn) == _outSynapses[srcCellIdx].end());
     _outSynapses[srcCellIdx].push_back(newOutSyn);
   }
 }
@@ -262,6 +267,364 @@ void Cells4::eraseOutSynapses(UInt dstCellIdx, UInt dstSegIdx,
   }
 }
 
+//--------------------------------------------------------------------------------
+// Backtracking on private scratch states
+//--------------------------------------------------------------------------------
+
+// Outcome of evaluating a backtracking start offset
+static const UChar BACKTRACK_NOT_EVALUATED = 0;
+static const UChar BACKTRACK_FAILED = 1;
+static const UChar BACKTRACK_IN_SEQUENCE = 2;
+
+static bool pastDeadline(std::chrono::steady_clock::time_point deadline) {
+  return deadline != std::chrono::steady_clock::time_point::max() &&
+         std::chrono::steady_clock::now() > deadline;
+}
+
+UInt Cells4::getNumThreads() const { return _threadPool->getNumThreads(); }
+
+void Cells4::setNumThreads(UInt numThreads) {
+  NTA_CHECK(numThreads >= 1);
+  if (numThreads != _threadPool->getNumThreads()) {
+    _threadPool = std::make_shared<nupic::util::ThreadPool>(numThreads);
+  }
+}
+
+std::chrono::steady_clock::time_point Cells4::_backtrackDeadline() const {
+  if (_maxBacktrackTime <= 0)
+    return std::chrono::steady_clock::time_point::max();
+  return std::chrono::steady_clock::now() +
+         std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+             std::chrono::duration<Real64>(_maxBacktrackTime));
+}
+
+bool Cells4::_useParallelBacktrack(UInt numOffsets) const {
+  // The verbose traces are printed from inside the serial loops
+  return _threadPool->getNumThreads() > 1 && numOffsets > 1 && _verbosity < 3;
+}
+
+template <typename Activity>
+void Cells4::_forwardPropagation(const CState &state, Activity &activity) {
+  activity.reset();
+  state.forEachOn([this, &activity](UInt srcCellIdx) {
+    const OutSynapses &os = _outSynapses[srcCellIdx];
+    for (UInt j = 0; j != os.size(); ++j) {
+      activity.increment(os[j].dstCellIdx(), os[j].dstSegIdx());
+    }
+  });
+}
+
+template <typename Activity>
+bool Cells4::_inferPredictions(
+    Activity &activity, const CState &activeState, CState &predictedState,
+    Real *cellConfidence, Real *colConfidence,
+    std::vector<std::pair<UInt, UInt>> *dutyCycleReads) {
+  //---------------------------------------------------------------------------
+  // Initialize to 0 to start
+  predictedState.resetAll();
+  memset(cellConfidence, 0, _nCells * sizeof(cellConfidence[0]));
+  memset(colConfidence, 0, _nColumns * sizeof(colConfidence[0]));
+
+  //---------------------------------------------------------------------------
+  // Phase 2 - Compute predicted state and update cell and column confidences
+  UInt cellIdx = 0, numPredictedCols = 0;
+  Real sumColConfidence = 0;
+  for (UInt c = 0; c < _nColumns; c++) {
+
+    // For each cell in the column
+    bool colPredicted = false;
+    for (UInt i = 0; i < _nCellsPerCol; i++, cellIdx++) {
+
+      if (activity.get(cellIdx) >= _activationThreshold) {
+
+        // For each segment in the cell
+        for (UInt j = 0; j != _cells[cellIdx].size(); ++j) {
+
+          // Run sanity check to ensure forward prop matches activity
+          // calcuations (turned on in some tests)
+          if (_checkSynapseConsistency) {
+            const Segment &seg = _cells[cellIdx][j];
+            UInt numActiveSyns =
+                seg.computeActivity(activeState, _permConnected, false);
+            NTA_CHECK(numActiveSyns == activity.get(cellIdx, j));
+          }
+
+          // See if segment has a min number of active synapses
+          if (activity.get(cellIdx, j) >= _activationThreshold) {
+
+            // Incorporate the confidence into the owner cell and column
+            // Use segment::getLastPosDutyCycle() here. The value read is
+            // the same whether or not the cache is updated.
+            Real dc = _cells[cellIdx][j].dutyCycle(_nLrnIterations, false,
+                                                   dutyCycleReads != nullptr);
+            if (dutyCycleReads != nullptr)
+              dutyCycleReads->push_back(std::make_pair(cellIdx, j));
+            cellConfidence[cellIdx] += dc;
+            colConfidence[c] += dc;
+
+            // If we reach threshold on the connected synapses, predict it
+            if (isActive(cellIdx, j, activeState)) {
+              predictedState.set(cellIdx);
+              colPredicted = true;
+            }
+          }
+
+        } // for each segment
+
+      } // _cellActivity >= _activationThreshold
+
+    } // each cell in col
+
+    sumColConfidence += colConfidence[c];
+    numPredictedCols += (colPredicted ? 1 : 0);
+  } // each col
+
+  //---------------------------------------------------------------------------
+  // Normalize column confidences
+  if (sumColConfidence > 0) {
+    for (UInt c = 0; c < _nColumns; c++)
+      colConfidence[c] /= sumColConfidence;
+    for (UInt i = 0; i < _nCells; i++)
+      cellConfidence[i] /= sumColConfidence;
+  }
+
+  //---------------------------------------------------------------------------
+  // Are we predicting the required minimum number of columns?
+  return (numPredictedCols >= (0.5 * _avgInputDensity));
+}
+
+template <typename Activity>
+std::pair<UInt, UInt> Cells4::_bestMatchingCellT(UInt colIdx,
+                                                 const CState &state,
+                                                 UInt minThreshold,
+                                                 Activity &activity) {
+  { NTA_ASSERT(colIdx < nColumns()); }
+
+  int start = colIdx * _nCellsPerCol, end = start + _nCellsPerCol;
+  UInt best_cell = UInt(-1);
+  UInt best_seg = UInt(-1);
+  UInt best_activity = minThreshold > 0 ? minThreshold - 1 : 0;
+
+  // For each cell in the column
+  for (int ii = end - 1; ii >= start;
+       --ii) { // reverse segment order to match Python logic
+    UInt i = UInt(ii);
+
+    // Check synapse consistency for each segment if requested
+    if (_checkSynapseConsistency) {
+      for (UInt j = 0; j != _cells[i].size(); ++j) {
+        NTA_CHECK(segment(i, j).computeActivity(state, _permConnected, false) ==
+                  activity.get(i, j));
+      }
+    }
+
+    if (activity.get(i) >
+        best_activity) { // if this cell may have a worthy segment
+
+      for (UInt j = 0; j != _cells[i].size(); ++j) {
+
+        // Open: Does _cells[i].size() vary?
+        UInt segActivity = activity.get(i, j);
+
+        if (best_activity < segActivity) { // if a new maximum
+          best_activity = segActivity;     // set the new maximum
+          best_cell = i;                   // remember the cell
+          best_seg = j;                    // remember the segment
+        }
+        if (_verbosity >= 6 && segActivity >= minThreshold) {
+          std::cout << "getBestMatchingCell, learning on col=" << colIdx
+                    << ", segment: ";
+          _cells[i][j].print(std::cout, _nCellsPerCol);
+          std::cout << "\n";
+          std::cout << "activity = " << segActivity
+                    << ", maxSegActivity = " << best_activity << "\n";
+        }
+      } // for each segment in cell
+
+    } // if this cell may have a segment with a new maximum
+  }   // for each cell in the column
+
+  return std::make_pair(best_cell, best_seg); // could be (-1,-1)
+}
+
+/**
+ * Same steps as one pass of the inferBacktrack loop, on scratch states.
+ */
+bool Cells4::_replayInference(UInt startOffset, CBacktrackScratch &scratch) {
+  for (UInt offset = startOffset; offset < _prevInfPatterns.size(); offset++) {
+    // The previous prediction is ignored when starting on start cells
+    if (offset != startOffset)
+      scratch.predictedStateT1 = scratch.predictedState;
+    if (!_inferPhase1(_prevInfPatterns[offset], (offset == startOffset),
+                      scratch.activeState, scratch.predictedStateT1))
+      return false;
+
+    _forwardPropagation(scratch.activeState, scratch.activity);
+    if (!_inferPredictions(scratch.activity, scratch.activeState,
+                           scratch.predictedState,
+                           scratch.cellConfidence.data(),
+                           scratch.colConfidence.data(),
+                           &scratch.dutyCycleReads))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * Same steps as learnBacktrackFrom(startOffset, true), on scratch states.
+ */
+bool Cells4::_replayLearning(UInt startOffset, CBacktrackScratch &scratch) {
+  UInt numPrevPatterns = _prevLrnPatterns.size();
+  UInt currentTimeStepsOffset = numPrevPatterns - 1;
+
+  bool inSequence = true;
+  for (UInt offset = startOffset; offset < numPrevPatterns; offset++) {
+    const std::vector<UInt> &activeColumns = _prevLrnPatterns[offset];
+    scratch.predictedStateT1 = scratch.predictedState;
+    scratch.activeState.resetAll();
+
+    // Compute activeState[t] given bottom-up and predictedState[t-1]
+    if (offset == startOffset) {
+      for (auto &activeColumn : activeColumns) {
+        scratch.activeState.set(activeColumn * _nCellsPerCol);
+      }
+    } else {
+      // learnPhase1 with readOnly: turn on the predicted cell, if any
+      UInt numUnpredictedColumns = 0;
+      for (auto &activeColumn : activeColumns) {
+        UInt cell0 = activeColumn * _nCellsPerCol;
+        UInt numPredictedCells = 0, predictingCell = _nCellsPerCol;
+        for (UInt j = 0; j < _nCellsPerCol; j++) {
+          if (scratch.predictedStateT1.isSet(j + cell0)) {
+            numPredictedCells++;
+            predictingCell = j;
+          }
+        }
+        if (numPredictedCells == 1)
+          scratch.activeState.set(cell0 + predictingCell);
+        else
+          numUnpredictedColumns++;
+      }
+      inSequence = numUnpredictedColumns < activeColumns.size() / 2;
+    }
+
+    if (!inSequence || (offset == currentTimeStepsOffset))
+      break;
+
+    // learnPhase2 with readOnly: predict the best matching cell per column
+    _forwardPropagation(scratch.activeState, scratch.activity);
+    scratch.predictedState.resetAll();
+    for (UInt colIdx = 0; colIdx != _nColumns; ++colIdx) {
+      std::pair<UInt, UInt> p = _bestMatchingCellT(
+          colIdx, scratch.activeState, _activationThreshold, scratch.activity);
+      if (p.second != (UInt)-1)
+        scratch.predictedState.set(p.first);
+    }
+  }
+
+  return inSequence;
+}
+
+Int Cells4::_searchBacktrack(UInt numOffsets, bool learn,
+                             std::chrono::steady_clock::time_point deadline,
+                             std::vector<UChar> &outcome, UInt &winner) {
+  const UInt numThreads = _threadPool->getNumThreads();
+
+  // Segment counts don't change while backtracking, so the compact
+  // activity layout is fixed for this call.
+  _segOffsets.resize(_nCells + 1);
+  _segOffsets[0] = 0;
+  for (UInt i = 0; i < _nCells; i++)
+    _segOffsets[i + 1] = _segOffsets[i] + _cells[i].size();
+
+  if (_backtrackScratch.size() < numThreads)
+    _backtrackScratch.resize(numThreads);
+  for (UInt t = 0; t < numThreads; t++) {
+    std::unique_ptr<CBacktrackScratch> &scratch = _backtrackScratch[t];
+    if (!scratch || scratch->cellConfidence.size() != _nCells ||
+        scratch->colConfidence.size() != _nColumns) {
+      scratch.reset(new CBacktrackScratch(_nCells, _nColumns));
+    }
+    scratch->activity.initialize(_segOffsets);
+    scratch->dutyCycleReads.clear();
+    scratch->evaluated.clear();
+  }
+
+  // Threads take offsets in increasing order and stop once an earlier one
+  // is known to stay in sequence, so every offset before the earliest
+  // success is evaluated, just as in the serial loop.
+  outcome.assign(numOffsets, BACKTRACK_NOT_EVALUATED);
+  std::vector<UInt> evaluatedBy(numOffsets, 0);
+  std::atomic<UInt> nextOffset(0);
+  std::atomic<UInt> firstInSequence(numOffsets);
+
+  _threadPool->parallelFor(numThreads, [&](UInt begin, UInt end) {
+    for (UInt t = begin; t < end; t++) {
+      CBacktrackScratch &scratch = *_backtrackScratch[t];
+      // The deadline is checked before an offset is taken, so that every
+      // offset taken before the earliest success is evaluated
+      while (!pastDeadline(deadline)) {
+        const UInt startOffset = nextOffset++;
+        if (startOffset >= numOffsets || startOffset > firstInSequence)
+          break;
+
+        bool inSequence = learn ? _replayLearning(startOffset, scratch)
+                                : _replayInference(startOffset, scratch);
+        scratch.evaluated.push_back(
+            std::make_pair(startOffset, (UInt)scratch.dutyCycleReads.size()));
+        outcome[startOffset] =
+            inSequence ? BACKTRACK_IN_SEQUENCE : BACKTRACK_FAILED;
+        evaluatedBy[startOffset] = t;
+
+        if (inSequence) {
+          // Keep the scratch states of this offset
+          UInt first = firstInSequence;
+          while (startOffset < first &&
+                 !firstInSequence.compare_exchange_weak(first, startOffset)) {
+          }
+          break;
+        }
+      }
+    }
+  });
+
+  // The serial loop stops at the first offset it has no time for, so the
+  // outcomes from there on are dropped, and a later success isn't
+  // accepted.
+  for (UInt startOffset = 0; startOffset < numOffsets; startOffset++) {
+    if (outcome[startOffset] == BACKTRACK_NOT_EVALUATED) {
+      std::fill(outcome.begin() + startOffset, outcome.end(),
+                BACKTRACK_NOT_EVALUATED);
+      return -1;
+    }
+    if (outcome[startOffset] == BACKTRACK_IN_SEQUENCE) {
+      winner = evaluatedBy[startOffset];
+      return (Int)startOffset;
+    }
+  }
+  return -1;
+}
+
+void Cells4::_commitBacktrackDutyCycles(UInt lastOffset,
+                                        const std::vector<UChar> &outcome) {
+  for (auto &scratch : _backtrackScratch) {
+    if (!scratch)
+      continue;
+    UInt begin = 0;
+    for (auto &evaluated : scratch->evaluated) {
+      if (evaluated.first <= lastOffset &&
+          outcome[evaluated.first] != BACKTRACK_NOT_EVALUATED) {
+        for (UInt i = begin; i < evaluated.second; i++) {
+          const std::pair<UInt, UInt> &read = scratch->dutyCycleReads[i];
+          _cells[read.first][read.second].dutyCycle(_nLrnIterations, false,
+                                                    false);
+        }
+      }
+      begin = evaluated.second;
+    }
+  }
+}
+
 //--------------------------------------------------------------------------------
 /**
  * This "backtracks" our inference state, trying to see if we can lock
@@ -292,88 +655,130 @@ void Cells4::inferBacktrack(const std::vector<UInt> &activeColumns) {
   // up to the current time step and remove all the ones at the head of the
   // input history queue so that we don't waste time evaluating them again at
   // a later time step.
-  static std::vector<UInt> badPatterns;
-  badPatterns.clear(); // purge residual data
+  std::vector<UInt> badPatterns;
 
   //---------------------------------------------------------------------------
   // Let's go back in time and replay the recent inputs from start cells and
   // see if we can lock onto this current set of inputs that way. A detailed
   // description is in TP.py
-  bool inSequence = false;
-  Real candConfidence = -1;
+  const std::chrono::steady_clock::time_point deadline = _backtrackDeadline();
   Int candStartOffset = -1;
-  UInt startOffset = 0;
-  for (; startOffset < _prevInfPatterns.size(); startOffset++) {
-
-    // If we have a candidate already in the past, don't bother falling back
-    // to start cells on the current input.
-    if ((startOffset == currentTimeStepsOffset) && (candConfidence != -1))
-      break;
-
-    if (_verbosity >= 3) {
-      std::cout << "Trying to lock-on using startCell state from "
-                << _prevInfPatterns.size() - 1 - startOffset << " steps ago:";
-      printActiveColumns(std::cout, _prevInfPatterns[startOffset]);
-      std::cout << "\n";
+  if (_useParallelBacktrack(_prevInfPatterns.size())) {
+    // Evaluate the start offsets concurrently on scratch states and keep
+    // the earliest one that stays in sequence, as the loop below does.
+    std::vector<UChar> outcome;
+    UInt winner = 0;
+    candStartOffset = _searchBacktrack(_prevInfPatterns.size(), false,
+                                       deadline, outcome, winner);
+    UInt lastOffset = (candStartOffset == -1 ? _prevInfPatterns.size() - 1
+                                             : (UInt)candStartOffset);
+    for (UInt startOffset = 0; startOffset <= lastOffset; startOffset++) {
+      if (outcome[startOffset] == BACKTRACK_FAILED)
+        badPatterns.push_back(startOffset);
+    }
+    _commitBacktrackDutyCycles(lastOffset, outcome);
+
+    if (candStartOffset != -1) {
+      const CBacktrackScratch &scratch = *_backtrackScratch[winner];
+      _infActiveStateT = scratch.activeState;
+      _infPredictedStateT = scratch.predictedState;
+      memcpy(_cellConfidenceT, scratch.cellConfidence.data(),
+             _nCells * sizeof(_cellConfidenceT[0]));
+      memcpy(_colConfidenceT, scratch.colConfidence.data(),
+             _nColumns * sizeof(_colConfidenceT[0]));
     }
+  } else {
+    bool inSequence = false;
+    Real candConfidence = -1;
+    UInt startOffset = 0;
+    for (; startOffset < _prevInfPatterns.size(); startOffset++) {
+
+      // If we have a candidate already in the past, don't bother falling
+      // back to start cells on the current input.
+      if ((startOffset == currentTimeStepsOffset) && (candConfidence != -1))
+        break;
 
-    // Play through starting from time t-startOffset
-    inSequence = false;
-    Real totalConfidence = 0;
-    for (UInt offset = startOffset; offset < _prevInfPatterns.size();
-         offset++) {
-      // If we are about to set the active columns for the current time step
-      // based on what we predicted, capture and save the total confidence of
-      // predicting the current input
-      if (offset == currentTimeStepsOffset) {
-        totalConfidence = 0;
-        for (auto &activeColumn : activeColumns) {
-          totalConfidence += _colConfidenceT[activeColumn];
-        }
-      }
-
-      // Compute activeState[t] given bottom-up and predictedState[t-1]
-      _infPredictedStateT1 = _infPredictedStateT;
-      inSequence =
-          inferPhase1(_prevInfPatterns[offset], (offset == startOffset));
-      if (!inSequence)
+      // Out of time: treat the remaining start offsets as failures
+      if (pastDeadline(deadline))
         break;
 
-      // Compute predictedState['t'] given activeState['t']
       if (_verbosity >= 3) {
-        std::cout << "  backtrack: computing predictions from ";
-        printActiveColumns(std::cout, _prevInfPatterns[offset]);
+        std::cout << "Trying to lock-on using startCell state from "
+                  << _prevInfPatterns.size() - 1 - startOffset << " steps ago:";
+        printActiveColumns(std::cout, _prevInfPatterns[startOffset]);
         std::cout << "\n";
       }
-      inSequence = inferPhase2();
-      if (!inSequence)
-        break;
-    }
 
-    // If starting from startOffset got lost along the way, mark it as an
-    // invalid start point.
-    if (!inSequence) {
-      badPatterns.push_back(startOffset);
-    } else {
-      candStartOffset = startOffset;
+      // Play through starting from time t-startOffset
+      inSequence = false;
+      Real totalConfidence = 0;
+      for (UInt offset = startOffset; offset < _prevInfPatterns.size();
+           offset++) {
+        // If we are about to set the active columns for the current time step
+        // based on what we predicted, capture and save the total confidence of
+        // predicting the current input
+        if (offset == currentTimeStepsOffset) {
+          totalConfidence = 0;
+          for (auto &activeColumn : activeColumns) {
+            totalConfidence += _colConfidenceT[activeColumn];
+          }
+        }
 
-      // If we got to here, startOffset is a candidate starting point.
-      if (_verbosity >= 3 && (startOffset != currentTimeStepsOffset)) {
-        std::cout << "# Prediction confidence of current input after starting "
-                  << _prevInfPatterns.size() - 1 - startOffset
-                  << " steps ago: " << totalConfidence << "\n";
+        // Compute activeState[t] given bottom-up and predictedState[t-1]
+        _infPredictedStateT1 = _infPredictedStateT;
+        inSequence =
+            inferPhase1(_prevInfPatterns[offset], (offset == startOffset));
+        if (!inSequence)
+          break;
+
+        // Compute predictedState['t'] given activeState['t']
+        if (_verbosity >= 3) {
+          std::cout << "  backtrack: computing predictions from ";
+          printActiveColumns(std::cout, _prevInfPatterns[offset]);
+          std::cout << "\n";
+        }
+        inSequence = inferPhase2();
+        if (!inSequence)
+          break;
       }
 
-      if (candStartOffset == (Int)currentTimeStepsOffset)
+      // If starting from startOffset got lost along the way, mark it as an
+      // invalid start point.
+      if (!inSequence) {
+        badPatterns.push_back(startOffset);
+      } else {
+        candStartOffset = startOffset;
+
+        // If we got to here, startOffset is a candidate starting point.
+        if (_verbosity >= 3 && (startOffset != currentTimeStepsOffset)) {
+          std::cout
+              << "# Prediction confidence of current input after starting "
+              << _prevInfPatterns.size() - 1 - startOffset
+              << " steps ago: " << totalConfidence << "\n";
+        }
+
+        if (candStartOffset == (Int)currentTimeStepsOffset)
+          break;
+        _infActiveStateCandidate = _infActiveStateT;
+        _infPredictedStateCandidate = _infPredictedStateT;
+        memcpy(_cellConfidenceCandidate, _cellConfidenceT,
+               _nCells * sizeof(_cellConfidenceT[0]));
+        memcpy(_colConfidenceCandidate, _colConfidenceT,
+               _nColumns * sizeof(_colConfidenceT[0]));
+
         break;
-      _infActiveStateCandidate = _infActiveStateT;
-      _infPredictedStateCandidate = _infPredictedStateT;
-      memcpy(_cellConfidenceCandidate, _cellConfidenceT,
-             _nCells * sizeof(_cellConfidenceT[0]));
-      memcpy(_colConfidenceCandidate, _colConfidenceT,
-             _nColumns * sizeof(_colConfidenceT[0]));
+      }
+    }
 
-      break;
+    // Install the candidate state, if it wasn't the last one we evaluated.
+    if (candStartOffset != -1 &&
+        candStartOffset != (Int)currentTimeStepsOffset) {
+      _infActiveStateT = _infActiveStateCandidate;
+      _infPredictedStateT = _infPredictedStateCandidate;
+      memcpy(_cellConfidenceT, _cellConfidenceCandidate,
+             _nCells * sizeof(_cellConfidenceCandidate[0]));
+      memcpy(_colConfidenceT, _colConfidenceCandidate,
+             _nColumns * sizeof(_colConfidenceCandidate[0]));
     }
   }
 
@@ -393,15 +798,6 @@ void Cells4::inferBacktrack(const std::vector<UInt> &activeColumns) {
                 << _prevInfPatterns.size() - 1 - candStartOffset
                 << " steps ago.\n";
     }
-    // Install the candidate state, if it wasn't the last one we evaluated.
-    if (candStartOffset != (Int)currentTimeStepsOffset) {
-      _infActiveStateT = _infActiveStateCandidate;
-      _infPredictedStateT = _infPredictedStateCandidate;
-      memcpy(_cellConfidenceT, _cellConfidenceCandidate,
-             _nCells * sizeof(_cellConfidenceCandidate[0]));
-      memcpy(_colConfidenceT, _colConfidenceCandidate,
-             _nColumns * sizeof(_colConfidenceCandidate[0]));
-    }
   }
 
   //---------------------------------------------------------------------------
@@ -544,27 +940,51 @@ UInt Cells4::learnBacktrack() {
   // up to the current time step and remove all the ones at the head of the
   // input history queue so that we don't waste time evaluating them again at
   // a later time step.
-  static std::vector<UInt> badPatterns;
-  badPatterns.clear(); // purge residual data
+  std::vector<UInt> badPatterns;
 
   //---------------------------------------------------------------------------
   // Let's go back in time and replay the recent inputs from start cells and
   // see if we can lock onto this current set of inputs that way. A detailed
   // description is in TP.py
+  const std::chrono::steady_clock::time_point deadline = _backtrackDeadline();
   bool inSequence = false;
   UInt startOffset = 0;
-  for (; startOffset < numPrevPatterns; startOffset++) {
-    // Can we backtrack from startOffset?
-    inSequence = learnBacktrackFrom(startOffset, true);
+  if (_useParallelBacktrack(numPrevPatterns)) {
+    // Evaluate the start offsets concurrently on scratch states and keep
+    // the earliest one that stays in sequence, as the loop below does.
+    std::vector<UChar> outcome;
+    UInt winner = 0;
+    Int candStartOffset =
+        _searchBacktrack(numPrevPatterns, true, deadline, outcome, winner);
+    inSequence = (candStartOffset != -1);
+    startOffset = inSequence ? (UInt)candStartOffset : numPrevPatterns;
+    for (UInt i = 0; i < startOffset; i++) {
+      if (outcome[i] == BACKTRACK_FAILED)
+        badPatterns.push_back(i);
+    }
+
+    // The serial loop leaves the learning states of the last offset it
+    // tried behind. Replay that offset so the t-1 states match.
+    if (!inSequence && !badPatterns.empty())
+      learnBacktrackFrom(badPatterns.back(), true);
+  } else {
+    for (; startOffset < numPrevPatterns; startOffset++) {
+      // Out of time: treat the remaining start offsets as failures
+      if (pastDeadline(deadline))
+        break;
 
-    // Done playing through the sequence from starting point startOffset
-    // Break out as soon as we find a good path
-    if (inSequence)
-      break;
+      // Can we backtrack from startOffset?
+      inSequence = learnBacktrackFrom(startOffset, true);
+
+      // Done playing through the sequence from starting point startOffset
+      // Break out as soon as we find a good path
+      if (inSequence)
+        break;
 
-    // Take this bad starting point out of our input history so we don't
-    // try it again later.
-    badPatterns.push_back(startOffset);
+      // Take this bad starting point out of our input history so we don't
+      // try it again later.
+      badPatterns.push_back(startOffset);
+    }
   }
 
   //---------------------------------------------------------------------------
@@ -1044,9 +1464,18 @@ void Cells4::updateInferenceState(const std::vector<UInt> &activeColumns) {
 bool Cells4::inferPhase1(const std::vector<UInt> &activeColumns,
                          bool useStartCells) {
   TIMER(infPhase1Timer.start());
+  bool inSequence = _inferPhase1(activeColumns, useStartCells,
+                                 _infActiveStateT, _infPredictedStateT1);
+  TIMER(infPhase1Timer.stop());
+  return inSequence;
+}
+
+bool Cells4::_inferPhase1(const std::vector<UInt> &activeColumns,
+                          bool useStartCells, CState &activeState,
+                          const CState &predictedStateT1) {
   //---------------------------------------------------------------------------
   // Initialize current active state to 0 to start
-  _infActiveStateT.resetAll();
+  activeState.resetAll();
 
   //---------------------------------------------------------------------------
   // Phase 1 - turn on predicted cells in each column receiving bottom-up
@@ -1057,7 +1486,7 @@ bool Cells4::inferPhase1(const std::vector<UInt> &activeColumns,
   if (useStartCells) {
     for (auto &activeColumn : activeColumns) {
       UInt cellIdx = activeColumn * _nCellsPerCol;
-      _infActiveStateT.set(cellIdx);
+      activeState.set(cellIdx);
     }
 
   }
@@ -1069,9 +1498,9 @@ bool Cells4::inferPhase1(const std::vector<UInt> &activeColumns,
       UInt numPredictingCells = 0;
 
       for (UInt ci = cellIdx; ci < cellIdx + _nCellsPerCol; ci++) {
-        if (_infPredictedStateT1.isSet(ci)) {
+        if (predictedStateT1.isSet(ci)) {
           numPredictingCells++;
-          _infActiveStateT.set(ci);
+          activeState.set(ci);
         }
       }
 
@@ -1080,13 +1509,12 @@ bool Cells4::inferPhase1(const std::vector<UInt> &activeColumns,
       } else {
         // std::cout << "inferPhase1 bursting col=" << activeColumns[i] << "\n";
         for (UInt ci = cellIdx; ci < cellIdx + _nCellsPerCol; ci++) {
-          _infActiveStateT.set(ci); // whole column bursts
+          activeState.set(ci); // whole column bursts
         }
       }
     }
   }
 
-  TIMER(infPhase1Timer.stop());
   // Did we predict this input well enough?
   return (useStartCells ||
           (numPredictedColumns >= 0.50 * activeColumns.size()));
@@ -1105,78 +1533,11 @@ bool Cells4::inferPhase2() {
   TIMER(forwardInfPropTimer.stop());
 
   TIMER(infPhase2Timer.start());
-  //---------------------------------------------------------------------------
-  // Initialize to 0 to start
-  _infPredictedStateT.resetAll();
-  memset(_cellConfidenceT, 0, _nCells * sizeof(_cellConfidenceT[0]));
-  memset(_colConfidenceT, 0, _nColumns * sizeof(_colConfidenceT[0]));
-
-  //---------------------------------------------------------------------------
-  // Phase 2 - Compute predicted state and update cell and column confidences
-  UInt cellIdx = 0, numPredictedCols = 0;
-  Real sumColConfidence = 0;
-  for (UInt c = 0; c < _nColumns; c++) {
-
-    // For each cell in the column
-    bool colPredicted = false;
-    for (UInt i = 0; i < _nCellsPerCol; i++, cellIdx++) {
-
-      if (_inferActivity.get(cellIdx) >= _activationThreshold) {
-
-        // For each segment in the cell
-        for (UInt j = 0; j != _cells[cellIdx].size(); ++j) {
-
-          // Run sanity check to ensure forward prop matches activity
-          // calcuations (turned on in some tests)
-          if (_checkSynapseConsistency) {
-            const Segment &seg = _cells[cellIdx][j];
-            UInt numActiveSyns =
-                seg.computeActivity(_infActiveStateT, _permConnected, false);
-            NTA_CHECK(numActiveSyns == _inferActivity.get(cellIdx, j));
-          }
-
-          // See if segment has a min number of active synapses
-          if (_inferActivity.get(cellIdx, j) >= _activationThreshold) {
-
-            // Incorporate the confidence into the owner cell and column
-            // Use segment::getLastPosDutyCycle() here
-            Real dc =
-                _cells[cellIdx][j].dutyCycle(_nLrnIterations, false, false);
-            _cellConfidenceT[cellIdx] += dc;
-            _colConfidenceT[c] += dc;
-
-            // If we reach threshold on the connected synapses, predict it
-            if (isActive(cellIdx, j, _infActiveStateT)) {
-              _infPredictedStateT.set(cellIdx);
-              colPredicted = true;
-            }
-          }
-
-        } // for each segment
-
-      } // _cellActivity >= _activationThreshold
-
-    } // each cell in col
-
-    sumColConfidence += _colConfidenceT[c];
-    numPredictedCols += (colPredicted ? 1 : 0);
-  } // each col
-
-  //---------------------------------------------------------------------------
-  // Normalize column confidences
-  if (sumColConfidence > 0) {
-    for (UInt c = 0; c < _nColumns; c++)
-      _colConfidenceT[c] /= sumColConfidence;
-    for (UInt i = 0; i < _nCells; i++)
-      _cellConfidenceT[i] /= sumColConfidence;
-  }
-
-  // Turn off timer before we return
+  bool inSequence =
+      _inferPredictions(_inferActivity, _infActiveStateT, _infPredictedStateT,
+                        _cellConfidenceT, _colConfidenceT, nullptr);
   TIMER(infPhase2Timer.stop());
-
-  //---------------------------------------------------------------------------
-  // Are we predicting the required minimum number of columns?
-  return (numPredictedCols >= (0.5 * _avgInputDensity));
+  return inSequence;
 }
 
 //------------------------------------------------------------------------------
@@ -1282,84 +1643,15 @@ void Cells4::compute(Real *input, Real *output, bool doInference,
   // invalidating our indexes.
   memset(output, 0, _nCells * sizeof(output[0])); // most output is zero
 #if SOME_STATES_NOT_INDEXED
-#if defined(NTA_ARCH_32)
-  const UInt multipleOf4 = 4 * (_nCells / 4);
-  UInt i;
-  for (i = 0; i < multipleOf4; i += 4) {
-    UInt32 fourStates = *(UInt32 *)(_infPredictedStateT.arrayPtr() + i);
-    if (fourStates != 0) {
-      if ((fourStates & 0x000000ff) != 0)
-        output[i + 0] = 1.0;
-      if ((fourStates & 0x0000ff00) != 0)
-        output[i + 1] = 1.0;
-      if ((fourStates & 0x00ff0000) != 0)
-        output[i + 2] = 1.0;
-      if ((fourStates & 0xff000000) != 0)
-        output[i + 3] = 1.0;
-    }
-    fourStates = *(UInt32 *)(_infActiveStateT.arrayPtr() + i);
-    if (fourStates != 0) {
-      if ((fourStates & 0x000000ff) != 0)
-        output[i + 0] = 1.0;
-      if ((fourStates & 0x0000ff00) != 0)
-        output[i + 1] = 1.0;
-      if ((fourStates & 0x00ff0000) != 0)
-        output[i + 2] = 1.0;
-      if ((fourStates & 0xff000000) != 0)
-        output[i + 3] = 1.0;
-    }
-  }
-
-  // process the tail if (_nCells % 4) != 0
-  for (i = multipleOf4; i < _nCells; i++) {
-    if (_infPredictedStateT.isSet(i)) {
-      output[i] = 1.0;
-    } else if (_infActiveStateT.isSet(i)) {
-      output[i] = 1.0;
-    }
-  }
-#else
+  const Byte *predictedState = _infPredictedStateT.arrayPtr();
+  const Byte *activeState = _infActiveStateT.arrayPtr();
   const UInt multipleOf8 = 8 * (_nCells / 8);
   UInt i;
   for (i = 0; i < multipleOf8; i += 8) {
-    UInt64 eightStates = *(UInt64 *)(_infPredictedStateT.arrayPtr() + i);
-    if (eightStates != 0) {
-      if ((eightStates & 0x00000000000000ff) != 0)
-        output[i + 0] = 1.0;
-      if ((eightStates & 0x000000000000ff00) != 0)
-        output[i + 1] = 1.0;
-      if ((eightStates & 0x0000000000ff0000) != 0)
-        output[i + 2] = 1.0;
-      if ((eightStates & 0x00000000ff000000) != 0)
-        output[i + 3] = 1.0;
-      if ((eightStates & 0x000000ff00000000) != 0)
-        output[i + 4] = 1.0;
-      if ((eightStates & 0x0000ff0000000000) != 0)
-        output[i + 5] = 1.0;
-      if ((eightStates & 0x00ff000000000000) != 0)
-        output[i + 6] = 1.0;
-      if ((eightStates & 0xff00000000000000) != 0)
-        output[i + 7] = 1.0;
-    }
-    eightStates = *(UInt64 *)(_infActiveStateT.arrayPtr() + i);
-    if (eightStates != 0) {
-      if ((eightStates & 0x00000000000000ff) != 0)
-        output[i + 0] = 1.0;
-      if ((eightStates & 0x000000000000ff00) != 0)
-        output[i + 1] = 1.0;
-      if ((eightStates & 0x0000000000ff0000) != 0)
-        output[i + 2] = 1.0;
-      if ((eightStates & 0x00000000ff000000) != 0)
-        output[i + 3] = 1.0;
-      if ((eightStates & 0x000000ff00000000) != 0)
-        output[i + 4] = 1.0;
-      if ((eightStates & 0x0000ff0000000000) != 0)
-        output[i + 5] = 1.0;
-      if ((eightStates & 0x00ff000000000000) != 0)
-        output[i + 6] = 1.0;
-      if ((eightStates & 0xff00000000000000) != 0)
-        output[i + 7] = 1.0;
-    }
+    UInt64 mask = CState::onMask(predictedState + i) |
+                  CState::onMask(activeState + i);
+    for (; mask != 0; mask &= mask - 1)
+      output[i + CState::firstOn(mask)] = 1.0;
   }
 
   // process the tail if (_nCells % 8) != 0
@@ -1370,16 +1662,11 @@ void Cells4::compute(Real *input, Real *output, bool doInference,
       output[i] = 1.0;
     }
   }
-#endif // NTA_ARCH_32/64
 #else  // some states indexed
-  static std::vector<UInt> cellsOn;
-  std::vector<UInt>::iterator iterOn;
-  cellsOn = _infPredictedStateT.cellsOn();
-  for (iterOn = cellsOn.begin(); iterOn != cellsOn.end(); ++iterOn)
-    output[*iterOn] = 1.0;
-  cellsOn = _infActiveStateT.cellsOn();
-  for (iterOn = cellsOn.begin(); iterOn != cellsOn.end(); ++iterOn)
-    output[*iterOn] = 1.0;
+  for (UInt cellIdx : _infPredictedStateT.getCellsOn())
+    output[cellIdx] = 1.0;
+  for (UInt cellIdx : _infActiveStateT.getCellsOn())
+    output[cellIdx] = 1.0;
 #endif // SOME_STATES_NOT_INDEXED
 
   if (_checkSynapseConsistency) {
@@ -1806,7 +2093,8 @@ void Cells4::trimOldSegments(UInt maxAge) {
 // This is useful if segments have changed.
 void Cells4::rebuildOutSynapses() {
   // TODO: Is this logic sufficient?
-  _outSynapses.resize(_nCells);
+  SynapsePoolAllocator<OutSynapse> outSynapseAlloc(_synapsePool.get());
+  _outSynapses.resize(_nCells, OutSynapses(outSynapseAlloc));
 
   // Clear existing out synapses
   for (UInt srcCellIdx = 0; srcCellIdx != _nCells; ++srcCellIdx) {
@@ -2037,6 +2325,7 @@ void Cells4::read(Cells4Proto::Reader &proto) {
   _cells.resize(_nCells);
   for (UInt i = 0; i < cellListProto.size(); ++i) {
     auto cellProto = cellListProto[i];
+    _cells[i].setSynapsePool(_synapsePool.get());
     _cells[i].read(cellProto);
   }
 
@@ -2493,6 +2782,7 @@ void Cells4::initialize(UInt nColumns, UInt nCellsPerCol,
   _pamCounter = _pamLength + 1;
   _maxInfBacktrack = 10;
   _maxLrnBacktrack = 5;
+  _maxBacktrackTime = 0;
   _maxSeqLength = 0;
   _learnedSeqLength = 0;
   _avgLearnedSeqLength = 0.0;
@@ -2502,8 +2792,11 @@ void Cells4::initialize(UInt nColumns, UInt nCellsPerCol,
   _maxSynapsesPerSegment = -1;
 
   _cells.resize(_nCells);
+  for (Cell &cell : _cells)
+    cell.setSynapsePool(_synapsePool.get());
   Cell::setSegmentOrder(false);
-  _outSynapses.resize(_nCells);
+  SynapsePoolAllocator<OutSynapse> outSynapseAlloc(_synapsePool.get());
+  _outSynapses.resize(_nCells, OutSynapses(outSynapseAlloc));
 
   // This is for Python: TP10X is a thin class
   // that contains an instance of Cells4, and we can have either
@@ -2625,53 +2918,7 @@ std::vector<UInt> Cells4::getNonEmptySegList(UInt colIdx, UInt cellIdxInCol) {
 std::pair<UInt, UInt> Cells4::getBestMatchingCellT(UInt colIdx,
                                                    const CState &state,
                                                    UInt minThreshold) {
-  { NTA_ASSERT(colIdx < nColumns()); }
-
-  int start = colIdx * _nCellsPerCol, end = start + _nCellsPerCol;
-  UInt best_cell = UInt(-1);
-  UInt best_seg = UInt(-1);
-  UInt best_activity = minThreshold > 0 ? minThreshold - 1 : 0;
-
-  // For each cell in the column
-  for (int ii = end - 1; ii >= start;
-       --ii) { // reverse segment order to match Python logic
-    UInt i = UInt(ii);
-
-    // Check synapse consistency for each segment if requested
-    if (_checkSynapseConsistency) {
-      for (UInt j = 0; j != _cells[i].size(); ++j) {
-        NTA_CHECK(segment(i, j).computeActivity(state, _permConnected, false) ==
-                  _learnActivity.get(i, j));
-      }
-    }
-
-    if (_learnActivity.get(i) >
-        best_activity) { // if this cell may have a worthy segment
-
-      for (UInt j = 0; j != _cells[i].size(); ++j) {
-
-        // Open: Does _cells[i].size() vary?
-        UInt activity = _learnActivity.get(i, j);
-
-        if (best_activity < activity) { // if a new maximum
-          best_activity = activity;     // set the new maximum
-          best_cell = i;                // remember the cell
-          best_seg = j;                 // remember the segment
-        }
-        if (_verbosity >= 6 && activity >= minThreshold) {
-          std::cout << "getBestMatchingCell, learning on col=" << colIdx
-                    << ", segment: ";
-          _cells[i][j].print(std::cout, _nCellsPerCol);
-          std::cout << "\n";
-          std::cout << "activity = " << activity
-                    << ", maxSegActivity = " << best_activity << "\n";
-        }
-      } // for each segment in cell
-
-    } // if this cell may have a segment with a new maximum
-  }   // for each cell in the column
-
-  return std::make_pair(best_cell, best_seg); // could be (-1,-1)
+  return _bestMatchingCellT(colIdx, state, minThreshold, _learnActivity);
 }
 
 //----------------------------------------------------------------------
@@ -2737,26 +2984,20 @@ void Cells4::chooseCellsToLearnFrom(UInt cellIdx, UInt segIdx, UInt nSynToAdd,
 
   // start with a sorted vector of all the cells that are on in the current
   // state
-  static std::vector<UInt> vecCellBuffer;
-  vecCellBuffer = state.cellsOn(true);
+  const std::vector<UInt> &vecCellBuffer = state.getCellsOn(true);
 
   // remove any cells already in this segment
-  static std::vector<UInt> vecPruned;
+  std::vector<UInt> vecPruned;
   if (segIdx != (UInt)-1) {
 
     // collect the sorted list of source cell indices
-    Segment segThis = _cells[cellIdx][segIdx];
-    static std::vector<UInt> vecAlreadyHave;
-    if (vecAlreadyHave.capacity() < segThis.size())
-      vecAlreadyHave.reserve(segThis.size());
-    vecAlreadyHave.clear(); // purge residual data
-    for (UInt i = 0; i != segThis.size(); ++i)
-      vecAlreadyHave.push_back(segThis[i].srcCellIdx());
+    const Segment &segThis = _cells[cellIdx][segIdx];
+    std::vector<UInt> vecAlreadyHave;
+    vecAlreadyHave.reserve(segThis.size());
+    segThis.getSrcCellIndices(vecAlreadyHave);
 
     // remove any of these found in vecCellBuffer
-    if (vecPruned.size() <
-        vecCellBuffer.size()) // ensure there is enough room for the results
-      vecPruned.resize(vecCellBuffer.size());
+    vecPruned.resize(vecCellBuffer.size());
     std::vector<UInt>::iterator iterPruned;
     iterPruned = std::set_difference(vecCellBuffer.begin(), vecCellBuffer.end(),
                                      vecAlreadyHave.begin(),
@@ -3072,12 +3313,8 @@ void Cells4::computeForwardPropagation(CStateIndexed &state) {
   // activity coming into a cell.
 
   // process all cells that are on in the current state
-  static std::vector<UInt> vecCellBuffer;
-  vecCellBuffer = state.cellsOn();
-  std::vector<UInt>::iterator iterCellBuffer;
-  for (iterCellBuffer = vecCellBuffer.begin();
-       iterCellBuffer != vecCellBuffer.end(); ++iterCellBuffer) {
-    std::vector<OutSynapse> &os = _outSynapses[*iterCellBuffer];
+  for (UInt srcCellIdx : state.getCellsOn()) {
+    const OutSynapses &os = _outSynapses[srcCellIdx];
     for (UInt j = 0; j != os.size(); ++j) {
       UInt dstCellIdx = os[j].dstCellIdx();
       UInt dstSegIdx = os[j].dstSegIdx();
@@ -3099,71 +3336,9 @@ void Cells4::computeForwardPropagation(CStateIndexed &state) {
  * known offender is TP.py.
  */
 void Cells4::computeForwardPropagation(CState &state) {
-  // Zero out previous values
-  // Using memset is quite a bit faster on laptops, but has almost no effect
-  // on Neo15!
-  _inferActivity.reset();
-
-  // Compute cell and segment activity by following forward propagation
-  // links from each source cell.  _cellActivity will be set to the total
-  // activity coming into a cell.
-#ifdef NTA_ARCH_64
-  const UInt multipleOf8 = 8 * (_nCells / 8);
-  UInt i;
-  for (i = 0; i < multipleOf8; i += 8) {
-    UInt64 eightStates = *(UInt64 *)(state.arrayPtr() + i);
-    for (int k = 0; eightStates != 0 && k < 8; eightStates >>= 8, k++) {
-      if ((eightStates & 0xff) != 0) {
-        std::vector<OutSynapse> &os = _outSynapses[i + k];
-        for (UInt j = 0; j != os.size(); ++j) {
-          UInt dstCellIdx = os[j].dstCellIdx();
-          UInt dstSegIdx = os[j].dstSegIdx();
-          _inferActivity.increment(dstCellIdx, dstSegIdx);
-        }
-      }
-    }
-  }
-
-  // process the tail if (_nCells % 8) != 0
-  for (i = multipleOf8; i < _nCells; i++) {
-    if (state.isSet(i)) {
-      std::vector<OutSynapse> &os = _outSynapses[i];
-      for (UInt j = 0; j != os.size(); ++j) {
-        UInt dstCellIdx = os[j].dstCellIdx();
-        UInt dstSegIdx = os[j].dstSegIdx();
-        _inferActivity.increment(dstCellIdx, dstSegIdx);
-      }
-    }
-  }
-#else
-  const UInt multipleOf4 = 4 * (_nCells / 4);
-  UInt i;
-  for (i = 0; i < multipleOf4; i += 4) {
-    UInt32 fourStates = *(UInt32 *)(state.arrayPtr() + i);
-    for (int k = 0; fourStates != 0 && k < 4; fourStates >>= 8, k++) {
-      if ((fourStates & 0xff) != 0) {
-        std::vector<OutSynapse> &os = _outSynapses[i + k];
-        for (UInt j = 0; j != os.size(); ++j) {
-          UInt dstCellIdx = os[j].dstCellIdx();
-          UInt dstSegIdx = os[j].dstSegIdx();
-          _inferActivity.increment(dstCellIdx, dstSegIdx);
-        }
-      }
-    }
-  }
-
-  // process the tail if (_nCells % 4) != 0
-  for (i = multipleOf4; i < _nCells; i++) {
-    if (state.isSet(i)) {
-      std::vector<OutSynapse> &os = _outSynapses[i];
-      for (UInt j = 0; j != os.size(); ++j) {
-        UInt dstCellIdx = os[j].dstCellIdx();
-        UInt dstSegIdx = os[j].dstSegIdx();
-        _inferActivity.increment(dstCellIdx, dstSegIdx);
-      }
-    }
-  }
-#endif // NTA_ARCH_32/64
+  // Zero out previous values, then compute cell and segment activity by
+  // following forward propagation links from each source cell.
+  _forwardPropagation(state, _inferActivity);
 }
 #endif // SOME_STATES_NOT_INDEXED
 
@@ -23,10 +23,13 @@
 #ifndef NTA_Cells4_HPP
 #define NTA_Cells4_HPP
 
+#include <chrono>
 #include <cstring>
 #include <fstream>
+#include <memory>
 #include <nupic/algorithms/OutSynapse.hpp>
 #include <nupic/algorithms/Segment.hpp>
+#include <nupic/algorithms/SegmentSynapses.hpp>
 #include <nupic/proto/Cells4.capnp.h>
 #include <nupic/types/Serializable.hpp>
 #include <nupic/types/Types.hpp>
@@ -67,6 +70,10 @@
  */
 
 namespace nupic {
+namespace util {
+class ThreadPool;
+}
+
 namespace algorithms {
 namespace Cells4 {
 
@@ -244,10 +251,89 @@ private:
   CBasicActivity<It> _seg;
 };
 
+#ifndef SWIG
+/**
+ * Class CCompactSegActivity:
+ * The same counters as CCellSegActivity<UChar>, but with one slot per
+ * existing segment rather than _MAX_CELLS * _MAX_SEGS slots, so that
+ * every backtracking thread can afford its own copy. Segment segIdx of
+ * cell cellIdx uses slot segOffsets[cellIdx] + segIdx, where segOffsets
+ * holds the running total of segments per cell.
+ */
+class CCompactSegActivity {
+public:
+  CCompactSegActivity() : _segOffsets(nullptr) {}
+  void initialize(const std::vector<UInt> &segOffsets) {
+    _segOffsets = &segOffsets;
+    _cell.assign(segOffsets.size() - 1, 0);
+    _seg.assign(segOffsets.back(), 0);
+    _touched.clear();
+  }
+  UInt get(UInt cellIdx) const { return _cell[cellIdx]; }
+  UInt get(UInt cellIdx, UInt segIdx) const {
+    return _seg[(*_segOffsets)[cellIdx] + segIdx];
+  }
+  void increment(UInt cellIdx, UInt segIdx) {
+    const UChar count = ++_seg[(*_segOffsets)[cellIdx] + segIdx];
+    UChar &cellMax = _cell[cellIdx];
+    if (count > cellMax) {
+      if (cellMax == 0)
+        _touched.push_back(cellIdx);
+      cellMax = count;
+    }
+  }
+  void reset() {
+    // every nonzero segment counter belongs to a touched cell
+    for (UInt cellIdx : _touched) {
+      _cell[cellIdx] = 0;
+      std::fill(_seg.begin() + (*_segOffsets)[cellIdx],
+                _seg.begin() + (*_segOffsets)[cellIdx + 1], 0);
+    }
+    _touched.clear();
+  }
+
+private:
+  const std::vector<UInt> *_segOffsets;
+  std::vector<UChar> _cell;
+  std::vector<UChar> _seg;
+  std::vector<UInt> _touched;
+};
+
+/**
+ * Class CBacktrackScratch:
+ * Private copies of the states that inferBacktrack and learnBacktrack
+ * overwrite while replaying the input history from one start offset.
+ * Each backtracking thread owns one, so several start offsets can be
+ * evaluated at once without touching the Cells4 states.
+ */
+class CBacktrackScratch {
+public:
+  CBacktrackScratch(UInt nCells, UInt nColumns)
+      : cellConfidence(nCells), colConfidence(nColumns) {
+    activeState.initialize(nCells);
+    predictedState.initialize(nCells);
+    predictedStateT1.initialize(nCells);
+  }
+
+  CState activeState;
+  CState predictedState;
+  CState predictedStateT1;
+  std::vector<Real> cellConfidence;
+  std::vector<Real> colConfidence;
+  CCompactSegActivity activity;
+
+  // (cellIdx, segIdx) of every segment whose duty cycle was read, and for
+  // each start offset evaluated, the number of entries recorded by then.
+  std::vector<std::pair<UInt, UInt>> dutyCycleReads;
+  std::vector<std::pair<UInt, UInt>> evaluated;
+};
+#endif // SWIG
+
 class Cells4 : public Serializable<Cells4Proto> {
 public:
   typedef Segment::InSynapses InSynapses;
-  typedef std::vector<OutSynapse> OutSynapses;
+  typedef std::vector<OutSynapse, SynapsePoolAllocator<OutSynapse>>
+      OutSynapses;
   typedef std::vector<SegmentUpdate> SegmentUpdates;
   static const UInt VERSION = 2;
 
@@ -350,8 +436,10 @@ private:
 
   //-----------------------------------------------------------------------
   /**
-   * Internal data structures.
+   * Internal data structures. The synapse pool must outlive the segments
+   * and out synapses whose storage it holds, so it is declared first.
    */
+  std::unique_ptr<SynapsePool> _synapsePool;
   std::vector<Cell> _cells;
   std::deque<std::vector<UInt>> _prevInfPatterns;
   std::deque<std::vector<UInt>> _prevLrnPatterns;
@@ -368,6 +456,16 @@ private:
 // structures, and their use does not overlap
 #define _inferActivity _learnActivity
 
+  //-----------------------------------------------------------------------
+  /**
+   * Backtracking. Start offsets are evaluated by _threadPool on
+   * _backtrackScratch; _segOffsets indexes their CCompactSegActivity.
+   */
+  Real _maxBacktrackTime; // seconds per backtrack, 0 means no limit
+  std::vector<UInt> _segOffsets;
+  std::vector<std::unique_ptr<CBacktrackScratch>> _backtrackScratch;
+  std::shared_ptr<util::ThreadPool> _threadPool;
+
 public:
   //-----------------------------------------------------------------------
   /**
@@ -489,6 +587,7 @@ public:
   Int getMaxSegmentsPerCell() const { return _maxSegmentsPerCell; }
   Int getMaxSynapsesPerSegment() const { return _maxSynapsesPerSegment; }
   bool getCheckSynapseConsistency() const { return _checkSynapseConsistency; }
+  Real getMaxBacktrackTime() const { return _maxBacktrackTime; }
 
   //----------------------------------------------------------------------
   /**
@@ -501,6 +600,37 @@ public:
   void setMaxSeqLength(UInt v) { _maxSeqLength = v; }
   void setCheckSynapseConsistency(bool val) { _checkSynapseConsistency = val; }
 
+  /**
+   * Limits the time a single inferBacktrack or learnBacktrack call spends
+   * trying start offsets. Once it is used up, no further offsets are
+   * tried and the call behaves as if the untried ones had failed, which
+   * falls back to bursting or start cells. The limit is checked before
+   * each offset, so a call may overrun it by one replay.
+   *
+   * @param seconds time limit in seconds, 0 (the default) for no limit.
+   */
+  void setMaxBacktrackTime(Real seconds) {
+    NTA_CHECK(seconds >= 0);
+    _maxBacktrackTime = seconds;
+  }
+
+  /**
+   * Returns the number of threads used to evaluate backtracking start
+   * offsets.
+   */
+  UInt getNumThreads() const;
+
+  /**
+   * Sets the number of threads, including the calling thread, that
+   * inferBacktrack and learnBacktrack use to evaluate start offsets.
+   * The offset chosen is the earliest that stays in sequence, exactly as
+   * with one thread, so the results do not depend on this setting.
+   * Backtracking runs serially while verbosity is 3 or more.
+   *
+   * @param numThreads integer number of threads, must be at least 1.
+   */
+  void setNumThreads(UInt numThreads);
+
   void setMaxSegmentsPerCell(int maxSegs) {
     if (maxSegs != -1) {
       NTA_CHECK(maxSegs > 0);
@@ -1135,6 +1265,64 @@ public:
   // Statistics
   //-----------------------------------------------------------------------
   void stats() const { return; }
+
+private:
+  //-----------------------------------------------------------------------
+  /**
+   * Bodies of inferPhase1, inferPhase2, computeForwardPropagation and
+   * getBestMatchingCellT on explicit states, shared by the normal path
+   * and the backtracking scratch states. If dutyCycleReads is given,
+   * duty cycles are read without updating their cache, and the segments
+   * read are appended to it instead.
+   */
+  bool _inferPhase1(const std::vector<UInt> &activeColumns, bool useStartCells,
+                    CState &activeState, const CState &predictedStateT1);
+  template <typename Activity>
+  bool _inferPredictions(Activity &activity, const CState &activeState,
+                         CState &predictedState, Real *cellConfidence,
+                         Real *colConfidence,
+                         std::vector<std::pair<UInt, UInt>> *dutyCycleReads);
+  template <typename Activity>
+  void _forwardPropagation(const CState &state, Activity &activity);
+  template <typename Activity>
+  std::pair<UInt, UInt> _bestMatchingCellT(UInt colIdx, const CState &state,
+                                           UInt minThreshold,
+                                           Activity &activity);
+
+  //-----------------------------------------------------------------------
+  /**
+   * Replay the inference (or read-only learning) history from startOffset
+   * on the given scratch states. Returns true if it stays in sequence up
+   * to the current time step.
+   */
+  bool _replayInference(UInt startOffset, CBacktrackScratch &scratch);
+  bool _replayLearning(UInt startOffset, CBacktrackScratch &scratch);
+
+  //-----------------------------------------------------------------------
+  /**
+   * Evaluates start offsets 0 to numOffsets - 1 concurrently and returns
+   * the earliest one that stays in sequence, or -1. outcome receives the
+   * result of each offset, and winner the index of the scratch holding
+   * the states of the offset returned. Offsets after the earliest
+   * success, or past the deadline, may be left unevaluated. A success is
+   * only returned if every earlier offset was evaluated, and outcome is
+   * cut at the first unevaluated offset, as the serial loop stops there.
+   */
+  Int _searchBacktrack(UInt numOffsets, bool learn,
+                       std::chrono::steady_clock::time_point deadline,
+                       std::vector<UChar> &outcome, UInt &winner);
+
+  //-----------------------------------------------------------------------
+  /**
+   * Updates the duty cycle cache of every segment read while evaluating
+   * offsets up to lastOffset that have an outcome, as the serial
+   * inferBacktrack loop does.
+   */
+  void _commitBacktrackDutyCycles(UInt lastOffset,
+                                  const std::vector<UChar> &outcome);
+
+  std::chrono::steady_clock::time_point _backtrackDeadline() const;
+  bool _useParallelBacktrack(UInt numOffsets) const;
 };
 
 //-----------------------------------------------------------------------
@@ -24,6 +24,7 @@
  * Implementation of Connections
  */
 
+#include <algorithm>
 #include <climits>
 #include <iomanip>
 #include <iostream>
@@ -33,6 +34,8 @@
 #include <kj/std/iostream.h>
 
 #include <nupic/algorithms/Connections.hpp>
+#include <nupic/os/MappedFile.hpp>
+#include <nupic/utils/BinaryStream.hpp>
 
 using std::endl;
 using std::string;
@@ -46,6 +49,14 @@ Connections::Connections(CellIdx numCells) { initialize(numCells); }
 
 void Connections::initialize(CellIdx numCells) {
   cells_ = vector<CellData>(numCells);
+  segments_.clear();
+  destroyedSegments_.clear();
+  synapses_.clear();
+  destroyedSynapses_.clear();
+  synapsesForPresynapticCell_.clear();
+  presynapticIdxForSynapse_.clear();
+  segmentOrdinals_.clear();
+  synapseOrdinals_.clear();
 
   // Every time a segment or synapse is created, we assign it an ordinal and
   // increment the nextOrdinal. Ordinals are never recycled, so they can be used
@@ -104,6 +115,7 @@ Synapse Connections::createSynapse(Segment segment, CellIdx presynapticCell,
     synapse.flatIdx = synapses_.size();
     synapses_.push_back(SynapseData());
     synapseOrdinals_.push_back(0);
+    presynapticIdxForSynapse_.push_back(0);
   }
 
   SynapseData &synapseData = synapses_[synapse];
@@ -115,7 +127,7 @@ Synapse Connections::createSynapse(Segment segment, CellIdx presynapticCell,
   synapseOrdinals_[synapse] = nextSynapseOrdinal_++;
   segmentData.synapses.push_back(synapse);
 
-  synapsesForPresynapticCell_[presynapticCell].push_back(synapse);
+  addSynapseToPresynapticMap_(synapse);
 
   for (auto h : eventHandlers_) {
     h.second->onCreateSynapse(synapse);
@@ -139,19 +151,31 @@ bool Connections::synapseExists_(Synapse synapse) const {
                     synapse) != synapsesOnSegment.end());
 }
 
+void Connections::addSynapseToPresynapticMap_(Synapse synapse) {
+  const SynapseData &synapseData = synapses_[synapse];
+  if (synapseData.presynapticCell >= synapsesForPresynapticCell_.size()) {
+    synapsesForPresynapticCell_.resize(synapseData.presynapticCell + 1);
+  }
+
+  vector<PresynapticSynapseData> &presynapticSynapses =
+      synapsesForPresynapticCell_[synapseData.presynapticCell];
+  presynapticIdxForSynapse_[synapse] = presynapticSynapses.size();
+  presynapticSynapses.push_back(
+      {synapse, synapseData.segment, synapseData.permanence});
+}
+
 void Connections::removeSynapseFromPresynapticMap_(Synapse synapse) {
   const SynapseData &synapseData = synapses_[synapse];
-  vector<Synapse> &presynapticSynapses =
-      synapsesForPresynapticCell_.at(synapseData.presynapticCell);
+  vector<PresynapticSynapseData> &presynapticSynapses =
+      synapsesForPresynapticCell_[synapseData.presynapticCell];
 
-  auto it = std::find(presynapticSynapses.begin(), presynapticSynapses.end(),
-                      synapse);
-  NTA_ASSERT(it != presynapticSynapses.end());
-  presynapticSynapses.erase(it);
+  const UInt32 idx = presynapticIdxForSynapse_[synapse];
+  NTA_ASSERT(idx < presynapticSynapses.size());
+  NTA_ASSERT(presynapticSynapses[idx].synapse == synapse);
 
-  if (presynapticSynapses.size() == 0) {
-    synapsesForPresynapticCell_.erase(synapseData.presynapticCell);
-  }
+  presynapticSynapses[idx] = presynapticSynapses.back();
+  presynapticIdxForSynapse_[presynapticSynapses[idx].synapse] = idx;
+  presynapticSynapses.pop_back();
 }
 
 void Connections::destroySegment(Segment segment) {
@@ -213,7 +237,11 @@ void Connections::updateSynapsePermanence(Synapse synapse,
     h.second->onUpdateSynapsePermanence(synapse, permanence);
   }
 
-  synapses_[synapse].permanence = permanence;
+  SynapseData &synapseData = synapses_[synapse];
+  synapseData.permanence = permanence;
+  synapsesForPresynapticCell_[synapseData.presynapticCell]
+                             [presynapticIdxForSynapse_[synapse]]
+                                 .permanence = permanence;
 }
 
 const vector<Segment> &Connections::segmentsForCell(CellIdx cell) const {
@@ -279,11 +307,15 @@ bool Connections::compareSegments(Segment a, Segment b) const {
 
 vector<Synapse>
 Connections::synapsesForPresynapticCell(CellIdx presynapticCell) const {
-  if (synapsesForPresynapticCell_.find(presynapticCell) ==
-      synapsesForPresynapticCell_.end())
-    return vector<Synapse>{};
+  vector<Synapse> synapses;
+  if (presynapticCell < synapsesForPresynapticCell_.size()) {
+    for (const PresynapticSynapseData &presynapticSynapse :
+         synapsesForPresynapticCell_[presynapticCell]) {
+      synapses.push_back(presynapticSynapse.synapse);
+    }
+  }
 
-  return synapsesForPresynapticCell_.at(presynapticCell);
+  return synapses;
 }
 
 Synapse Connections::minPermanenceSynapse_(Segment segment) const {
@@ -307,6 +339,20 @@ Synapse Connections::minPermanenceSynapse_(Segment segment) const {
   return minSynapse;
 }
 
+static void
+computeActivityForCell_(const vector<PresynapticSynapseData> &presynapticSynapses,
+                        UInt32 *numActiveConnected, UInt32 *numActivePotential,
+                        Permanence threshold) {
+  for (const PresynapticSynapseData &presynapticSynapse : presynapticSynapses) {
+    ++numActivePotential[presynapticSynapse.segment];
+
+    NTA_ASSERT(presynapticSynapse.permanence > 0);
+    if (presynapticSynapse.permanence >= threshold) {
+      ++numActiveConnected[presynapticSynapse.segment];
+    }
+  }
+}
+
 void Connections::computeActivity(
     vector<UInt32> &numActiveConnectedSynapsesForSegment,
     vector<UInt32> &numActivePotentialSynapsesForSegment,
@@ -314,16 +360,31 @@ void Connections::computeActivity(
   NTA_ASSERT(numActiveConnectedSynapsesForSegment.size() == segments_.size());
   NTA_ASSERT(numActivePotentialSynapsesForSegment.size() == segments_.size());
 
-  if (synapsesForPresynapticCell_.count(activePresynapticCell)) {
-    for (Synapse synapse :
-         synapsesForPresynapticCell_.at(activePresynapticCell)) {
-      const SynapseData &synapseData = synapses_[synapse];
-      ++numActivePotentialSynapsesForSegment[synapseData.segment];
+  if (activePresynapticCell < synapsesForPresynapticCell_.size()) {
+    computeActivityForCell_(synapsesForPresynapticCell_[activePresynapticCell],
+                            numActiveConnectedSynapsesForSegment.data(),
+                            numActivePotentialSynapsesForSegment.data(),
+                            connectedPermanence - EPSILON);
+  }
+}
 
-      NTA_ASSERT(synapseData.permanence > 0);
-      if (synapseData.permanence >= connectedPermanence - EPSILON) {
-        ++numActiveConnectedSynapsesForSegment[synapseData.segment];
-      }
+void Connections::computeActivity(
+    vector<UInt32> &numActiveConnectedSynapsesForSegment,
+    vector<UInt32> &numActivePotentialSynapsesForSegment,
+    const vector<CellIdx> &activePresynapticCells,
+    Permanence connectedPermanence) const {
+  NTA_ASSERT(numActiveConnectedSynapsesForSegment.size() == segments_.size());
+  NTA_ASSERT(numActivePotentialSynapsesForSegment.size() == segments_.size());
+
+  UInt32 *numActiveConnected = numActiveConnectedSynapsesForSegment.data();
+  UInt32 *numActivePotential = numActivePotentialSynapsesForSegment.data();
+  const Permanence threshold = connectedPermanence - EPSILON;
+
+  for (CellIdx cell : activePresynapticCells) {
+    if (cell < synapsesForPresynapticCell_.size()) {
+      computeActivityForCell_(synapsesForPresynapticCell_[cell],
+                              numActiveConnected, numActivePotential,
+                              threshold);
     }
   }
 }
@@ -331,21 +392,34 @@ void Connections::computeActivity(
 void Connections::computeActivity(
     vector<UInt32> &numActiveConnectedSynapsesForSegment,
     vector<UInt32> &numActivePotentialSynapsesForSegment,
+    vector<Segment> &touchedSegments,
     const vector<CellIdx> &activePresynapticCells,
     Permanence connectedPermanence) const {
   NTA_ASSERT(numActiveConnectedSynapsesForSegment.size() == segments_.size());
   NTA_ASSERT(numActivePotentialSynapsesForSegment.size() == segments_.size());
 
+  UInt32 *numActiveConnected = numActiveConnectedSynapsesForSegment.data();
+  UInt32 *numActivePotential = numActivePotentialSynapsesForSegment.data();
+  const Permanence threshold = connectedPermanence - EPSILON;
+
+  touchedSegments.clear();
   for (CellIdx cell : activePresynapticCells) {
-    if (synapsesForPresynapticCell_.count(cell)) {
-      for (Synapse synapse : synapsesForPresynapticCell_.at(cell)) {
-        const SynapseData &synapseData = synapses_[synapse];
-        ++numActivePotentialSynapsesForSegment[synapseData.segment];
+    if (cell >= synapsesForPresynapticCell_.size()) {
+      continue;
+    }
 
-        NTA_ASSERT(synapseData.permanence > 0);
-        if (synapseData.permanence >= connectedPermanence - EPSILON) {
-          ++numActiveConnectedSynapsesForSegment[synapseData.segment];
-        }
+    for (const PresynapticSynapseData &presynapticSynapse :
+         synapsesForPresynapticCell_[cell]) {
+      const Segment segment = presynapticSynapse.segment;
+      NTA_ASSERT(presynapticSynapse.permanence > 0);
+
+      // The counters start at zero, so the first increment marks the
+      // segment as touched.
+      if (numActivePotential[segment]++ == 0) {
+        touchedSegments.push_back(segment);
+      }
+      if (presynapticSynapse.permanence >= threshold) {
+        ++numActiveConnected[segment];
       }
     }
   }
@@ -480,9 +554,9 @@ void Connections::load(std::istream &inStream) {
           segmentData.synapses.push_back(synapse);
           synapses_.push_back(synapseData);
           synapseOrdinals_.push_back(nextSynapseOrdinal_++);
+          presynapticIdxForSynapse_.push_back(0);
 
-          synapsesForPresynapticCell_[synapseData.presynapticCell].push_back(
-              synapse);
+          addSynapseToPresynapticMap_(synapse);
         }
       }
     }
@@ -492,6 +566,136 @@ void Connections::load(std::istream &inStream) {
   NTA_CHECK(marker == "~Connections");
 }
 
+void Connections::saveBinary(std::ostream &outStream) const {
+  util::BinaryWriter writer(outStream);
+  writer.writeMarker("NTACONNS");
+  writer.write<UInt32>(Connections::BINARY_VERSION);
+  writer.write<UInt32>(synapsesForPresynapticCell_.size());
+
+  // Live segments and synapses are packed in cell order, which is also the
+  // flat index order that loadBinary assigns.
+  vector<SegmentIdx> numSegmentsForCell;
+  vector<SynapseIdx> numSynapsesForSegment;
+  vector<CellIdx> presynapticCells;
+  vector<Permanence> permanences;
+  numSegmentsForCell.reserve(cells_.size());
+  numSynapsesForSegment.reserve(numSegments());
+  presynapticCells.reserve(numSynapses());
+  permanences.reserve(numSynapses());
+
+  for (const CellData &cellData : cells_) {
+    numSegmentsForCell.push_back(cellData.segments.size());
+    for (Segment segment : cellData.segments) {
+      const vector<Synapse> &synapses = segments_[segment].synapses;
+      numSynapsesForSegment.push_back(synapses.size());
+      for (Synapse synapse : synapses) {
+        presynapticCells.push_back(synapses_[synapse].presynapticCell);
+        permanences.push_back(synapses_[synapse].permanence);
+      }
+    }
+  }
+
+  writer.writeVector(numSegmentsForCell);
+  writer.writeVector(numSynapsesForSegment);
+  writer.writeVector(presynapticCells);
+  writer.writeVector(permanences);
+
+  writer.writeMarker("~NTACONN");
+}
+
+void Connections::loadBinary(const std::string &path) {
+  MappedFile file(path);
+  util::BinaryReader reader(file.data(), file.size());
+  loadBinary(reader);
+}
+
+void Connections::loadBinary(util::BinaryReader &reader) {
+  reader.readMarker("NTACONNS");
+  const UInt32 version = reader.read<UInt32>();
+  NTA_CHECK(version <= Connections::BINARY_VERSION);
+
+  // Version 1 did not store the number of presynaptic cells; bound it only
+  // by what CellIdx can index.
+  const UInt32 numPresynapticCells = version >= 2
+                                         ? reader.read<UInt32>()
+                                         : std::numeric_limits<CellIdx>::max();
+
+  vector<SegmentIdx> numSegmentsForCell;
+  vector<SynapseIdx> numSynapsesForSegment;
+  vector<CellIdx> presynapticCells;
+  vector<Permanence> permanences;
+  reader.readVector(numSegmentsForCell);
+  reader.readVector(numSynapsesForSegment);
+  reader.readVector(presynapticCells);
+  reader.readVector(permanences);
+  reader.readMarker("~NTACONN");
+
+  UInt64 totalSegments = 0;
+  for (SegmentIdx n : numSegmentsForCell) {
+    totalSegments += n;
+  }
+  UInt64 totalSynapses = 0;
+  for (SynapseIdx n : numSynapsesForSegment) {
+    totalSynapses += n;
+  }
+  NTA_CHECK(totalSegments == numSynapsesForSegment.size());
+  NTA_CHECK(totalSynapses == presynapticCells.size());
+  NTA_CHECK(totalSynapses == permanences.size());
+
+  initialize(numSegmentsForCell.size());
+
+  segments_.resize(totalSegments);
+  synapses_.resize(totalSynapses);
+  presynapticIdxForSynapse_.resize(totalSynapses);
+  segmentOrdinals_.resize(totalSegments);
+  synapseOrdinals_.resize(totalSynapses);
+
+  // Size each presynaptic list up front so the map is filled without any
+  // reallocation.
+  vector<UInt32> numSynapsesForPresynapticCell;
+  for (CellIdx presynapticCell : presynapticCells) {
+    NTA_CHECK(presynapticCell < numPresynapticCells)
+        << "Presynaptic cell " << presynapticCell << " is out of range ("
+        << numPresynapticCells << " cells).";
+    if (presynapticCell >= numSynapsesForPresynapticCell.size()) {
+      numSynapsesForPresynapticCell.resize(presynapticCell + 1, 0);
+    }
+    numSynapsesForPresynapticCell[presynapticCell]++;
+  }
+  synapsesForPresynapticCell_.resize(numSynapsesForPresynapticCell.size());
+  for (CellIdx i = 0; i < numSynapsesForPresynapticCell.size(); i++) {
+    synapsesForPresynapticCell_[i].reserve(numSynapsesForPresynapticCell[i]);
+  }
+
+  Segment segment = 0;
+  UInt32 synapse = 0;
+  for (CellIdx cell = 0; cell < cells_.size(); cell++) {
+    CellData &cellData = cells_[cell];
+    cellData.segments.resize(numSegmentsForCell[cell]);
+
+    for (Segment &cellSegment : cellData.segments) {
+      SegmentData &segmentData = segments_[segment];
+      segmentData.cell = cell;
+      segmentData.synapses.resize(numSynapsesForSegment[segment]);
+      segmentOrdinals_[segment] = nextSegmentOrdinal_++;
+      cellSegment = segment;
+
+      for (Synapse &segmentSynapse : segmentData.synapses) {
+        SynapseData &synapseData = synapses_[synapse];
+        synapseData.presynapticCell = presynapticCells[synapse];
+        synapseData.permanence = permanences[synapse];
+        synapseData.segment = segment;
+        synapseOrdinals_[synapse] = nextSynapseOrdinal_++;
+        segmentSynapse = {synapse};
+
+        addSynapseToPresynapticMap_(segmentSynapse);
+        synapse++;
+      }
+      segment++;
+    }
+  }
+}
+
 void Connections::read(ConnectionsProto::Reader &proto) {
   // Check the saved version.
   UInt version = proto.getVersion();
@@ -527,9 +731,10 @@ void Connections::read(ConnectionsProto::Reader &proto) {
         Synapse synapse = {(UInt32)synapses_.size()};
         synapses_.push_back(synapseData);
         synapseOrdinals_.push_back(nextSynapseOrdinal_++);
+        presynapticIdxForSynapse_.push_back(0);
         segmentData.synapses.push_back(synapse);
 
-        synapsesForPresynapticCell_[presynapticCell].push_back(synapse);
+        addSynapseToPresynapticMap_(synapse);
       }
     }
   }
@@ -594,32 +799,36 @@ bool Connections::operator==(const Connections &other) const {
     }
   }
 
-  if (synapsesForPresynapticCell_.size() !=
-      other.synapsesForPresynapticCell_.size())
-    return false;
-
-  for (auto i = synapsesForPresynapticCell_.begin();
-       i != synapsesForPresynapticCell_.end(); ++i) {
-    const vector<Synapse> &synapses = i->second;
-    const vector<Synapse> &otherSynapses =
-        other.synapsesForPresynapticCell_.at(i->first);
+  // The presynaptic lists are compacted by moving the last synapse into each
+  // hole, so their order depends on history. Compare them as multisets.
+  const size_t numPresynapticCells =
+      std::max(synapsesForPresynapticCell_.size(),
+               other.synapsesForPresynapticCell_.size());
+  vector<CellIdx> cells, otherCells;
+  for (size_t i = 0; i < numPresynapticCells; ++i) {
+    cells.clear();
+    otherCells.clear();
+
+    if (i < synapsesForPresynapticCell_.size()) {
+      for (const PresynapticSynapseData &presynapticSynapse :
+           synapsesForPresynapticCell_[i]) {
+        cells.push_back(segments_[presynapticSynapse.segment].cell);
+      }
+    }
+    if (i < other.synapsesForPresynapticCell_.size()) {
+      for (const PresynapticSynapseData &presynapticSynapse :
+           other.synapsesForPresynapticCell_[i]) {
+        otherCells.push_back(other.segments_[presynapticSynapse.segment].cell);
+      }
+    }
 
-    if (synapses.size() != otherSynapses.size())
+    if (cells.size() != otherCells.size())
       return false;
 
-    for (SynapseIdx j = 0; j < synapses.size(); ++j) {
-      Synapse synapse = synapses[j];
-      const SynapseData &synapseData = synapses_[synapse];
-      const SegmentData &segmentData = segments_[synapseData.segment];
-      Synapse otherSynapse = otherSynapses[j];
-      const SynapseData &otherSynapseData = other.synapses_[otherSynapse];
-      const SegmentData &otherSegmentData =
-          other.segments_[otherSynapseData.segment];
-
-      if (segmentData.cell != otherSegmentData.cell) {
-        return false;
-      }
-    }
+    std::sort(cells.begin(), cells.end());
+    std::sort(otherCells.begin(), otherCells.end());
+    if (cells != otherCells)
+      return false;
   }
 
   return true;
@@ -38,6 +38,10 @@
 
 namespace nupic {
 
+namespace util {
+class BinaryReader;
+}
+
 namespace algorithms {
 
 namespace connections {
@@ -118,6 +122,30 @@ struct CellData {
   std::vector<Segment> segments;
 };
 
+/**
+ * PresynapticSynapseData class used in Connections.
+ *
+ * @b Description
+ * An entry in a presynaptic cell's list of outgoing synapses. It duplicates
+ * the synapse's segment and permanence so that computing segment activity can
+ * stream through one contiguous array per cell instead of looking up each
+ * synapse's SynapseData.
+ *
+ * @param synapse
+ * The synapse that this entry refers to.
+ *
+ * @param segment
+ * Segment that the synapse is on.
+ *
+ * @param permanence
+ * Permanence of synapse.
+ */
+struct PresynapticSynapseData {
+  Synapse synapse;
+  Segment segment;
+  Permanence permanence;
+};
+
 /**
  * A base class for Connections event handlers.
  *
@@ -186,6 +214,7 @@ public:
 class Connections : public Serializable<ConnectionsProto> {
 public:
   static const UInt16 VERSION = 2;
+  static const UInt32 BINARY_VERSION = 2;
 
   /**
    * Connections empty constructor.
@@ -393,6 +422,39 @@ public:
                   const std::vector<CellIdx> &activePresynapticCells,
                   Permanence connectedPermanence) const;
 
+  /**
+   * Compute the segment excitations for a vector of active presynaptic
+   * cells, and list the segments that receive any input.
+   *
+   * The output count vectors aren't grown or cleared. They must be
+   * preinitialized with the length returned by
+   * getSegmentFlatVectorLength() and hold zero for every segment. Callers
+   * that keep them between steps only need to zero the segments listed in
+   * the previous touchedSegments, rather than the whole vectors.
+   *
+   * @param numActiveConnectedSynapsesForSegment
+   * An output vector for active connected synapse counts per segment.
+   *
+   * @param numActivePotentialSynapsesForSegment
+   * An output vector for active potential synapse counts per segment.
+   *
+   * @param touchedSegments
+   * An output vector, replaced by the segments with at least one active
+   * potential synapse, in no particular order.
+   *
+   * @param activePresynapticCells
+   * Active cells in the input.
+   *
+   * @param connectedPermanence
+   * Minimum permanence for a synapse to be "connected".
+   */
+  void
+  computeActivity(std::vector<UInt32> &numActiveConnectedSynapsesForSegment,
+                  std::vector<UInt32> &numActivePotentialSynapsesForSegment,
+                  std::vector<Segment> &touchedSegments,
+                  const std::vector<CellIdx> &activePresynapticCells,
+                  Permanence connectedPermanence) const;
+
   /**
    * Compute the segment excitations for a single active presynaptic cell.
    *
@@ -450,6 +512,25 @@ public:
    */
   virtual void read(ConnectionsProto::Reader &proto) override;
 
+  /**
+   * Saves a little-endian binary snapshot to output stream. The per-cell
+   * segment counts, per-segment synapse counts, presynaptic cells and
+   * permanences are each written as one flat array.
+   */
+  void saveBinary(std::ostream &outStream) const;
+
+  /**
+   * Loads a binary snapshot from a file through a read-only memory map.
+   */
+  void loadBinary(const std::string &path);
+
+#ifndef SWIG
+  /**
+   * Loads a binary snapshot from a buffer, leaving the reader just past it.
+   */
+  void loadBinary(util::BinaryReader &reader);
+#endif
+
   // Debugging
 
   /**
@@ -545,9 +626,19 @@ protected:
    */
   bool synapseExists_(Synapse synapse) const;
 
+  /**
+   * Add a synapse to synapsesForPresynapticCell_.
+   *
+   * @param Synapse
+   */
+  void addSynapseToPresynapticMap_(Synapse synapse);
+
   /**
    * Remove a synapse from synapsesForPresynapticCell_.
    *
+   * The presynaptic cell's last synapse is moved into the vacated slot, so
+   * each cell's list stays dense.
+   *
    * @param Synapse
    */
   void removeSynapseFromPresynapticMap_(Synapse synapse);
@@ -559,8 +650,11 @@ private:
   std::vector<SynapseData> synapses_;
   std::vector<Synapse> destroyedSynapses_;
 
-  // Extra bookkeeping for faster computing of segment activity.
-  std::map<CellIdx, std::vector<Synapse>> synapsesForPresynapticCell_;
+  // Extra bookkeeping for faster computing of segment activity. Indexed by
+  // presynaptic cell and grown on demand. presynapticIdxForSynapse_ holds
+  // each synapse's position in its presynaptic cell's list.
+  std::vector<std::vector<PresynapticSynapseData>> synapsesForPresynapticCell_;
+  std::vector<UInt32> presynapticIdxForSynapse_;
 
   std::vector<UInt64> segmentOrdinals_;
   std::vector<UInt64> synapseOrdinals_;
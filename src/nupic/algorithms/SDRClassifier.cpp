@@ -20,9 +20,12 @@
  * ---------------------------------------------------------------------
  */
 
+#include <algorithm>
 #include <cmath>
 #include <deque>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <limits>
 #include <map>
 #include <sstream>
@@ -34,6 +37,11 @@
 #include <capnp/serialize.h>
 #include <kj/std/iostream.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NTA_SDR_CLASSIFIER_SSE2
+#endif
+
 #include <nupic/algorithms/ClassifierResult.hpp>
 #include <nupic/algorithms/SDRClassifier.hpp>
 #include <nupic/math/ArrayAlgo.hpp>
@@ -46,12 +54,161 @@ namespace nupic {
 namespace algorithms {
 namespace sdr_classifier {
 
+// Rows of the weight tensor are padded to a multiple of this many weights,
+// which is a whole number of cache lines for either weight type.
+static const UInt bucketAlignment = 64 / sizeof(Real32);
+
+#ifdef NTA_SDR_CLASSIFIER_SSE2
+// The SSE2 operations used by the kernels below, for each weight type.
+template <typename T> struct Sse2;
+
+template <> struct Sse2<Real64> {
+  typedef __m128d Vec;
+  static const UInt width = 2;
+
+  static Vec load(const Real64 *p) { return _mm_loadu_pd(p); }
+  static void store(Real64 *p, Vec v) { _mm_storeu_pd(p, v); }
+  static Vec set1(Real64 x) { return _mm_set1_pd(x); }
+  static Vec add(Vec a, Vec b) { return _mm_add_pd(a, b); }
+  static Vec mul(Vec a, Vec b) { return _mm_mul_pd(a, b); }
+  static Vec div(Vec a, Vec b) { return _mm_div_pd(a, b); }
+  static Vec max(Vec a, Vec b) { return _mm_max_pd(a, b); }
+
+  // Zeroes the lanes whose magnitude is at most eps.
+  static Vec threshold(Vec v, Vec eps) {
+    const Vec small = _mm_cmple_pd(_mm_andnot_pd(_mm_set1_pd(-0.0), v), eps);
+    return _mm_andnot_pd(small, v);
+  }
+
+  static Real64 hmax(Vec v) {
+    return std::max(_mm_cvtsd_f64(v), _mm_cvtsd_f64(_mm_unpackhi_pd(v, v)));
+  }
+};
+
+template <> struct Sse2<Real32> {
+  typedef __m128 Vec;
+  static const UInt width = 4;
+
+  static Vec load(const Real32 *p) { return _mm_loadu_ps(p); }
+  static void store(Real32 *p, Vec v) { _mm_storeu_ps(p, v); }
+  static Vec set1(Real32 x) { return _mm_set1_ps(x); }
+  static Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+  static Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+  static Vec div(Vec a, Vec b) { return _mm_div_ps(a, b); }
+  static Vec max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+
+  // Zeroes the lanes whose magnitude is at most eps.
+  static Vec threshold(Vec v, Vec eps) {
+    const Vec small = _mm_cmple_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), v), eps);
+    return _mm_andnot_ps(small, v);
+  }
+
+  static Real32 hmax(Vec v) {
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+  }
+};
+#endif
+
+// y[i] += x[i]
+template <typename T> static void addRow(T *y, const T *x, UInt n) {
+  UInt i = 0;
+#ifdef NTA_SDR_CLASSIFIER_SSE2
+  typedef Sse2<T> S;
+  for (; i + S::width <= n; i += S::width) {
+    S::store(y + i, S::add(S::load(y + i), S::load(x + i)));
+  }
+#endif
+  for (; i < n; ++i) {
+    y[i] += x[i];
+  }
+}
+
+// w[i] = w[i] + alpha * e[i], zeroing the weights that fall within
+// nupic::Epsilon of zero. This is Dense::axby with a == 1.
+template <typename T>
+static void updateRow(T *w, const T *e, T alpha, UInt n) {
+  const T epsilon = nupic::Epsilon;
+  UInt i = 0;
+#ifdef NTA_SDR_CLASSIFIER_SSE2
+  typedef Sse2<T> S;
+  const typename S::Vec a = S::set1(alpha);
+  const typename S::Vec eps = S::set1(epsilon);
+  for (; i + S::width <= n; i += S::width) {
+    const typename S::Vec v =
+        S::add(S::load(w + i), S::mul(a, S::load(e + i)));
+    S::store(w + i, S::threshold(v, eps));
+  }
+#endif
+  for (; i < n; ++i) {
+    w[i] = w[i] + alpha * e[i];
+    if (std::fabs(w[i]) <= epsilon) {
+      w[i] = 0;
+    }
+  }
+}
+
+// In-place softmax. The max and the final division are vectorized; exp and
+// the sum stay scalar and sequential so that the result does not depend on
+// whether SSE2 is available.
+//
+// Only the elements up to the first maximum are shifted by it. The original
+// loop subtracted through an iterator to the maximum, which became zero
+// once reached, and trained models depend on that.
+template <typename T> static void softmaxRow(T *x, UInt n) {
+  if (n == 0) {
+    return;
+  }
+
+  T max = x[0];
+  UInt i = 1;
+#ifdef NTA_SDR_CLASSIFIER_SSE2
+  typedef Sse2<T> S;
+  if (n >= 2 * S::width) {
+    typename S::Vec m = S::max(S::load(x), S::load(x + S::width));
+    for (i = 2 * S::width; i + S::width <= n; i += S::width) {
+      m = S::max(m, S::load(x + i));
+    }
+    max = S::hmax(m);
+  }
+#endif
+  for (; i < n; ++i) {
+    if (max < x[i]) {
+      max = x[i];
+    }
+  }
+
+  const UInt maxIdx = (UInt)(std::find(x, x + n, max) - x);
+  for (i = 0; i <= maxIdx; ++i) {
+    x[i] -= max;
+  }
+
+  T sum = 0;
+  for (i = 0; i < n; ++i) {
+    x[i] = std::exp(x[i]);
+    sum += x[i];
+  }
+
+  i = 0;
+#ifdef NTA_SDR_CLASSIFIER_SSE2
+  const typename S::Vec s = S::set1(sum);
+  for (; i + S::width <= n; i += S::width) {
+    S::store(x + i, S::div(S::load(x + i), s));
+  }
+#endif
+  for (; i < n; ++i) {
+    x[i] /= sum;
+  }
+}
+
 SDRClassifier::SDRClassifier(const vector<UInt> &steps, Real64 alpha,
-                             Real64 actValueAlpha, UInt verbosity)
+                             Real64 actValueAlpha, UInt verbosity,
+                             bool useFloat32)
     : steps_(steps), alpha_(alpha), actValueAlpha_(actValueAlpha),
-      maxInputIdx_(0), maxBucketIdx_(0), actualValues_({0.0}),
-      actualValuesSet_({false}), version_(sdrClassifierVersion),
-      verbosity_(verbosity) {
+      bucketStride_(0), useFloat32_(useFloat32), maxInputIdx_(0),
+      maxBucketIdx_(0), actualValues_({0.0}), actualValuesSet_({false}),
+      version_(sdrClassifierVersion), verbosity_(verbosity) {
   sort(steps_.begin(), steps_.end());
   if (steps_.size() > 0) {
     maxSteps_ = steps_.at(steps_.size() - 1) + 1;
@@ -60,16 +217,11 @@ SDRClassifier::SDRClassifier(const vector<UInt> &steps, Real64 alpha,
   }
 
   // TODO: insert maxBucketIdx / maxInputIdx hint as parameter?
-  // There can be great overhead reallocating the array every time a new
-  // input is seen, especially if we start at (0, 0). The client will
-  // usually know what is the final maxInputIdx (typically the number
-  // of columns?), and we can have heuristics using the encoder's
-  // settings to get an good approximate of the maxBucketIdx, thus having
-  // to reallocate this matrix only a few times, even never if we use
-  // lower bounds
-  for (const auto &step : steps_) {
-    weightMatrix_.emplace(step, Matrix(maxInputIdx_ + 1, maxBucketIdx_ + 1));
-  }
+  // New inputs only append rows to the weight tensor, and new buckets
+  // relayout it only when they overflow the row stride, which grows
+  // geometrically. A hint would still let the client skip the first few
+  // relayouts.
+  growWeights_();
 }
 
 SDRClassifier::~SDRClassifier() {}
@@ -102,10 +254,7 @@ void SDRClassifier::compute(UInt recordNum, const vector<UInt> &patternNZ,
     UInt maxInputIdx = *max_element(patternNZ.begin(), patternNZ.end());
     if (maxInputIdx > maxInputIdx_) {
       maxInputIdx_ = maxInputIdx;
-      for (const auto &step : steps_) {
-        Matrix &weights = weightMatrix_.at(step);
-        weights.resize(maxInputIdx_ + 1, maxBucketIdx_ + 1);
-      }
+      growWeights_();
     }
   }
 
@@ -123,10 +272,7 @@ void SDRClassifier::compute(UInt recordNum, const vector<UInt> &patternNZ,
       // matrix with zero-padding
       if (bucketIdx > maxBucketIdx_) {
         maxBucketIdx_ = bucketIdx;
-        for (const auto &step : steps_) {
-          Matrix &weights = weightMatrix_.at(step);
-          weights.resize(maxInputIdx_ + 1, maxBucketIdx_ + 1);
-        }
+        growWeights_();
       }
 
       // update rolling averages of bucket values
@@ -149,16 +295,17 @@ void SDRClassifier::compute(UInt recordNum, const vector<UInt> &patternNZ,
     for (auto learnRecord = recordNumHistory_.begin();
          learnRecord != recordNumHistory_.end();
          learnRecord++, patternIteration++) {
-      const vector<UInt> learnPatternNZ = *patternIteration;
+      const vector<UInt> &learnPatternNZ = *patternIteration;
       const UInt nSteps = recordNum - *learnRecord;
 
       // update weights
       if (binary_search(steps_.begin(), steps_.end(), nSteps)) {
-        vector<Real64> error =
-            calculateError_(bucketIdxList, learnPatternNZ, nSteps);
-        Matrix &weights = weightMatrix_.at(nSteps);
-        for (auto &bit : learnPatternNZ) {
-          weights.axby(bit, 1.0, alpha_, error);
+        const UInt stepIdx = stepIndex_(nSteps);
+        if (useFloat32_) {
+          learn_(weights32_, error32_, bucketIdxList, learnPatternNZ,
+                 stepIdx);
+        } else {
+          learn_(weights_, error_, bucketIdxList, learnPatternNZ, stepIdx);
         }
       }
     }
@@ -195,52 +342,130 @@ void SDRClassifier::infer_(const vector<UInt> &patternNZ,
     }
   }
 
+  const UInt numBuckets = maxBucketIdx_ + 1;
   for (auto nSteps = steps_.begin(); nSteps != steps_.end(); ++nSteps) {
     vector<Real64> *likelihoods =
-        result->createVector(*nSteps, maxBucketIdx_ + 1, 0.0);
-    for (auto &bit : patternNZ) {
-      const Matrix &weights = weightMatrix_.at(*nSteps);
-      add(likelihoods->begin(), likelihoods->end(), weights.begin(bit),
-          weights.begin(bit + 1));
+        result->createVector(*nSteps, numBuckets, 0.0);
+    const UInt stepIdx = stepIndex_(*nSteps);
+    if (useFloat32_) {
+      likelihoods32_.assign(numBuckets, 0.0f);
+      computeLikelihoods_(weights32_, patternNZ, stepIdx,
+                          likelihoods32_.data());
+      copy(likelihoods32_.begin(), likelihoods32_.end(),
+           likelihoods->begin());
+    } else {
+      computeLikelihoods_(weights_, patternNZ, stepIdx, likelihoods->data());
     }
-    softmax_(likelihoods->begin(), likelihoods->end());
   }
 }
 
-vector<Real64> SDRClassifier::calculateError_(const vector<UInt> &bucketIdxList,
-                                              const vector<UInt> patternNZ,
-                                              UInt step) {
-  // compute predicted likelihoods
-  vector<Real64> likelihoods(maxBucketIdx_ + 1, 0);
-
+template <typename T>
+void SDRClassifier::computeLikelihoods_(
+    const vector<T, util::AlignedAllocator<T>> &weights,
+    const vector<UInt> &patternNZ, UInt stepIdx, T *likelihoods) const {
+  const UInt numBuckets = maxBucketIdx_ + 1;
   for (auto &bit : patternNZ) {
-    const Matrix &weights = weightMatrix_.at(step);
-    add(likelihoods.begin(), likelihoods.end(), weights.begin(bit),
-        weights.begin(bit + 1));
+    addRow(likelihoods, weightRow_(weights, bit, stepIdx), numBuckets);
   }
-  softmax_(likelihoods.begin(), likelihoods.end());
+  softmaxRow(likelihoods, numBuckets);
+}
 
-  // compute target likelihoods
-  vector<Real64> targetDistribution(maxBucketIdx_ + 1, 0.0);
-  Real64 numCategories = (Real64)bucketIdxList.size();
-  for (size_t i = 0; i < bucketIdxList.size(); i++)
-    targetDistribution[bucketIdxList[i]] = 1.0 / numCategories;
+template <typename T>
+void SDRClassifier::learn_(vector<T, util::AlignedAllocator<T>> &weights,
+                           vector<T> &error,
+                           const vector<UInt> &bucketIdxList,
+                           const vector<UInt> &patternNZ, UInt stepIdx) {
+  // compute predicted likelihoods
+  const UInt numBuckets = maxBucketIdx_ + 1;
+  error.assign(numBuckets, 0);
+  computeLikelihoods_(weights, patternNZ, stepIdx, error.data());
 
-  axby(-1.0, likelihoods, 1.0, targetDistribution);
-  return likelihoods;
+  // subtract them from the target likelihoods. 0 - x rather than -x keeps
+  // the sign of zeros the same as in target - x.
+  for (UInt i = 0; i < numBuckets; ++i) {
+    error[i] = 0 - error[i];
+  }
+  const T target = (T)(1.0 / (Real64)bucketIdxList.size());
+  for (size_t i = 0; i < bucketIdxList.size(); i++) {
+    const auto begin = bucketIdxList.begin();
+    if (find(begin, begin + i, bucketIdxList[i]) == begin + i) {
+      error[bucketIdxList[i]] += target;
+    }
+  }
+
+  // update the weights of the active bits
+  for (auto &bit : patternNZ) {
+    updateRow(weightRow_(weights, bit, stepIdx), error.data(), (T)alpha_,
+              numBuckets);
+  }
 }
 
 void SDRClassifier::softmax_(vector<Real64>::iterator begin,
                              vector<Real64>::iterator end) {
-  vector<Real64>::iterator maxItr = max_element(begin, end);
-  for (auto itr = begin; itr != end; ++itr) {
-    *itr -= *maxItr;
+  if (begin != end) {
+    softmaxRow(&*begin, (UInt)(end - begin));
+  }
+}
+
+void SDRClassifier::growWeights_() {
+  const UInt numBuckets = maxBucketIdx_ + 1;
+  UInt stride = bucketStride_;
+  if (numBuckets > stride) {
+    // Widen the rows. Doubling the stride keeps the number of relayouts
+    // logarithmic in the number of buckets.
+    stride = max(2 * bucketStride_, numBuckets);
+    stride = (stride + bucketAlignment - 1) / bucketAlignment * bucketAlignment;
   }
-  range_exp(1.0, begin, end);
-  Real64 sum = accumulate(begin, end, 0.0);
-  for (auto itr = begin; itr != end; ++itr) {
-    *itr /= sum;
+
+  if (useFloat32_) {
+    resizeWeights_(weights32_, stride);
+  } else {
+    resizeWeights_(weights_, stride);
   }
+  bucketStride_ = stride;
+}
+
+template <typename T>
+void SDRClassifier::resizeWeights_(
+    vector<T, util::AlignedAllocator<T>> &weights, UInt stride) const {
+  const size_t numRows = (size_t)(maxInputIdx_ + 1) * steps_.size();
+  if (stride == bucketStride_) {
+    weights.resize(numRows * stride, 0);
+    return;
+  }
+
+  vector<T, util::AlignedAllocator<T>> resized(numRows * stride, 0);
+  const size_t oldRows =
+      bucketStride_ > 0 ? weights.size() / bucketStride_ : 0;
+  for (size_t row = 0; row < oldRows; ++row) {
+    copy(weights.begin() + row * bucketStride_,
+         weights.begin() + (row + 1) * bucketStride_,
+         resized.begin() + row * stride);
+  }
+  weights.swap(resized);
+}
+
+Real64 SDRClassifier::getWeight_(UInt bit, UInt stepIdx, UInt bucket) const {
+  if (useFloat32_) {
+    return weightRow_(weights32_, bit, stepIdx)[bucket];
+  }
+  return weightRow_(weights_, bit, stepIdx)[bucket];
+}
+
+void SDRClassifier::setWeight_(UInt bit, UInt stepIdx, UInt bucket,
+                               Real64 weight) {
+  if (useFloat32_) {
+    weightRow_(weights32_, bit, stepIdx)[bucket] = (Real32)weight;
+  } else {
+    weightRow_(weights_, bit, stepIdx)[bucket] = weight;
+  }
+}
+
+UInt SDRClassifier::stepIndex_(UInt step) const {
+  auto it = lower_bound(steps_.begin(), steps_.end(), step);
+  NTA_CHECK(it != steps_.end() && *it == step)
+      << "SDRClassifier: unknown prediction step " << step;
+  return (UInt)(it - steps_.begin());
 }
 
 UInt SDRClassifier::version() const { return version_; }
@@ -251,15 +476,21 @@ void SDRClassifier::setVerbosity(UInt verbosity) { verbosity_ = verbosity; }
 
 UInt SDRClassifier::getAlpha() const { return alpha_; }
 
+bool SDRClassifier::getUseFloat32() const { return useFloat32_; }
+
 void SDRClassifier::save(ostream &outStream) const {
   // Write a starting marker and version.
   outStream << "SDRClassifier" << endl;
-  outStream << version_ << endl;
+  outStream << sdrClassifierVersion << endl;
+
+  // Weights and actual values round-trip exactly.
+  const std::streamsize precision = outStream.precision();
+  outStream << std::setprecision(std::numeric_limits<Real64>::max_digits10);
 
   // Store the simple variables first.
-  outStream << version() << " " << alpha_ << " " << actValueAlpha_ << " "
-            << maxSteps_ << " " << maxBucketIdx_ << " " << maxInputIdx_ << " "
-            << verbosity_ << " " << endl;
+  outStream << sdrClassifierVersion << " " << alpha_ << " " << actValueAlpha_
+            << " " << maxSteps_ << " " << maxBucketIdx_ << " " << maxInputIdx_
+            << " " << verbosity_ << " " << endl;
 
   // V1 additions.
   outStream << recordNumHistory_.size() << " ";
@@ -268,6 +499,9 @@ void SDRClassifier::save(ostream &outStream) const {
   }
   outStream << endl;
 
+  // V2 additions.
+  outStream << useFloat32_ << endl;
+
   // Store the different prediction steps.
   outStream << steps_.size() << " ";
   for (auto &elem : steps_) {
@@ -285,11 +519,19 @@ void SDRClassifier::save(ostream &outStream) const {
   }
   outStream << endl;
 
-  // Store weight matrix
-  outStream << weightMatrix_.size() << " ";
-  for (const auto &elem : weightMatrix_) {
-    outStream << elem.first << " ";
-    outStream << elem.second;
+  // Store the weight matrix of each distinct prediction step
+  vector<UInt> uniqueSteps;
+  unique_copy(steps_.begin(), steps_.end(), back_inserter(uniqueSteps));
+  outStream << uniqueSteps.size() << " ";
+  for (const auto &step : uniqueSteps) {
+    const UInt stepIdx = stepIndex_(step);
+    outStream << step << " ";
+    for (UInt i = 0; i <= maxInputIdx_; ++i) {
+      for (UInt j = 0; j <= maxBucketIdx_; ++j) {
+        outStream << getWeight_(i, stepIdx, j) << " ";
+      }
+      outStream << endl;
+    }
   }
   outStream << endl;
 
@@ -303,6 +545,7 @@ void SDRClassifier::save(ostream &outStream) const {
 
   // Write an ending marker.
   outStream << "~SDRClassifier" << endl;
+  outStream.precision(precision);
 }
 
 void SDRClassifier::load(istream &inStream) {
@@ -312,7 +555,9 @@ void SDRClassifier::load(istream &inStream) {
   patternNZHistory_.clear();
   actualValues_.clear();
   actualValuesSet_.clear();
-  weightMatrix_.clear();
+  weights_.clear();
+  weights32_.clear();
+  bucketStride_ = 0;
 
   // Check the starting marker.
   string marker;
@@ -322,7 +567,7 @@ void SDRClassifier::load(istream &inStream) {
   // Check the version.
   UInt version;
   inStream >> version;
-  NTA_CHECK(version <= 1);
+  NTA_CHECK(version <= 2);
 
   // Load the simple variables.
   inStream >> version_ >> alpha_ >> actValueAlpha_ >> maxSteps_ >>
@@ -330,7 +575,7 @@ void SDRClassifier::load(istream &inStream) {
 
   UInt recordNumHistory;
   UInt curRecordNum;
-  if (version == 1) {
+  if (version >= 1) {
     inStream >> recordNumHistory;
     for (UInt i = 0; i < recordNumHistory; ++i) {
       inStream >> curRecordNum;
@@ -338,6 +583,11 @@ void SDRClassifier::load(istream &inStream) {
     }
   }
 
+  useFloat32_ = false;
+  if (version >= 2) {
+    inStream >> useFloat32_;
+  }
+
   // Load the prediction steps.
   UInt size;
   UInt step;
@@ -359,15 +609,17 @@ void SDRClassifier::load(istream &inStream) {
   }
 
   // Load weight matrix.
+  growWeights_();
   UInt numSteps;
   inStream >> numSteps;
   for (UInt s = 0; s < numSteps; ++s) {
     inStream >> step;
-    // Insert the step to initialize the weight matrix
-    weightMatrix_[step] = Matrix(maxInputIdx_ + 1, maxBucketIdx_ + 1);
+    const UInt stepIdx = stepIndex_(step);
+    Real64 weight;
     for (UInt i = 0; i <= maxInputIdx_; ++i) {
       for (UInt j = 0; j <= maxBucketIdx_; ++j) {
-        inStream >> weightMatrix_[step].at(i, j);
+        inStream >> weight;
+        setWeight_(i, stepIdx, j, weight);
       }
     }
   }
@@ -421,19 +673,32 @@ void SDRClassifier::write(SdrClassifierProto::Builder &proto) const {
   proto.setMaxBucketIdx(maxBucketIdx_);
   proto.setMaxInputIdx(maxInputIdx_);
 
-  auto weightMatrixProtos = proto.initWeightMatrix(weightMatrix_.size());
+  vector<UInt> uniqueSteps;
+  unique_copy(steps_.begin(), steps_.end(), back_inserter(uniqueSteps));
+  auto weightMatrixProtos = proto.initWeightMatrix(uniqueSteps.size());
   UInt k = 0;
-  for (const auto &stepWeightMatrix : weightMatrix_) {
+  for (const auto &step : uniqueSteps) {
+    const UInt stepIdx = stepIndex_(step);
     auto stepWeightMatrixProto = weightMatrixProtos[k];
-    stepWeightMatrixProto.setSteps(stepWeightMatrix.first);
-    auto weightProto = stepWeightMatrixProto.initWeight((maxInputIdx_ + 1) *
-                                                        (maxBucketIdx_ + 1));
+    stepWeightMatrixProto.setSteps(step);
+    const UInt size = (maxInputIdx_ + 1) * (maxBucketIdx_ + 1);
     // flatten weight matrix, serialized as a list of floats
     UInt idx = 0;
-    for (UInt i = 0; i <= maxInputIdx_; ++i) {
-      for (UInt j = 0; j <= maxBucketIdx_; ++j) {
-        weightProto.set(idx, stepWeightMatrix.second.at(i, j));
-        idx++;
+    if (useFloat32_) {
+      auto weightProto = stepWeightMatrixProto.initWeight32(size);
+      for (UInt i = 0; i <= maxInputIdx_; ++i) {
+        for (UInt j = 0; j <= maxBucketIdx_; ++j) {
+          weightProto.set(idx, weightRow_(weights32_, i, stepIdx)[j]);
+          idx++;
+        }
+      }
+    } else {
+      auto weightProto = stepWeightMatrixProto.initWeight(size);
+      for (UInt i = 0; i <= maxInputIdx_; ++i) {
+        for (UInt j = 0; j <= maxBucketIdx_; ++j) {
+          weightProto.set(idx, weightRow_(weights_, i, stepIdx)[j]);
+          idx++;
+        }
       }
     }
     k++;
@@ -452,6 +717,7 @@ void SDRClassifier::write(SdrClassifierProto::Builder &proto) const {
 
   proto.setVersion(version_);
   proto.setVerbosity(verbosity_);
+  proto.setUseFloat32(useFloat32_);
 }
 
 void SDRClassifier::read(SdrClassifierProto::Reader &proto) {
@@ -461,7 +727,9 @@ void SDRClassifier::read(SdrClassifierProto::Reader &proto) {
   patternNZHistory_.clear();
   actualValues_.clear();
   actualValuesSet_.clear();
-  weightMatrix_.clear();
+  weights_.clear();
+  weights32_.clear();
+  bucketStride_ = 0;
 
   for (auto step : proto.getSteps()) {
     steps_.push_back(step);
@@ -487,18 +755,29 @@ void SDRClassifier::read(SdrClassifierProto::Reader &proto) {
   maxBucketIdx_ = proto.getMaxBucketIdx();
   maxInputIdx_ = proto.getMaxInputIdx();
 
+  useFloat32_ = proto.getUseFloat32();
+  growWeights_();
   auto weightMatrixProto = proto.getWeightMatrix();
   for (UInt i = 0; i < weightMatrixProto.size(); ++i) {
     auto stepWeightMatrix = weightMatrixProto[i];
-    UInt steps = stepWeightMatrix.getSteps();
-    weightMatrix_[steps] = Matrix(maxInputIdx_ + 1, maxBucketIdx_ + 1);
-    auto weights = stepWeightMatrix.getWeight();
+    const UInt stepIdx = stepIndex_(stepWeightMatrix.getSteps());
     UInt j = 0;
     // un-flatten weight matrix, serialized as a list of floats
-    for (UInt row = 0; row <= maxInputIdx_; ++row) {
-      for (UInt col = 0; col <= maxBucketIdx_; ++col) {
-        weightMatrix_[steps].at(row, col) = weights[j];
-        j++;
+    if (useFloat32_) {
+      auto weights = stepWeightMatrix.getWeight32();
+      for (UInt row = 0; row <= maxInputIdx_; ++row) {
+        for (UInt col = 0; col <= maxBucketIdx_; ++col) {
+          weightRow_(weights32_, row, stepIdx)[col] = weights[j];
+          j++;
+        }
+      }
+    } else {
+      auto weights = stepWeightMatrix.getWeight();
+      for (UInt row = 0; row <= maxInputIdx_; ++row) {
+        for (UInt col = 0; col <= maxBucketIdx_; ++col) {
+          weightRow_(weights_, row, stepIdx)[col] = weights[j];
+          j++;
+        }
       }
     }
   }
@@ -511,8 +790,10 @@ void SDRClassifier::read(SdrClassifierProto::Reader &proto) {
     actualValuesSet_.push_back(actValueSet);
   }
 
-  version_ = proto.getVersion();
   verbosity_ = proto.getVerbosity();
+
+  // Update the version number, since the state is now the current layout.
+  version_ = sdrClassifierVersion;
 }
 
 bool SDRClassifier::operator==(const SDRClassifier &other) const {
@@ -564,15 +845,13 @@ bool SDRClassifier::operator==(const SDRClassifier &other) const {
     return false;
   }
 
-  if (weightMatrix_.size() != other.weightMatrix_.size()) {
+  if (useFloat32_ != other.useFloat32_) {
     return false;
   }
-  for (auto it = weightMatrix_.begin(); it != weightMatrix_.end(); it++) {
-    Matrix thisWeights = it->second;
-    Matrix otherWeights = other.weightMatrix_.at(it->first);
+  for (UInt s = 0; s < steps_.size(); s++) {
     for (UInt i = 0; i <= maxInputIdx_; ++i) {
       for (UInt j = 0; j <= maxBucketIdx_; ++j) {
-        if (thisWeights.at(i, j) != otherWeights.at(i, j)) {
+        if (getWeight_(i, s, j) != other.getWeight_(i, s, j)) {
           return false;
         }
       }
@@ -38,6 +38,7 @@
 #include <nupic/proto/SdrClassifier.capnp.h>
 #include <nupic/types/Serializable.hpp>
 #include <nupic/types/Types.hpp>
+#include <nupic/utils/AlignedAllocator.hpp>
 
 namespace nupic {
 namespace algorithms {
@@ -46,7 +47,7 @@ typedef cla_classifier::ClassifierResult ClassifierResult;
 
 namespace sdr_classifier {
 
-const UInt sdrClassifierVersion = 1;
+const UInt sdrClassifierVersion = 2;
 
 typedef Dense<UInt, Real64> Matrix;
 
@@ -58,7 +59,7 @@ public:
   /**
    * Constructor for use when deserializing.
    */
-  SDRClassifier() {}
+  SDRClassifier() : bucketStride_(0), useFloat32_(false) {}
 
   /**
    * Constructor.
@@ -68,9 +69,12 @@ public:
    * @param actValueAlpha The alpha to use when decaying the actual
    *                      values for each bucket.
    * @param verbosity The logging verbosity.
+   * @param useFloat32 Whether to keep the weights and compute the
+   *                   likelihoods in 32-bit floats. This halves the memory
+   *                   of the weights at some cost in precision.
    */
   SDRClassifier(const vector<UInt> &steps, Real64 alpha, Real64 actValueAlpha,
-                UInt verbosity);
+                UInt verbosity, bool useFloat32 = false);
 
   /**
    * Destructor.
@@ -115,6 +119,11 @@ public:
    */
   UInt getAlpha() const;
 
+  /**
+   * Whether the weights are kept in 32-bit floats.
+   */
+  bool getUseFloat32() const;
+
   /**
    * Get the size of the string needed for the serialized state.
    */
@@ -163,9 +172,43 @@ private:
   void infer_(const vector<UInt> &patternNZ, const vector<Real64> &actValue,
               ClassifierResult *result);
 
-  // Helper function to compute the error signal in learning mode
-  vector<Real64> calculateError_(const vector<UInt> &bucketIdxList,
-                                 const vector<UInt> patternNZ, UInt step);
+#ifndef SWIG
+  // Helper function to compute the error signal in learning mode and
+  // apply it to the weights of the given step.
+  template <typename T>
+  void learn_(vector<T, util::AlignedAllocator<T>> &weights,
+              vector<T> &error, const vector<UInt> &bucketIdxList,
+              const vector<UInt> &patternNZ, UInt stepIdx);
+
+  // Sums the weight rows of the active bits for one prediction step and
+  // turns the sums into likelihoods with softmax.
+  template <typename T>
+  void computeLikelihoods_(const vector<T, util::AlignedAllocator<T>> &weights,
+                           const vector<UInt> &patternNZ, UInt stepIdx,
+                           T *likelihoods) const;
+
+  // Grows the weight tensor to cover maxInputIdx_ and maxBucketIdx_,
+  // keeping the existing weights and zero filling the new ones.
+  void growWeights_();
+  template <typename T>
+  void resizeWeights_(vector<T, util::AlignedAllocator<T>> &weights,
+                      UInt stride) const;
+
+  // Position of a prediction step in steps_.
+  UInt stepIndex_(UInt step) const;
+
+  // The weights of one input bit for one prediction step.
+  template <typename Weights>
+  auto weightRow_(Weights &weights, UInt bit, UInt stepIdx) const
+      -> decltype(weights.data()) {
+    return weights.data() +
+           ((size_t)bit * steps_.size() + stepIdx) * bucketStride_;
+  }
+
+  // Reads or writes a single weight of whichever tensor is in use.
+  Real64 getWeight_(UInt bit, UInt stepIdx, UInt bucket) const;
+  void setWeight_(UInt bit, UInt stepIdx, UInt bucket, Real64 weight);
+#endif // SWIG
 
   // softmax function
   void softmax_(vector<Real64>::iterator begin, vector<Real64>::iterator end);
@@ -187,8 +230,21 @@ private:
   deque<vector<UInt>> patternNZHistory_;
   deque<UInt> recordNumHistory_;
 
-  // Weight matrices for the classifier (one per prediction step)
-  map<UInt, Matrix> weightMatrix_;
+  // Weights for all prediction steps in one tensor, indexed by input bit,
+  // then position in steps_, then bucket. Each row holds bucketStride_
+  // weights so that rows start on a cache line; the buckets past
+  // maxBucketIdx_ are zero. weights32_ replaces weights_ when useFloat32_
+  // is set.
+  vector<Real64, util::AlignedAllocator<Real64>> weights_;
+  vector<Real32, util::AlignedAllocator<Real32>> weights32_;
+  UInt bucketStride_;
+  bool useFloat32_;
+
+  // Scratch buffers for the error signal and the float likelihoods,
+  // reused between records.
+  vector<Real64> error_;
+  vector<Real32> error32_;
+  vector<Real32> likelihoods32_;
 
   // The highest input bit that the classifier has seen so far.
   UInt maxInputIdx_;
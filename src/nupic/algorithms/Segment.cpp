@@ -51,16 +51,16 @@ void printSynapse(UInt srcCellIdx, UInt nCellsPerCol) {
 
 //----------------------------------------------------------------------
 Segment::Segment(InSynapses _s, Real frequency, bool seqSegFlag,
-                 Real permConnected, UInt iteration)
+                 Real permConnected, UInt iteration, SynapsePool *pool)
     : _totalActivations(1), _positiveActivations(1), _lastActiveIteration(0),
       _lastPosDutyCycle(1.0 / iteration), _lastPosDutyCycleIteration(iteration),
-      _seqSegFlag(seqSegFlag), _frequency(frequency), _synapses(std::move(_s)),
-      _nConnected(0) {
+      _seqSegFlag(seqSegFlag), _frequency(frequency),
+      _synapses(pool), _nConnected(0) {
+  _synapses.assign(std::move(_s));
   for (UInt i = 0; i != _synapses.size(); ++i)
-    if (_synapses[i].permanence() >= permConnected)
+    if (_synapses.permanence(i) >= permConnected)
       ++_nConnected;
 
-  std::sort(_synapses.begin(), _synapses.end(), InSynapseOrder());
   NTA_ASSERT(invariants());
 }
 
@@ -81,6 +81,22 @@ Segment &Segment::operator=(const Segment &o) {
   return *this;
 }
 
+//--------------------------------------------------------------------------------
+Segment &Segment::operator=(Segment &&o) noexcept {
+  if (&o != this) {
+    _seqSegFlag = o._seqSegFlag;
+    _frequency = o._frequency;
+    _synapses = std::move(o._synapses);
+    _nConnected = o._nConnected;
+    _totalActivations = o._totalActivations;
+    _positiveActivations = o._positiveActivations;
+    _lastActiveIteration = o._lastActiveIteration;
+    _lastPosDutyCycle = o._lastPosDutyCycle;
+    _lastPosDutyCycleIteration = o._lastPosDutyCycleIteration;
+  }
+  return *this;
+}
+
 //--------------------------------------------------------------------------------
 bool Segment::operator==(const Segment &other) const {
   if (_totalActivations != other._totalActivations ||
@@ -107,6 +123,16 @@ Segment::Segment(const Segment &o)
   NTA_ASSERT(invariants());
 }
 
+//--------------------------------------------------------------------------------
+Segment::Segment(Segment &&o) noexcept
+    : _totalActivations(o._totalActivations),
+      _positiveActivations(o._positiveActivations),
+      _lastActiveIteration(o._lastActiveIteration),
+      _lastPosDutyCycle(o._lastPosDutyCycle),
+      _lastPosDutyCycleIteration(o._lastPosDutyCycleIteration),
+      _seqSegFlag(o._seqSegFlag), _frequency(o._frequency),
+      _synapses(std::move(o._synapses)), _nConnected(o._nConnected) {}
+
 bool Segment::isActive(const CState &activities, Real permConnected,
                        UInt activationThreshold) const {
   { NTA_ASSERT(invariants()); }
@@ -116,10 +142,12 @@ bool Segment::isActive(const CState &activities, Real permConnected,
   if (_nConnected < activationThreshold)
     return false;
 
+  const UInt *srcCellIdx = _synapses.srcCellIndices();
+  const Real *permanence = _synapses.permanences();
+
   // TODO: maintain nPermConnected incrementally??
   for (UInt i = 0; i != size() && activity < activationThreshold; ++i)
-    if (_synapses[i].permanence() >= permConnected &&
-        activities.isSet(_synapses[i].srcCellIdx()))
+    if (permanence[i] >= permConnected && activities.isSet(srcCellIdx[i]))
       activity++;
 
   return activity >= activationThreshold;
@@ -184,15 +212,16 @@ UInt Segment::computeActivity(const CState &activities, Real permConnected,
   { NTA_ASSERT(invariants()); }
 
   UInt activity = 0;
+  const UInt *srcCellIdx = _synapses.srcCellIndices();
+  const Real *permanence = _synapses.permanences();
 
   if (connectedSynapsesOnly) {
     for (UInt i = 0; i != size(); ++i)
-      if (activities.isSet(_synapses[i].srcCellIdx()) &&
-          (_synapses[i].permanence() >= permConnected))
+      if (activities.isSet(srcCellIdx[i]) && (permanence[i] >= permConnected))
         activity++;
   } else {
     for (UInt i = 0; i != size(); ++i)
-      if (activities.isSet(_synapses[i].srcCellIdx()))
+      if (activities.isSet(srcCellIdx[i]))
         activity++;
   }
 
@@ -201,15 +230,10 @@ UInt Segment::computeActivity(const CState &activities, Real permConnected,
 
 void Segment::addSynapses(const std::set<UInt> &srcCells, Real initStrength,
                           Real permConnected) {
-  auto srcCellIdx = srcCells.begin();
-
-  for (; srcCellIdx != srcCells.end(); ++srcCellIdx) {
-    _synapses.push_back(InSynapse(*srcCellIdx, initStrength));
-    if (initStrength >= permConnected)
-      ++_nConnected;
-  }
+  _synapses.insert(srcCells, initStrength);
+  if (initStrength >= permConnected)
+    _nConnected += srcCells.size();
 
-  sort(_synapses, InSynapseOrder());
   NTA_ASSERT(invariants()); // will catch non-unique synapses
 }
 
@@ -225,18 +249,18 @@ void Segment::decaySynapses(Real decay, std::vector<UInt> &removed,
 
   for (UInt i = 0; i != _synapses.size(); ++i) {
 
-    int wasConnected = (int)(_synapses[i].permanence() >= permConnected);
+    int wasConnected = (int)(_synapses.permanence(i) >= permConnected);
 
-    if (_synapses[i].permanence() < decay) {
+    if (_synapses.permanence(i) < decay) {
 
-      removed.push_back(_synapses[i].srcCellIdx());
+      removed.push_back(_synapses.srcCellIdx(i));
       del.push_back(i);
 
     } else if (doDecay) {
-      _synapses[i].permanence() -= decay;
+      _synapses.permanence(i) -= decay;
     }
 
-    int isConnected = (int)(_synapses[i].permanence() >= permConnected);
+    int isConnected = (int)(_synapses.permanence(i) >= permConnected);
 
     _nConnected += isConnected - wasConnected;
   }
@@ -266,23 +290,23 @@ void Segment::decaySynapses2(Real decay, std::vector<UInt> &removed,
   for (UInt i = 0; i != _synapses.size(); ++i) {
 
     // Remove synapse whose permanence will go to zero or below.
-    if (_synapses[i].permanence() <= decay) {
+    if (_synapses.permanence(i) <= decay) {
 
       // If it was connected, reduce our connected count
-      if (_synapses[i].permanence() >= permConnected)
+      if (_synapses.permanence(i) >= permConnected)
         _nConnected--;
 
       // Add this synapse to list of synapses to be removed
-      removed.push_back(_synapses[i].srcCellIdx());
+      removed.push_back(_synapses.srcCellIdx(i));
       del.push_back(i);
 
     } else {
 
-      _synapses[i].permanence() -= decay;
+      _synapses.permanence(i) -= decay;
 
       // If it was connected and is now below permanence, reduce connected count
-      if ((_synapses[i].permanence() + decay >= permConnected) &&
-          (_synapses[i].permanence() < permConnected))
+      if ((_synapses.permanence(i) + decay >= permConnected) &&
+          (_synapses.permanence(i) < permConnected))
         _nConnected--;
     }
   }
@@ -351,7 +375,7 @@ void Segment::freeNSynapses(UInt numToFree,
     // Put in *segment indices*, not source cell indices
     candidates.push_back(
         InSynapse(inactiveSegmentIndices[i],
-                  _synapses[inactiveSegmentIndices[i]].permanence()));
+                  _synapses.permanence(inactiveSegmentIndices[i])));
   }
 
   // If we need more, choose from active synapses in order of increasing
@@ -362,7 +386,7 @@ void Segment::freeNSynapses(UInt numToFree,
       // Put in *segment indices*, not source cell indices
       candidates.push_back(
           InSynapse(activeSegmentIndices[i],
-                    _synapses[activeSegmentIndices[i]].permanence() + permMax));
+                    _synapses.permanence(activeSegmentIndices[i]) + permMax));
     }
   }
 
@@ -375,7 +399,7 @@ void Segment::freeNSynapses(UInt numToFree,
   del.clear(); // purge residual data
   for (UInt i = 0; i < numToFree; i++) {
     del.push_back(candidates[i].srcCellIdx());
-    UInt cellIdx = _synapses[candidates[i].srcCellIdx()].srcCellIdx();
+    UInt cellIdx = _synapses.srcCellIdx(candidates[i].srcCellIdx());
     removed.push_back(cellIdx);
   }
 
@@ -413,11 +437,11 @@ void Segment::print(std::ostream &outStream, UInt nCellsPerCol) const {
             << _positiveActivations << "/" << _totalActivations << ") ";
   for (UInt i = 0; i != _synapses.size(); ++i) {
     if (nCellsPerCol > 0) {
-      UInt cellIdx = _synapses[i].srcCellIdx();
+      UInt cellIdx = _synapses.srcCellIdx(i);
       UInt col = (UInt)(cellIdx / nCellsPerCol);
       UInt cell = cellIdx - col * nCellsPerCol;
       outStream << "[" << col << "," << cell << "]" << std::setprecision(4)
-                << _synapses[i].permanence() << " ";
+                << _synapses.permanence(i) << " ";
     } else {
       outStream << _synapses[i];
     }
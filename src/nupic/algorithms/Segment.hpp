@@ -31,7 +31,12 @@
 #include <set>
 #include <vector>
 
+#if defined(NTA_COMPILER_MSVC)
+#include <intrin.h> // _BitScanForward64
+#endif
+
 #include <nupic/algorithms/InSynapse.hpp>
+#include <nupic/algorithms/SegmentSynapses.hpp>
 #include <nupic/math/ArrayAlgo.hpp> // is_sorted
 #include <nupic/math/StlIo.hpp>     // binary_save
 #include <nupic/proto/Segment.capnp.h>
@@ -64,9 +69,10 @@
     class to avoid always shuffling the list of segments whenever a segment is
     deleted.
 
-    A Segment stores synapses in an STL vector of InSynapses. Synapses are
-    unique on the segment, and they are kept in order of increasing source cell
-    index for speed of certain operations.
+    A Segment stores its synapses in a SegmentSynapses: parallel arrays of
+    source cell indices and permanences in a slab from the SynapsePool of
+    its Cells4. Synapses are unique on the segment, and they are kept in
+    order of increasing source cell index for speed of certain operations.
 
     There are a list of duty cycle "tiers". These are iteration counts at which
     different alpha values are used to update the duty cycle. This is necessary
@@ -145,6 +151,50 @@ public:
   bool isSet(const UInt cellIdx) const { return _pData[cellIdx] != 0; }
   void set(const UInt cellIdx) { _pData[cellIdx] = 1; }
   void resetAll() { memset(_pData, 0, _nCells); }
+
+  /**
+   * Returns a mask with the high bit of each nonzero byte among the 8 bytes
+   * at p set, and every other bit clear. Assumes a little-endian layout, so
+   * that byte k maps to bits 8k..8k+7.
+   */
+  static UInt64 onMask(const Byte *p) {
+    const UInt64 low7 = 0x7f7f7f7f7f7f7f7fULL;
+    UInt64 word;
+    memcpy(&word, p, sizeof(word));
+    return (((word & low7) + low7) | word) & ~low7;
+  }
+
+  /**
+   * Returns the index of the lowest byte flagged in a nonzero onMask.
+   */
+  static UInt firstOn(UInt64 mask) {
+    NTA_ASSERT(mask != 0);
+#if defined(NTA_COMPILER_MSVC)
+    unsigned long bit;
+    _BitScanForward64(&bit, mask);
+    return (UInt)(bit >> 3);
+#else
+    return (UInt)(__builtin_ctzll(mask) >> 3);
+#endif
+  }
+
+  /**
+   * Calls f(cellIdx) for each cell that is On, in increasing order. Eight
+   * cells are tested at a time and only the On ones are visited, so the
+   * cost is one test per eight Off cells.
+   */
+  template <typename F> void forEachOn(F f) const {
+    const UInt multipleOf8 = 8 * (_nCells / 8);
+    UInt i = 0;
+    for (; i < multipleOf8; i += 8) {
+      for (UInt64 mask = onMask(_pData + i); mask != 0; mask &= mask - 1)
+        f(i + firstOn(mask));
+    }
+    for (; i < _nCells; i++) {
+      if (_pData[i] != 0)
+        f(i);
+    }
+  }
   Byte *arrayPtr() const {
     // We expose the data array to Python.  For objects in derived
     // class CStateIndexed, a Python script can wreak havoc by
@@ -253,6 +303,17 @@ public:
     }
     return _cellsOn; // returns a copy that can be modified
   }
+  /**
+   * Same as cellsOn, but returns a reference instead of a copy. It is
+   * invalidated by the next change to this state.
+   */
+  const std::vector<UInt> &getCellsOn(bool fSorted = false) {
+    if (fSorted && !_isSorted) {
+      std::sort(_cellsOn.begin(), _cellsOn.end());
+      _isSorted = true;
+    }
+    return _cellsOn;
+  }
   void set(const UInt cellIdx) {
     if (!isSet(cellIdx)) {
       CState::set(cellIdx); // call the base class function
@@ -375,7 +436,7 @@ public:
 private:
   bool _seqSegFlag;     // sequence segment flag
   Real _frequency;      // frequency [UNUSED IN LATEST IMPLEMENTATION]
-  InSynapses _synapses; // incoming connections to this segment
+  SegmentSynapses _synapses; // incoming connections to this segment
   UInt _nConnected;     // number of current connected synapses
 
 public:
@@ -387,14 +448,20 @@ public:
 
   //----------------------------------------------------------------------
   Segment(InSynapses _s, Real frequency, bool seqSegFlag, Real permConnected,
-          UInt iteration);
+          UInt iteration, SynapsePool *pool = nullptr);
 
   //-----------------------------------------------------------------------
   Segment(const Segment &o);
 
+  //-----------------------------------------------------------------------
+  Segment(Segment &&o) noexcept;
+
   //-----------------------------------------------------------------------
   Segment &operator=(const Segment &o);
 
+  //-----------------------------------------------------------------------
+  Segment &operator=(Segment &&o) noexcept;
+
   //-----------------------------------------------------------------------
   /**
     Checks that the synapses are unique and sorted in order of increasing
@@ -417,7 +484,7 @@ public:
     indices.clear(); // purge residual data
 
     for (UInt i = 0; i != _synapses.size(); ++i)
-      indices.push_back(_synapses[i].srcCellIdx());
+      indices.push_back(_synapses.srcCellIdx(i));
 
 #ifndef NDEBUG
     if (indices.size() != _synapses.size())
@@ -442,7 +509,7 @@ public:
     //
     UInt nc = 0;
     for (UInt i = 0; i != _synapses.size(); ++i)
-      nc += (_synapses[i].permanence() >= permConnected);
+      nc += (_synapses.permanence(i) >= permConnected);
 
     if (nc != _nConnected) {
       std::cout << "\nConnected stats inconsistent. _nConnected=" << _nConnected
@@ -457,6 +524,7 @@ public:
    * Various accessors
    */
   inline bool empty() const { return _synapses.empty(); }
+  inline void setSynapsePool(SynapsePool *pool) { _synapses.setPool(pool); }
   inline UInt size() const { return _synapses.size(); }
   inline bool isSequenceSegment() const { return _seqSegFlag; }
   inline Real &frequency() { return _frequency; }
@@ -483,9 +551,9 @@ public:
     UInt hi = _synapses.size();
     while (lo < hi) {
       const UInt test = (lo + hi) / 2;
-      if (_synapses[test].srcCellIdx() < srcCellIdx)
+      if (_synapses.srcCellIdx(test) < srcCellIdx)
         lo = test + 1;
-      else if (_synapses[test].srcCellIdx() > srcCellIdx)
+      else if (_synapses.srcCellIdx(test) > srcCellIdx)
         hi = test;
       else
         return true;
@@ -503,7 +571,7 @@ public:
   inline void setPermanence(UInt idx, Real val) {
     NTA_ASSERT(idx < _synapses.size());
 
-    _synapses[idx].permanence() = val;
+    _synapses.permanence(idx) = val;
   }
 
   //-----------------------------------------------------------------------
@@ -512,9 +580,9 @@ public:
    */
   inline Real getPermanence(UInt idx) const {
     NTA_ASSERT(idx < _synapses.size());
-    NTA_ASSERT(0 <= _synapses[idx].permanence());
+    NTA_ASSERT(0 <= _synapses.permanence(idx));
 
-    return _synapses[idx].permanence();
+    return _synapses.permanence(idx);
   }
 
   //-----------------------------------------------------------------------
@@ -523,7 +591,7 @@ public:
    */
   inline UInt getSrcCellIdx(UInt idx) const {
     NTA_ASSERT(idx < _synapses.size());
-    return _synapses[idx].srcCellIdx();
+    return _synapses.srcCellIdx(idx);
   }
 
   //-----------------------------------------------------------------------
@@ -536,9 +604,8 @@ public:
    */
   inline void getSrcCellIndices(std::vector<UInt> &srcCells) const {
     NTA_ASSERT(srcCells.size() == 0);
-    for (auto &elem : _synapses) {
-      srcCells.push_back(elem.srcCellIdx());
-    }
+    srcCells.insert(srcCells.end(), _synapses.srcCellIndices(),
+                    _synapses.srcCellIndices() + _synapses.size());
   }
 
   //-----------------------------------------------------------------------
@@ -549,14 +616,13 @@ public:
    */
   inline void clear() {
     _synapses.clear();
-    _synapses.resize(0);
     _seqSegFlag = false;
     _frequency = 0;
     _nConnected = 0;
   }
 
   //-----------------------------------------------------------------------
-  inline const InSynapse &operator[](UInt idx) const {
+  inline InSynapse operator[](UInt idx) const {
     NTA_ASSERT(idx < size());
     return _synapses[idx];
   }
@@ -588,7 +654,7 @@ public:
   void recomputeConnected(Real permConnected) {
     _nConnected = 0;
     for (UInt i = 0; i != _synapses.size(); ++i)
-      if (_synapses[i].permanence() >= permConnected)
+      if (_synapses.permanence(i) >= permConnected)
         ++_nConnected;
   }
 
@@ -604,23 +670,7 @@ private:
   inline void _removeSynapses(const std::vector<UInt> &del) {
     // TODO: check what happens if synapses doesn't exist anymore
     // because of decay
-    UInt i = 0, idel = 0, j = 0;
-
-    while (i < _synapses.size() && idel < del.size()) {
-      if (i == del[idel]) {
-        ++i;
-        ++idel;
-      } else if (i < del[idel]) {
-        _synapses[j++] = _synapses[i++];
-      } else if (del[idel] < i) {
-        NTA_CHECK(false); // Synapses have to be sorted!
-      }
-    }
-
-    while (i < _synapses.size())
-      _synapses[j++] = _synapses[i++];
-
-    _synapses.resize(j);
+    _synapses.erase(del);
   }
 
 public:
@@ -655,13 +705,13 @@ public:
 
     while (i1 < size() && i2 < synapses.size()) {
 
-      if (_synapses[i1].srcCellIdx() == synapses[i2]) {
+      if (_synapses.srcCellIdx(i1) == synapses[i2]) {
 
         Real oldPerm = getPermanence(i1);
         Real newPerm = std::min(oldPerm + delta, permMax);
 
         if (newPerm <= 0) {
-          removed.push_back(_synapses[i1].srcCellIdx());
+          removed.push_back(_synapses.srcCellIdx(i1));
           del.push_back(i1);
         }
 
@@ -675,7 +725,7 @@ public:
         ++i1;
         ++i2;
 
-      } else if (_synapses[i1].srcCellIdx() < synapses[i2]) {
+      } else if (_synapses.srcCellIdx(i1) < synapses[i2]) {
         ++i1;
       } else {
         ++i2;
@@ -828,8 +878,8 @@ public:
     auto synapsesProto = proto.initSynapses(size());
     for (UInt i = 0; i < size(); ++i) {
       auto inSynapseProto = synapsesProto[i];
-      inSynapseProto.setSrcCellIdx(_synapses[i].srcCellIdx());
-      inSynapseProto.setPermanence(_synapses[i].permanence());
+      inSynapseProto.setSrcCellIdx(_synapses.srcCellIdx(i));
+      inSynapseProto.setPermanence(_synapses.permanence(i));
     }
   }
 
@@ -845,9 +895,10 @@ public:
     _lastPosDutyCycle = proto.getLastPosDutyCycle();
     _lastPosDutyCycleIteration = proto.getLastPosDutyCycleIteration();
     _synapses.clear();
+    _synapses.reserve(proto.getSynapses().size());
     for (auto inSynapseProto : proto.getSynapses()) {
-      _synapses.emplace_back(inSynapseProto.getSrcCellIdx(),
-                             inSynapseProto.getPermanence());
+      _synapses.push_back(inSynapseProto.getSrcCellIdx(),
+                          inSynapseProto.getPermanence());
     }
   }
 
@@ -858,7 +909,12 @@ public:
               << _nConnected << ' ' << _totalActivations << ' '
               << _positiveActivations << ' ' << _lastActiveIteration << ' '
               << _lastPosDutyCycle << ' ' << _lastPosDutyCycleIteration << ' ';
-    binary_save(outStream, _synapses);
+    // Same layout as the former std::vector<InSynapse>
+    std::vector<InSynapse> synapses;
+    synapses.reserve(size());
+    for (UInt i = 0; i != size(); ++i)
+      synapses.push_back(_synapses[i]);
+    binary_save(outStream, synapses);
     outStream << ' ';
   }
 
@@ -868,9 +924,13 @@ public:
     inStream >> n >> _seqSegFlag >> _frequency >> _nConnected >>
         _totalActivations >> _positiveActivations >> _lastActiveIteration >>
         _lastPosDutyCycle >> _lastPosDutyCycleIteration;
-    _synapses.resize(n);
+    std::vector<InSynapse> synapses(n);
     inStream.ignore(1);
-    binary_load(inStream, _synapses);
+    binary_load(inStream, synapses);
+    _synapses.clear();
+    _synapses.reserve(n);
+    for (const InSynapse &synapse : synapses)
+      _synapses.push_back(synapse.srcCellIdx(), synapse.permanence());
     NTA_ASSERT(invariants());
   }
 
@@ -0,0 +1,296 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <nupic/algorithms/SegmentSynapses.hpp>
+#include <nupic/utils/Log.hpp>
+
+using namespace nupic::algorithms::Cells4;
+
+namespace {
+// Chunks are carved into slabs of any size class.
+const size_t CHUNK_BYTES = 1 << 20;
+} // namespace
+
+//--------------------------------------------------------------------------------
+SynapsePool::SynapsePool() : chunkPos_(nullptr), chunkLeft_(0) {
+  std::fill(freeLists_, freeLists_ + NUM_SIZE_CLASSES, nullptr);
+}
+
+//--------------------------------------------------------------------------------
+SynapsePool::~SynapsePool() {
+  for (char *chunk : chunks_)
+    delete[] chunk;
+}
+
+//--------------------------------------------------------------------------------
+UInt SynapsePool::capacityFor(UInt n) {
+  UInt capacity = MIN_CAPACITY;
+  while (capacity < n)
+    capacity *= 2;
+  return capacity;
+}
+
+//--------------------------------------------------------------------------------
+UInt SynapsePool::sizeClass_(UInt capacity) {
+  UInt sizeClass = 0;
+  while ((MIN_CAPACITY << sizeClass) < capacity)
+    ++sizeClass;
+  return sizeClass;
+}
+
+//--------------------------------------------------------------------------------
+void *SynapsePool::allocate(UInt capacity) {
+  NTA_ASSERT(capacity == capacityFor(capacity));
+
+  const UInt sizeClass = sizeClass_(capacity);
+  const size_t bytes = capacity * SYNAPSE_BYTES;
+  if (sizeClass >= NUM_SIZE_CLASSES)
+    return new char[bytes];
+
+  void *slab = freeLists_[sizeClass];
+  if (slab != nullptr) {
+    freeLists_[sizeClass] = *(void **)slab;
+    return slab;
+  }
+
+  if (chunkLeft_ < bytes) {
+    // Hand the tail of the current chunk to the free lists before moving on.
+    for (UInt c = NUM_SIZE_CLASSES; c-- > 0;) {
+      const size_t classBytes = (MIN_CAPACITY << c) * SYNAPSE_BYTES;
+      while (chunkLeft_ >= classBytes) {
+        *(void **)chunkPos_ = freeLists_[c];
+        freeLists_[c] = chunkPos_;
+        chunkPos_ += classBytes;
+        chunkLeft_ -= classBytes;
+      }
+    }
+    chunks_.push_back(new char[CHUNK_BYTES]);
+    chunkPos_ = chunks_.back();
+    chunkLeft_ = CHUNK_BYTES;
+  }
+
+  slab = chunkPos_;
+  chunkPos_ += bytes;
+  chunkLeft_ -= bytes;
+  return slab;
+}
+
+//--------------------------------------------------------------------------------
+void SynapsePool::release(void *slab, UInt capacity) {
+  const UInt sizeClass = sizeClass_(capacity);
+  if (sizeClass >= NUM_SIZE_CLASSES) {
+    delete[](char *) slab;
+    return;
+  }
+
+  *(void **)slab = freeLists_[sizeClass];
+  freeLists_[sizeClass] = slab;
+}
+
+//--------------------------------------------------------------------------------
+void *SynapsePool::allocate(SynapsePool *pool, UInt capacity) {
+  if (pool != nullptr)
+    return pool->allocate(capacity);
+  return new char[capacity * SYNAPSE_BYTES];
+}
+
+//--------------------------------------------------------------------------------
+void SynapsePool::release(SynapsePool *pool, void *slab, UInt capacity) {
+  if (pool != nullptr)
+    pool->release(slab, capacity);
+  else
+    delete[](char *) slab;
+}
+
+//--------------------------------------------------------------------------------
+SegmentSynapses::SegmentSynapses(const SegmentSynapses &o)
+    : _pool(nullptr), _srcCellIdx(nullptr), _permanence(nullptr), _size(0), _capacity(0) {
+  *this = o;
+}
+
+//--------------------------------------------------------------------------------
+SegmentSynapses::SegmentSynapses(SegmentSynapses &&o) noexcept
+    : _pool(o._pool), _srcCellIdx(o._srcCellIdx), _permanence(o._permanence),
+      _size(o._size), _capacity(o._capacity) {
+  o._srcCellIdx = nullptr;
+  o._permanence = nullptr;
+  o._size = 0;
+  o._capacity = 0;
+}
+
+//--------------------------------------------------------------------------------
+SegmentSynapses &SegmentSynapses::operator=(const SegmentSynapses &o) {
+  if (&o != this) {
+    if (o._size > _capacity) {
+      _release();
+      reserve(o._size);
+    }
+    _size = o._size;
+    if (_size > 0) {
+      std::memcpy(_srcCellIdx, o._srcCellIdx, _size * sizeof(UInt));
+      std::memcpy(_permanence, o._permanence, _size * sizeof(Real));
+    }
+  }
+  return *this;
+}
+
+//--------------------------------------------------------------------------------
+SegmentSynapses &SegmentSynapses::operator=(SegmentSynapses &&o) noexcept {
+  if (&o != this) {
+    _release();
+    std::swap(_pool, o._pool);
+    std::swap(_srcCellIdx, o._srcCellIdx);
+    std::swap(_permanence, o._permanence);
+    std::swap(_size, o._size);
+    std::swap(_capacity, o._capacity);
+  }
+  return *this;
+}
+
+//--------------------------------------------------------------------------------
+bool SegmentSynapses::operator==(const SegmentSynapses &o) const {
+  if (_size != o._size)
+    return false;
+  for (UInt i = 0; i != _size; ++i) {
+    if (_srcCellIdx[i] != o._srcCellIdx[i] ||
+        _permanence[i] != o._permanence[i])
+      return false;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------
+void SegmentSynapses::assign(std::vector<InSynapse> synapses) {
+  std::sort(synapses.begin(), synapses.end(),
+            [](const InSynapse &a, const InSynapse &b) {
+              return a.srcCellIdx() < b.srcCellIdx();
+            });
+
+  _size = 0;
+  reserve((UInt)synapses.size());
+  for (const InSynapse &synapse : synapses) {
+    _srcCellIdx[_size] = synapse.srcCellIdx();
+    _permanence[_size] = synapse.permanence();
+    ++_size;
+  }
+}
+
+//--------------------------------------------------------------------------------
+void SegmentSynapses::insert(const std::set<UInt> &srcCells, Real initStrength) {
+  const UInt newSize = _size + (UInt)srcCells.size();
+  reserve(newSize);
+
+  // Merge from the back, so that existing synapses move at most once.
+  Int i = (Int)_size - 1;
+  UInt k = newSize;
+  for (auto it = srcCells.rbegin(); it != srcCells.rend(); ++it) {
+    while (i >= 0 && _srcCellIdx[i] > *it) {
+      --k;
+      _srcCellIdx[k] = _srcCellIdx[i];
+      _permanence[k] = _permanence[i];
+      --i;
+    }
+    --k;
+    _srcCellIdx[k] = *it;
+    _permanence[k] = initStrength;
+  }
+
+  _size = newSize;
+}
+
+//--------------------------------------------------------------------------------
+void SegmentSynapses::push_back(UInt srcCellIdx, Real permanence) {
+  if (_size == _capacity)
+    reserve(_size + 1);
+  _srcCellIdx[_size] = srcCellIdx;
+  _permanence[_size] = permanence;
+  ++_size;
+}
+
+//--------------------------------------------------------------------------------
+void SegmentSynapses::erase(const std::vector<UInt> &del) {
+  UInt i = 0, idel = 0, j = 0;
+
+  while (i < _size && idel < del.size()) {
+    if (i == del[idel]) {
+      ++i;
+      ++idel;
+    } else if (i < del[idel]) {
+      _srcCellIdx[j] = _srcCellIdx[i];
+      _permanence[j++] = _permanence[i++];
+    } else if (del[idel] < i) {
+      NTA_CHECK(false); // Synapses have to be sorted!
+    }
+  }
+
+  while (i < _size) {
+    _srcCellIdx[j] = _srcCellIdx[i];
+    _permanence[j++] = _permanence[i++];
+  }
+
+  _size = j;
+}
+
+//--------------------------------------------------------------------------------
+void SegmentSynapses::reserve(UInt n) {
+  if (n <= _capacity)
+    return;
+
+  const UInt capacity = SynapsePool::capacityFor(n);
+  char *slab = (char *)SynapsePool::allocate(_pool, capacity);
+  UInt *srcCellIdx = (UInt *)slab;
+  Real *permanence = (Real *)(slab + capacity * sizeof(UInt));
+
+  if (_size > 0) {
+    std::memcpy(srcCellIdx, _srcCellIdx, _size * sizeof(UInt));
+    std::memcpy(permanence, _permanence, _size * sizeof(Real));
+  }
+
+  const UInt size = _size;
+  _release();
+  _srcCellIdx = srcCellIdx;
+  _permanence = permanence;
+  _size = size;
+  _capacity = capacity;
+}
+
+//--------------------------------------------------------------------------------
+void SegmentSynapses::setPool(SynapsePool *pool) {
+  if (pool == _pool)
+    return;
+  SegmentSynapses moved(pool);
+  moved = *this;
+  *this = std::move(moved);
+}
+
+//--------------------------------------------------------------------------------
+void SegmentSynapses::_release() {
+  if (_srcCellIdx != nullptr)
+    SynapsePool::release(_pool, _srcCellIdx, _capacity);
+  _srcCellIdx = nullptr;
+  _permanence = nullptr;
+  _size = 0;
+  _capacity = 0;
+}
@@ -0,0 +1,252 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef NTA_SEGMENT_SYNAPSES_HPP
+#define NTA_SEGMENT_SYNAPSES_HPP
+
+#include <set>
+#include <vector>
+
+#include <nupic/algorithms/InSynapse.hpp>
+#include <nupic/types/Types.hpp>
+
+//--------------------------------------------------------------------------------
+
+namespace nupic {
+namespace algorithms {
+namespace Cells4 {
+
+//--------------------------------------------------------------------------------
+/**
+ * Allocator for the synapse storage of the segments of one Cells4.
+ *
+ * Slabs come in power-of-two size classes. They are carved out of large
+ * chunks, so the synapses of neighbouring segments sit next to each other in
+ * memory instead of in hundreds of thousands of separate heap blocks. A slab
+ * that is released goes onto the free list of its size class and is handed
+ * out again to the next segment that needs one. The chunks are freed when the
+ * pool is destroyed, so the pool holds at most the high-water mark of live
+ * synapses of its owner.
+ *
+ * Slabs larger than the biggest size class are allocated and freed directly.
+ *
+ * A pool is not thread safe: it belongs to a single Cells4, which only
+ * allocates synapses from the thread that calls compute. The static
+ * allocate and release overloads take a null pool to mean the heap, for
+ * segments that live outside of any Cells4.
+ */
+class SynapsePool {
+public:
+  // Capacity, in synapses, of the smallest size class.
+  static const UInt MIN_CAPACITY = 4;
+
+  // Number of pooled size classes (capacities 4, 8, ..., 2048).
+  static const UInt NUM_SIZE_CLASSES = 10;
+
+  // Size of a synapse in a slab: a source cell index and a permanence.
+  static const size_t SYNAPSE_BYTES = sizeof(UInt) + sizeof(Real);
+
+  SynapsePool();
+  ~SynapsePool();
+
+  /**
+   * Returns the capacity of the smallest slab that holds n synapses.
+   */
+  static UInt capacityFor(UInt n);
+
+  /**
+   * Returns a slab for capacity synapses, where capacity is a value
+   * returned by capacityFor.
+   */
+  void *allocate(UInt capacity);
+
+  /**
+   * Returns a slab obtained from allocate(capacity) to the pool.
+   */
+  void release(void *slab, UInt capacity);
+
+  /**
+   * As above, from the given pool, or from the heap if pool is null.
+   */
+  static void *allocate(SynapsePool *pool, UInt capacity);
+  static void release(SynapsePool *pool, void *slab, UInt capacity);
+
+  /**
+   * Returns the number of chunks the pool has taken from the system.
+   */
+  size_t nChunks() const { return chunks_.size(); }
+
+private:
+  SynapsePool(const SynapsePool &) = delete;
+  SynapsePool &operator=(const SynapsePool &) = delete;
+
+  static UInt sizeClass_(UInt capacity);
+
+  void *freeLists_[NUM_SIZE_CLASSES]; // singly linked through the slabs
+  std::vector<char *> chunks_;
+  char *chunkPos_;
+  size_t chunkLeft_;
+};
+
+//--------------------------------------------------------------------------------
+/**
+ * STL allocator drawing from a SynapsePool, for containers of synapse-sized
+ * elements such as the OutSynapses lists of Cells4. A default constructed
+ * allocator uses the heap.
+ */
+template <typename T> class SynapsePoolAllocator {
+public:
+  typedef T value_type;
+
+  SynapsePoolAllocator(SynapsePool *pool = nullptr) : pool_(pool) {}
+  template <typename U>
+  SynapsePoolAllocator(const SynapsePoolAllocator<U> &o) : pool_(o.pool()) {}
+
+  T *allocate(size_t n) {
+    return (T *)SynapsePool::allocate(pool_, capacity_(n));
+  }
+  void deallocate(T *p, size_t n) {
+    SynapsePool::release(pool_, p, capacity_(n));
+  }
+
+  SynapsePool *pool() const { return pool_; }
+
+  template <typename U>
+  bool operator==(const SynapsePoolAllocator<U> &o) const {
+    return pool_ == o.pool();
+  }
+  template <typename U>
+  bool operator!=(const SynapsePoolAllocator<U> &o) const {
+    return pool_ != o.pool();
+  }
+
+private:
+  static UInt capacity_(size_t n) {
+    const size_t bytes = n * sizeof(T);
+    return SynapsePool::capacityFor(
+        (UInt)((bytes + SynapsePool::SYNAPSE_BYTES - 1) /
+               SynapsePool::SYNAPSE_BYTES));
+  }
+
+  SynapsePool *pool_;
+};
+
+//--------------------------------------------------------------------------------
+/**
+ * The incoming synapses of a Segment, stored as struct-of-arrays: the source
+ * cell indices and the permanences live in two parallel arrays at the front
+ * and back of a single slab from a SynapsePool, or from the heap when the
+ * segment has no pool.
+ *
+ * Synapses are kept in order of increasing source cell index; the methods
+ * that add synapses maintain that order, the others leave it unchanged.
+ */
+class SegmentSynapses {
+public:
+  explicit SegmentSynapses(SynapsePool *pool = nullptr)
+      : _pool(pool), _srcCellIdx(nullptr), _permanence(nullptr), _size(0),
+        _capacity(0) {}
+
+  // A copy lives on the heap, since it may outlive the pool of o. Copy
+  // assignment keeps the pool of the destination, while moves carry the
+  // pool along with the slab.
+  SegmentSynapses(const SegmentSynapses &o);
+  SegmentSynapses(SegmentSynapses &&o) noexcept;
+  ~SegmentSynapses() { _release(); }
+
+  SegmentSynapses &operator=(const SegmentSynapses &o);
+  SegmentSynapses &operator=(SegmentSynapses &&o) noexcept;
+
+  bool operator==(const SegmentSynapses &o) const;
+  inline bool operator!=(const SegmentSynapses &o) const {
+    return !operator==(o);
+  }
+
+  inline UInt size() const { return _size; }
+  inline bool empty() const { return _size == 0; }
+  inline UInt capacity() const { return _capacity; }
+  inline SynapsePool *pool() const { return _pool; }
+
+  /**
+   * Moves the synapses to a slab from pool (the heap if null).
+   */
+  void setPool(SynapsePool *pool);
+
+  inline UInt srcCellIdx(UInt idx) const { return _srcCellIdx[idx]; }
+  inline Real permanence(UInt idx) const { return _permanence[idx]; }
+  inline Real &permanence(UInt idx) { return _permanence[idx]; }
+
+  inline const UInt *srcCellIndices() const { return _srcCellIdx; }
+  inline const Real *permanences() const { return _permanence; }
+
+  inline InSynapse operator[](UInt idx) const {
+    return InSynapse(_srcCellIdx[idx], _permanence[idx]);
+  }
+
+  /**
+   * Replaces the contents with the given synapses, sorted by source cell
+   * index.
+   */
+  void assign(std::vector<InSynapse> synapses);
+
+  /**
+   * Adds a new synapse with permanence initStrength for each of srcCells,
+   * none of which may already be on the segment.
+   */
+  void insert(const std::set<UInt> &srcCells, Real initStrength);
+
+  /**
+   * Appends a synapse. The caller is responsible for keeping the order.
+   */
+  void push_back(UInt srcCellIdx, Real permanence);
+
+  /**
+   * Removes the synapses at the given positions, which must be sorted.
+   */
+  void erase(const std::vector<UInt> &del);
+
+  /**
+   * Removes all synapses and gives the slab back to the pool.
+   */
+  void clear() { _release(); }
+
+  /**
+   * Makes room for at least n synapses, keeping the current ones.
+   */
+  void reserve(UInt n);
+
+private:
+  void _release();
+
+  SynapsePool *_pool;
+  UInt *_srcCellIdx;
+  Real *_permanence;
+  UInt _size;
+  UInt _capacity;
+};
+
+// end namespace
+} // namespace Cells4
+} // namespace algorithms
+} // namespace nupic
+
+#endif // NTA_SEGMENT_SYNAPSES_HPP
@@ -24,6 +24,7 @@
  * Implementation of SpatialPooler
  */
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <string>
@@ -32,15 +33,24 @@
 #include <nupic/algorithms/SpatialPooler.hpp>
 #include <nupic/math/Math.hpp>
 #include <nupic/math/Topology.hpp>
+#include <nupic/os/Profiler.hpp>
 #include <nupic/proto/SpatialPoolerProto.capnp.h>
 
 using namespace std;
 using namespace nupic;
 using namespace nupic::algorithms::spatial_pooler;
 using namespace nupic::math::topology;
+using nupic::util::ThreadPool;
 
 static const Real PERMANENCE_EPSILON = 0.000001;
 
+static const UInt32 overlapProbe =
+    Profiler::getTimingProbe("SpatialPooler.overlap");
+static const UInt32 inhibitProbe =
+    Profiler::getTimingProbe("SpatialPooler.inhibit");
+static const UInt32 learnProbe =
+    Profiler::getTimingProbe("SpatialPooler.learn");
+
 // MSVC doesn't provide round() which only became standard in C99 or C++11
 #if defined(NTA_COMPILER_MSVC)
 template <typename T> T round(T num) {
@@ -105,6 +115,7 @@ private:
 SpatialPooler::SpatialPooler() {
   // The current version number.
   version_ = 2;
+  threadPool_ = make_shared<ThreadPool>(1);
 }
 
 SpatialPooler::SpatialPooler(
@@ -113,13 +124,14 @@ SpatialPooler::SpatialPooler(
     Real localAreaDensity, UInt numActiveColumnsPerInhArea,
     UInt stimulusThreshold, Real synPermInactiveDec, Real synPermActiveInc,
     Real synPermConnected, Real minPctOverlapDutyCycles, UInt dutyCyclePeriod,
-    Real boostStrength, Int seed, UInt spVerbosity, bool wrapAround)
+    Real boostStrength, Int seed, UInt spVerbosity, bool wrapAround,
+    UInt numThreads)
     : SpatialPooler::SpatialPooler() {
   initialize(inputDimensions, columnDimensions, potentialRadius, potentialPct,
              globalInhibition, localAreaDensity, numActiveColumnsPerInhArea,
              stimulusThreshold, synPermInactiveDec, synPermActiveInc,
              synPermConnected, minPctOverlapDutyCycles, dutyCyclePeriod,
-             boostStrength, seed, spVerbosity, wrapAround);
+             boostStrength, seed, spVerbosity, wrapAround, numThreads);
 }
 
 vector<UInt> SpatialPooler::getColumnDimensions() const {
@@ -217,6 +229,17 @@ bool SpatialPooler::getWrapAround() const { return wrapAround_; }
 
 void SpatialPooler::setWrapAround(bool wrapAround) { wrapAround_ = wrapAround; }
 
+UInt SpatialPooler::getNumThreads() const {
+  return threadPool_->getNumThreads();
+}
+
+void SpatialPooler::setNumThreads(UInt numThreads) {
+  NTA_CHECK(numThreads >= 1);
+  if (numThreads != threadPool_->getNumThreads()) {
+    threadPool_ = make_shared<ThreadPool>(numThreads);
+  }
+}
+
 UInt SpatialPooler::getUpdatePeriod() const { return updatePeriod_; }
 
 void SpatialPooler::setUpdatePeriod(UInt updatePeriod) {
@@ -352,7 +375,8 @@ void SpatialPooler::initialize(
     Real localAreaDensity, UInt numActiveColumnsPerInhArea,
     UInt stimulusThreshold, Real synPermInactiveDec, Real synPermActiveInc,
     Real synPermConnected, Real minPctOverlapDutyCycles, UInt dutyCyclePeriod,
-    Real boostStrength, Int seed, UInt spVerbosity, bool wrapAround) {
+    Real boostStrength, Int seed, UInt spVerbosity, bool wrapAround,
+    UInt numThreads) {
 
   numInputs_ = 1;
   inputDimensions_.clear();
@@ -401,6 +425,7 @@ void SpatialPooler::initialize(
   initConnectedPct_ = 0.5;
   iterationNum_ = 0;
   iterationLearnNum_ = 0;
+  setNumThreads(numThreads);
 
   tieBreaker_.resize(numColumns_);
   for (UInt i = 0; i < numColumns_; i++) {
@@ -411,6 +436,7 @@ void SpatialPooler::initialize(
   permanences_.resize(numColumns_, numInputs_);
   connectedSynapses_.resize(numColumns_, numInputs_);
   connectedCounts_.resize(numColumns_);
+  connectedColumnsForInput_.clear();
 
   overlapDutyCycles_.assign(numColumns_, 0);
   activeDutyCycles_.assign(numColumns_, 0);
@@ -439,6 +465,7 @@ void SpatialPooler::initialize(
 
 void SpatialPooler::compute(UInt inputArray[], bool learn, UInt activeArray[]) {
   updateBookeepingVars_(learn);
+  Profiler::start(overlapProbe);
   calculateOverlap_(inputArray, overlaps_);
   calculateOverlapPct_(overlaps_, overlapsPct_);
 
@@ -447,11 +474,15 @@ void SpatialPooler::compute(UInt inputArray[], bool learn, UInt activeArray[]) {
   } else {
     boostedOverlaps_.assign(overlaps_.begin(), overlaps_.end());
   }
+  Profiler::stop(overlapProbe);
 
+  Profiler::start(inhibitProbe);
   inhibitColumns_(boostedOverlaps_, activeColumns_);
+  Profiler::stop(inhibitProbe);
   toDense_(activeColumns_, activeArray, numColumns_);
 
   if (learn) {
+    ProfileScope scope(learnProbe);
     adaptSynapses_(inputArray, activeColumns_);
     updateDutyCycles_(overlaps_, activeArray);
     bumpUpWeakColumns_();
@@ -463,6 +494,46 @@ void SpatialPooler::compute(UInt inputArray[], bool learn, UInt activeArray[]) {
   }
 }
 
+void SpatialPooler::compute(UInt activeInputsSize, const UInt activeInputs[],
+                            bool learn, UInt activeArray[]) {
+  for (UInt i = 0; i < activeInputsSize; i++) {
+    NTA_CHECK(activeInputs[i] < numInputs_)
+        << "Active input " << activeInputs[i] << " is out of range ("
+        << numInputs_ << " inputs).";
+    NTA_CHECK(i == 0 || activeInputs[i - 1] < activeInputs[i])
+        << "Active inputs must be in increasing order without duplicates.";
+  }
+
+  updateBookeepingVars_(learn);
+  Profiler::start(overlapProbe);
+  calculateOverlapSparse_(activeInputsSize, activeInputs, overlaps_);
+  calculateOverlapPct_(overlaps_, overlapsPct_);
+
+  if (learn) {
+    boostOverlaps_(overlaps_, boostedOverlaps_);
+  } else {
+    boostedOverlaps_.assign(overlaps_.begin(), overlaps_.end());
+  }
+  Profiler::stop(overlapProbe);
+
+  Profiler::start(inhibitProbe);
+  inhibitColumns_(boostedOverlaps_, activeColumns_);
+  Profiler::stop(inhibitProbe);
+  toDense_(activeColumns_, activeArray, numColumns_);
+
+  if (learn) {
+    ProfileScope scope(learnProbe);
+    adaptSynapsesSparse_(activeInputsSize, activeInputs, activeColumns_);
+    updateDutyCycles_(overlaps_, activeArray);
+    bumpUpWeakColumns_();
+    updateBoostFactors_();
+    if (isUpdateRound_()) {
+      updateInhibitionRadius_();
+      updateMinDutyCycles_();
+    }
+  }
+}
+
 void SpatialPooler::stripUnlearnedColumns(UInt activeArray[]) const {
   for (UInt i = 0; i < numColumns_; i++) {
     if (activeDutyCycles_[i] == 0) {
@@ -577,7 +648,6 @@ void SpatialPooler::updatePermanencesForColumn_(vector<Real> &perm, UInt column,
                                                 bool raisePerm) {
   vector<UInt> connectedSparse;
 
-  UInt numConnected;
   if (raisePerm) {
     vector<UInt> potential;
     potential.resize(numInputs_);
@@ -585,19 +655,147 @@ void SpatialPooler::updatePermanencesForColumn_(vector<Real> &perm, UInt column,
     raisePermanencesToThreshold_(perm, potential);
   }
 
-  numConnected = 0;
   for (UInt i = 0; i < perm.size(); ++i) {
     if (perm[i] >= synPermConnected_ - PERMANENCE_EPSILON) {
       connectedSparse.push_back(i);
-      ++numConnected;
     }
   }
 
   clip_(perm, true);
-  connectedSynapses_.replaceSparseRow(column, connectedSparse.begin(),
-                                      connectedSparse.end());
+  setConnectedSynapses_(column, connectedSparse);
   permanences_.setRowFromDense(column, perm);
-  connectedCounts_[column] = numConnected;
+}
+
+void SpatialPooler::loadColumnUpdate_(UInt column,
+                                      ColumnUpdate &update) const {
+  const vector<UInt> &potential = potentialPools_.getSparseRow(column);
+  update.potentialPerm.assign(potential.size(), 0);
+  update.outsidePotential = false;
+
+  // The potential pool and the stored permanences are both sorted.
+  auto permIndex = permanences_.row_nz_index_begin(column);
+  auto permIndexEnd = permanences_.row_nz_index_end(column);
+  auto permValue = permanences_.row_nz_value_begin(column);
+  for (UInt i = 0; i < potential.size() && permIndex != permIndexEnd; i++) {
+    while (permIndex != permIndexEnd && *permIndex < potential[i]) {
+      update.outsidePotential = true;
+      ++permIndex;
+      ++permValue;
+    }
+    if (permIndex != permIndexEnd && *permIndex == potential[i]) {
+      update.potentialPerm[i] = *permValue;
+      ++permIndex;
+      ++permValue;
+    }
+  }
+  if (permIndex != permIndexEnd) {
+    update.outsidePotential = true;
+  }
+}
+
+void SpatialPooler::computeColumnUpdate_(UInt column, bool raisePerm,
+                                         ColumnUpdate &update) {
+  update.raisePerm = raisePerm;
+  update.connected.clear();
+  update.permIndices.clear();
+  update.permValues.clear();
+  if (update.outsidePotential) {
+    return;
+  }
+
+  const vector<UInt> &potential = potentialPools_.getSparseRow(column);
+  vector<Real> &perm = update.potentialPerm;
+  NTA_ASSERT(perm.size() == potential.size());
+
+  if (raisePerm) {
+    // Same as raisePermanencesToThreshold_.
+    clip_(perm, false);
+    while (countConnected_(perm) < stimulusThreshold_) {
+      for (auto &elem : perm) {
+        elem += synPermBelowStimulusInc_;
+      }
+    }
+  }
+
+  for (UInt i = 0; i < potential.size(); ++i) {
+    if (perm[i] >= synPermConnected_ - PERMANENCE_EPSILON) {
+      update.connected.push_back(potential[i]);
+    }
+  }
+
+  clip_(perm, true);
+  for (UInt i = 0; i < potential.size(); ++i) {
+    if (!nearlyZero(perm[i])) {
+      update.permIndices.push_back(potential[i]);
+      update.permValues.push_back(perm[i]);
+    }
+  }
+}
+
+void SpatialPooler::applyColumnUpdate_(UInt column,
+                                       const ColumnUpdate &update) {
+  if (update.outsidePotential) {
+    // Permanences outside the potential pool (see setPermanence) still
+    // count towards the connected synapses, so use the dense update.
+    const vector<UInt> &potential = potentialPools_.getSparseRow(column);
+    vector<Real> perm(numInputs_, 0);
+    permanences_.getRowToDense(column, perm);
+    for (UInt i = 0; i < potential.size(); i++) {
+      perm[potential[i]] = update.potentialPerm[i];
+    }
+    updatePermanencesForColumn_(perm, column, update.raisePerm);
+    return;
+  }
+
+  setConnectedSynapses_(column, update.connected);
+  permanences_.setRowFromSparse(column, update.permIndices.begin(),
+                                update.permIndices.end(),
+                                update.permValues.begin());
+}
+
+void SpatialPooler::setConnectedSynapses_(UInt column,
+                                          const vector<UInt> &connected) {
+  const vector<UInt> &previous = connectedSynapses_.getSparseRow(column);
+  if (previous.size() == connected.size() &&
+      equal(previous.begin(), previous.end(), connected.begin())) {
+    return;
+  }
+
+  if (!connectedColumnsForInput_.empty()) {
+    // Both rows are sorted, so walk them together and only touch the inputs
+    // that were connected or disconnected.
+    auto prev = previous.begin();
+    auto next = connected.begin();
+    while (prev != previous.end() || next != connected.end()) {
+      if (next == connected.end() ||
+          (prev != previous.end() && *prev < *next)) {
+        vector<UInt> &columns = connectedColumnsForInput_[*prev];
+        columns.erase(lower_bound(columns.begin(), columns.end(), column));
+        ++prev;
+      } else if (prev == previous.end() || *next < *prev) {
+        vector<UInt> &columns = connectedColumnsForInput_[*next];
+        columns.insert(lower_bound(columns.begin(), columns.end(), column),
+                       column);
+        ++next;
+      } else {
+        ++prev;
+        ++next;
+      }
+    }
+  }
+
+  connectedSynapses_.replaceSparseRow(column, connected.begin(),
+                                      connected.end());
+  connectedCounts_[column] = connected.size();
+}
+
+void SpatialPooler::buildConnectedColumnsForInput_() {
+  connectedColumnsForInput_.assign(numInputs_, vector<UInt>());
+  for (UInt column = 0; column < numColumns_; column++) {
+    for (UInt input : connectedSynapses_.getSparseRow(column)) {
+      connectedColumnsForInput_[input].push_back(column);
+    }
+  }
 }
 
 UInt SpatialPooler::countConnected_(vector<Real> &perm) {
@@ -690,19 +888,22 @@ void SpatialPooler::updateMinDutyCyclesLocal_() {
 
 void SpatialPooler::updateDutyCycles_(vector<UInt> &overlaps,
                                       UInt activeArray[]) {
-  vector<UInt> newOverlapVal(numColumns_, 0);
-  vector<UInt> newActiveVal(numColumns_, 0);
-
-  for (UInt i = 0; i < numColumns_; i++) {
-    newOverlapVal[i] = overlaps[i] > 0 ? 1 : 0;
-    newActiveVal[i] = activeArray[i] > 0 ? 1 : 0;
-  }
-
   UInt period =
       dutyCyclePeriod_ > iterationNum_ ? iterationNum_ : dutyCyclePeriod_;
+  NTA_ASSERT(period >= 1);
 
-  updateDutyCyclesHelper_(overlapDutyCycles_, newOverlapVal, period);
-  updateDutyCyclesHelper_(activeDutyCycles_, newActiveVal, period);
+  // Same arithmetic as updateDutyCyclesHelper_, one block of columns at a
+  // time.
+  threadPool_->parallelFor(numColumns_, [&](UInt begin, UInt end) {
+    for (UInt i = begin; i < end; i++) {
+      const UInt newOverlapVal = overlaps[i] > 0 ? 1 : 0;
+      const UInt newActiveVal = activeArray[i] > 0 ? 1 : 0;
+      overlapDutyCycles_[i] =
+          (overlapDutyCycles_[i] * (period - 1) + newOverlapVal) / period;
+      activeDutyCycles_[i] =
+          (activeDutyCycles_[i] * (period - 1) + newActiveVal) / period;
+    }
+  });
 }
 
 Real SpatialPooler::avgColumnsPerInput_() {
@@ -786,45 +987,85 @@ Real SpatialPooler::avgConnectedSpanForColumnND_(UInt column) {
   return (Real)totalSpan / inputDimensions_.size();
 }
 
-void SpatialPooler::adaptSynapses_(UInt inputVector[],
-                                   vector<UInt> &activeColumns) {
-  vector<Real> permChanges(numInputs_, -1 * synPermInactiveDec_);
-  for (UInt i = 0; i < numInputs_; i++) {
-    if (inputVector[i] > 0) {
-      permChanges[i] = synPermActiveInc_;
+template <typename AdaptColumn>
+void SpatialPooler::adaptColumns_(const vector<UInt> &activeColumns,
+                                  AdaptColumn adaptColumn) {
+  if (threadPool_->getNumThreads() == 1) {
+    for (UInt column : activeColumns) {
+      loadColumnUpdate_(column, columnUpdate_);
+      adaptColumn(potentialPools_.getSparseRow(column),
+                  columnUpdate_.potentialPerm);
+      computeColumnUpdate_(column, true, columnUpdate_);
+      applyColumnUpdate_(column, columnUpdate_);
     }
+    return;
   }
 
-  for (UInt i = 0; i < activeColumns.size(); i++) {
-    UInt column = activeColumns[i];
-    vector<UInt> potential;
-    vector<Real> perm(numInputs_, 0);
-    potential.resize(potentialPools_.nNonZerosOnRow(i));
-    potential = potentialPools_.getSparseRow(column);
-    permanences_.getRowToDense(column, perm);
-    for (auto &elem : potential) {
-      UInt index = elem;
-      perm[index] += permChanges[index];
+  // The matrix writes are not thread-safe, so only the per-column
+  // arithmetic runs in parallel.
+  if (columnUpdates_.size() < activeColumns.size()) {
+    columnUpdates_.resize(activeColumns.size());
+  }
+  threadPool_->parallelFor(activeColumns.size(), [&](UInt begin, UInt end) {
+    for (UInt i = begin; i < end; i++) {
+      const UInt column = activeColumns[i];
+      loadColumnUpdate_(column, columnUpdates_[i]);
+      adaptColumn(potentialPools_.getSparseRow(column),
+                  columnUpdates_[i].potentialPerm);
+      computeColumnUpdate_(column, true, columnUpdates_[i]);
     }
-    updatePermanencesForColumn_(perm, column, true);
+  });
+  for (UInt i = 0; i < activeColumns.size(); i++) {
+    applyColumnUpdate_(activeColumns[i], columnUpdates_[i]);
   }
 }
 
+void SpatialPooler::adaptSynapses_(UInt inputVector[],
+                                   vector<UInt> &activeColumns) {
+  adaptColumns_(activeColumns, [&](const vector<UInt> &potential,
+                                   vector<Real> &potentialPerm) {
+    for (UInt i = 0; i < potential.size(); i++) {
+      if (inputVector[potential[i]] > 0) {
+        potentialPerm[i] += synPermActiveInc_;
+      } else {
+        potentialPerm[i] -= synPermInactiveDec_;
+      }
+    }
+  });
+}
+
+void SpatialPooler::adaptSynapsesSparse_(UInt activeInputsSize,
+                                         const UInt activeInputs[],
+                                         vector<UInt> &activeColumns) {
+  const UInt *activeEnd = activeInputs + activeInputsSize;
+  adaptColumns_(activeColumns, [&](const vector<UInt> &potential,
+                                   vector<Real> &potentialPerm) {
+    // The potential pool and the active inputs are both sorted.
+    const UInt *active = activeInputs;
+    for (UInt i = 0; i < potential.size(); i++) {
+      while (active != activeEnd && *active < potential[i]) {
+        ++active;
+      }
+      if (active != activeEnd && *active == potential[i]) {
+        potentialPerm[i] += synPermActiveInc_;
+      } else {
+        potentialPerm[i] -= synPermInactiveDec_;
+      }
+    }
+  });
+}
+
 void SpatialPooler::bumpUpWeakColumns_() {
   for (UInt i = 0; i < numColumns_; i++) {
     if (overlapDutyCycles_[i] >= minOverlapDutyCycles_[i]) {
       continue;
     }
-    vector<Real> perm(numInputs_, 0);
-    vector<UInt> potential;
-    potential.resize(potentialPools_.nNonZerosOnRow(i));
-    potential = potentialPools_.getSparseRow(i);
-    permanences_.getRowToDense(i, perm);
-    for (auto &elem : potential) {
-      UInt index = elem;
-      perm[index] += synPermBelowStimulusInc_;
+    loadColumnUpdate_(i, columnUpdate_);
+    for (auto &perm : columnUpdate_.potentialPerm) {
+      perm += synPermBelowStimulusInc_;
     }
-    updatePermanencesForColumn_(perm, i, false);
+    computeColumnUpdate_(i, false, columnUpdate_);
+    applyColumnUpdate_(i, columnUpdate_);
   }
 }
 
@@ -865,28 +1106,30 @@ void SpatialPooler::updateBoostFactorsGlobal_() {
 }
 
 void SpatialPooler::updateBoostFactorsLocal_() {
-  for (UInt i = 0; i < numColumns_; ++i) {
-    UInt numNeighbors = 0;
-    Real localActivityDensity = 0;
+  threadPool_->parallelFor(numColumns_, [&](UInt begin, UInt end) {
+    for (UInt i = begin; i < end; ++i) {
+      UInt numNeighbors = 0;
+      Real localActivityDensity = 0;
 
-    if (wrapAround_) {
-      for (UInt neighbor :
-           WrappingNeighborhood(i, inhibitionRadius_, columnDimensions_)) {
-        localActivityDensity += activeDutyCycles_[neighbor];
-        numNeighbors += 1;
-      }
-    } else {
-      for (UInt neighbor :
-           Neighborhood(i, inhibitionRadius_, columnDimensions_)) {
-        localActivityDensity += activeDutyCycles_[neighbor];
-        numNeighbors += 1;
+      if (wrapAround_) {
+        for (UInt neighbor :
+             WrappingNeighborhood(i, inhibitionRadius_, columnDimensions_)) {
+          localActivityDensity += activeDutyCycles_[neighbor];
+          numNeighbors += 1;
+        }
+      } else {
+        for (UInt neighbor :
+             Neighborhood(i, inhibitionRadius_, columnDimensions_)) {
+          localActivityDensity += activeDutyCycles_[neighbor];
+          numNeighbors += 1;
+        }
       }
-    }
 
-    Real targetDensity = localActivityDensity / numNeighbors;
-    boostFactors_[i] =
-        exp((targetDensity - activeDutyCycles_[i]) * boostStrength_);
-  }
+      Real targetDensity = localActivityDensity / numNeighbors;
+      boostFactors_[i] =
+          exp((targetDensity - activeDutyCycles_[i]) * boostStrength_);
+    }
+  });
 }
 
 void SpatialPooler::updateBookeepingVars_(bool learn) {
@@ -899,8 +1142,37 @@ void SpatialPooler::updateBookeepingVars_(bool learn) {
 void SpatialPooler::calculateOverlap_(UInt inputVector[],
                                       vector<UInt> &overlaps) {
   overlaps.assign(numColumns_, 0);
-  connectedSynapses_.rightVecSumAtNZ(inputVector, inputVector + numInputs_,
-                                     overlaps.begin(), overlaps.end());
+  if (threadPool_->getNumThreads() == 1) {
+    connectedSynapses_.rightVecSumAtNZ(inputVector, inputVector + numInputs_,
+                                       overlaps.begin(), overlaps.end());
+    return;
+  }
+
+  // Each thread sums a block of rows of connectedSynapses_.
+  threadPool_->parallelFor(numColumns_, [&](UInt begin, UInt end) {
+    for (UInt column = begin; column < end; column++) {
+      UInt overlap = 0;
+      for (UInt input : connectedSynapses_.getSparseRow(column)) {
+        overlap += inputVector[input];
+      }
+      overlaps[column] = overlap;
+    }
+  });
+}
+
+void SpatialPooler::calculateOverlapSparse_(UInt activeInputsSize,
+                                            const UInt activeInputs[],
+                                            vector<UInt> &overlaps) {
+  if (connectedColumnsForInput_.empty()) {
+    buildConnectedColumnsForInput_();
+  }
+
+  overlaps.assign(numColumns_, 0);
+  for (UInt i = 0; i < activeInputsSize; i++) {
+    for (UInt column : connectedColumnsForInput_[activeInputs[i]]) {
+      overlaps[column]++;
+    }
+  }
 }
 
 void SpatialPooler::calculateOverlapPct_(vector<UInt> &overlaps,
@@ -973,22 +1245,44 @@ void SpatialPooler::inhibitColumnsGlobal_(const vector<Real> &overlaps,
   const UInt numDesired = (UInt)(density * numColumns_);
   NTA_CHECK(numDesired > 0) << "Not enough columns (" << numColumns_ << ") "
                             << "for desired density (" << density << ").";
-  vector<pair<UInt, Real>> winners;
+
+  // Highest overlap first. Ties go to the higher column index, matching the
+  // order produced by isWinner_ / addToWinners_.
+  const Real *overlapsData = overlaps.data();
+  auto compare = [overlapsData](UInt a, UInt b) {
+    return overlapsData[a] > overlapsData[b] ||
+           (overlapsData[a] == overlapsData[b] && a > b);
+  };
+
+  // Keep the best numDesired columns in a heap whose front is the weakest
+  // winner, so most columns are rejected with a single comparison.
+  const Real threshold = stimulusThreshold_;
+  activeColumns.reserve(numDesired);
   for (UInt i = 0; i < numColumns_; i++) {
-    if (isWinner_(overlaps[i], winners, numDesired)) {
-      addToWinners_(i, overlaps[i], winners);
+    if (overlapsData[i] < threshold) {
+      continue;
+    }
+    if (activeColumns.size() < numDesired) {
+      activeColumns.push_back(i);
+      push_heap(activeColumns.begin(), activeColumns.end(), compare);
+    } else if (overlapsData[i] >= overlapsData[activeColumns.front()]) {
+      // Later columns win ties, so an equal overlap displaces the front.
+      pop_heap(activeColumns.begin(), activeColumns.end(), compare);
+      activeColumns.back() = i;
+      push_heap(activeColumns.begin(), activeColumns.end(), compare);
     }
   }
-
-  const UInt numActual = min(numDesired, (UInt)winners.size());
-  for (UInt i = 0; i < numActual; i++) {
-    activeColumns.push_back(winners[i].first);
-  }
+  sort_heap(activeColumns.begin(), activeColumns.end(), compare);
 }
 
 void SpatialPooler::inhibitColumnsLocal_(const vector<Real> &overlaps,
                                          Real density,
                                          vector<UInt> &activeColumns) {
+  if (threadPool_->getNumThreads() > 1) {
+    inhibitColumnsLocalParallel_(overlaps, density, activeColumns);
+    return;
+  }
+
   activeColumns.clear();
 
   // Tie-breaking: when overlaps are equal, columns that have already been
@@ -1037,6 +1331,95 @@ void SpatialPooler::inhibitColumnsLocal_(const vector<Real> &overlaps,
   }
 }
 
+// Visits the neighbors of a column, except the column itself.
+template <typename F>
+static void forEachNeighbor_(UInt column, UInt radius,
+                             const vector<UInt> &dimensions, bool wrapAround,
+                             F f) {
+  if (wrapAround) {
+    for (UInt neighbor : WrappingNeighborhood(column, radius, dimensions)) {
+      if (neighbor != column) {
+        f(neighbor);
+      }
+    }
+  } else {
+    for (UInt neighbor : Neighborhood(column, radius, dimensions)) {
+      if (neighbor != column) {
+        f(neighbor);
+      }
+    }
+  }
+}
+
+void SpatialPooler::inhibitColumnsLocalParallel_(const vector<Real> &overlaps,
+                                                 Real density,
+                                                 vector<UInt> &activeColumns) {
+  // The serial loop breaks ties in favor of neighbors that were already
+  // selected, i.e. active neighbors with a lower index. Most columns don't
+  // depend on that: they win even if every lower tied neighbor is active, or
+  // lose even if none is. Those are decided in parallel. The remaining
+  // columns are decided afterwards in index order, exactly as the serial
+  // loop would.
+  enum : char { INACTIVE = 0, ACTIVE = 1, UNDECIDED = 2 };
+  vector<char> state(numColumns_, INACTIVE);
+
+  threadPool_->parallelFor(numColumns_, [&](UInt begin, UInt end) {
+    for (UInt column = begin; column < end; column++) {
+      if (overlaps[column] < stimulusThreshold_) {
+        continue;
+      }
+
+      UInt numNeighbors = 0;
+      UInt numBigger = 0;
+      UInt numTiedBefore = 0;
+      forEachNeighbor_(column, inhibitionRadius_, columnDimensions_,
+                       wrapAround_, [&](UInt neighbor) {
+                         numNeighbors++;
+                         const Real difference =
+                             overlaps[neighbor] - overlaps[column];
+                         if (difference > 0) {
+                           numBigger++;
+                         } else if (difference == 0 && neighbor < column) {
+                           numTiedBefore++;
+                         }
+                       });
+
+      UInt numActive = (UInt)(0.5 + (density * (numNeighbors + 1)));
+      if (numBigger + numTiedBefore < numActive) {
+        state[column] = ACTIVE;
+      } else if (numBigger < numActive) {
+        state[column] = UNDECIDED;
+      }
+    }
+  });
+
+  activeColumns.clear();
+  for (UInt column = 0; column < numColumns_; column++) {
+    if (state[column] == UNDECIDED) {
+      UInt numNeighbors = 0;
+      UInt numBigger = 0;
+      forEachNeighbor_(column, inhibitionRadius_, columnDimensions_,
+                       wrapAround_, [&](UInt neighbor) {
+                         numNeighbors++;
+                         const Real difference =
+                             overlaps[neighbor] - overlaps[column];
+                         if (difference > 0 ||
+                             (difference == 0 && neighbor < column &&
+                              state[neighbor] == ACTIVE)) {
+                           numBigger++;
+                         }
+                       });
+
+      UInt numActive = (UInt)(0.5 + (density * (numNeighbors + 1)));
+      state[column] = (numBigger < numActive) ? ACTIVE : INACTIVE;
+    }
+
+    if (state[column] == ACTIVE) {
+      activeColumns.push_back(column);
+    }
+  }
+}
+
 bool SpatialPooler::isUpdateRound_() {
   return (iterationNum_ % updatePeriod_) == 0;
 }
@@ -1251,6 +1634,7 @@ void SpatialPooler::load(istream &inStream) {
   permanences_.resize(numColumns_, numInputs_);
   connectedSynapses_.resize(numColumns_, numInputs_);
   connectedCounts_.resize(numColumns_);
+  connectedColumnsForInput_.clear();
   for (UInt i = 0; i < numColumns_; i++) {
     UInt nNonZerosOnRow;
     inStream >> nNonZerosOnRow;
@@ -1411,6 +1795,7 @@ void SpatialPooler::read(SpatialPoolerProto::Reader &proto) {
 
   connectedSynapses_.resize(numColumns_, numInputs_);
   connectedCounts_.resize(numColumns_);
+  connectedColumnsForInput_.clear();
 
   // since updatePermanencesForColumn_, used below for initialization, is
   // used elsewhere and necessarily updates permanences_, there is no need
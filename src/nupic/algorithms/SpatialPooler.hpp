@@ -30,11 +30,13 @@
 #include <capnp/message.h>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <nupic/math/SparseBinaryMatrix.hpp>
 #include <nupic/math/SparseMatrix.hpp>
 #include <nupic/proto/SpatialPoolerProto.capnp.h>
 #include <nupic/types/Serializable.hpp>
 #include <nupic/types/Types.hpp>
+#include <nupic/utils/ThreadPool.hpp>
 #include <string>
 #include <vector>
 
@@ -78,7 +80,8 @@ public:
                 Real synPermActiveInc = 0.05, Real synPermConnected = 0.1,
                 Real minPctOverlapDutyCycles = 0.001,
                 UInt dutyCyclePeriod = 1000, Real boostStrength = 0.0,
-                Int seed = 1, UInt spVerbosity = 0, bool wrapAround = true);
+                Int seed = 1, UInt spVerbosity = 0, bool wrapAround = true,
+                UInt numThreads = 1);
 
   virtual ~SpatialPooler() {}
 
@@ -202,6 +205,10 @@ public:
         at the beginning and end of an input dimension are considered
         neighbors for the purpose of mapping inputs to columns.
 
+  @param numThreads The number of threads that compute uses, including the
+        calling thread. The columns are split into contiguous blocks, one
+        per thread. The output is identical for any number of threads.
+
    */
   virtual void
   initialize(vector<UInt> inputDimensions, vector<UInt> columnDimensions,
@@ -211,7 +218,8 @@ public:
              Real synPermInactiveDec = 0.01, Real synPermActiveInc = 0.1,
              Real synPermConnected = 0.1, Real minPctOverlapDutyCycles = 0.001,
              UInt dutyCyclePeriod = 1000, Real boostStrength = 0.0,
-             Int seed = 1, UInt spVerbosity = 0, bool wrapAround = true);
+             Int seed = 1, UInt spVerbosity = 0, bool wrapAround = true,
+             UInt numThreads = 1);
 
   /**
   This is the main workshorse method of the SpatialPooler class. This
@@ -246,6 +254,31 @@ public:
    */
   virtual void compute(UInt inputVector[], bool learn, UInt activeVector[]);
 
+  /**
+  Same as compute(inputVector, learn, activeVector), but the input is given
+  as the indices of its active bits. The cost of computing overlaps and of
+  learning grows with the number of active bits rather than with the input
+  width.
+
+  The first call builds an index from each input bit to the columns it is
+  connected to. The SP keeps it up to date from then on.
+
+  @param activeInputsSize Number of active input bits.
+
+  @param activeInputs Indices of the active input bits, in increasing
+        order and without duplicates. Each index must be smaller than
+        getNumInputs().
+
+  @param learn Whether learning should be performed, as for the dense
+        compute.
+
+  @param activeVector An array of size getNumColumns() that will be
+        populated with 1's at the indices of the active columns, and 0's
+        everywhere else.
+   */
+  virtual void compute(UInt activeInputsSize, const UInt activeInputs[],
+                       bool learn, UInt activeVector[]);
+
   /**
    Removes the set of columns who have never been active from the set
    of active columns selected in the inhibition round. Such columns
@@ -511,6 +544,21 @@ public:
   */
   void setWrapAround(bool wrapAround);
 
+  /**
+  Returns the number of threads used by compute.
+
+  @returns integer number of threads.
+  */
+  UInt getNumThreads() const;
+
+  /**
+  Sets the number of threads used by compute, including the calling
+  thread. This is a runtime setting and is not serialized.
+
+  @param numThreads integer number of threads, must be at least 1.
+  */
+  void setNumThreads(UInt numThreads);
+
   /**
   Returns the update period.
 
@@ -906,6 +954,69 @@ public:
   */
   void updatePermanencesForColumn_(vector<Real> &perm, UInt column,
                                    bool raisePerm = true);
+
+  /**
+      The new permanences of one column, worked out over its potential pool
+      before they are written to the matrices. Learning fills one of these
+      per column, so the per-column arithmetic can run on worker threads
+      while the matrix writes stay on the calling thread.
+  */
+  struct ColumnUpdate {
+    // The permanence of each input in the potential pool, in the order of
+    // potentialPools_.getSparseRow(column).
+    vector<Real> potentialPerm;
+    // Whether the column has permanences outside its potential pool, in
+    // which case applyColumnUpdate_ falls back to the dense update.
+    bool outsidePotential;
+    bool raisePerm;
+    vector<UInt> connected;
+    vector<UInt> permIndices;
+    vector<Real> permValues;
+  };
+
+  /**
+      Copies a column's stored permanences into update.potentialPerm.
+  */
+  void loadColumnUpdate_(UInt column, ColumnUpdate &update) const;
+
+  /**
+      Sparse counterpart of updatePermanencesForColumn_. Clips, trims and
+      optionally raises update.potentialPerm, and works out the column's
+      connected inputs and stored permanences. Reads the matrices only, so
+      it is safe to call for different columns concurrently.
+
+      @param column     An int number identifying a column.
+
+      @param raisePerm  As for updatePermanencesForColumn_.
+
+      @param update     A ColumnUpdate filled by loadColumnUpdate_ whose
+     potentialPerm has been changed by the caller.
+  */
+  void computeColumnUpdate_(UInt column, bool raisePerm,
+                            ColumnUpdate &update);
+
+  /**
+      Writes a ColumnUpdate to permanences_, connectedSynapses_ and
+      connectedCounts_. The permanence row keeps its storage unless the
+      column gains stored permanences.
+  */
+  void applyColumnUpdate_(UInt column, const ColumnUpdate &update);
+
+  /**
+      Replaces a column's row of connectedSynapses_ and its connected count,
+      keeping connectedColumnsForInput_ in sync once it has been built.
+
+      @param column     An int number identifying a column.
+
+      @param connected  The connected input indices, in increasing order.
+  */
+  void setConnectedSynapses_(UInt column, const vector<UInt> &connected);
+
+  /**
+      Builds connectedColumnsForInput_ from connectedSynapses_.
+  */
+  void buildConnectedColumnsForInput_();
+
   UInt countConnected_(vector<Real> &perm);
   UInt raisePermanencesToThreshold_(vector<Real> &perm,
                                     vector<UInt> &potential);
@@ -931,6 +1042,21 @@ public:
      input bits which are turned on.
   */
   void calculateOverlap_(UInt inputVector[], vector<UInt> &overlap);
+
+  /**
+     Sparse counterpart of calculateOverlap_. Each active input adds one
+     to the overlap of every column it is connected to.
+
+     @param activeInputsSize Number of active input bits.
+
+     @param activeInputs Indices of the active input bits.
+
+     @param overlap an int vector containing the overlap score for each
+     column.
+  */
+  void calculateOverlapSparse_(UInt activeInputsSize,
+                               const UInt activeInputs[],
+                               vector<UInt> &overlap);
   void calculateOverlapPct_(vector<UInt> &overlaps, vector<Real> &overlapPct);
 
   bool isWinner_(Real score, vector<pair<UInt, Real>> &winners,
@@ -962,7 +1088,10 @@ public:
      columns with the highest overlap score in the entire region. At
      most half of the columns in a local neighborhood are allowed to be
      active. Columns with an overlap score below the 'stimulusThreshold'
-     are always inhibited.
+     are always inhibited. Among equal overlap scores the column with the
+     higher index wins.
+
+     The active columns are returned in order of decreasing overlap.
 
      @param overlaps
      a real array containing the overlap score for each column. The
@@ -1008,6 +1137,14 @@ public:
   void inhibitColumnsLocal_(const vector<Real> &overlaps, Real density,
                             vector<UInt> &activeColumns);
 
+  /**
+     Multithreaded variant of inhibitColumnsLocal_ with identical results.
+     Columns whose outcome does not depend on tie-breaking are decided in
+     parallel; the rest are decided serially in column order.
+  */
+  void inhibitColumnsLocalParallel_(const vector<Real> &overlaps, Real density,
+                                    vector<UInt> &activeColumns);
+
   /**
       The primary method in charge of learning.
 
@@ -1027,6 +1164,36 @@ public:
             */
   void adaptSynapses_(UInt inputVector[], vector<UInt> &activeColumns);
 
+  /**
+      Sparse counterpart of adaptSynapses_. Each active column's potential
+      pool is merged with the sorted active inputs, so no array the size of
+      the input is built.
+
+      @param activeInputsSize Number of active input bits.
+
+      @param activeInputs Indices of the active input bits, in increasing
+     order.
+
+      @param  activeColumns  an int vector containing the indices of the columns
+     that survived inhibition.
+  */
+  void adaptSynapsesSparse_(UInt activeInputsSize, const UInt activeInputs[],
+                            vector<UInt> &activeColumns);
+
+  /**
+      Applies learning to each active column through a ColumnUpdate, on the
+      thread pool when there is one.
+
+      @param  activeColumns  an int vector containing the indices of the columns
+     that survived inhibition.
+
+      @param  adaptColumn    called as adaptColumn(potential, potentialPerm)
+     to add the permanence changes to a column's potential pool.
+  */
+  template <typename AdaptColumn>
+  void adaptColumns_(const vector<UInt> &activeColumns,
+                     AdaptColumn adaptColumn);
+
   /**
       This method increases the permanence values of synapses of columns whose
       activity level has been too low. Such columns are identified by having an
@@ -1279,6 +1446,14 @@ protected:
   SparseBinaryMatrix<UInt, UInt> connectedSynapses_;
   vector<UInt> connectedCounts_;
 
+  // For each input, the columns connected to it, in increasing order. Empty
+  // until the sparse compute first needs it.
+  vector<vector<UInt>> connectedColumnsForInput_;
+
+  // Scratch space for learning, reused between calls.
+  ColumnUpdate columnUpdate_;
+  vector<ColumnUpdate> columnUpdates_;
+
   vector<UInt> overlaps_;
   vector<Real> overlapsPct_;
   vector<Real> boostedOverlaps_;
@@ -1287,6 +1462,9 @@ protected:
 
   UInt version_;
   Random rng_;
+
+  // Shared between copies; ThreadPool serializes concurrent parallelFor calls.
+  std::shared_ptr<util::ThreadPool> threadPool_;
 };
 
 } // end namespace spatial_pooler
@@ -47,6 +47,9 @@
 
 #include <nupic/algorithms/Connections.hpp>
 #include <nupic/algorithms/TemporalMemory.hpp>
+#include <nupic/os/MappedFile.hpp>
+#include <nupic/os/Profiler.hpp>
+#include <nupic/utils/BinaryStream.hpp>
 #include <nupic/utils/GroupBy.hpp>
 
 using namespace std;
@@ -56,6 +59,12 @@ using namespace nupic::algorithms::temporal_memory;
 
 static const Permanence EPSILON = 0.000001;
 static const UInt TM_VERSION = 2;
+static const UInt32 TM_BINARY_VERSION = 1;
+
+static const UInt32 activateCellsProbe =
+    Profiler::getTimingProbe("TemporalMemory.activateCells");
+static const UInt32 activateDendritesProbe =
+    Profiler::getTimingProbe("TemporalMemory.activateDendrites");
 
 template <typename Iterator>
 bool isSortedWithoutDuplicates(Iterator begin, Iterator end) {
@@ -147,6 +156,9 @@ void TemporalMemory::initialize(
   winnerCells_.clear();
   activeSegments_.clear();
   matchingSegments_.clear();
+  numActiveConnectedSynapsesForSegment_.clear();
+  numActivePotentialSynapsesForSegment_.clear();
+  touchedSegments_.clear();
 }
 
 static CellIdx getLeastUsedCell(Random &rng, UInt column,
@@ -451,6 +463,8 @@ static void punishPredictedColumn(
 
 void TemporalMemory::activateCells(size_t activeColumnsSize,
                                    const UInt activeColumns[], bool learn) {
+  ProfileScope scope(activateCellsProbe);
+
   if (checkInputs_) {
     NTA_CHECK(isSortedWithoutDuplicates(activeColumns,
                                         activeColumns + activeColumnsSize))
@@ -516,31 +530,25 @@ void TemporalMemory::activateCells(size_t activeColumnsSize,
 }
 
 void TemporalMemory::activateDendrites(bool learn) {
+  ProfileScope scope(activateDendritesProbe);
+
   const UInt32 length = connections.segmentFlatListLength();
 
-  numActiveConnectedSynapsesForSegment_.assign(length, 0);
-  numActivePotentialSynapsesForSegment_.assign(length, 0);
+  // Only the segments touched by the previous step have non-zero counts
+  for (Segment segment : touchedSegments_) {
+    numActiveConnectedSynapsesForSegment_[segment] = 0;
+    numActivePotentialSynapsesForSegment_[segment] = 0;
+  }
+  numActiveConnectedSynapsesForSegment_.resize(length, 0);
+  numActivePotentialSynapsesForSegment_.resize(length, 0);
   connections.computeActivity(numActiveConnectedSynapsesForSegment_,
                               numActivePotentialSynapsesForSegment_,
-                              activeCells_, connectedPermanence_);
-
-  // Active segments, connected synapses.
-  activeSegments_.clear();
-  for (Segment segment = 0;
-       segment < numActiveConnectedSynapsesForSegment_.size(); segment++) {
-    if (numActiveConnectedSynapsesForSegment_[segment] >=
-        activationThreshold_) {
-      activeSegments_.push_back(segment);
-    }
-  }
-  std::sort(
-      activeSegments_.begin(), activeSegments_.end(),
-      [&](Segment a, Segment b) { return connections.compareSegments(a, b); });
+                              touchedSegments_, activeCells_,
+                              connectedPermanence_);
 
   // Matching segments, potential synapses.
   matchingSegments_.clear();
-  for (Segment segment = 0;
-       segment < numActivePotentialSynapsesForSegment_.size(); segment++) {
+  for (Segment segment : touchedSegments_) {
     if (numActivePotentialSynapsesForSegment_[segment] >= minThreshold_) {
       matchingSegments_.push_back(segment);
     }
@@ -549,6 +557,26 @@ void TemporalMemory::activateDendrites(bool learn) {
       matchingSegments_.begin(), matchingSegments_.end(),
       [&](Segment a, Segment b) { return connections.compareSegments(a, b); });
 
+  // Active segments, connected synapses. A segment's connected count never
+  // exceeds its potential count, so when activationThreshold is at least
+  // minThreshold every active segment is also matching and keeps its order.
+  activeSegments_.clear();
+  const vector<Segment> &candidates =
+      activationThreshold_ >= minThreshold_ ? matchingSegments_
+                                            : touchedSegments_;
+  for (Segment segment : candidates) {
+    if (numActiveConnectedSynapsesForSegment_[segment] >=
+        activationThreshold_) {
+      activeSegments_.push_back(segment);
+    }
+  }
+  if (activationThreshold_ < minThreshold_) {
+    std::sort(activeSegments_.begin(), activeSegments_.end(),
+              [&](Segment a, Segment b) {
+                return connections.compareSegments(a, b);
+              });
+  }
+
   if (learn) {
     for (Segment segment : activeSegments_) {
       lastUsedIterationForSegment_[segment] = iteration_;
@@ -966,6 +994,16 @@ void TemporalMemory::read(TemporalMemoryProto::Reader &proto) {
         segmentNumPair.getCell(), segmentNumPair.getIdxOnCell());
     numActivePotentialSynapsesForSegment_[segment] = segmentNumPair.getNumber();
   }
+  // Keep only the counts of active and matching segments, like load(), so
+  // that every non-zero count is in the touched set and gets reset
+  vector<UInt32> potentialCounts(connections.segmentFlatListLength(), 0);
+  for (Segment segment : activeSegments_) {
+    potentialCounts[segment] = numActivePotentialSynapsesForSegment_[segment];
+  }
+  for (Segment segment : matchingSegments_) {
+    potentialCounts[segment] = numActivePotentialSynapsesForSegment_[segment];
+  }
+  numActivePotentialSynapsesForSegment_.swap(potentialCounts);
 
   iteration_ = proto.getIteration();
 
@@ -976,6 +1014,149 @@ void TemporalMemory::read(TemporalMemoryProto::Reader &proto) {
         segmentIterationPair.getCell(), segmentIterationPair.getIdxOnCell());
     lastUsedIterationForSegment_[segment] = segmentIterationPair.getNumber();
   }
+
+  resetTouchedSegments_();
+}
+
+void TemporalMemory::saveBinary(ostream &outStream) const {
+  util::BinaryWriter writer(outStream);
+  writer.writeMarker("NTATMBIN");
+  writer.write<UInt32>(TM_BINARY_VERSION);
+
+  writer.writeVector(columnDimensions_);
+  writer.write<UInt32>(cellsPerColumn_);
+  writer.write<UInt32>(activationThreshold_);
+  writer.write<UInt32>(minThreshold_);
+  writer.write<UInt32>(maxNewSynapseCount_);
+  writer.write<Byte>(checkInputs_);
+  writer.write<Real32>(initialPermanence_);
+  writer.write<Real32>(connectedPermanence_);
+  writer.write<Real32>(permanenceIncrement_);
+  writer.write<Real32>(permanenceDecrement_);
+  writer.write<Real32>(predictedSegmentDecrement_);
+  writer.write<UInt32>(maxSegmentsPerCell_);
+  writer.write<UInt32>(maxSynapsesPerSegment_);
+  writer.write<UInt64>(iteration_);
+
+  connections.saveBinary(outStream);
+
+  stringstream rng;
+  rng << rng_;
+  writer.writeString(rng.str());
+
+  writer.writeVector(activeCells_);
+  writer.writeVector(winnerCells_);
+
+  // Connections::saveBinary packs segments in cell order, so translate flat
+  // indices into positions in that order.
+  vector<Segment> packed(connections.segmentFlatListLength());
+  vector<UInt64> lastUsedIteration;
+  lastUsedIteration.reserve(connections.numSegments());
+  for (CellIdx cell = 0; cell < connections.numCells(); cell++) {
+    for (Segment segment : connections.segmentsForCell(cell)) {
+      packed[segment] = lastUsedIteration.size();
+      lastUsedIteration.push_back(lastUsedIterationForSegment_[segment]);
+    }
+  }
+
+  // As with save, the counts are only meaningful for active and matching
+  // segments.
+  vector<Segment> segments;
+  vector<UInt32> counts;
+  for (Segment segment : activeSegments_) {
+    segments.push_back(packed[segment]);
+    counts.push_back(numActiveConnectedSynapsesForSegment_[segment]);
+  }
+  writer.writeVector(segments);
+  writer.writeVector(counts);
+
+  segments.clear();
+  counts.clear();
+  for (Segment segment : matchingSegments_) {
+    segments.push_back(packed[segment]);
+    counts.push_back(numActivePotentialSynapsesForSegment_[segment]);
+  }
+  writer.writeVector(segments);
+  writer.writeVector(counts);
+
+  writer.writeVector(lastUsedIteration);
+
+  writer.writeMarker("~NTATMBN");
+}
+
+void TemporalMemory::loadBinary(const string &path) {
+  MappedFile file(path);
+  util::BinaryReader reader(file.data(), file.size());
+  loadBinary(reader);
+}
+
+void TemporalMemory::loadBinary(util::BinaryReader &reader) {
+  reader.readMarker("NTATMBIN");
+  const UInt32 version = reader.read<UInt32>();
+  NTA_CHECK(version <= TM_BINARY_VERSION);
+
+  reader.readVector(columnDimensions_);
+  numColumns_ = 1;
+  for (UInt dimension : columnDimensions_) {
+    numColumns_ *= dimension;
+  }
+  cellsPerColumn_ = reader.read<UInt32>();
+  activationThreshold_ = reader.read<UInt32>();
+  minThreshold_ = reader.read<UInt32>();
+  maxNewSynapseCount_ = reader.read<UInt32>();
+  checkInputs_ = reader.read<Byte>() != 0;
+  initialPermanence_ = reader.read<Real32>();
+  connectedPermanence_ = reader.read<Real32>();
+  permanenceIncrement_ = reader.read<Real32>();
+  permanenceDecrement_ = reader.read<Real32>();
+  predictedSegmentDecrement_ = reader.read<Real32>();
+  maxSegmentsPerCell_ = reader.read<UInt32>();
+  maxSynapsesPerSegment_ = reader.read<UInt32>();
+  iteration_ = reader.read<UInt64>();
+
+  connections.loadBinary(reader);
+  const UInt32 numSegments = connections.segmentFlatListLength();
+  const UInt32 numCells = numColumns_ * cellsPerColumn_;
+  NTA_CHECK(connections.numCells() == numCells);
+
+  stringstream rng(reader.readString());
+  rng >> rng_;
+
+  reader.readVector(activeCells_);
+  for (CellIdx cell : activeCells_) {
+    NTA_CHECK(cell < numCells);
+  }
+  reader.readVector(winnerCells_);
+  for (CellIdx cell : winnerCells_) {
+    NTA_CHECK(cell < numCells);
+  }
+
+  numActiveConnectedSynapsesForSegment_.assign(numSegments, 0);
+  numActivePotentialSynapsesForSegment_.assign(numSegments, 0);
+
+  vector<UInt32> counts;
+  reader.readVector(activeSegments_);
+  reader.readVector(counts);
+  NTA_CHECK(counts.size() == activeSegments_.size());
+  for (size_t i = 0; i < activeSegments_.size(); i++) {
+    NTA_CHECK(activeSegments_[i] < numSegments);
+    numActiveConnectedSynapsesForSegment_[activeSegments_[i]] = counts[i];
+  }
+
+  reader.readVector(matchingSegments_);
+  reader.readVector(counts);
+  NTA_CHECK(counts.size() == matchingSegments_.size());
+  for (size_t i = 0; i < matchingSegments_.size(); i++) {
+    NTA_CHECK(matchingSegments_[i] < numSegments);
+    numActivePotentialSynapsesForSegment_[matchingSegments_[i]] = counts[i];
+  }
+
+  reader.readVector(lastUsedIterationForSegment_);
+  NTA_CHECK(lastUsedIterationForSegment_.size() == numSegments);
+
+  reader.readMarker("~NTATMBN");
+
+  resetTouchedSegments_();
 }
 
 void TemporalMemory::load(istream &inStream) {
@@ -1088,11 +1269,20 @@ void TemporalMemory::load(istream &inStream) {
   }
 
   lastUsedIterationForSegment_.resize(connections.segmentFlatListLength());
+  resetTouchedSegments_();
 
   inStream >> marker;
   NTA_CHECK(marker == "~TemporalMemory");
 }
 
+void TemporalMemory::resetTouchedSegments_() {
+  // Deserialized counts are only non-zero for the active and matching
+  // segments
+  touchedSegments_ = activeSegments_;
+  touchedSegments_.insert(touchedSegments_.end(), matchingSegments_.begin(),
+                          matchingSegments_.end());
+}
+
 static set<pair<CellIdx, SynapseIdx>>
 getComparableSegmentSet(const Connections &connections,
                         const vector<Segment> &segments) {
@@ -414,6 +414,32 @@ public:
   using Serializable::read;
   virtual void read(TemporalMemoryProto::Reader &proto) override;
 
+  /**
+   * Save a little-endian binary snapshot to the specified output stream.
+   * Unlike save, this writes the per-segment arrays flat and also keeps the
+   * last used iteration of every segment.
+   *
+   * @param outStream A valid ostream, opened in binary mode.
+   */
+  void saveBinary(ostream &outStream) const;
+
+  /**
+   * Load a snapshot written by saveBinary from the specified file. The file
+   * is memory-mapped read-only, so only the pages that are parsed are read.
+   *
+   * @param path Path to the snapshot file.
+   */
+  void loadBinary(const string &path);
+
+#ifndef SWIG
+  /**
+   * Load a snapshot written by saveBinary from a buffer.
+   *
+   * @param reader Reader positioned at the start of the snapshot.
+   */
+  void loadBinary(util::BinaryReader &reader);
+#endif
+
   /**
    * Returns the number of bytes that a save operation would result in.
    * Note: this method is currently somewhat inefficient as it just does
@@ -455,6 +481,9 @@ public:
   void printState(vector<Real> &state);
 
 protected:
+  // Rebuilds touchedSegments_ after deserialization
+  void resetTouchedSegments_();
+
   UInt numColumns_;
   vector<UInt> columnDimensions_;
   UInt cellsPerColumn_;
@@ -474,6 +503,9 @@ protected:
   vector<Segment> matchingSegments_;
   vector<UInt32> numActiveConnectedSynapsesForSegment_;
   vector<UInt32> numActivePotentialSynapsesForSegment_;
+  // Segments whose counts above may be non-zero, zeroed before each
+  // activateDendrites instead of the whole vectors
+  vector<Segment> touchedSegments_;
 
   UInt maxSegmentsPerCell_;
   UInt maxSynapsesPerSegment_;
@@ -0,0 +1,97 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of TemporalMemoryBatch
+ */
+
+#include <nupic/algorithms/TemporalMemoryBatch.hpp>
+#include <nupic/utils/Log.hpp>
+#include <nupic/utils/ThreadPool.hpp>
+
+using namespace std;
+using namespace nupic;
+using namespace nupic::algorithms::temporal_memory;
+using nupic::util::ThreadPool;
+
+TemporalMemoryBatch::TemporalMemoryBatch() {
+  threadPool_ = make_shared<ThreadPool>(1);
+}
+
+TemporalMemoryBatch::TemporalMemoryBatch(const TemporalMemory &prototype,
+                                         UInt batchSize, UInt numThreads) {
+  threadPool_ = make_shared<ThreadPool>(1);
+  initialize(prototype, batchSize, numThreads);
+}
+
+TemporalMemoryBatch::~TemporalMemoryBatch() {}
+
+void TemporalMemoryBatch::initialize(const TemporalMemory &prototype,
+                                     UInt batchSize, UInt numThreads) {
+  streams_.assign(batchSize, prototype);
+  setNumThreads(numThreads);
+}
+
+void TemporalMemoryBatch::compute(const size_t activeColumnsSizes[],
+                                  const UInt *const activeColumns[],
+                                  bool learn) {
+  // Streams share nothing, so each block of streams runs independently.
+  threadPool_->parallelFor(streams_.size(), [&](UInt begin, UInt end) {
+    for (UInt stream = begin; stream < end; stream++) {
+      streams_[stream].compute(activeColumnsSizes[stream],
+                               activeColumns[stream], learn);
+    }
+  });
+}
+
+void TemporalMemoryBatch::reset() {
+  for (TemporalMemory &stream : streams_) {
+    stream.reset();
+  }
+}
+
+UInt TemporalMemoryBatch::getBatchSize() const { return streams_.size(); }
+
+TemporalMemory &TemporalMemoryBatch::getStream(UInt stream) {
+  NTA_CHECK(stream < streams_.size())
+      << "Stream " << stream << " is out of range, the batch has "
+      << streams_.size() << " streams";
+  return streams_[stream];
+}
+
+const TemporalMemory &TemporalMemoryBatch::getStream(UInt stream) const {
+  NTA_CHECK(stream < streams_.size())
+      << "Stream " << stream << " is out of range, the batch has "
+      << streams_.size() << " streams";
+  return streams_[stream];
+}
+
+UInt TemporalMemoryBatch::getNumThreads() const {
+  return threadPool_->getNumThreads();
+}
+
+void TemporalMemoryBatch::setNumThreads(UInt numThreads) {
+  NTA_CHECK(numThreads >= 1);
+  if (numThreads != threadPool_->getNumThreads()) {
+    threadPool_ = make_shared<ThreadPool>(numThreads);
+  }
+}
@@ -0,0 +1,146 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definitions for the TemporalMemoryBatch class in C++
+ */
+
+#ifndef NTA_TEMPORAL_MEMORY_BATCH_HPP
+#define NTA_TEMPORAL_MEMORY_BATCH_HPP
+
+#include <memory>
+#include <vector>
+
+#include <nupic/algorithms/TemporalMemory.hpp>
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+
+namespace util {
+class ThreadPool;
+}
+
+namespace algorithms {
+namespace temporal_memory {
+
+/**
+ * A batch of independent Temporal Memory streams stepped together.
+ *
+ * @b Description
+ * Each stream is a full TemporalMemory with its own connections and
+ * state. All streams start as copies of one prototype, so they share its
+ * parameters. compute() steps every stream once, spreading the streams
+ * over a thread pool. Each stream computes exactly as it would if it were
+ * stepped on its own.
+ *
+ * The streams are stored contiguously. Use getStream() to seed, inspect,
+ * save or load an individual stream.
+ *
+ * Example usage:
+ *
+ *     TemporalMemory prototype(columnDimensions, cellsPerColumn);
+ *     TemporalMemoryBatch batch(prototype, numStreams, numThreads);
+ *     batch.compute(activeColumnsSizes, activeColumns, learn);
+ *     batch.getStream(i).getPredictiveCells();
+ */
+class TemporalMemoryBatch {
+public:
+  TemporalMemoryBatch();
+
+  /**
+   * Initialize the batch with copies of a prototype.
+   *
+   * @param prototype
+   * Temporal Memory whose parameters and state every stream starts from.
+   *
+   * @param batchSize
+   * Number of streams.
+   *
+   * @param numThreads
+   * Number of threads used by compute, including the calling thread.
+   */
+  TemporalMemoryBatch(const TemporalMemory &prototype, UInt batchSize,
+                      UInt numThreads = 1);
+
+  virtual ~TemporalMemoryBatch();
+
+  virtual void initialize(const TemporalMemory &prototype, UInt batchSize,
+                          UInt numThreads = 1);
+
+  /**
+   * Perform one time step on every stream.
+   *
+   * @param activeColumnsSizes
+   * Number of active columns of each stream, batchSize entries.
+   *
+   * @param activeColumns
+   * Sorted list of indices of active columns of each stream, batchSize
+   * entries.
+   *
+   * @param learn
+   * Whether or not learning is enabled.
+   */
+  virtual void compute(const size_t activeColumnsSizes[],
+                       const UInt *const activeColumns[], bool learn = true);
+
+  /**
+   * Indicates the start of a new sequence on every stream.
+   */
+  virtual void reset();
+
+  /**
+   * Returns the number of streams.
+   */
+  UInt getBatchSize() const;
+
+  /**
+   * Returns one stream of the batch.
+   *
+   * @param stream Index of the stream, less than getBatchSize().
+   */
+  TemporalMemory &getStream(UInt stream);
+  const TemporalMemory &getStream(UInt stream) const;
+
+  /**
+   * Returns the number of threads used by compute.
+   */
+  UInt getNumThreads() const;
+
+  /**
+   * Sets the number of threads used by compute, including the calling
+   * thread.
+   *
+   * @param numThreads integer number of threads, must be at least 1.
+   */
+  void setNumThreads(UInt numThreads);
+
+protected:
+  vector<TemporalMemory> streams_;
+
+  std::shared_ptr<util::ThreadPool> threadPool_;
+};
+
+} // end namespace temporal_memory
+} // end namespace algorithms
+} // namespace nupic
+
+#endif // NTA_TEMPORAL_MEMORY_BATCH_HPP
@@ -117,6 +117,15 @@ _ALGORITHMS = _algorithms
   nupic::initializeNumpy();
 %}
 
+// The compute methods of SpatialPooler, TemporalMemory and Cells4 release
+// the GIL while the C++ code runs, so Python threads can drive independent
+// models in parallel. An instance is not thread safe: a thread must not use
+// an instance, or the numpy arrays passed to its compute, while another
+// thread is in that instance's compute.
+%init %{
+  PyEval_InitThreads();
+%}
+
 %{
 #include <nupic/py_support/NumpyVector.hpp>
 #include <nupic/py_support/PyCapnp.hpp>
@@ -1050,7 +1059,10 @@ void forceRetentionOfImageSensorLiteLibrary(void) {
   {
     PyArrayObject* x = (PyArrayObject*) py_x;
     nupic::NumpyVectorT<nupic::Real> y(self->nCells());
-    self->compute((nupic::Real*) PyArray_DATA(x), y.begin(), doInference, doLearning);
+    {
+      nupic::py::ReleaseGIL releaseGIL;
+      self->compute((nupic::Real*) PyArray_DATA(x), y.begin(), doInference, doLearning);
+    }
     return y.forPython();
   }
 }
@@ -1173,6 +1185,7 @@ void forceRetentionOfImageSensorLiteLibrary(void) {
   {
     nupic::CheckedNumpyVectorWeakRefT<nupic::UInt> inputArray(py_inputArray);
     nupic::CheckedNumpyVectorWeakRefT<nupic::UInt> activeArray(py_activeArray);
+    nupic::py::ReleaseGIL releaseGIL;
     self->compute(inputArray.begin(), learn, activeArray.begin());
   }
 
@@ -1379,9 +1392,10 @@ void forceRetentionOfImageSensorLiteLibrary(void) {
   %pythoncode %{
     VERSION = 1
 
-    def __init__(self, steps=(1,), alpha=0.001, actValueAlpha=0.3, verbosity=0):
+    def __init__(self, steps=(1,), alpha=0.001, actValueAlpha=0.3, verbosity=0,
+                 useFloat32=False):
       self.this = _ALGORITHMS.new_SDRClassifier(
-          steps, alpha, actValueAlpha, verbosity)
+          steps, alpha, actValueAlpha, verbosity, useFloat32)
       self.valueToCategory = {}
       self.version = SDRClassifier.VERSION
 
@@ -1775,6 +1789,9 @@ void forceRetentionOfImageSensorLiteLibrary(void) {
 
       @param learn (boolean)
       Whether or not learning is enabled.
+
+      Other Python threads run while this computes. This instance must not
+      be used by them in the meantime.
       """
       activeColumnsArray = numpy.array(sorted(activeColumns), dtype=uintDType)
       self.convertedCompute(activeColumnsArray, learn)
@@ -1871,6 +1888,7 @@ void forceRetentionOfImageSensorLiteLibrary(void) {
     UInt32* activeColumns =
       (UInt32*)PyArray_DATA(_activeColumns);
 
+    nupic::py::ReleaseGIL releaseGIL;
     self->activateCells(activeColumnsSize,
                         activeColumns,
                         learn);
@@ -1886,6 +1904,7 @@ void forceRetentionOfImageSensorLiteLibrary(void) {
     UInt32* activeColumns =
       (UInt32*)PyArray_DATA(_activeColumns);
 
+    nupic::py::ReleaseGIL releaseGIL;
     self->compute(activeColumnsSize, activeColumns, learn);
   }
 
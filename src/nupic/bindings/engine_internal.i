@@ -89,6 +89,7 @@ _TRAVERSAL_LIMIT_IN_WORDS = 1 << 63
 #include <nupic/engine/Link.hpp>
 #include <nupic/engine/Region.hpp>
 #include <nupic/engine/Spec.hpp>
+#include <nupic/os/Profiler.hpp>
 #include <nupic/os/Timer.hpp>
 #include <nupic/utils/Watcher.hpp>
 
@@ -172,7 +173,22 @@ class IterablePair(object):
   %}
 }
 
+// For Network::getProfilingSnapshot()
+%ignore nupic::ProfileScope;
+%include <nupic/os/Profiler.hpp>
+%template(ProfileEntryVector) std::vector<nupic::ProfileEntry>;
+
 %include <nupic/engine/NuPIC.hpp>
+
+// Network.run() releases the GIL, so Python threads can run independent
+// networks in parallel. Python regions take the GIL back to compute, and
+// need it to initialize. A network is not thread safe: no other thread may
+// use it, its regions or their buffers until run() returns.
+%feature("action") nupic::Network::run {
+  arg1->initialize();
+  nupic::py::ReleaseGIL releaseGIL;
+  arg1->run(arg2);
+}
 %include <nupic/engine/Network.hpp>
 %ignore nupic::Region::getInputData;
 %ignore nupic::Region::getOutputData;
@@ -207,6 +223,11 @@ class IterablePair(object):
   nupic::initializeNumpy();
 %}
 
+// Network.run() releases the GIL, see above
+%init %{
+  PyEval_InitThreads();
+%}
+
 
 %include <nupic/py_support/PyArray.hpp>
 %template(ByteArray) nupic::PyArray<nupic::Byte>;
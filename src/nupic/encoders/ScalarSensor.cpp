@@ -82,6 +82,18 @@ void ScalarSensor::compute() {
   Real32 *array = (Real32 *)encodedOutput_->getData().getBuffer();
   const Int32 iBucket = encoder_->encodeIntoArray(sensedValue_, array);
   ((Int32 *)bucketOutput_->getData().getBuffer())[0] = iBucket;
+
+  // The same encoding as the indices of its active bits
+  Array &sparse = const_cast<Array &>(sparseEncodedOutput_->getData());
+  UInt32 *indices = (UInt32 *)sparse.getBuffer();
+  const size_t n = encodedOutput_->getData().getCount();
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (array[i] != 0) {
+      indices[count++] = (UInt32)i;
+    }
+  }
+  sparse.setCount(count);
 }
 
 /* static */ Spec *ScalarSensor::createSpec() {
@@ -169,6 +181,15 @@ void ScalarSensor::compute() {
                                         true  // isDefaultOutput
                                         ));
 
+  ns->outputs.add("sparseEncoded",
+                  OutputSpec("Encoded value as the indices of its active bits",
+                             NTA_BasicType_UInt32,
+                             0,     // elementCount
+                             true,  // isRegionLevel
+                             false, // isDefaultOutput
+                             true   // sparse
+                             ));
+
   ns->outputs.add("bucket", OutputSpec("Bucket number for this sensedValue",
                                        NTA_BasicType_Int32,
                                        0,    // elementCount
@@ -202,11 +223,12 @@ void ScalarSensor::setParameterFromBuffer(const std::string &name, Int64 index,
 
 void ScalarSensor::initialize() {
   encodedOutput_ = getOutput("encoded");
+  sparseEncodedOutput_ = getOutput("sparseEncoded");
   bucketOutput_ = getOutput("bucket");
 }
 
 size_t ScalarSensor::getNodeOutputElementCount(const std::string &outputName) {
-  if (outputName == "encoded") {
+  if (outputName == "encoded" || outputName == "sparseEncoded") {
     return encoder_->getOutputWidth();
   } else if (outputName == "bucket") {
     return 1;
@@ -84,6 +84,7 @@ private:
   Real64 sensedValue_;
   ScalarEncoderBase *encoder_;
   const Output *encodedOutput_;
+  const Output *sparseEncodedOutput_;
   const Output *bucketOutput_;
 };
 } // namespace nupic
@@ -39,7 +39,8 @@ namespace nupic {
 Input::Input(Region &region, NTA_BasicType dataType, bool isRegionLevel,
              bool isSparse)
     : region_(region), isRegionLevel_(isRegionLevel), initialized_(false),
-      data_(dataType), name_("Unnamed"), isSparse_(isSparse) {}
+      zeroCopy_(false), data_(dataType), name_("Unnamed"),
+      isSparse_(isSparse) {}
 
 Input::~Input() {
   uninitialize();
@@ -113,8 +114,12 @@ Link *Input::findLink(const std::string &srcRegionName,
 }
 
 void Input::prepare() {
-  // Each link copies data into its section of the overall input
+  // Each link copies data into its section of the overall input. Links into
+  // a sparse input append their indices.
   // TODO: initialization check?
+  if (isSparse_ && !zeroCopy_) {
+    data_.setCount(0);
+  }
   for (auto &elem : links_) {
     (elem)->compute();
   }
@@ -135,6 +140,8 @@ bool Input::isRegionLevel() { return isRegionLevel_; }
 
 bool Input::isSparse() { return isSparse_; }
 
+bool Input::isZeroCopy() const { return zeroCopy_; }
+
 // See header file for documentation
 size_t Input::evaluateLinks() {
   /**
@@ -474,15 +481,35 @@ void Input::initialize() {
     // Setting the destination offset makes the link usable.
     // TODO: change
     (*l)->initialize(count);
-    count += (*l)->getSrc().getData().getCount();
+    // The dense width of a sparse output is the capacity of its buffer
+    const Array &srcData = (*l)->getSrc().getData();
+    count += (*l)->getSrc().isSparse() ? srcData.getMaxElementsCount()
+                                       : srcData.getCount();
+  }
+
+  // A single undelayed link that needs no conversion can share the source
+  // buffer instead of copying it on every prepare(). A region linked to
+  // itself keeps a copy so that it does not read its output as it writes it.
+  if (links_.size() == 1 && links_[0]->getPropagationDelay() == 0) {
+    Output &src = links_[0]->getSrc();
+    const Array &srcData = src.getData();
+    zeroCopy_ = &src.getRegion() != &region_ &&
+                src.isSparse() == isSparse_ &&
+                srcData.getType() == data_.getType() &&
+                srcData.getBuffer() != nullptr;
   }
 
-  // Later we may optimize with the zeroCopyEnabled_ flag but
-  // for now we always allocate our own buffer.
-  data_.allocateBuffer(count);
+  if (zeroCopy_) {
+    const Array &srcData = links_[0]->getSrc().getData();
+    data_.ArrayBase::setBuffer(srcData.getBuffer(),
+                              srcData.getMaxElementsCount());
+    data_.setCount(srcData.getCount());
+  } else {
+    data_.allocateBuffer(count);
+  }
 
   // Zero the inputs (required for inspectors)
-  if (count != 0) {
+  if (count != 0 && !zeroCopy_) {
     void *buffer = data_.getBuffer();
     ::memset(buffer, 0, data_.getBufferSize());
     if (isSparse_) {
@@ -515,6 +542,7 @@ void Input::uninitialize() {
   NTA_CHECK(!region_.isInitialized());
 
   initialized_ = false;
+  zeroCopy_ = false;
   data_.releaseBuffer();
   splitterMap_.clear();
 }
@@ -254,10 +254,21 @@ public:
    */
   bool isSparse();
 
+  /*
+   * Tells whether the input shares the buffer of its source Output instead
+   * of copying it. This is the case for an initialized input with a single
+   * link that has no propagation delay, no sparse/dense conversion and the
+   * same data type at both ends. A shared input must not be written to.
+   *
+   * @returns
+   *     Whether the input is zero-copy
+   */
+  bool isZeroCopy() const;
+
 private:
   Region &region_;
   // buffer is concatenation of input buffers (after prepare), or,
-  // if zeroCopyEnabled it points to the connected output
+  // if zeroCopy_ it points to the connected output
   bool isRegionLevel_;
 
   // Use a vector of links because order is important.
@@ -265,6 +276,7 @@ private:
 
   // volatile (non-serialized) state
   bool initialized_;
+  bool zeroCopy_;
   Array data_;
 
   /*
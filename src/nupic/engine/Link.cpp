@@ -23,7 +23,8 @@
 /** @file
  * Implementation of the Link class
  */
-#include <cstring> // memcpy,memset
+#include <algorithm> // fill
+#include <cstring>   // memcpy
 #include <nupic/engine/Input.hpp>
 #include <nupic/engine/Link.hpp>
 #include <nupic/engine/LinkPolicy.hpp>
@@ -31,6 +32,7 @@
 #include <nupic/engine/Output.hpp>
 #include <nupic/engine/Region.hpp>
 #include <nupic/ntypes/Array.hpp>
+#include <nupic/os/Profiler.hpp>
 #include <nupic/types/BasicType.hpp>
 #include <nupic/utils/ArrayProtoUtils.hpp>
 #include <nupic/utils/Log.hpp>
@@ -41,22 +43,18 @@
 
 namespace nupic {
 
-// Represents 'zero' scalar value used to compare Input/Output buffer contents
-// for non-zero values
-const static NTA_Real64 ZERO_VALUE = 0;
-
 Link::Link(const std::string &linkType, const std::string &linkParams,
            const std::string &srcRegionName, const std::string &destRegionName,
            const std::string &srcOutputName, const std::string &destInputName,
            const size_t propagationDelay)
-    : srcBuffer_(0) {
+    : srcBuffer_(0), bytesProbe_(Profiler::NO_PROBE), profilingEnabled_(false) {
   commonConstructorInit_(linkType, linkParams, srcRegionName, destRegionName,
                          srcOutputName, destInputName, propagationDelay);
 }
 
 Link::Link(const std::string &linkType, const std::string &linkParams,
            Output *srcOutput, Input *destInput, const size_t propagationDelay)
-    : srcBuffer_(0) {
+    : srcBuffer_(0), bytesProbe_(Profiler::NO_PROBE), profilingEnabled_(false) {
   commonConstructorInit_(linkType, linkParams, srcOutput->getRegion().getName(),
                          destInput->getRegion().getName(), srcOutput->getName(),
                          destInput->getName(), propagationDelay);
@@ -66,7 +64,9 @@ Link::Link(const std::string &linkType, const std::string &linkParams,
   // initialization time
 }
 
-Link::Link() : srcBuffer_(0) {}
+Link::Link()
+    : srcBuffer_(0), bytesProbe_(Profiler::NO_PROBE), profilingEnabled_(false) {
+}
 
 void Link::commonConstructorInit_(const std::string &linkType,
                                   const std::string &linkParams,
@@ -92,7 +92,10 @@ void Link::commonConstructorInit_(const std::string &linkType,
   impl_ = LinkPolicyFactory().createLinkPolicy(linkType, linkParams, this);
 }
 
-Link::~Link() { delete impl_; }
+Link::~Link() {
+  delete impl_;
+  Profiler::releaseProbe(bytesProbe_);
+}
 
 void Link::initPropagationDelayBuffer_(size_t propagationDelay,
                                        const Array &original) {
@@ -180,9 +183,9 @@ void Link::initialize(size_t destinationOffset) {
 
   // Validate sparse link
   if (src_->isSparse() && !dest_->isSparse()) {
-    // Sparse to dense: unit32 -> bool
-    NTA_CHECK(dest_->getDataType() == NTA_BasicType_Bool)
-        << "Sparse to Dense link destination must be boolean";
+    // Sparse to dense: uint32 -> any scalar type
+    NTA_CHECK(dest_->getDataType() != NTA_BasicType_Handle)
+        << "Sparse to Dense link destination must be a scalar type";
   } else if (!src_->isSparse() && dest_->isSparse()) {
     // Dense to sparse:  NTA_BasicType -> uint32
     NTA_CHECK(dest_->getDataType() == NTA_BasicType_UInt32)
@@ -200,6 +203,16 @@ void Link::initialize(size_t destinationOffset) {
   initialized_ = true;
 }
 
+void Link::enableProfiling(const std::string &probePrefix) {
+  if (bytesProbe_ == Profiler::NO_PROBE) {
+    bytesProbe_ = Profiler::getCounterProbe(probePrefix + "Link." +
+                                            getMoniker() + ".bytes");
+  }
+  profilingEnabled_ = true;
+}
+
+void Link::disableProfiling() { profilingEnabled_ = false; }
+
 void Link::setSrcDimensions(Dimensions &dims) {
   NTA_CHECK(src_ != nullptr && dest_ != nullptr)
       << "Link::setSrcDimensions() can only be called on a connected link";
@@ -249,6 +262,8 @@ const std::string &Link::getDestRegionName() const { return destRegionName_; }
 
 const std::string &Link::getDestInputName() const { return destInputName_; }
 
+size_t Link::getPropagationDelay() const { return propagationDelay_; }
+
 std::string Link::getMoniker() const {
   std::stringstream ss;
   ss << getSrcRegionName() << "." << getSrcOutputName() << "-->"
@@ -333,66 +348,170 @@ void Link::compute() {
 
   const Array &dest = dest_->getData();
 
-  size_t srcSize = src.getBufferSize();
-  size_t typeSize = BasicType::getSize(src.getType());
-  size_t destByteOffset = destOffset_ * typeSize;
-
   if (_LINK_DEBUG) {
     NTA_DEBUG << "Link::compute: " << getMoniker() << "; copying to dest input"
               << "; delay=" << propagationDelay_ << "; " << src.getCount()
               << " elements=" << src;
   }
 
+  // Remove 'const' to update the variable length array of sparse inputs.
+  // Sparse inputs are emptied by Input::prepare() and each link appends its
+  // indices, offset by the dense width of the links before it.
+  Array &destArray = const_cast<Array &>(dest);
+
+  // Bytes written to the destination, for the profiler
+  size_t bytesCopied = 0;
+
   if (src_->isSparse() == dest_->isSparse()) {
-    // No conversion required, just copy the buffer over
-    ::memcpy((char *)(dest.getBuffer()) + destByteOffset, src.getBuffer(),
-             srcSize);
-    if (dest_->isSparse()) {
-      // Remove 'const' to update the variable length array
-      const_cast<Array &>(dest).setCount(src.getCount());
+    if (dest.getBuffer() == src.getBuffer()) {
+      // The input shares the source buffer (see Input::initialize)
+      if (dest_->isSparse()) {
+        destArray.setCount(src.getCount());
+      }
+    } else if (dest_->isSparse()) {
+      const NTA_UInt32 *srcBuf = (const NTA_UInt32 *)src.getBuffer();
+      NTA_UInt32 *destBuf = (NTA_UInt32 *)dest.getBuffer();
+      size_t destIdx = dest.getCount();
+      NTA_CHECK(destIdx + src.getCount() <= dest.getMaxElementsCount())
+          << "Link destination is too small. "
+          << "It should be at least " << destIdx + src.getCount();
+      for (size_t i = 0; i < src.getCount(); i++) {
+        destBuf[destIdx++] = srcBuf[i] + (NTA_UInt32)destOffset_;
+      }
+      bytesCopied = src.getCount() * sizeof(NTA_UInt32);
+      destArray.setCount(destIdx);
+    } else {
+      // No conversion required, just copy the buffer over
+      size_t destByteOffset = destOffset_ * BasicType::getSize(src.getType());
+      ::memcpy((char *)(dest.getBuffer()) + destByteOffset, src.getBuffer(),
+               src.getBufferSize());
+      bytesCopied = src.getBufferSize();
     }
   } else if (dest_->isSparse()) {
-    // Destination is sparse, convert source from dense to sparse
-
-    // Sparse Output must be NTA_UInt32. See "initialize".
-    NTA_UInt32 *destBuf =
-        (NTA_UInt32 *)((char *)(dest.getBuffer()) + destByteOffset);
-
-    // Dense source can be any scalar type. The scalar values will be lost
-    // and only the indexes of the non-zero values will be stored.
-    char *srcBuf = (char *)src.getBuffer();
-    size_t destLen = dest.getBufferSize();
-    size_t destIdx = 0;
-    for (size_t i = 0; i < srcSize; i++) {
-      // Check for any non-zero scalar value
-      if (::memcmp(srcBuf + i * typeSize, &ZERO_VALUE, typeSize)) {
-        NTA_CHECK(destIdx < destLen) << "Link destination is too small. "
-                                     << "It should be at least " << destIdx + 1;
-        destBuf[destIdx++] = i;
-      }
+    // Destination is sparse, convert source from dense to sparse. Dense
+    // source can be any scalar type. The scalar values will be lost and only
+    // the indexes of the non-zero values will be stored.
+    size_t destIdx = dest.getCount();
+    switch (src.getType()) {
+    case NTA_BasicType_Byte:
+      destIdx = appendNonZeroIndices_<NTA_Byte>(src, dest, destIdx);
+      break;
+    case NTA_BasicType_Int16:
+      destIdx = appendNonZeroIndices_<NTA_Int16>(src, dest, destIdx);
+      break;
+    case NTA_BasicType_UInt16:
+      destIdx = appendNonZeroIndices_<NTA_UInt16>(src, dest, destIdx);
+      break;
+    case NTA_BasicType_Int32:
+      destIdx = appendNonZeroIndices_<NTA_Int32>(src, dest, destIdx);
+      break;
+    case NTA_BasicType_UInt32:
+      destIdx = appendNonZeroIndices_<NTA_UInt32>(src, dest, destIdx);
+      break;
+    case NTA_BasicType_Int64:
+      destIdx = appendNonZeroIndices_<NTA_Int64>(src, dest, destIdx);
+      break;
+    case NTA_BasicType_UInt64:
+      destIdx = appendNonZeroIndices_<NTA_UInt64>(src, dest, destIdx);
+      break;
+    case NTA_BasicType_Real32:
+      destIdx = appendNonZeroIndices_<NTA_Real32>(src, dest, destIdx);
+      break;
+    case NTA_BasicType_Real64:
+      destIdx = appendNonZeroIndices_<NTA_Real64>(src, dest, destIdx);
+      break;
+    case NTA_BasicType_Bool:
+      destIdx = appendNonZeroIndices_<bool>(src, dest, destIdx);
+      break;
+    default:
+      NTA_THROW << "Link " << getMoniker() << ": unsupported dense type "
+                << BasicType::getName(src.getType());
     }
-    // Remove 'const' to update the variable length array
-    const_cast<Array &>(dest).setCount(destIdx);
+    bytesCopied = (destIdx - dest.getCount()) * sizeof(NTA_UInt32);
+    destArray.setCount(destIdx);
   } else {
-    // Destination is dense, convert source from sparse to dense
-
-    // Sparse Input must be NTA_UInt32. See "initialize".
-    NTA_UInt32 *srcBuf = (NTA_UInt32 *)src.getBuffer();
+    // Destination is dense, convert source from sparse to dense. Every
+    // index in the source is set to 1 in the destination.
+    switch (dest.getType()) {
+    case NTA_BasicType_Byte:
+      scatterIndices_<NTA_Byte>(src, dest);
+      break;
+    case NTA_BasicType_Int16:
+      scatterIndices_<NTA_Int16>(src, dest);
+      break;
+    case NTA_BasicType_UInt16:
+      scatterIndices_<NTA_UInt16>(src, dest);
+      break;
+    case NTA_BasicType_Int32:
+      scatterIndices_<NTA_Int32>(src, dest);
+      break;
+    case NTA_BasicType_UInt32:
+      scatterIndices_<NTA_UInt32>(src, dest);
+      break;
+    case NTA_BasicType_Int64:
+      scatterIndices_<NTA_Int64>(src, dest);
+      break;
+    case NTA_BasicType_UInt64:
+      scatterIndices_<NTA_UInt64>(src, dest);
+      break;
+    case NTA_BasicType_Real32:
+      scatterIndices_<NTA_Real32>(src, dest);
+      break;
+    case NTA_BasicType_Real64:
+      scatterIndices_<NTA_Real64>(src, dest);
+      break;
+    case NTA_BasicType_Bool:
+      scatterIndices_<bool>(src, dest);
+      break;
+    default:
+      NTA_THROW << "Link " << getMoniker() << ": unsupported dense type "
+                << BasicType::getName(dest.getType());
+    }
+    bytesCopied = src_->getData().getMaxElementsCount() *
+                  BasicType::getSize(dest.getType());
+  }
 
-    // Dense destination links must be bool. See "initialize".
-    bool *destBuf = (bool *)((char *)dest.getBuffer() + destByteOffset);
+  if (profilingEnabled_)
+    Profiler::addUnchecked(bytesProbe_, bytesCopied);
+}
 
-    size_t srcLen = src.getCount();
-    size_t destLen = dest.getBufferSize();
-    ::memset(destBuf, 0, destLen);
-    size_t destIdx;
-    for (size_t i = 0; i < srcLen; i++) {
-      destIdx = srcBuf[i];
+template <typename T>
+size_t Link::appendNonZeroIndices_(const Array &src, const Array &dest,
+                                   size_t destIdx) const {
+  // Sparse Input must be NTA_UInt32. See "initialize".
+  const T *srcBuf = (const T *)src.getBuffer();
+  NTA_UInt32 *destBuf = (NTA_UInt32 *)dest.getBuffer();
+  const size_t destLen = dest.getMaxElementsCount();
+  for (size_t i = 0; i < src.getCount(); i++) {
+    if (srcBuf[i] != T(0)) {
       NTA_CHECK(destIdx < destLen) << "Link destination is too small. "
                                    << "It should be at least " << destIdx + 1;
-      destBuf[destIdx] = true;
+      destBuf[destIdx++] = (NTA_UInt32)(i + destOffset_);
     }
   }
+  return destIdx;
+}
+
+template <typename T>
+void Link::scatterIndices_(const Array &src, const Array &dest) const {
+  // Sparse Output must be NTA_UInt32. See "initialize".
+  const NTA_UInt32 *srcBuf = (const NTA_UInt32 *)src.getBuffer();
+
+  // The dense width of a sparse source is the capacity of its output buffer,
+  // which is allocated at the declared size. A delayed copy (src) may be
+  // smaller, e.g. after Link::read.
+  const size_t srcLen = src_->getData().getMaxElementsCount();
+  NTA_CHECK(destOffset_ + srcLen <= dest.getMaxElementsCount())
+      << "Link destination is too small. "
+      << "It should be at least " << destOffset_ + srcLen;
+  T *destBuf = (T *)dest.getBuffer() + destOffset_;
+  std::fill(destBuf, destBuf + srcLen, T(0));
+  for (size_t i = 0; i < src.getCount(); i++) {
+    NTA_CHECK(srcBuf[i] < srcLen) << "Link source index " << srcBuf[i]
+                                  << " is out of range. "
+                                  << "It should be less than " << srcLen;
+    destBuf[srcBuf[i]] = T(1);
+  }
 }
 
 void Link::shiftBufferedData() {
@@ -267,6 +267,14 @@ public:
    */
   const std::string &getDestInputName() const;
 
+  /**
+   * Get the propagation delay of the link.
+   *
+   * @returns
+   *         The number of iterations by which the link delays its data
+   */
+  size_t getPropagationDelay() const;
+
   /**
    * @}
    *
@@ -377,6 +385,18 @@ public:
    */
   void shiftBufferedData();
 
+  /**
+   * Count the bytes written to the destination. The first call registers
+   * the Profiler probe "<probePrefix>Link.<moniker>.bytes", which is
+   * released when the link is destroyed.
+   */
+  void enableProfiling(const std::string &probePrefix = "");
+
+  /**
+   * Stop counting the bytes written to the destination.
+   */
+  void disableProfiling();
+
   /**
    * Convert the Link to a human-readable string.
    *
@@ -417,6 +437,16 @@ private:
   void initPropagationDelayBuffer_(size_t propagationDelay,
                                    const Array &original);
 
+  // Appends the indices of the non-zero elements of a dense source to a
+  // sparse destination, starting at destIdx. Returns the new count.
+  template <typename T>
+  size_t appendNonZeroIndices_(const Array &src, const Array &dest,
+                               size_t destIdx) const;
+
+  // Writes a sparse source into this link's slice of a dense destination
+  template <typename T>
+  void scatterIndices_(const Array &src, const Array &dest) const;
+
   // TODO: The strings with src/dest names are redundant with
   // the src_ and dest_ objects. For unit testing links,
   // and for deserializing networks, we need to be able to create
@@ -459,6 +489,11 @@ private:
   // Number of delay slots
   size_t propagationDelay_;
 
+  // Profiler counter of the bytes written to the destination, NO_PROBE until
+  // profiling is first enabled
+  UInt32 bytesProbe_;
+  bool profilingEnabled_;
+
   // link must be initialized before it can compute()
   bool initialized_;
 };
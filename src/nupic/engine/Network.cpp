@@ -24,11 +24,18 @@
 Implementation of the Network class
 */
 
+#include <algorithm>
+#include <atomic>
+#include <fstream>
 #include <iostream>
 #include <limits>
 #include <sstream>
 #include <stdexcept>
 
+#include <capnp/message.h>
+#include <capnp/serialize.h>
+#include <kj/std/iostream.h>
+
 #include <nupic/engine/Input.hpp>
 #include <nupic/engine/Link.hpp>
 #include <nupic/engine/Network.hpp>
@@ -39,12 +46,14 @@ Implementation of the Network class
 #include <nupic/ntypes/BundleIO.hpp>
 #include <nupic/os/Directory.hpp>
 #include <nupic/os/FStream.hpp>
+#include <nupic/os/MappedFile.hpp>
 #include <nupic/os/Path.hpp>
 #include <nupic/proto/NetworkProto.capnp.h>
 #include <nupic/proto/RegionProto.capnp.h>
 #include <nupic/types/BasicType.hpp>
 #include <nupic/utils/Log.hpp>
 #include <nupic/utils/StringUtils.hpp>
+#include <nupic/utils/ThreadPool.hpp>
 #include <yaml-cpp/yaml.h>
 
 namespace nupic {
@@ -63,10 +72,15 @@ Network::Network(const std::string &path) {
 }
 
 void Network::commonInit() {
+  // Same-named regions of different networks don't share probes
+  static std::atomic<UInt64> nextProfilingId(0);
+  profilingPrefix_ = "Network" + std::to_string(nextProfilingId++) + ".";
+
   initialized_ = false;
   iteration_ = 0;
   minEnabledPhase_ = 0;
   maxEnabledPhase_ = 0;
+  threadPool_ = std::make_shared<util::ThreadPool>(1);
   // automatic initialization of NuPIC, so users don't
   // have to call NuPIC::initialize
   NuPIC::init();
@@ -205,6 +219,7 @@ void Network::setPhases_(Region *r, std::set<UInt32> &phases) {
   r->setPhases(phases);
 
   resetEnabledPhases_();
+  checkpointPath_.clear();
 }
 
 void Network::resetEnabledPhases_() {
@@ -274,6 +289,7 @@ void Network::removeRegion(const std::string &name) {
   // Region destructor cleans up all incoming links
   delete r;
 
+  checkpointPath_.clear();
   return;
 }
 
@@ -326,11 +342,11 @@ void Network::link(const std::string &srcRegionName,
         << BasicType::getName(srcOutput->getDataType())
         << " != " << BasicType::getName(destInput->getDataType());
   } else if (srcOutput->isSparse()) {
-    // Sparse to dense: unit32 -> bool
+    // Sparse to dense: uint32 -> any scalar type
     NTA_CHECK(srcOutput->getDataType() == NTA_BasicType_UInt32 &&
-              destInput->getDataType() == NTA_BasicType_Bool)
+              destInput->getDataType() != NTA_BasicType_Handle)
         << "Network::link -- Sparse to Dense link: source must be uint32 and "
-           "destination must be boolean";
+           "destination must be a scalar type";
   } else if (destInput->isSparse()) {
     // Dense to sparse:  NTA_BasicType -> uint32
     NTA_CHECK(destInput->getDataType() == NTA_BasicType_UInt32)
@@ -341,6 +357,7 @@ void Network::link(const std::string &srcRegionName,
   auto link =
       new Link(linkType, linkParams, srcOutput, destInput, propagationDelay);
   destInput->addLink(link, srcOutput);
+  checkpointPath_.clear();
 }
 
 void Network::removeLink(const std::string &srcRegionName,
@@ -385,6 +402,7 @@ void Network::removeLink(const std::string &srcRegionName,
 
   // Finally, remove the link
   destInput->removeLink(link);
+  checkpointPath_.clear();
 }
 
 void Network::run(int n) {
@@ -398,14 +416,28 @@ void Network::run(int n) {
   NTA_CHECK(maxEnabledPhase_ < phaseInfo_.size())
       << "maxphase: " << maxEnabledPhase_ << " size: " << phaseInfo_.size();
 
+  std::vector<std::vector<std::vector<Region *>>> phaseLevels;
+  if (threadPool_->getNumThreads() > 1) {
+    phaseLevels = buildPhaseLevels_();
+  }
+
   for (int iter = 0; iter < n; iter++) {
     iteration_++;
 
     // compute on all enabled regions in phase order
-    for (UInt32 phase = minEnabledPhase_; phase <= maxEnabledPhase_; phase++) {
-      for (auto r : phaseInfo_[phase]) {
-        r->prepareInputs();
-        r->compute();
+    if (phaseLevels.empty()) {
+      for (UInt32 phase = minEnabledPhase_; phase <= maxEnabledPhase_;
+           phase++) {
+        for (auto r : phaseInfo_[phase]) {
+          r->prepareInputs();
+          r->compute();
+        }
+      }
+    } else {
+      for (const auto &levels : phaseLevels) {
+        for (const auto &level : levels) {
+          runLevel_(level);
+        }
       }
     }
 
@@ -432,6 +464,86 @@ void Network::run(int n) {
   return;
 }
 
+void Network::setNumThreads(UInt32 numThreads) {
+  NTA_CHECK(numThreads >= 1) << "Network needs at least one thread";
+  if (numThreads != threadPool_->getNumThreads()) {
+    threadPool_ = std::make_shared<util::ThreadPool>(numThreads);
+  }
+}
+
+UInt32 Network::getNumThreads() const { return threadPool_->getNumThreads(); }
+
+std::vector<std::vector<std::vector<Region *>>>
+Network::buildPhaseLevels_() const {
+  // Regions joined by a link, in either direction
+  std::set<std::pair<const Region *, const Region *>> linked;
+  for (size_t i = 0; i < regions_.getCount(); i++) {
+    const Region *dest = regions_.getByIndex(i).second;
+    for (const auto &inputTuple : dest->getInputs()) {
+      for (const auto pLink : inputTuple.second->getLinks()) {
+        const Region *src = &pLink->getSrc().getRegion();
+        linked.insert(std::make_pair(src, dest));
+        linked.insert(std::make_pair(dest, src));
+      }
+    }
+  }
+
+  // A region's level is one more than that of any linked region before it
+  // in the phase, so linked regions run in the same order as they would on
+  // one thread, and regions within a level share no links.
+  std::vector<std::vector<std::vector<Region *>>> phaseLevels;
+  for (UInt32 phase = minEnabledPhase_; phase <= maxEnabledPhase_; phase++) {
+    const std::vector<Region *> regions(phaseInfo_[phase].begin(),
+                                        phaseInfo_[phase].end());
+    std::vector<size_t> regionLevel(regions.size(), 0);
+    std::vector<std::vector<Region *>> levels;
+    for (size_t i = 0; i < regions.size(); i++) {
+      for (size_t j = 0; j < i; j++) {
+        if (linked.count(std::make_pair(regions[j], regions[i]))) {
+          regionLevel[i] = std::max(regionLevel[i], regionLevel[j] + 1);
+        }
+      }
+      if (regionLevel[i] >= levels.size()) {
+        levels.resize(regionLevel[i] + 1);
+      }
+      levels[regionLevel[i]].push_back(regions[i]);
+    }
+    phaseLevels.push_back(levels);
+  }
+  return phaseLevels;
+}
+
+void Network::runLevel_(const std::vector<Region *> &level) {
+  // Python regions need the interpreter lock held by the calling thread
+  std::vector<Region *> regions;
+  for (auto r : level) {
+    if (StringUtils::startsWith(r->getType(), "py.")) {
+      r->prepareInputs();
+      r->compute();
+    } else {
+      regions.push_back(r);
+    }
+  }
+
+  if (regions.size() <= 1) {
+    for (auto r : regions) {
+      r->prepareInputs();
+      r->compute();
+    }
+    return;
+  }
+
+  // Each thread takes the next region that has not started yet, so a slow
+  // region does not hold up the others.
+  std::atomic<size_t> next(0);
+  threadPool_->parallelFor(threadPool_->getNumThreads(), [&](UInt, UInt) {
+    for (size_t i = next++; i < regions.size(); i = next++) {
+      regions[i]->prepareInputs();
+      regions[i]->compute();
+    }
+  });
+}
+
 void Network::initialize() {
 
   /*
@@ -560,6 +672,18 @@ Collection<Link *> Network::getLinks() {
   return links;
 }
 
+size_t Network::getZeroCopyLinkCount() const {
+  size_t count = 0;
+  for (size_t i = 0; i < regions_.getCount(); i++) {
+    for (auto &input : regions_.getByIndex(i).second->getInputs()) {
+      if (input.second->isZeroCopy()) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
 Collection<Network::callbackItem> &Network::getCallbacks() {
   return callbacks_;
 }
@@ -724,6 +848,195 @@ void Network::saveToBundle(const std::string &name) {
   }
 }
 
+// All links of the network, in the order Network::write() saves them.
+static std::vector<Link *> getAllLinks(const Collection<Region *> &regions) {
+  std::vector<Link *> links;
+  for (size_t i = 0; i < regions.getCount(); i++) {
+    for (auto inputPair : regions.getByIndex(i).second->getInputs()) {
+      auto &newLinks = inputPair.second->getLinks();
+      links.insert(links.end(), newLinks.begin(), newLinks.end());
+    }
+  }
+  return links;
+}
+
+void Network::checkpoint(const std::string &path) {
+  capnp::MallocMessageBuilder message;
+  auto record = message.initRoot<NetworkCheckpointRecordProto>();
+  record.setIteration(iteration_);
+
+  std::vector<Region *> saved;
+  if (path != checkpointPath_ || !Path::exists(path)) {
+    auto base = record.initBase();
+    write(base);
+    for (size_t i = 0; i < regions_.getCount(); i++) {
+      saved.push_back(regions_.getByIndex(i).second);
+    }
+  } else {
+    for (size_t i = 0; i < regions_.getCount(); i++) {
+      Region *r = regions_.getByIndex(i).second;
+      if (r->isStateDirty()) {
+        saved.push_back(r);
+      }
+    }
+
+    auto entries = record.initDelta().initEntries(saved.size());
+    for (UInt i = 0; i < saved.size(); i++) {
+      entries[i].setKey(saved[i]->getName().c_str());
+      auto regionProto = entries[i].initValue();
+      saved[i]->write(regionProto);
+    }
+
+    // Delay buffers are shifted on every compute without dirtying a region
+    const std::vector<Link *> links = getAllLinks(regions_);
+    bool delayed = false;
+    for (const Link *link : links) {
+      delayed = delayed || link->getPropagationDelay() > 0;
+    }
+    if (delayed) {
+      auto linksProto = record.initLinks(links.size());
+      for (UInt i = 0; i < links.size(); i++) {
+        auto linkProto = linksProto[i];
+        links[i]->write(linkProto);
+      }
+    }
+  }
+
+  std::ofstream f(path.c_str(), std::ios::binary | std::ios::app);
+  if (!f.is_open())
+    NTA_THROW << "Network::checkpoint -- unable to open " << path;
+  kj::std::StdOutputStream out(f);
+  capnp::writeMessage(out, message);
+  f.close();
+  if (f.fail())
+    NTA_THROW << "Network::checkpoint -- unable to write " << path;
+
+  // Only mark regions clean once their state is safely on disk
+  for (Region *r : saved) {
+    r->clearStateDirty();
+  }
+  checkpointPath_ = path;
+}
+
+// Merges the records of a checkpoint file into a single base record: the
+// last base record, with each region replaced by its state in the last
+// delta that holds it, and the links of the last record that holds them.
+// An incomplete last record, left by a crash while it was being appended, is
+// dropped. Returns false if that happened.
+static bool mergeCheckpoint(const std::string &path,
+                            capnp::MallocMessageBuilder &merged) {
+  MappedFile file(path);
+  kj::ArrayPtr<const capnp::word> words(
+      reinterpret_cast<const capnp::word *>(file.data()),
+      file.size() / sizeof(capnp::word));
+  capnp::ReaderOptions options;
+  options.traversalLimitInWords = kj::maxValue; // Don't limit.
+
+  // The readers point into the mapping and are kept until the merge is done.
+  // Records before the last base record are dropped as soon as it is found.
+  std::vector<std::unique_ptr<capnp::FlatArrayMessageReader>> messages;
+  NetworkProto::Reader base;
+  bool hasBase = false;
+  UInt64 iteration = 0;
+  std::map<std::string, RegionProto::Reader> latest;
+  capnp::List<LinkProto>::Reader links;
+  bool complete = file.size() % sizeof(capnp::word) == 0;
+
+  while (words.size() > 0) {
+    if (capnp::expectedSizeInWordsFromPrefix(words) > words.size()) {
+      complete = false;
+      break;
+    }
+    messages.emplace_back(new capnp::FlatArrayMessageReader(words, options));
+    auto record = messages.back()->getRoot<NetworkCheckpointRecordProto>();
+    words = kj::arrayPtr(messages.back()->getEnd(), words.end());
+
+    iteration = record.getIteration();
+    if (record.isBase()) {
+      messages.erase(messages.begin(), messages.end() - 1);
+      base = record.getBase();
+      links = base.getLinks();
+      hasBase = true;
+      latest.clear();
+    } else {
+      for (auto entry : record.getDelta().getEntries()) {
+        latest[entry.getKey().cStr()] = entry.getValue();
+      }
+      if (record.hasLinks()) {
+        links = record.getLinks();
+      }
+    }
+  }
+
+  if (!hasBase)
+    NTA_THROW << "Checkpoint file " << path << " has no base record";
+
+  auto record = merged.initRoot<NetworkCheckpointRecordProto>();
+  record.setIteration(iteration);
+  auto mergedBase = record.initBase();
+  auto baseEntries = base.getRegions().getEntries();
+  auto entries = mergedBase.initRegions().initEntries(baseEntries.size());
+  for (UInt i = 0; i < baseEntries.size(); i++) {
+    entries[i].setKey(baseEntries[i].getKey());
+    auto delta = latest.find(baseEntries[i].getKey().cStr());
+    if (delta != latest.end()) {
+      entries[i].setValue(delta->second);
+    } else {
+      entries[i].setValue(baseEntries[i].getValue());
+    }
+  }
+  mergedBase.setLinks(links);
+  return complete;
+}
+
+// Replaces a checkpoint file with a single record.
+static void rewriteCheckpoint(const std::string &path,
+                              capnp::MallocMessageBuilder &merged) {
+  const std::string compactedPath = path + ".compact";
+  {
+    std::ofstream f(compactedPath.c_str(), std::ios::binary);
+    if (!f.is_open())
+      NTA_THROW << "Network -- unable to open " << compactedPath;
+    kj::std::StdOutputStream out(f);
+    capnp::writeMessage(out, merged);
+    f.close();
+    if (f.fail())
+      NTA_THROW << "Network -- unable to write " << compactedPath;
+  }
+
+#if defined(NTA_OS_WINDOWS)
+  // MoveFile won't replace an existing file
+  Path::remove(path);
+#endif
+  Path::rename(compactedPath, path);
+}
+
+void Network::loadCheckpoint(const std::string &path) {
+  capnp::MallocMessageBuilder merged;
+  if (!mergeCheckpoint(path, merged)) {
+    // Records appended after the incomplete one could never be read back
+    NTA_WARN << "Dropping the incomplete last record of checkpoint " << path;
+    rewriteCheckpoint(path, merged);
+  }
+
+  auto record = merged.getRoot<NetworkCheckpointRecordProto>().asReader();
+  auto base = record.getBase();
+  read(base);
+  iteration_ = record.getIteration();
+
+  // The file already holds this state, so keep appending deltas to it
+  for (size_t i = 0; i < regions_.getCount(); i++) {
+    regions_.getByIndex(i).second->clearStateDirty();
+  }
+  checkpointPath_ = path;
+}
+
+void Network::compactCheckpoint(const std::string &path) {
+  capnp::MallocMessageBuilder merged;
+  mergeCheckpoint(path, merged);
+  rewriteCheckpoint(path, merged);
+}
+
 void Network::load(const std::string &path) {
   if (StringUtils::endsWith(path, ".tgz")) {
     NTA_THROW << "Gzipped tar archives (" << path << ") not yet supported";
@@ -1026,21 +1339,35 @@ void Network::read(NetworkProto::Reader &proto) {
   }
 
   initialized_ = false;
+  checkpointPath_.clear();
 }
 
 void Network::enableProfiling() {
   for (size_t i = 0; i < regions_.getCount(); i++)
-    regions_.getByIndex(i).second->enableProfiling();
+    regions_.getByIndex(i).second->enableProfiling(profilingPrefix_);
+  for (Link *link : getAllLinks(regions_))
+    link->enableProfiling(profilingPrefix_);
 }
 
 void Network::disableProfiling() {
   for (size_t i = 0; i < regions_.getCount(); i++)
     regions_.getByIndex(i).second->disableProfiling();
+  for (Link *link : getAllLinks(regions_))
+    link->disableProfiling();
 }
 
 void Network::resetProfiling() {
   for (size_t i = 0; i < regions_.getCount(); i++)
     regions_.getByIndex(i).second->resetProfiling();
+  Profiler::reset(profilingPrefix_);
+}
+
+std::vector<ProfileEntry> Network::getProfilingSnapshot() const {
+  std::vector<ProfileEntry> snapshot = Profiler::getSnapshot(profilingPrefix_);
+  for (ProfileEntry &entry : snapshot) {
+    entry.name.erase(0, profilingPrefix_.size());
+  }
+  return snapshot;
 }
 
 void Network::registerPyRegion(const std::string module,
@@ -29,11 +29,13 @@
 
 #include <iostream>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
 
 #include <nupic/ntypes/Collection.hpp>
+#include <nupic/os/Profiler.hpp>
 
 #include <nupic/proto/NetworkProto.capnp.h>
 #include <nupic/proto/RegionProto.capnp.h>
@@ -47,6 +49,10 @@ class Dimensions;
 class GenericRegisteredRegionImpl;
 class Link;
 
+namespace util {
+class ThreadPool;
+}
+
 /**
  * Represents an HTM network. A network is a collection of regions.
  *
@@ -117,6 +123,43 @@ public:
    */
   void save(const std::string &name);
 
+  /**
+   * Append the state of the network to an incremental checkpoint file.
+   *
+   * The first checkpoint to a path appends a base record holding the whole
+   * network, as does the first checkpoint after regions, links or phases
+   * were changed. Every other checkpoint appends a delta record holding only
+   * the regions whose state is dirty (see Region::isStateDirty()), so
+   * regions that don't learn cost nothing to checkpoint. If any link has a
+   * propagation delay, delta records also hold the state of every link.
+   *
+   * @param path
+   *        Path of the checkpoint file, created if it doesn't exist
+   */
+  void checkpoint(const std::string &path);
+
+  /**
+   * Replace the network with the latest state in an incremental checkpoint
+   * file, built from its last base record and the deltas that follow it.
+   * Later calls to checkpoint() with the same path append deltas to it.
+   * An incomplete last record, as left by a crash during checkpoint(), is
+   * dropped and the file is rewritten without it.
+   *
+   * @param path
+   *        Path of the checkpoint file
+   */
+  void loadCheckpoint(const std::string &path);
+
+  /**
+   * Rewrite an incremental checkpoint file as a single base record holding
+   * its latest state. The regions are merged as serialized data, so no
+   * region is instantiated. The file is replaced atomically.
+   *
+   * @param path
+   *        Path of the checkpoint file
+   */
+  static void compactCheckpoint(const std::string &path);
+
   /**
    * @}
    *
@@ -250,6 +293,16 @@ public:
    */
   Collection<Link *> getLinks();
 
+  /**
+   * Get the number of links whose destination input shares the source
+   * output buffer instead of copying it on every iteration.
+   *
+   * Only initialized inputs are counted.
+   *
+   * @returns The number of zero-copy links in the network
+   */
+  size_t getZeroCopyLinkCount() const;
+
   /**
    * Set phases for a region.
    *
@@ -330,6 +383,31 @@ public:
    */
   void run(int n);
 
+  /**
+   * Set the number of threads used by run().
+   *
+   * With more than one thread, regions in the same phase compute
+   * concurrently unless a link connects them. Linked regions in a phase keep
+   * the order they have with a single thread. Phases still run one after
+   * another, and callbacks and delayed link data are handled on the calling
+   * thread once all phases are done. Python regions always compute on the
+   * calling thread.
+   *
+   * The compute methods of regions that share a phase must be safe to call
+   * concurrently. The thread count is not saved with the network.
+   *
+   * @param numThreads Total number of threads, including the calling
+   * thread. Defaults to 1.
+   */
+  void setNumThreads(UInt32 numThreads);
+
+  /**
+   * Get the number of threads used by run().
+   *
+   * @returns Number of threads, including the calling thread
+   */
+  UInt32 getNumThreads() const;
+
   /**
    * The type of run callback function.
    *
@@ -363,20 +441,35 @@ public:
    */
 
   /**
-   * Start profiling for all regions of this network.
+   * Start profiling for all regions and links of this network. Their
+   * Profiler probes are registered the first time, and released when the
+   * region or link is destroyed. This doesn't enable the process-wide
+   * algorithm probes, see Profiler::enable().
    */
   void enableProfiling();
 
   /**
-   * Stop profiling for all regions of this network.
+   * Stop profiling for all regions and links of this network.
    */
   void disableProfiling();
 
   /**
-   * Reset profiling timers for all regions of this network.
+   * Reset profiling timers for all regions of this network, and the
+   * Profiler probes of its regions and links.
    */
   void resetProfiling();
 
+  /**
+   * Get the Profiler histograms and counters of this network: region
+   * compute and prepareInputs latencies, and bytes copied by links.
+   * Algorithm phase timings are process-wide, and are found in
+   * Profiler::getSnapshot() instead.
+   *
+   * @returns A snapshot of every probe of this network that has recorded
+   *          something, named without the network prefix
+   */
+  std::vector<ProfileEntry> getProfilingSnapshot() const;
+
   // Capnp serialization methods
   using Serializable::write;
   virtual void write(NetworkProto::Builder &proto) const override;
@@ -438,6 +531,13 @@ private:
   // the network
   void resetEnabledPhases_();
 
+  // Splits each enabled phase into levels of regions that share no links,
+  // for the multithreaded run()
+  std::vector<std::vector<std::vector<Region *>>> buildPhaseLevels_() const;
+
+  // prepareInputs() and compute() on each region of a level, concurrently
+  void runLevel_(const std::vector<Region *> &level);
+
   bool initialized_;
   Collection<Region *> regions_;
 
@@ -453,6 +553,17 @@ private:
 
   // number of elapsed iterations
   UInt64 iteration_;
+
+  // The checkpoint file that holds a base record for the current regions,
+  // links and phases. Changing any of them clears it, so that the next
+  // checkpoint starts with a new base record.
+  std::string checkpointPath_;
+
+  std::shared_ptr<util::ThreadPool> threadPool_;
+
+  // Prefix of the Profiler probes of the regions and links, unique in the
+  // process
+  std::string profilingPrefix_;
 };
 
 } // namespace nupic
@@ -37,6 +37,7 @@ Methods related to inputs and outputs are in Region_io.cpp
 #include <nupic/engine/RegionImplFactory.hpp>
 #include <nupic/engine/Spec.hpp>
 #include <nupic/ntypes/NodeSet.hpp>
+#include <nupic/os/Profiler.hpp>
 #include <nupic/os/Timer.hpp>
 #include <nupic/proto/RegionProto.capnp.h>
 #include <nupic/utils/Log.hpp>
@@ -52,7 +53,10 @@ class GenericRegisteredRegionImpl;
 Region::Region(std::string name, const std::string &nodeType,
                const std::string &nodeParams, Network *network)
     : name_(std::move(name)), type_(nodeType), initialized_(false),
-      enabledNodes_(nullptr), network_(network), profilingEnabled_(false) {
+      enabledNodes_(nullptr), network_(network), stateDirty_(true),
+      computedSinceClean_(false), profilingEnabled_(false),
+      computeProbe_(Profiler::NO_PROBE),
+      prepareInputsProbe_(Profiler::NO_PROBE) {
   // Set region info before creating the RegionImpl so that the
   // Impl has access to the region info in its constructor.
   RegionImplFactory &factory = RegionImplFactory::getInstance();
@@ -73,7 +77,10 @@ Region::Region(std::string name, const std::string &nodeType,
 Region::Region(std::string name, const std::string &nodeType,
                const Dimensions &dimensions, BundleIO &bundle, Network *network)
     : name_(std::move(name)), type_(nodeType), initialized_(false),
-      enabledNodes_(nullptr), network_(network), profilingEnabled_(false) {
+      enabledNodes_(nullptr), network_(network), stateDirty_(true),
+      computedSinceClean_(false), profilingEnabled_(false),
+      computeProbe_(Profiler::NO_PROBE),
+      prepareInputsProbe_(Profiler::NO_PROBE) {
   // Set region info before creating the RegionImpl so that the
   // Impl has access to the region info in its constructor.
   RegionImplFactory &factory = RegionImplFactory::getInstance();
@@ -98,7 +105,9 @@ Region::Region(std::string name, const std::string &nodeType,
 Region::Region(std::string name, RegionProto::Reader &proto, Network *network)
     : name_(std::move(name)), type_(proto.getNodeType().cStr()),
       initialized_(false), enabledNodes_(nullptr), network_(network),
-      profilingEnabled_(false) {
+      stateDirty_(true), computedSinceClean_(false), profilingEnabled_(false),
+      computeProbe_(Profiler::NO_PROBE),
+      prepareInputsProbe_(Profiler::NO_PROBE) {
   read(proto);
   createInputsAndOutputs_();
 }
@@ -157,6 +166,9 @@ Region::~Region() {
 
   delete impl_;
   delete enabledNodes_;
+
+  Profiler::releaseProbe(computeProbe_);
+  Profiler::releaseProbe(prepareInputsProbe_);
 }
 
 void Region::initialize() {
@@ -217,6 +229,8 @@ std::string Region::executeCommand(const std::vector<std::string> &args) {
     NTA_THROW << "Invalid empty command specified";
   }
 
+  stateDirty_ = true;
+
   if (profilingEnabled_)
     executeTimer_.start();
 
@@ -233,17 +247,33 @@ void Region::compute() {
     NTA_THROW << "Region " << getName()
               << " unable to compute because not initialized";
 
-  if (profilingEnabled_)
+  if (profilingEnabled_) {
     computeTimer_.start();
+    Profiler::startUnchecked(computeProbe_);
+  }
 
   impl_->compute();
+  computedSinceClean_ = true;
 
-  if (profilingEnabled_)
+  if (profilingEnabled_) {
+    Profiler::stopUnchecked(computeProbe_);
     computeTimer_.stop();
+  }
 
   return;
 }
 
+bool Region::isStateDirty() const {
+  return stateDirty_ || (computedSinceClean_ && impl_->computeModifiesState());
+}
+
+void Region::markStateDirty() { stateDirty_ = true; }
+
+void Region::clearStateDirty() {
+  stateDirty_ = false;
+  computedSinceClean_ = false;
+}
+
 /**
  * These internal methods are called by Network as
  * part of initialization.
@@ -421,13 +451,22 @@ void Region::read(RegionProto::Reader &proto) {
                                         this);
 }
 
-void Region::enableProfiling() { profilingEnabled_ = true; }
+void Region::enableProfiling(const std::string &probePrefix) {
+  if (computeProbe_ == Profiler::NO_PROBE) {
+    const std::string prefix = probePrefix + "Region." + name_;
+    computeProbe_ = Profiler::getTimingProbe(prefix + ".compute");
+    prepareInputsProbe_ = Profiler::getTimingProbe(prefix + ".prepareInputs");
+  }
+  profilingEnabled_ = true;
+}
 
 void Region::disableProfiling() { profilingEnabled_ = false; }
 
 void Region::resetProfiling() {
   computeTimer_.reset();
   executeTimer_.reset();
+  Profiler::resetProbe(computeProbe_);
+  Profiler::resetProbe(prepareInputsProbe_);
 }
 
 const Timer &Region::getComputeTimer() const { return computeTimer_; }
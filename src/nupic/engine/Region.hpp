@@ -569,6 +569,39 @@ public:
    */
   void compute();
 
+  /**
+   * @}
+   *
+   * @name Checkpointing
+   *
+   * @{
+   *
+   */
+
+  /**
+   * Whether the serialized state of the region may have changed since the
+   * last call to clearStateDirty().
+   *
+   * Setting a parameter or executing a command always marks the region
+   * dirty. Computing marks it dirty unless the RegionImpl reports that
+   * compute leaves its state alone, e.g. because it isn't learning.
+   *
+   * @returns
+   *        Whether an incremental checkpoint must save this region
+   */
+  bool isStateDirty() const;
+
+  /**
+   * Mark the region dirty. Callers that change the state of the RegionImpl
+   * directly, bypassing the Region API, must call this.
+   */
+  void markStateDirty();
+
+  /**
+   * Mark the region clean, after its state has been saved.
+   */
+  void clearStateDirty();
+
   /**
    * @}
    *
@@ -579,9 +612,12 @@ public:
    */
 
   /**
-   * Enable profiling of the compute and execute operations
+   * Enable profiling of the compute and execute operations. The first call
+   * registers the Profiler probes "<probePrefix>Region.<name>.compute" and
+   * "<probePrefix>Region.<name>.prepareInputs", which are released when the
+   * region is destroyed.
    */
-  void enableProfiling();
+  void enableProfiling(const std::string &probePrefix = "");
 
   /**
    * Disable profiling of the compute and execute operations
@@ -589,7 +625,8 @@ public:
   void disableProfiling();
 
   /**
-   * Reset the compute and execute timers
+   * Reset the compute and execute timers, and the Profiler histograms of
+   * this region
    */
   void resetProfiling();
 
@@ -741,10 +778,21 @@ private:
   // private helper methods
   void setupEnabledNodeSet();
 
+  // Dirty tracking for incremental checkpoints. computedSinceClean_ is only
+  // turned into dirtiness when asked, since asking the RegionImpl may be
+  // expensive.
+  bool stateDirty_;
+  bool computedSinceClean_;
+
   // Profiling related methods and variables.
   bool profilingEnabled_;
   Timer computeTimer_;
   Timer executeTimer_;
+
+  // Profiler probes, NO_PROBE until profiling is first enabled. They record
+  // while profilingEnabled_ is set.
+  UInt32 computeProbe_;
+  UInt32 prepareInputsProbe_;
 };
 
 } // namespace nupic
@@ -236,6 +236,8 @@ bool RegionImpl::isParameterShared(const std::string &name) {
             << getType();
 }
 
+bool RegionImpl::computeModifiesState() { return true; }
+
 void RegionImpl::getParameterFromBuffer(const std::string &name, Int64 index,
                                         IWriteBuffer &value) {
   NTA_THROW
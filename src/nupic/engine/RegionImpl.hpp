@@ -196,6 +196,14 @@ public:
    */
   virtual bool isParameterShared(const std::string &name);
 
+  /**
+   * Whether compute() may change the state saved by serialize() and write().
+   * Incremental network checkpoints skip regions whose state is unchanged,
+   * so a region that is only inferring can return false.
+   * Default implementation -- compute always changes state
+   */
+  virtual bool computeModifiesState();
+
 protected:
   Region *region_;
 
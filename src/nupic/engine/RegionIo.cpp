@@ -30,6 +30,7 @@
 #include <nupic/engine/RegionImpl.hpp>
 #include <nupic/ntypes/Array.hpp>
 #include <nupic/ntypes/ArrayRef.hpp>
+#include <nupic/os/Profiler.hpp>
 #include <nupic/types/BasicType.hpp>
 #include <nupic/utils/Log.hpp>
 
@@ -101,6 +102,8 @@ ArrayRef Region::getInputData(const std::string &inputName) const {
 }
 
 void Region::prepareInputs() {
+  ProfileScope scope(prepareInputsProbe_, profilingEnabled_);
+
   // Ask each input to prepare itself
   for (InputMap::const_iterator i = inputs_.begin(); i != inputs_.end(); i++) {
     i->second->prepare();
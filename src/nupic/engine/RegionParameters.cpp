@@ -36,34 +36,42 @@ namespace nupic {
 // setParameter
 
 void Region::setParameterInt32(const std::string &name, Int32 value) {
+  stateDirty_ = true;
   impl_->setParameterInt32(name, (Int64)-1, value);
 }
 
 void Region::setParameterUInt32(const std::string &name, UInt32 value) {
+  stateDirty_ = true;
   impl_->setParameterUInt32(name, (Int64)-1, value);
 }
 
 void Region::setParameterInt64(const std::string &name, Int64 value) {
+  stateDirty_ = true;
   impl_->setParameterInt64(name, (Int64)-1, value);
 }
 
 void Region::setParameterUInt64(const std::string &name, UInt64 value) {
+  stateDirty_ = true;
   impl_->setParameterUInt64(name, (Int64)-1, value);
 }
 
 void Region::setParameterReal32(const std::string &name, Real32 value) {
+  stateDirty_ = true;
   impl_->setParameterReal32(name, (Int64)-1, value);
 }
 
 void Region::setParameterReal64(const std::string &name, Real64 value) {
+  stateDirty_ = true;
   impl_->setParameterReal64(name, (Int64)-1, value);
 }
 
 void Region::setParameterHandle(const std::string &name, Handle value) {
+  stateDirty_ = true;
   impl_->setParameterHandle(name, (Int64)-1, value);
 }
 
 void Region::setParameterBool(const std::string &name, bool value) {
+  stateDirty_ = true;
   impl_->setParameterBool(name, (Int64)-1, value);
 }
 
@@ -120,6 +128,7 @@ void Region::getParameterArray(const std::string &name, Array &array) const {
 }
 
 void Region::setParameterArray(const std::string &name, const Array &array) {
+  stateDirty_ = true;
   // We do not check the array size here because it would be
   // expensive -- involving a check against the nodespec,
   // and only usable in the rare case that the nodespec specified
@@ -128,6 +137,7 @@ void Region::setParameterArray(const std::string &name, const Array &array) {
 }
 
 void Region::setParameterString(const std::string &name, const std::string &s) {
+  stateDirty_ = true;
   impl_->setParameterString(name, (Int64)-1, s);
 }
 
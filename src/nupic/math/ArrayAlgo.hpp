@@ -21,9 +21,9 @@
  */
 
 /** @file
- * Algorithms on arrays, dense or sparse. Contains speed-optimized asm
- * code that uses SIMD instructions provided by SSE in x86, only for darwin86
- * so far.
+ * Algorithms on arrays, dense or sparse. The dense 0/1 scans and logical
+ * operations on Real32 arrays use the runtime-dispatched SIMD kernels of
+ * nupic/math/Simd.hpp.
  */
 
 #ifndef NTA_ARRAY_ALGO_HPP
@@ -33,12 +33,14 @@
 #include <iterator>
 #include <math.h>
 
-#if defined(NTA_OS_WINDOWS) && defined(NTA_COMPILER_MSVC)
-#include <array>
+#if defined(NTA_COMPILER_MSVC)
 #include <intrin.h>
+#elif defined(NTA_ASM)
+#include <cpuid.h>
 #endif
 
 #include <nupic/math/Math.hpp>
+#include <nupic/math/Simd.hpp>
 #include <nupic/math/Types.hpp>
 #include <nupic/utils/Random.hpp> // For the official Numenta RNG
 
@@ -57,61 +59,22 @@ namespace nupic {
 // If 19th bit of ecx is 1, we have sse4.1.
 // If 20th bit of ecx is 1, we have sse4.2.
 //--------------------------------------------------------------------------------
-static int checkSSE() {
+inline int checkSSE() {
   unsigned int c = 0, d = 0;
   const unsigned int SSE = 1 << 25, SSE2 = 1 << 26, SSE3 = 1 << 0,
                      SSE41 = 1 << 19, SSE42 = 1 << 20;
-#ifdef NTA_ASM
-#if defined(NTA_ARCH_32)
-#if defined(NTA_OS_WINDOWS) && defined(NTA_COMPILER_MSVC)
-
-  // VC asm
-
-  unsigned int f = 1;
-  __asm {
-        mov eax, f
-        cpuid
-        mov c, ecx
-        mov d, edx
-  }
-
-  // TODO: add asm code for gcc/clang/... on Windows
-
-#elif defined(NTA_OS_LINUX) || defined(NTA_OS_DARWIN)
-
-  unsigned int a = 0, b = 0, f = 1;
-
-  // PIC-compliant asm
-  __asm__ __volatile__("pushl %%ebx\n\t"
-                       "cpuid\n\t"
-                       "movl %%ebx, %1\n\t"
-                       "popl %%ebx\n\t"
-                       : "=a"(a), "=r"(b), "=c"(c), "=d"(d)
-                       : "a"(f)
-                       : "cc");
-#endif
-#elif defined(NTA_ARCH_64)
-#if defined(NTA_OS_LINUX) || defined(NTA_OS_DARWIN)
+#if defined(NTA_ASM) && defined(NTA_COMPILER_MSVC)
 
-  __asm__ __volatile__("pushq  %%rbx\n\t"
+  int cpui[4];
+  __cpuid(cpui, 1);
+  c = cpui[2];
+  d = cpui[3];
 
-                       "movl   $1, %%eax\n\t"
-                       "cpuid\n\t"
-                       "movl   %%ecx, %0\n\t"
-                       "movl   %%edx, %1\n\t"
+#elif defined(NTA_ASM)
 
-                       "popq  %%rbx\n\t"
-                       : "=c"(c), "=d"(d)
-                       :
-                       :);
-#elif defined(NTA_OS_WINDOWS) && defined(NTA_COMPILER_MSVC)
+  unsigned int a = 0, b = 0;
+  __get_cpuid(1, &a, &b, &c, &d);
 
-  std::array<int, 4> cpui;
-  __cpuid(cpui.data(), 1);
-  c = cpui[2];
-  d = cpui[3];
-#endif
-#endif
 #endif // NTA_ASM
 
   int ret = -1;
@@ -129,14 +92,6 @@ static int checkSSE() {
   return ret;
 }
 
-//--------------------------------------------------------------------------------
-// Highest SSE level supported by the CPU: 1, 2, 3 or 41 or 42.
-// Note that the asm routines are written for gcc only so far, so we turn them
-// off for all platforms except darwin86. Also, they won't work properly on 64
-// bits platforms for now.
-//--------------------------------------------------------------------------------
-static const int SSE_LEVEL = checkSSE();
-
 //--------------------------------------------------------------------------------
 // TESTS
 //
@@ -210,329 +165,38 @@ template <typename T> inline bool is_zero(const std::vector<T> &x) {
 //--------------------------------------------------------------------------------
 /**
  * Scans a binary 0/1 vector to decide whether it is uniformly zero,
- * or if it contains non-zeros (4X faster than C++ loop).
- *
- * If vector x is not aligned on a 16 bytes boundary, the function
- * reverts to slow C++. This can happen when using it with slices of numpy
- * arrays.
- *
- * TODO: find 16 bytes aligned block that can be sent to SSE.
- * TODO: support win32/win64 for the fast path.
- * TODO: can we go faster if working on ints rather than floats?
+ * or if it contains non-zeros. Arrays of Real32 go through the SIMD
+ * kernel in nupic/math/Simd.hpp, which tests the bits, about 4X faster
+ * than the C++ loop.
  */
 template <typename InputIterator>
 inline bool isZero_01(InputIterator x, InputIterator x_end) {
   { NTA_ASSERT(x <= x_end); }
 
-  // This test can be moved to compile time using a template with an int
-  // parameter, and partial specializations that will match the static
-  // const int SSE_LEVEL.
-  if (SSE_LEVEL >= 41) { // ptest is a SSE 4.1 instruction
-
-    // On win32, the asm syntax is not correct.
-#if defined(NTA_ASM) && defined(NTA_ARCH_32) && !defined(NTA_OS_WINDOWS)
-
-    // n is the total number of floats to process.
-    // n1 is the number of floats we can process in parallel using SSE.
-    // If x is not aligned on a 4 bytes boundary, we eschew all asm.
-    int result = 0;
-    int n = (int)(x_end - x);
-    int n1 = 0;
-    if (((long)x) % 16 == 0)
-      n1 = 8 * (n / 8); // we are going to process 2x4 floats at a time
-
-    if (n1 > 0) {
-
-      __asm__ __volatile__(
-          "pusha\n\t" // save all registers
-
-          // fill xmm4 with all 1's,
-          // our mask to detect if there are on bits
-          // in the vector or not
-          "subl $16, %%esp\n\t"            // allocate 4 floats on the stack
-          "movl $0xffffffff, (%%esp)\n\t"  // copy mask 4 times,
-          "movl $0xffffffff, 4(%%esp)\n\t" // then move 16 bytes at once
-          "movl $0xffffffff, 8(%%esp)\n\t" // using movaps
-          "movl $0xffffffff, 12(%%esp)\n\t"
-          "movaps (%%esp), %%xmm4\n\t"
-          "addl $16, %%esp\n\t" // deallocate 4 floats on the stack
-
-          "0:\n\t"
-          // esi and edi point to the same x, but staggered, so
-          // that we can load 2x4 bytes into xmm0 and xmm1
-          "movaps (%%edi), %%xmm0\n\t" // move 4 floats from x
-          "movaps (%%esi), %%xmm1\n\t" // move another 4 floats from same x
-          "ptest %%xmm4, %%xmm0\n\t"   // ptest first 4 floats, in xmm0
-          "jne 1f\n\t"                 // jump if ZF = 0, some bit is not zero
-          "ptest %%xmm4, %%xmm1\n\t"   // ptest second 4 floats, in xmm1
-          "jne 1f\n\t"                 // jump if ZF = 0, some bit is not zero
-
-          "addl $32, %%edi\n\t" // jump over 4 floats
-          "addl $32, %%esi\n\t" // and another 4 floats here
-          "subl $8, %%ecx\n\t"  // processed 8 floats
-          "ja 0b\n\t"
-
-          "movl $0, %0\n\t" // didn't find anything, result = 0 (int)
-          "jmp 2f\n\t"      // exit
-
-          "1:\n\t"            // found something
-          "movl $0x1, %0\n\t" // result = 1 (int)
-
-          "2:\n\t"   // exit
-          "popa\n\t" // restore all registers
-
-          : "=m"(result), "=D"(x)
-          : "D"(x), "S"(x + 4), "c"(n1)
-          :);
-
-      if (result == 1)
-        return false;
-    } // n1>0 end
-
-    // Complete computation by iterating over "stragglers" one by one.
-    for (int i = n1; i != n; ++i)
-      if (*(x + i) > 0)
-        return false;
-    return true;
-
-#elif defined(NTA_ASM) && defined(NTA_ARCH_64) && !defined(NTA_OS_WINDOWS)
-
-    // n is the total number of floats to process.
-    // n1 is the number of floats we can process in parallel using SSE.
-    // If x is not aligned on a 4 bytes boundary, we eschew all asm.
-    int result = 0;
-    int n = (int)(x_end - x);
-    int n1 = 0;
-
-    if (((long)x) % 16 == 0)
-      n1 = 8 * (n / 8); // we are going to process 2x4 floats at a time
-
-    if (n1 > 0) {
-
-      __asm__ __volatile__(
-          // fill xmm4 with all 1's,
-          // our mask to detect if there are on bits
-          // in the vector or not
-          "subq $16, %%rsp\n\t"            // allocate 4 floats on the stack
-          "movl $0xffffffff, (%%rsp)\n\t"  // copy mask 4 times,
-          "movl $0xffffffff, 4(%%rsp)\n\t" // then move 16 bytes at once
-          "movl $0xffffffff, 8(%%rsp)\n\t" // using movaps
-          "movl $0xffffffff, 12(%%rsp)\n\t"
-          "movaps (%%rsp), %%xmm4\n\t"
-          "addq $16, %%rsp\n\t" // deallocate 4 floats on the stack
-
-          "0:\n\t"
-          // rsi and rdi point to the same x, but staggered, so
-          // that we can load 2x4 bytes into xmm0 and xmm1
-          "movaps (%%rdi), %%xmm0\n\t" // move 4 floats from x
-          "movaps (%%rsi), %%xmm1\n\t" // move another 4 floats from same x
-          "ptest %%xmm4, %%xmm0\n\t"   // ptest first 4 floats, in xmm0
-          "jne 1f\n\t"                 // jump if ZF = 0, some bit is not zero
-          "ptest %%xmm4, %%xmm1\n\t"   // ptest second 4 floats, in xmm1
-          "jne 1f\n\t"                 // jump if ZF = 0, some bit is not zero
-
-          "addq $32, %%rdi\n\t" // jump over 4 floats
-          "addq $32, %%rsi\n\t" // and another 4 floats here
-          "subq $8, %%rcx\n\t"  // processed 8 floats
-          "ja 0b\n\t"
-
-          "movl $0, %0\n\t" // didn't find anything, result = 0 (int)
-          "jmp 2f\n\t"      // exit
-
-          "1:\n\t"            // found something
-          "movl $0x1, %0\n\t" // result = 1 (int)
-
-          "2:\n\t" // exit
-
-          : "=m"(result), "=D"(x)
-          : "D"(x), "S"(x + 4), "c"(n1)
-          :);
-
-      if (result == 1)
-        return false;
-      else
-        return true;
-    } // n1>0 end
-
-    // Revert to slow c++ version if array is not on 16 byte boundary
-    for (; x != x_end; ++x)
-      if (*x > 0)
-        return false;
-    return true;
+  for (; x != x_end; ++x)
+    if (*x > 0)
+      return false;
+  return true;
+}
 
-#else
-    for (; x != x_end; ++x)
-      if (*x > 0)
-        return false;
-    return true;
-#endif
+inline bool isZero_01(const nupic::Real32 *x, const nupic::Real32 *x_end) {
+  { NTA_ASSERT(x <= x_end); }
 
-  } else { // not SSE4.2
+  return simd::isZero(x, (x_end - x) * sizeof(nupic::Real32));
+}
 
-    for (; x != x_end; ++x)
-      if (*x > 0)
-        return false;
-    return true;
-  }
-} // end method
+inline bool isZero_01(nupic::Real32 *x, nupic::Real32 *x_end) {
+  return isZero_01((const nupic::Real32 *)x, (const nupic::Real32 *)x_end);
+}
 
 //--------------------------------------------------------------------------------
 /**
  * 10X faster than function just above.
  */
 inline bool is_zero_01(const ByteVector &x, size_t begin, size_t end) {
-  const Byte *x_beg = &x[begin];
-  const Byte *x_end = &x[end];
-
-  // On win32, the asm syntax is not correct.
-
-  // This test can be moved to compile time using a template with an int
-  // parameter, and partial specializations that will match the static
-  // const int SSE_LEVEL.
-  if (SSE_LEVEL >= 41) { // ptest is a SSE 4.1 instruction
-
-#if defined(NTA_ASM) && defined(NTA_ARCH_32) && !defined(NTA_OS_WINDOWS)
-
-    // n is the total number of floats to process.
-    // n1 is the number of floats we can process in parallel using SSE.
-    // If x is not aligned on a 4 bytes boundary, we eschew all asm.
-    int result = 0;
-    int n = (int)(x_end - x_beg);
-    int n1 = 0;
-    if (((long)x_beg) % 16 == 0)
-      n1 = 32 * (n / 32); // we are going to process 32 bytes at a time
-
-    if (n1 > 0) {
-
-      __asm__ __volatile__(
-          "pusha\n\t" // save all registers
-
-          // fill xmm4 with all 1's,
-          // our mask to detect if there are on bits
-          // in the vector or not
-          "subl $16, %%esp\n\t"            // allocate 4 floats on the stack
-          "movl $0xffffffff, (%%esp)\n\t"  // copy mask 4 times,
-          "movl $0xffffffff, 4(%%esp)\n\t" // then move 16 bytes at once
-          "movl $0xffffffff, 8(%%esp)\n\t" // using movaps
-          "movl $0xffffffff, 12(%%esp)\n\t"
-          "movaps (%%esp), %%xmm4\n\t"
-          "addl $16, %%esp\n\t" // deallocate 4 floats on the stack
-
-          "0:\n\t"
-          // esi and edi point to the same x, but staggered, so
-          // that we can load 2x4 bytes into xmm0 and xmm1
-          "movaps (%%edi), %%xmm0\n\t" // move 4 floats from x
-          "movaps (%%esi), %%xmm1\n\t" // move another 4 floats from same x
-          "ptest %%xmm4, %%xmm0\n\t"   // ptest first 4 floats, in xmm0
-          "jne 1f\n\t"                 // jump if ZF = 0, some bit is not zero
-          "ptest %%xmm4, %%xmm1\n\t"   // ptest second 4 floats, in xmm1
-          "jne 1f\n\t"                 // jump if ZF = 0, some bit is not zero
-
-          "addl $32, %%edi\n\t" // jump 32 bytes (16 in xmm0 + 16 in xmm1)
-          "addl $32, %%esi\n\t" // and another 32 bytes
-          "subl $32, %%ecx\n\t" // processed 32 bytes
-          "ja 0b\n\t"
-
-          "movl $0, %0\n\t" // didn't find anything, result = 0 (int)
-          "jmp 2f\n\t"      // exit
-
-          "1:\n\t"            // found something
-          "movl $0x1, %0\n\t" // result = 1 (int)
-
-          "2:\n\t"   // exit
-          "popa\n\t" // restore all registers
-
-          : "=m"(result), "=D"(x_beg)
-          : "D"(x_beg), "S"(x_beg + 16), "c"(n1)
-          :);
-
-      if (result == 1)
-        return false;
-    }
+  { NTA_ASSERT(begin <= end && end <= x.size()); }
 
-    // Complete computation by iterating over "stragglers" one by one.
-    for (int i = n1; i != n; ++i)
-      if (*(x_beg + i) > 0)
-        return false;
-    return true;
-
-#elif defined(NTA_ASM) && !defined(NTA_OS_WINDOWS)
-
-    // n is the total number of floats to process.
-    // n1 is the number of floats we can process in parallel using SSE.
-    // If x is not aligned on a 4 bytes boundary, we eschew all asm.
-    int result = 0;
-    int n = (int)(x_end - x_beg);
-    int n1 = 0;
-    if (((long)x_beg) % 16 == 0)
-      n1 = 32 * (n / 32); // we are going to process 32 bytes at a time
-
-    if (n1 > 0) {
-
-      __asm__ __volatile__(
-          // fill xmm4 with all 1's,
-          // our mask to detect if there are on bits
-          // in the vector or not
-          "subq $16, %%rsp\n\t"            // allocate 4 floats on the stack
-          "movq $0xffffffff, (%%rsp)\n\t"  // copy mask 4 times,
-          "movq $0xffffffff, 4(%%rsp)\n\t" // then move 16 bytes at once
-          "movq $0xffffffff, 8(%%rsp)\n\t" // using movaps
-          "movq $0xffffffff, 12(%%rsp)\n\t"
-          "movaps (%%rsp), %%xmm4\n\t"
-          "addq $16, %%rsp\n\t" // deallocate 4 floats on the stack
-
-          "0:\n\t"
-          // rsi and rdi point to the same x, but staggered, so
-          // that we can load 2x4 bytes into xmm0 and xmm1
-          "movaps (%%rdi), %%xmm0\n\t" // move 4 floats from x
-          "movaps (%%rsi), %%xmm1\n\t" // move another 4 floats from same x
-          "ptest %%xmm4, %%xmm0\n\t"   // ptest first 4 floats, in xmm0
-          "jne 1f\n\t"                 // jump if ZF = 0, some bit is not zero
-          "ptest %%xmm4, %%xmm1\n\t"   // ptest second 4 floats, in xmm1
-          "jne 1f\n\t"                 // jump if ZF = 0, some bit is not zero
-
-          "addq $32, %%rdi\n\t" // jump 32 bytes (16 in xmm0 + 16 in xmm1)
-          "addq $32, %%rsi\n\t" // and another 32 bytes
-          "subq $32, %%rcx\n\t" // processed 32 bytes
-          "ja 0b\n\t"
-
-          "movl $0, %0\n\t" // didn't find anything, result = 0 (int)
-          "jmp 2f\n\t"      // exit
-
-          "1:\n\t"            // found something
-          "movl $0x1, %0\n\t" // result = 1 (int)
-
-          "2:\n\t"   // exit
-          "popa\n\t" // restore all registers
-
-          : "=m"(result), "=D"(x_beg)
-          : "D"(x_beg), "S"(x_beg + 16), "c"(n1)
-          :);
-
-      if (result == 1)
-        return false;
-      else
-        return true;
-    }
-
-    // if n1 is not on a 32 byte boundary then use slower code
-    for (; x_beg != x_end; ++x_beg)
-      if (*x_beg > 0)
-        return false;
-    return true;
-#endif
-  } else { // SSE 4.1
-
-    for (; x_beg != x_end; ++x_beg)
-      if (*x_beg > 0)
-        return false;
-    return true;
-  }
-
-  for (; x_beg != x_end; ++x_beg)
-    if (*x_beg > 0)
-      return false;
-  return true;
+  return simd::isZero(x.data() + begin, end - begin);
 }
 
 //--------------------------------------------------------------------------------
@@ -3388,166 +3052,20 @@ inline size_t count_ones(const C &c,
 /**
  * Counts the number of values greater than a given threshold in a given range.
  *
- * Asm SSE is many times faster than C++ (almost 10X), and C++ is 10X faster
- * than numpy (some_array > threshold).sum(). The asm code doesn't have branchs,
- * which is probably very good for the CPU front-end.
+ * The SIMD kernel is many times faster than C++ (almost 10X), and C++ is 10X
+ * faster than numpy (some_array > threshold).sum(). The kernel doesn't have
+ * branches, which is probably very good for the CPU front-end.
  *
  * This is not as general as a count_gt that would be parameterized on the type
  * of the elements in the range, and it requires passing in a Python arrays
  * that are .astype(float32).
- *
- * Doesn't work on win32.
  */
 inline nupic::UInt32 count_gt(nupic::Real32 *begin, nupic::Real32 *end,
                               nupic::Real32 threshold) {
   NTA_ASSERT(begin <= end);
 
-  // Need this, because the asm syntax is not correct for win32,
-  // we simply can't compile the code as is on win32.
-
-  // Need this, because even on darwin32 (which is darwin86), some older
-  // machines might not have the right SSE instructions.
-  if (SSE_LEVEL >= 3) {
-
-    // Compute offsets into array [begin..end):
-    // start is the first 4 bytes aligned address (to start movaps)
-    // n0 is the number of floats before we reach start and can use parallel
-    //  xmm operations
-    // n1 is the number floats we can process in parallel with xmm
-    // n2 is the number of "stragglers" what we will have to do one by one ( <
-    // 4)
-    nupic::Real32 count = 0;
-    NTA_UIntPtr x_addr = (NTA_UIntPtr)begin; // 8 bytes on 64 bits platforms
-    nupic::Real32 *start =
-        (x_addr % 16 == 0) ? begin : (nupic::Real32 *)(16 * (x_addr / 16 + 1));
-    int n0 = (int)(start - begin);
-    int n1 = 4 * ((end - start) / 4);
-    int n2 = (int)(end - start - n1);
-
-#if defined(NTA_ASM) && defined(NTA_ARCH_64) && !defined(NTA_OS_WINDOWS)
-
-#if defined(NTA_OS_DARWIN)
-
-    // DO NOT CHANGE THESE NEXT TWO LINES, OTHERWISE THE ASM CODE BELOW WILL
-    // BREAK. 'localThreshold' MUST BE STATIC!! Must always assign threshold to
-    // localThreshold also!
-    static float localThreshold;
-    localThreshold = threshold;
-#endif
-
-    __asm__ __volatile__(
-
-#if defined(NTA_OS_DARWIN)
-        // We need to access localThreshold by it's mangled name here because
-        // g++ and clang++ do things differently on OS X. They clobber eax by
-        // the time they get here and 'threshold' is not properly loaded into
-        // rax by the constraint at the end of this asm snippet. This means we
-        // need to use 'rip relative' addressing to access a 'static' variable
-        // (a global would also work) here and then load it into eax manually.
-        // Then things work fine.
-        "movq  __ZZN5nupic8count_gtEPfS0_fE14localThreshold@GOTPCREL(%%rip), "
-        "%%r11\n\t"
-        "movl  (%%r11), %%eax\n\t"
-#endif
-
-        "subq $16, %%rsp\n\t"        // allocate 4 floats on stack
-        "movl %%eax, (%%rsp)\n\t"    // copy threshold to 4 locations
-        "movl %%eax, 4(%%rsp)\n\t"   // on stack: we want threshold
-        "movl %%eax, 8(%%rsp)\n\t"   // to be filling xmm1 and xmm
-        "movl %%eax, 12(%%rsp)\n\t"  // (operate on 4 floats at a time)
-        "movaps (%%rsp), %%xmm1\n\t" // move 4 thresholds into xmm1
-        "movaps %%xmm1, %%xmm2\n\t"  // copy 4 thresholds to xmm2
-
-        "movl $0x3f800000, (%%rsp)\n\t"   // $0x3f800000 = (float) 1.0
-        "movl $0x3f800000, 4(%%rsp)\n\t"  // we want to have that constant
-        "movl $0x3f800000, 8(%%rsp)\n\t"  // 8 times, in xmm3 and xmm4,
-        "movl $0x3f800000, 12(%%rsp)\n\t" // since the xmm4 registers allow
-        "movaps (%%rsp), %%xmm3\n\t"      // us to operate on 4 floats at
-        "movaps (%%rsp), %%xmm4\n\t"      // a time
-
-        "addq $16, %%rsp\n\t" // deallocate 4 floats on stack
-
-        "xorps %%xmm5, %%xmm5\n\t" // set xmm5 to 0
-
-        // Loop over individual floats till we reach the right alignment
-        // that was computed in n0. If we don't start handling 4 floats
-        // at a time with SSE on a 4 bytes boundary, we get a crash
-        // in movaps (here, we use only movss, moving only 1 float at a
-        // time).
-        "0:\n\t"
-        "test %%rcx, %%rcx\n\t" // if n0 == 0, jump to next loop
-        "jz 1f\n\t"
-
-        "movss (%%rsi), %%xmm0\n\t"    // move a single float to xmm0
-        "cmpss $1, %%xmm0, %%xmm1\n\t" // compare to threshold
-        "andps %%xmm1, %%xmm3\n\t"     // and with all 1s
-        "addss %%xmm3, %%xmm5\n\t"     // add result to xmm5 (=count!)
-        "movaps %%xmm2, %%xmm1\n\t"    // restore threshold in xmm1
-        "movaps %%xmm4, %%xmm3\n\t"    // restore all 1s in xmm3
-        "addq $4, %%rsi\n\t"           // move to next float (4 bytes)
-        "decq %%rcx\n\t"               // decrement rcx, which started at n0
-        "ja 0b\n\t"                    // jump if not done yet
-
-        // Loop over 4 floats at a time: this time, we have reached
-        // the proper alignment for movaps, so we can operate in parallel
-        // on 4 floats at a time. The code is the same as the previous loop
-        // except that the "ss" instructions are now "ps" instructions.
-        "1:\n\t"
-        "test %%rdx, %%rdx\n\t"
-        "jz 2f\n\t"
-
-        "movaps (%%rsi), %%xmm0\n\t" // note movaps, not movss
-        "cmpps $1, %%xmm0, %%xmm1\n\t"
-        "andps %%xmm1, %%xmm3\n\t"
-        "addps %%xmm3, %%xmm5\n\t" // addps, not addss
-        "movaps %%xmm2, %%xmm1\n\t"
-        "movaps %%xmm4, %%xmm3\n\t"
-        "addq $16, %%rsi\n\t" // jump over 4 floats
-        "subq $4, %%rdx\n\t"  // decrement rdx (n1) by 4
-        "ja 1b\n\t"
-
-        // Tally up count so far into last float of xmm5: we were
-        // doing operations in parallels on the 4 floats in the xmm
-        // registers, resulting in 4 partial counts in xmm5.
-        "xorps %%xmm0, %%xmm0\n\t"
-        "haddps %%xmm0, %%xmm5\n\t"
-        "haddps %%xmm0, %%xmm5\n\t"
-
-        // Last loop, for stragglers in case the array is not evenly
-        // divisible by 4. We are back to operating on a single float
-        // at a time, using movss and addss.
-        "2:\n\t"
-        "test %%rdi, %%rdi\n\t"
-        "jz 3f\n\t"
-
-        "movss (%%rsi), %%xmm0\n\t"
-        "cmpss $1, %%xmm0, %%xmm1\n\t"
-        "andps %%xmm1, %%xmm3\n\t"
-        "addss %%xmm3, %%xmm5\n\t"
-        "movaps %%xmm2, %%xmm1\n\t"
-        "movaps %%xmm4, %%xmm3\n\t"
-        "addq $4, %%rsi\n\t"
-        "decq %%rdi\n\t"
-        "ja 0b\n\t"
-
-        // Push result from xmm5 to variable count in memory.
-        "3:\n\t"
-        "movss %%xmm5, %0\n\t"
-
-        : "=m"(count)
-        : "S"(begin), "a"(threshold), "c"(n0), "d"(n1), "D"(n2)
-        :);
-
-    return (int)count;
-
-#else
-    return std::count_if(
-        begin, end, std::bind2nd(std::greater<nupic::Real32>(), threshold));
-#endif
-  } else {
-    return std::count_if(
-        begin, end, std::bind2nd(std::greater<nupic::Real32>(), threshold));
-  }
+  return (nupic::UInt32)simd::countGreater(begin, (size_t)(end - begin),
+                                           threshold);
 }
 
 //--------------------------------------------------------------------------------
@@ -4469,16 +3987,8 @@ inline size_t sample_one(const C1 &pdf, RNG &rng) {
  * elements at the corresponding position in z. This is faster than the numpy
  * logical_and, which doesn't seem to be using SSE.
  *
- * x, y and z are arrays of floats, but with 0/1 values.
- *
- * If any of the vectors is not aligned on a 16 bytes boundary, the function
- * reverts to slow C++. This can happen when using it with slices of numpy
- * arrays.
- *
- * Doesn't work on win32/win64.
- *
- * TODO: find 16 bytes aligned block that can be sent to SSE.
- * TODO: support win32/win64 for the fast path.
+ * x, y and z are arrays of floats, but with 0/1 values. Arrays of Real32
+ * go through the SIMD kernel in nupic/math/Simd.hpp, which ands the bits.
  */
 template <typename InputIterator, typename OutputIterator>
 inline void logical_and(InputIterator x, InputIterator x_end, InputIterator y,
@@ -4489,111 +3999,19 @@ inline void logical_and(InputIterator x, InputIterator x_end, InputIterator y,
     NTA_ASSERT(x_end - x == z_end - z);
   }
 
-  // See comments in count_gt. We need both conditional compilation and
-  // SSE_LEVEL check.
-#if !defined(NTA_OS_WINDOWS) && defined(NTA_ASM)
-
-  if (SSE_LEVEL >= 3) {
-
-    // n is the total number of floats to process
-    // n1 is 0 if any of the arrays x,y,z is not aligned on a 4 bytes
-    // boundary, or the number of floats we'll be able to process in parallel
-    // using the xmm.
-    int n = (int)(x_end - x);
-    int n1 = 0;
-    if (((long)x) % 16 == 0 && ((long)y) % 16 == 0 && ((long)z) % 16 == 0)
-      n1 = 16 * (n / 16);
-
-    // If we are not aligned on 4 bytes, n1 == 0, and we simply
-    // skip the asm.
-    if (n1 > 0) {
-
-#if defined(NTA_ARCH_32)
-      __asm__ __volatile__(
-          "pusha\n\t" // save all registers
-
-          "0:\n\t"
-          "movaps (%%esi), %%xmm0\n\t"   // move 4 floats of x to xmm0
-          "andps (%%edi), %%xmm0\n\t"    // parallel and with 4 floats of y
-          "movaps 16(%%esi), %%xmm1\n\t" // play again with next 4 floats
-          "andps 16(%%edi), %%xmm1\n\t"
-          "movaps 32(%%esi), %%xmm2\n\t" // and next 4 floats
-          "andps 32(%%edi), %%xmm2\n\t"
-          "movaps 48(%%esi), %%xmm3\n\t" // and next 4 floats: we've and'ed
-          "andps 48(%%edi), %%xmm3\n\t"  // 16 floats of x and y at this point
-
-          "movaps %%xmm0, (%%ecx)\n\t"   // simply move 4 floats at a time to z
-          "movaps %%xmm1, 16(%%ecx)\n\t" // and next 4 floats
-          "movaps %%xmm2, 32(%%ecx)\n\t" // and next 4 floats
-          "movaps %%xmm3, 48(%%ecx)\n\t" // and next 4: moved 16 floats to z
-
-          "addl $64, %%esi\n\t" // increment pointer into x by 16 floats
-          "addl $64, %%edi\n\t" // increment pointer into y
-          "addl $64, %%ecx\n\t" // increment pointer into z
-          "subl $16, %%edx\n\t" // we've processed 16 floats
-          "ja 0b\n\t"           // loop
-
-          "popa\n\t" // restore registers
-
-          :
-          : "S"(x), "D"(y), "c"(z), "d"(n1)
-          :);
-
-#else
-      __asm__ __volatile__(
-          "pushq %%rsi\n\t" // save affected registers
-          "pushq %%rdi\n\t" // this 'shouldn't' be necessary
-          "pushq %%rcx\n\t" // but I was seeing some random
-          "pushq %%rdx\n\t" // crashes on OS X. Remove?
-
-          "0:\n\t"
-          "movaps (%%rsi), %%xmm0\n\t"   // move 4 floats of x to xmm0
-          "andps (%%rdi), %%xmm0\n\t"    // parallel and with 4 floats of y
-          "movaps 16(%%rsi), %%xmm1\n\t" // play again with next 4 floats
-          "andps 16(%%rdi), %%xmm1\n\t"
-          "movaps 32(%%rsi), %%xmm2\n\t" // and next 4 floats
-          "andps 32(%%rdi), %%xmm2\n\t"
-          "movaps 48(%%rsi), %%xmm3\n\t" // and next 4 floats: we've and'ed
-          "andps 48(%%rdi), %%xmm3\n\t"  // 16 floats of x and y at this point
-
-          "movaps %%xmm0, (%%rcx)\n\t"   // simply move 4 floats at a time to z
-          "movaps %%xmm1, 16(%%rcx)\n\t" // and next 4 floats
-          "movaps %%xmm2, 32(%%rcx)\n\t" // and next 4 floats
-          "movaps %%xmm3, 48(%%rcx)\n\t" // and next 4: moved 16 floats to z
-
-          "addq $64, %%rsi\n\t" // increment pointer into x by 16 floats
-          "addq $64, %%rdi\n\t" // increment pointer into y
-          "addq $64, %%rcx\n\t" // increment pointer into z
-          "subq $16, %%rdx\n\t" // we've processed 16 floats
-
-          "ja 0b\n\t" // loop
-
-          "popq %%rdx\n\t" // restore saved registers
-          "popq %%rcx\n\t"
-          "popq %%rdi\n\t"
-          "popq %%rsi\n\t"
-
-          :
-          : "S"(x), "D"(y), "c"(z), "d"(n1)
-          :);
-
-#endif
-    }
-
-    // Finish up for stragglers in case the array length was not
-    // evenly divisible by 4
-    for (int i = n1; i != n; ++i)
-      *(z + i) = *(x + i) && *(y + i);
-
-  } else {
-
-    for (; x != x_end; ++x, ++y, ++z)
-      *z = (*x) && (*y);
-  }
-#else
   for (; x != x_end; ++x, ++y, ++z)
     *z = (*x) && (*y);
-#endif
+}
+
+inline void logical_and(nupic::Real32 *x, nupic::Real32 *x_end,
+                        nupic::Real32 *y, nupic::Real32 *y_end,
+                        nupic::Real32 *z, nupic::Real32 *z_end) {
+  {
+    NTA_ASSERT(x_end - x == y_end - y);
+    NTA_ASSERT(x_end - x == z_end - z);
+  }
+
+  simd::logicalAnd(x, y, (size_t)(x_end - x), z);
 }
 
 //--------------------------------------------------------------------------------
@@ -4606,99 +4024,15 @@ inline void in_place_logical_and(Iterator x, Iterator x_end, Iterator y,
                                  Iterator y_end) {
   { NTA_ASSERT(x_end - x == y_end - y); }
 
-  // See comments in count_gt. We need conditional compilation
-  // _AND_ SSE_LEVEL check.
-#if (defined(NTA_OS_LINUX) || defined(NTA_OS_DARWIN)) && defined(NTA_ASM)
-
-  if (SSE_LEVEL >= 3) {
-
-    // See comments in logical_and.
-    int n = (int)(x_end - x);
-    int n1 = 0;
-    if (((long)x) % 16 == 0 && ((long)y) % 16 == 0)
-      n1 = 16 * (n / 16);
-
-    if (n1 > 0) {
-
-#if defined(NTA_ARCH_32)
-      __asm__ __volatile__("pusha\n\t"
-
-                           "0:\n\t"
-                           "movaps (%%esi), %%xmm0\n\t"
-                           "movaps 16(%%esi), %%xmm1\n\t"
-                           "movaps 32(%%esi), %%xmm2\n\t"
-                           "movaps 48(%%esi), %%xmm3\n\t"
-                           "andps (%%edi), %%xmm0\n\t"
-                           "andps 16(%%edi), %%xmm1\n\t"
-                           "andps 32(%%edi), %%xmm2\n\t"
-                           "andps 48(%%edi), %%xmm3\n\t"
-                           "movaps %%xmm0, (%%edi)\n\t"
-                           "movaps %%xmm1, 16(%%edi)\n\t"
-                           "movaps %%xmm2, 32(%%edi)\n\t"
-                           "movaps %%xmm3, 48(%%edi)\n\t"
-
-                           "addl $64, %%esi\n\t"
-                           "addl $64, %%edi\n\t"
-                           "subl $16, %%edx\n\t"
-                           "prefetch (%%esi)\n\t"
-                           "ja 0b\n\t"
-
-                           "popa\n\t"
-
-                           :
-                           : "S"(x), "D"(y), "d"(n1)
-                           :);
-
-#else // 64bit
-      __asm__ __volatile__(
-          "pushq %%rsi\n\t" // save affected registers
-          "pushq %%rdi\n\t"
-          "pushq %%rdx\n\t"
-
-          "0:\n\t"
-          "movaps (%%rsi), %%xmm0\n\t"
-          "movaps 16(%%rsi), %%xmm1\n\t"
-          "movaps 32(%%rsi), %%xmm2\n\t"
-          "movaps 48(%%rsi), %%xmm3\n\t"
-
-          "andps (%%rdi), %%xmm0\n\t"
-          "andps 16(%%rdi), %%xmm1\n\t" // in place and
-          "andps 32(%%rdi), %%xmm2\n\t"
-          "andps 48(%%rdi), %%xmm3\n\t"
-
-          "movaps %%xmm0, (%%rdi)\n\t"
-          "movaps %%xmm1, 16(%%rdi)\n\t"
-          "movaps %%xmm2, 32(%%rdi)\n\t"
-          "movaps %%xmm3, 48(%%rdi)\n\t"
-
-          "addq $64, %%rsi\n\t" // increment pointer into x by 16 floats
-          "addq $64, %%rdi\n\t" // increment pointer into y
-          "subq $16, %%rdx\n\t" // we've processed 16 floats
-
-          "ja 0b\n\t" // loop
-
-          "popq %%rdx\n\t" // restore saved registers
-          "popq %%rdi\n\t"
-          "popq %%rsi\n\t"
-
-          :
-          : "S"(x), "D"(y), "d"(n1)
-          :);
-#endif
-    }
-
-    for (int i = n1; i != n; ++i)
-      *(y + i) = *(x + i) && *(y + i);
-
-  } else {
-
-    for (; x != x_end; ++x, ++y)
-      *y = (*x) && *(y);
-  }
-#else
   for (; x != x_end; ++x, ++y)
     *y = (*x) && *(y);
-#endif
+}
+
+inline void in_place_logical_and(nupic::Real32 *x, nupic::Real32 *x_end,
+                                 nupic::Real32 *y, nupic::Real32 *y_end) {
+  { NTA_ASSERT(x_end - x == y_end - y); }
+
+  simd::logicalAnd(x, y, (size_t)(x_end - x), y);
 }
 
 //--------------------------------------------------------------------------------
@@ -0,0 +1,858 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of the runtime-dispatched SIMD kernels
+ */
+
+#include <nupic/math/Simd.hpp>
+
+#if defined(NTA_ASM) &&                                                      \
+    (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) ||        \
+     defined(_M_IX86))
+#define NTA_SIMD_X86
+#endif
+
+#if defined(NTA_SIMD_X86) && defined(NTA_COMPILER_MSVC)
+#include <intrin.h>
+#define NTA_SIMD_TARGET(isa)
+#elif defined(NTA_SIMD_X86)
+#include <immintrin.h>
+#define NTA_SIMD_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// a * x + y must stay a rounded multiply followed by a rounded add, as in
+// the scalar templates, rather than becoming a fused multiply-add.
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace nupic {
+namespace simd {
+
+namespace {
+
+/**
+ * The Real32 kernels of one level.
+ */
+struct Kernels {
+  Real32 (*sumAtIndices)(const Real32 *, const UInt32 *, UInt32);
+  Real32 (*sumAtIndicesGtThreshold)(const Real32 *, const UInt32 *,
+                                    const Real32 *, UInt32, Real32);
+  UInt32 (*filterGreaterEqual)(UInt32 *, Real32 *, UInt32, Real32);
+  void (*scatter)(const UInt32 *, const Real32 *, UInt32, Real32 *);
+  void (*scatterAddScaled)(Real32, const UInt32 *, const Real32 *, UInt32,
+                           Real32 *);
+  void (*scale)(Real32, const Real32 *, size_t, Real32 *);
+  UInt32 (*compactNonZeros)(const Real32 *, UInt32, Real32, UInt32 *,
+                            Real32 *);
+  size_t (*countGreater)(const Real32 *, size_t, Real32);
+  void (*logicalAnd)(const Real32 *, const Real32 *, size_t, Real32 *);
+  bool (*isZero)(const void *, size_t);
+};
+
+bool isZeroScalar(const void *x, size_t nbytes) {
+  const Byte *p = (const Byte *)x;
+
+  for (size_t i = 0; i != nbytes; ++i)
+    if (p[i] != 0)
+      return false;
+
+  return true;
+}
+
+const Kernels scalarKernels = {
+    &sumAtIndices<Real32, UInt32>,
+    &sumAtIndicesGtThreshold<Real32, UInt32>,
+    &filterGreaterEqual<Real32, UInt32>,
+    &scatter<Real32, UInt32>,
+    &scatterAddScaled<Real32, UInt32>,
+    &scale<Real32>,
+    &compactNonZeros<Real32, UInt32>,
+    &countGreater<Real32>,
+    &logicalAnd<Real32>,
+    &isZeroScalar};
+
+#if defined(NTA_SIMD_X86)
+
+inline int countTrailingZeros(unsigned int mask) {
+#if defined(NTA_COMPILER_MSVC)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (int)index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+inline int popCount(unsigned int mask) {
+#if defined(NTA_COMPILER_MSVC)
+  return (int)__popcnt(mask);
+#else
+  return __builtin_popcount(mask);
+#endif
+}
+
+// Moves the pairs selected by the bits of mask, from block [i, i + width),
+// to the front of ind and nz. The values come from the already loaded
+// block, so that this works in place.
+inline UInt32 keepMasked(unsigned int mask, const Real32 *block, UInt32 i,
+                         const UInt32 *indIn, UInt32 *ind, Real32 *nz,
+                         UInt32 count) {
+  for (; mask != 0; mask &= mask - 1) {
+    const int b = countTrailingZeros(mask);
+    ind[count] = indIn != nullptr ? indIn[b] : i + b;
+    nz[count] = block[b];
+    ++count;
+  }
+  return count;
+}
+
+#endif // NTA_SIMD_X86
+
+// The scalar loops that finish the vectorized ones, from position k on.
+inline UInt32 filterTail(UInt32 *ind, Real32 *nz, UInt32 k, UInt32 n,
+                         Real32 threshold, UInt32 kept) {
+  for (; k != n; ++k)
+    if (nz[k] >= threshold) {
+      ind[kept] = ind[k];
+      nz[kept] = nz[k];
+      ++kept;
+    }
+  return kept;
+}
+
+inline UInt32 compactTail(const Real32 *dense, UInt32 i, UInt32 n,
+                          Real32 epsilon, UInt32 *ind, Real32 *nz,
+                          UInt32 count) {
+  for (; i != n; ++i) {
+    const Real32 val = dense[i];
+    if (!((val >= 0 ? val : -val) <= epsilon)) {
+      ind[count] = i;
+      nz[count] = val;
+      ++count;
+    }
+  }
+  return count;
+}
+
+inline size_t countTail(const Real32 *x, size_t i, size_t n,
+                        Real32 threshold, size_t count) {
+  for (; i != n; ++i)
+    if (x[i] > threshold)
+      ++count;
+  return count;
+}
+
+#if defined(NTA_SIMD_X86)
+
+//--------------------------------------------------------------------------------
+// SSE4.2
+//--------------------------------------------------------------------------------
+NTA_SIMD_TARGET("sse4.2")
+inline Real32 horizontalSum(__m128 v) {
+  v = _mm_hadd_ps(v, v);
+  v = _mm_hadd_ps(v, v);
+  return _mm_cvtss_f32(v);
+}
+
+NTA_SIMD_TARGET("sse4.2")
+Real32 sumAtIndicesSse(const Real32 *x, const UInt32 *ind, UInt32 n) {
+  __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+  UInt32 k = 0;
+
+  for (; k + 8 <= n; k += 8) {
+    acc0 = _mm_add_ps(acc0, _mm_set_ps(x[ind[k + 3]], x[ind[k + 2]],
+                                       x[ind[k + 1]], x[ind[k]]));
+    acc1 = _mm_add_ps(acc1, _mm_set_ps(x[ind[k + 7]], x[ind[k + 6]],
+                                       x[ind[k + 5]], x[ind[k + 4]]));
+  }
+
+  Real32 sum = horizontalSum(_mm_add_ps(acc0, acc1));
+  for (; k != n; ++k)
+    sum += x[ind[k]];
+
+  return sum;
+}
+
+NTA_SIMD_TARGET("sse4.2")
+Real32 sumAtIndicesGtThresholdSse(const Real32 *x, const UInt32 *ind,
+                                  const Real32 *nz, UInt32 n,
+                                  Real32 threshold) {
+  const __m128 thr = _mm_set1_ps(threshold);
+  __m128 acc = _mm_setzero_ps();
+  UInt32 k = 0;
+
+  for (; k + 4 <= n; k += 4) {
+    const __m128 keep = _mm_cmpgt_ps(_mm_loadu_ps(nz + k), thr);
+    const __m128 v = _mm_set_ps(x[ind[k + 3]], x[ind[k + 2]], x[ind[k + 1]],
+                                x[ind[k]]);
+    acc = _mm_add_ps(acc, _mm_and_ps(keep, v));
+  }
+
+  Real32 sum = horizontalSum(acc);
+  for (; k != n; ++k)
+    if (nz[k] > threshold)
+      sum += x[ind[k]];
+
+  return sum;
+}
+
+NTA_SIMD_TARGET("sse4.2")
+UInt32 filterGreaterEqualSse(UInt32 *ind, Real32 *nz, UInt32 n,
+                             Real32 threshold) {
+  const __m128 thr = _mm_set1_ps(threshold);
+  UInt32 kept = 0, k = 0;
+
+  for (; k + 4 <= n; k += 4) {
+    const __m128 v = _mm_loadu_ps(nz + k);
+    const unsigned int mask = _mm_movemask_ps(_mm_cmpge_ps(v, thr));
+    if (mask == 0xf) {
+      if (kept != k) {
+        const __m128i i = _mm_loadu_si128((const __m128i *)(ind + k));
+        _mm_storeu_si128((__m128i *)(ind + kept), i);
+        _mm_storeu_ps(nz + kept, v);
+      }
+      kept += 4;
+    } else if (mask != 0) {
+      alignas(16) Real32 block[4];
+      _mm_store_ps(block, v);
+      kept = keepMasked(mask, block, k, ind + k, ind, nz, kept);
+    }
+  }
+
+  return filterTail(ind, nz, k, n, threshold, kept);
+}
+
+NTA_SIMD_TARGET("sse4.2")
+void scaleSse(Real32 a, const Real32 *x, size_t n, Real32 *y) {
+  const __m128 va = _mm_set1_ps(a);
+  size_t i = 0;
+
+  for (; i + 4 <= n; i += 4)
+    _mm_storeu_ps(y + i, _mm_mul_ps(va, _mm_loadu_ps(x + i)));
+
+  for (; i != n; ++i)
+    y[i] = a * x[i];
+}
+
+NTA_SIMD_TARGET("sse4.2")
+UInt32 compactNonZerosSse(const Real32 *dense, UInt32 n, Real32 epsilon,
+                          UInt32 *ind, Real32 *nz) {
+  const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  const __m128 eps = _mm_set1_ps(epsilon);
+  UInt32 count = 0, i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    const __m128 v = _mm_loadu_ps(dense + i);
+    const __m128 zero = _mm_cmple_ps(_mm_and_ps(v, absMask), eps);
+    const unsigned int mask = ~_mm_movemask_ps(zero) & 0xf;
+    if (mask != 0) {
+      alignas(16) Real32 block[4];
+      _mm_store_ps(block, v);
+      count = keepMasked(mask, block, i, nullptr, ind, nz, count);
+    }
+  }
+
+  return compactTail(dense, i, n, epsilon, ind, nz, count);
+}
+
+NTA_SIMD_TARGET("sse4.2")
+size_t countGreaterSse(const Real32 *x, size_t n, Real32 threshold) {
+  const __m128 thr = _mm_set1_ps(threshold);
+  __m128i acc = _mm_setzero_si128();
+  size_t i = 0;
+
+  // Each comparison is 0 or -1 per lane: subtracting it counts.
+  for (; i + 4 <= n; i += 4) {
+    const __m128 gt = _mm_cmpgt_ps(_mm_loadu_ps(x + i), thr);
+    acc = _mm_sub_epi32(acc, _mm_castps_si128(gt));
+  }
+
+  alignas(16) UInt32 lanes[4];
+  _mm_store_si128((__m128i *)lanes, acc);
+  const size_t count = (size_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+  return countTail(x, i, n, threshold, count);
+}
+
+NTA_SIMD_TARGET("sse4.2")
+void logicalAndSse(const Real32 *x, const Real32 *y, size_t n, Real32 *z) {
+  size_t i = 0;
+
+  for (; i + 4 <= n; i += 4)
+    _mm_storeu_ps(z + i, _mm_and_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+
+  for (; i != n; ++i)
+    z[i] = x[i] && y[i];
+}
+
+NTA_SIMD_TARGET("sse4.2")
+bool isZeroSse(const void *x, size_t nbytes) {
+  const Byte *p = (const Byte *)x;
+  size_t i = 0;
+
+  for (; i + 16 <= nbytes; i += 16) {
+    const __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+    if (!_mm_testz_si128(v, v))
+      return false;
+  }
+
+  return isZeroScalar(p + i, nbytes - i);
+}
+
+const Kernels sseKernels = {&sumAtIndicesSse,
+                            &sumAtIndicesGtThresholdSse,
+                            &filterGreaterEqualSse,
+                            &scatter<Real32, UInt32>,
+                            &scatterAddScaled<Real32, UInt32>,
+                            &scaleSse,
+                            &compactNonZerosSse,
+                            &countGreaterSse,
+                            &logicalAndSse,
+                            &isZeroSse};
+
+//--------------------------------------------------------------------------------
+// AVX2
+//--------------------------------------------------------------------------------
+NTA_SIMD_TARGET("avx2")
+inline Real32 horizontalSum(__m256 v) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_hadd_ps(s, s);
+  s = _mm_hadd_ps(s, s);
+  return _mm_cvtss_f32(s);
+}
+
+NTA_SIMD_TARGET("avx2")
+Real32 sumAtIndicesAvx2(const Real32 *x, const UInt32 *ind, UInt32 n) {
+  __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+  UInt32 k = 0;
+
+  for (; k + 16 <= n; k += 16) {
+    const __m256i i0 = _mm256_loadu_si256((const __m256i *)(ind + k));
+    const __m256i i1 = _mm256_loadu_si256((const __m256i *)(ind + k + 8));
+    acc0 = _mm256_add_ps(acc0, _mm256_i32gather_ps(x, i0, 4));
+    acc1 = _mm256_add_ps(acc1, _mm256_i32gather_ps(x, i1, 4));
+  }
+
+  Real32 sum = horizontalSum(_mm256_add_ps(acc0, acc1));
+  for (; k != n; ++k)
+    sum += x[ind[k]];
+
+  return sum;
+}
+
+NTA_SIMD_TARGET("avx2")
+Real32 sumAtIndicesGtThresholdAvx2(const Real32 *x, const UInt32 *ind,
+                                   const Real32 *nz, UInt32 n,
+                                   Real32 threshold) {
+  const __m256 thr = _mm256_set1_ps(threshold);
+  __m256 acc = _mm256_setzero_ps();
+  UInt32 k = 0;
+
+  for (; k + 8 <= n; k += 8) {
+    const __m256 keep =
+        _mm256_cmp_ps(_mm256_loadu_ps(nz + k), thr, _CMP_GT_OQ);
+    const __m256i i = _mm256_loadu_si256((const __m256i *)(ind + k));
+    acc = _mm256_add_ps(acc, _mm256_mask_i32gather_ps(_mm256_setzero_ps(), x,
+                                                      i, keep, 4));
+  }
+
+  Real32 sum = horizontalSum(acc);
+  for (; k != n; ++k)
+    if (nz[k] > threshold)
+      sum += x[ind[k]];
+
+  return sum;
+}
+
+NTA_SIMD_TARGET("avx2")
+UInt32 filterGreaterEqualAvx2(UInt32 *ind, Real32 *nz, UInt32 n,
+                              Real32 threshold) {
+  const __m256 thr = _mm256_set1_ps(threshold);
+  UInt32 kept = 0, k = 0;
+
+  for (; k + 8 <= n; k += 8) {
+    const __m256 v = _mm256_loadu_ps(nz + k);
+    const unsigned int mask =
+        _mm256_movemask_ps(_mm256_cmp_ps(v, thr, _CMP_GE_OQ));
+    if (mask == 0xff) {
+      if (kept != k) {
+        const __m256i i = _mm256_loadu_si256((const __m256i *)(ind + k));
+        _mm256_storeu_si256((__m256i *)(ind + kept), i);
+        _mm256_storeu_ps(nz + kept, v);
+      }
+      kept += 8;
+    } else if (mask != 0) {
+      alignas(32) Real32 block[8];
+      _mm256_store_ps(block, v);
+      kept = keepMasked(mask, block, k, ind + k, ind, nz, kept);
+    }
+  }
+
+  return filterTail(ind, nz, k, n, threshold, kept);
+}
+
+NTA_SIMD_TARGET("avx2")
+void scaleAvx2(Real32 a, const Real32 *x, size_t n, Real32 *y) {
+  const __m256 va = _mm256_set1_ps(a);
+  size_t i = 0;
+
+  for (; i + 8 <= n; i += 8)
+    _mm256_storeu_ps(y + i, _mm256_mul_ps(va, _mm256_loadu_ps(x + i)));
+
+  for (; i != n; ++i)
+    y[i] = a * x[i];
+}
+
+NTA_SIMD_TARGET("avx2")
+UInt32 compactNonZerosAvx2(const Real32 *dense, UInt32 n, Real32 epsilon,
+                           UInt32 *ind, Real32 *nz) {
+  const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  const __m256 eps = _mm256_set1_ps(epsilon);
+  UInt32 count = 0, i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    const __m256 v = _mm256_loadu_ps(dense + i);
+    const __m256 zero =
+        _mm256_cmp_ps(_mm256_and_ps(v, absMask), eps, _CMP_LE_OQ);
+    const unsigned int mask = ~_mm256_movemask_ps(zero) & 0xff;
+    if (mask != 0) {
+      alignas(32) Real32 block[8];
+      _mm256_store_ps(block, v);
+      count = keepMasked(mask, block, i, nullptr, ind, nz, count);
+    }
+  }
+
+  return compactTail(dense, i, n, epsilon, ind, nz, count);
+}
+
+NTA_SIMD_TARGET("avx2")
+size_t countGreaterAvx2(const Real32 *x, size_t n, Real32 threshold) {
+  const __m256 thr = _mm256_set1_ps(threshold);
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    const __m256 gt = _mm256_cmp_ps(_mm256_loadu_ps(x + i), thr, _CMP_GT_OQ);
+    acc = _mm256_sub_epi32(acc, _mm256_castps_si256(gt));
+  }
+
+  alignas(32) UInt32 lanes[8];
+  _mm256_store_si256((__m256i *)lanes, acc);
+  size_t count = 0;
+  for (int lane = 0; lane != 8; ++lane)
+    count += lanes[lane];
+
+  return countTail(x, i, n, threshold, count);
+}
+
+NTA_SIMD_TARGET("avx2")
+void logicalAndAvx2(const Real32 *x, const Real32 *y, size_t n, Real32 *z) {
+  size_t i = 0;
+
+  for (; i + 8 <= n; i += 8)
+    _mm256_storeu_ps(
+        z + i, _mm256_and_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+
+  for (; i != n; ++i)
+    z[i] = x[i] && y[i];
+}
+
+NTA_SIMD_TARGET("avx2")
+bool isZeroAvx2(const void *x, size_t nbytes) {
+  const Byte *p = (const Byte *)x;
+  size_t i = 0;
+
+  for (; i + 32 <= nbytes; i += 32) {
+    const __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+    if (!_mm256_testz_si256(v, v))
+      return false;
+  }
+
+  return isZeroScalar(p + i, nbytes - i);
+}
+
+// AVX2 has gathers but no scatters: the scatter kernels stay scalar.
+const Kernels avx2Kernels = {&sumAtIndicesAvx2,
+                             &sumAtIndicesGtThresholdAvx2,
+                             &filterGreaterEqualAvx2,
+                             &scatter<Real32, UInt32>,
+                             &scatterAddScaled<Real32, UInt32>,
+                             &scaleAvx2,
+                             &compactNonZerosAvx2,
+                             &countGreaterAvx2,
+                             &logicalAndAvx2,
+                             &isZeroAvx2};
+
+//--------------------------------------------------------------------------------
+// AVX-512
+//
+// The full gathers and the reductions go through the masked forms and
+// plain stores: the unmasked intrinsics trip -Wuninitialized in the GCC
+// headers.
+//--------------------------------------------------------------------------------
+NTA_SIMD_TARGET("avx512f")
+inline __m512 gather(__m512i i, const Real32 *x) {
+  return _mm512_mask_i32gather_ps(_mm512_setzero_ps(), (__mmask16)0xffff, i,
+                                  x, 4);
+}
+
+NTA_SIMD_TARGET("avx512f")
+inline Real32 horizontalSum(__m512 v) {
+  alignas(64) Real32 lanes[16];
+  _mm512_store_ps(lanes, v);
+  const __m128 s0 = _mm_add_ps(_mm_load_ps(lanes), _mm_load_ps(lanes + 4));
+  const __m128 s1 = _mm_add_ps(_mm_load_ps(lanes + 8), _mm_load_ps(lanes + 12));
+  return horizontalSum(_mm_add_ps(s0, s1));
+}
+
+NTA_SIMD_TARGET("avx512f")
+Real32 sumAtIndicesAvx512(const Real32 *x, const UInt32 *ind, UInt32 n) {
+  __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+  UInt32 k = 0;
+
+  for (; k + 32 <= n; k += 32) {
+    const __m512i i0 = _mm512_loadu_si512(ind + k);
+    const __m512i i1 = _mm512_loadu_si512(ind + k + 16);
+    acc0 = _mm512_add_ps(acc0, gather(i0, x));
+    acc1 = _mm512_add_ps(acc1, gather(i1, x));
+  }
+
+  for (; k + 16 <= n; k += 16) {
+    const __m512i i0 = _mm512_loadu_si512(ind + k);
+    acc0 = _mm512_add_ps(acc0, gather(i0, x));
+  }
+
+  if (k != n) {
+    const __mmask16 rest = (__mmask16)((1u << (n - k)) - 1);
+    const __m512i i0 = _mm512_maskz_loadu_epi32(rest, ind + k);
+    acc1 = _mm512_add_ps(
+        acc1, _mm512_mask_i32gather_ps(_mm512_setzero_ps(), rest, i0, x, 4));
+  }
+
+  return horizontalSum(_mm512_add_ps(acc0, acc1));
+}
+
+NTA_SIMD_TARGET("avx512f")
+Real32 sumAtIndicesGtThresholdAvx512(const Real32 *x, const UInt32 *ind,
+                                     const Real32 *nz, UInt32 n,
+                                     Real32 threshold) {
+  const __m512 thr = _mm512_set1_ps(threshold);
+  __m512 acc = _mm512_setzero_ps();
+
+  for (UInt32 k = 0; k < n; k += 16) {
+    const __mmask16 rest =
+        n - k >= 16 ? (__mmask16)0xffff : (__mmask16)((1u << (n - k)) - 1);
+    const __m512 v = _mm512_maskz_loadu_ps(rest, nz + k);
+    const __mmask16 keep = _mm512_mask_cmp_ps_mask(rest, v, thr, _CMP_GT_OQ);
+    const __m512i i = _mm512_maskz_loadu_epi32(keep, ind + k);
+    acc = _mm512_add_ps(
+        acc, _mm512_mask_i32gather_ps(_mm512_setzero_ps(), keep, i, x, 4));
+  }
+
+  return horizontalSum(acc);
+}
+
+NTA_SIMD_TARGET("avx512f")
+UInt32 filterGreaterEqualAvx512(UInt32 *ind, Real32 *nz, UInt32 n,
+                                Real32 threshold) {
+  const __m512 thr = _mm512_set1_ps(threshold);
+  UInt32 kept = 0, k = 0;
+
+  for (; k + 16 <= n; k += 16) {
+    const __m512 v = _mm512_loadu_ps(nz + k);
+    const __mmask16 keep = _mm512_cmp_ps_mask(v, thr, _CMP_GE_OQ);
+    if (keep == 0xffff && kept == k) {
+      kept += 16;
+      continue;
+    }
+    const __m512i i = _mm512_loadu_si512(ind + k);
+    _mm512_mask_compressstoreu_epi32(ind + kept, keep, i);
+    _mm512_mask_compressstoreu_ps(nz + kept, keep, v);
+    kept += popCount(keep);
+  }
+
+  return filterTail(ind, nz, k, n, threshold, kept);
+}
+
+NTA_SIMD_TARGET("avx512f")
+void scatterAvx512(const UInt32 *ind, const Real32 *nz, UInt32 n,
+                   Real32 *dense) {
+  UInt32 k = 0;
+
+  for (; k + 16 <= n; k += 16) {
+    const __m512i i = _mm512_loadu_si512(ind + k);
+    _mm512_i32scatter_ps(dense, i, _mm512_loadu_ps(nz + k), 4);
+  }
+
+  for (; k != n; ++k)
+    dense[ind[k]] = nz[k];
+}
+
+NTA_SIMD_TARGET("avx512f")
+void scatterAddScaledAvx512(Real32 a, const UInt32 *ind, const Real32 *nz,
+                            UInt32 n, Real32 *dense) {
+  const __m512 va = _mm512_set1_ps(a);
+  UInt32 k = 0;
+
+  // The indices are distinct, so no lane can miss another lane's update.
+  for (; k + 16 <= n; k += 16) {
+    const __m512i i = _mm512_loadu_si512(ind + k);
+    const __m512 d = gather(i, dense);
+    const __m512 p = _mm512_mul_ps(va, _mm512_loadu_ps(nz + k));
+    _mm512_i32scatter_ps(dense, i, _mm512_add_ps(d, p), 4);
+  }
+
+  for (; k != n; ++k)
+    dense[ind[k]] += a * nz[k];
+}
+
+NTA_SIMD_TARGET("avx512f")
+void scaleAvx512(Real32 a, const Real32 *x, size_t n, Real32 *y) {
+  const __m512 va = _mm512_set1_ps(a);
+  size_t i = 0;
+
+  for (; i + 16 <= n; i += 16)
+    _mm512_storeu_ps(y + i, _mm512_mul_ps(va, _mm512_loadu_ps(x + i)));
+
+  for (; i != n; ++i)
+    y[i] = a * x[i];
+}
+
+NTA_SIMD_TARGET("avx512f")
+UInt32 compactNonZerosAvx512(const Real32 *dense, UInt32 n, Real32 epsilon,
+                             UInt32 *ind, Real32 *nz) {
+  const __m512 eps = _mm512_set1_ps(epsilon);
+  const __m512i lanes = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6,
+                                         5, 4, 3, 2, 1, 0);
+  UInt32 count = 0, i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    const __m512 v = _mm512_loadu_ps(dense + i);
+    const __mmask16 keep = _mm512_cmp_ps_mask(_mm512_abs_ps(v), eps,
+                                              _CMP_NLE_UQ);
+    if (keep == 0)
+      continue;
+    const __m512i idx = _mm512_add_epi32(lanes, _mm512_set1_epi32((int)i));
+    _mm512_mask_compressstoreu_epi32(ind + count, keep, idx);
+    _mm512_mask_compressstoreu_ps(nz + count, keep, v);
+    count += popCount(keep);
+  }
+
+  return compactTail(dense, i, n, epsilon, ind, nz, count);
+}
+
+NTA_SIMD_TARGET("avx512f")
+size_t countGreaterAvx512(const Real32 *x, size_t n, Real32 threshold) {
+  const __m512 thr = _mm512_set1_ps(threshold);
+  size_t count = 0, i = 0;
+
+  for (; i + 16 <= n; i += 16)
+    count += popCount(
+        _mm512_cmp_ps_mask(_mm512_loadu_ps(x + i), thr, _CMP_GT_OQ));
+
+  return countTail(x, i, n, threshold, count);
+}
+
+NTA_SIMD_TARGET("avx512f")
+void logicalAndAvx512(const Real32 *x, const Real32 *y, size_t n,
+                      Real32 *z) {
+  size_t i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    const __m512i a = _mm512_loadu_si512(x + i);
+    const __m512i b = _mm512_loadu_si512(y + i);
+    _mm512_storeu_si512(z + i, _mm512_and_si512(a, b));
+  }
+
+  for (; i != n; ++i)
+    z[i] = x[i] && y[i];
+}
+
+NTA_SIMD_TARGET("avx512f")
+bool isZeroAvx512(const void *x, size_t nbytes) {
+  const Byte *p = (const Byte *)x;
+  size_t i = 0;
+
+  for (; i + 64 <= nbytes; i += 64) {
+    const __m512i v = _mm512_loadu_si512(p + i);
+    if (_mm512_test_epi32_mask(v, v) != 0)
+      return false;
+  }
+
+  return isZeroScalar(p + i, nbytes - i);
+}
+
+const Kernels avx512Kernels = {&sumAtIndicesAvx512,
+                               &sumAtIndicesGtThresholdAvx512,
+                               &filterGreaterEqualAvx512,
+                               &scatterAvx512,
+                               &scatterAddScaledAvx512,
+                               &scaleAvx512,
+                               &compactNonZerosAvx512,
+                               &countGreaterAvx512,
+                               &logicalAndAvx512,
+                               &isZeroAvx512};
+
+#endif // NTA_SIMD_X86
+
+Level detectLevel() {
+#if defined(NTA_SIMD_X86) && defined(NTA_COMPILER_MSVC)
+  int info[4];
+  __cpuid(info, 0);
+  const int maxLeaf = info[0];
+  __cpuid(info, 1);
+  const bool sse42 = (info[2] & (1 << 20)) != 0;
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+  bool avx2 = false, avx512 = false;
+  if (maxLeaf >= 7) {
+    __cpuidex(info, 7, 0);
+    // The OS must save the ymm, and for AVX-512 the zmm, registers
+    avx2 = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+    avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6;
+  }
+  if (avx512)
+    return AVX512;
+  if (avx2)
+    return AVX2;
+  if (sse42)
+    return SSE42;
+#elif defined(NTA_SIMD_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return AVX512;
+  if (__builtin_cpu_supports("avx2"))
+    return AVX2;
+  if (__builtin_cpu_supports("sse4.2"))
+    return SSE42;
+#endif
+  return NONE;
+}
+
+const Kernels *kernelsFor(Level level) {
+  switch (level) {
+#if defined(NTA_SIMD_X86)
+  case AVX512:
+    return &avx512Kernels;
+  case AVX2:
+    return &avx2Kernels;
+  case SSE42:
+    return &sseKernels;
+#endif
+  default:
+    return &scalarKernels;
+  }
+}
+
+struct Dispatch {
+  Level supported;
+  Level level;
+  const Kernels *kernels;
+
+  Dispatch()
+      : supported(detectLevel()), level(supported),
+        kernels(kernelsFor(supported)) {}
+};
+
+// Function-local, so that it is ready for static initializers of other
+// translation units that already use SparseMatrix.
+Dispatch &dispatch() {
+  static Dispatch d;
+  return d;
+}
+
+} // end anonymous namespace
+
+Level getSupportedLevel() { return dispatch().supported; }
+
+Level getLevel() { return dispatch().level; }
+
+void setLevel(Level level) {
+  Dispatch &d = dispatch();
+  d.level = level < d.supported ? level : d.supported;
+  d.kernels = kernelsFor(d.level);
+}
+
+const char *getLevelName(Level level) {
+  switch (level) {
+  case SSE42:
+    return "SSE4.2";
+  case AVX2:
+    return "AVX2";
+  case AVX512:
+    return "AVX-512";
+  default:
+    return "none";
+  }
+}
+
+Real32 sumAtIndices(const Real32 *x, const UInt32 *ind, UInt32 n) {
+  return dispatch().kernels->sumAtIndices(x, ind, n);
+}
+
+Real32 sumAtIndicesGtThreshold(const Real32 *x, const UInt32 *ind,
+                               const Real32 *nz, UInt32 n, Real32 threshold) {
+  return dispatch().kernels->sumAtIndicesGtThreshold(x, ind, nz, n,
+                                                     threshold);
+}
+
+UInt32 filterGreaterEqual(UInt32 *ind, Real32 *nz, UInt32 n,
+                          Real32 threshold) {
+  return dispatch().kernels->filterGreaterEqual(ind, nz, n, threshold);
+}
+
+void scatter(const UInt32 *ind, const Real32 *nz, UInt32 n, Real32 *dense) {
+  dispatch().kernels->scatter(ind, nz, n, dense);
+}
+
+void scatterAddScaled(Real32 a, const UInt32 *ind, const Real32 *nz,
+                      UInt32 n, Real32 *dense) {
+  dispatch().kernels->scatterAddScaled(a, ind, nz, n, dense);
+}
+
+void scale(Real32 a, const Real32 *x, size_t n, Real32 *y) {
+  dispatch().kernels->scale(a, x, n, y);
+}
+
+UInt32 compactNonZeros(const Real32 *dense, UInt32 n, Real32 epsilon,
+                       UInt32 *ind, Real32 *nz) {
+  return dispatch().kernels->compactNonZeros(dense, n, epsilon, ind, nz);
+}
+
+size_t countGreater(const Real32 *x, size_t n, Real32 threshold) {
+  return dispatch().kernels->countGreater(x, n, threshold);
+}
+
+void logicalAnd(const Real32 *x, const Real32 *y, size_t n, Real32 *z) {
+  dispatch().kernels->logicalAnd(x, y, n, z);
+}
+
+bool isZero(const void *x, size_t nbytes) {
+  return dispatch().kernels->isZero(x, nbytes);
+}
+
+} // end namespace simd
+} // end namespace nupic
@@ -0,0 +1,224 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Runtime-dispatched SIMD kernels for the inner loops of SparseMatrix
+ * and ArrayAlgo.
+ *
+ * Each kernel has a generic scalar template, which is the reference
+ * implementation for any value and index type, and a Real32 / UInt32
+ * overload that runs the widest code path the CPU supports: AVX-512,
+ * AVX2 or SSE4.2 on x86, the scalar template everywhere else. The level
+ * is detected on first use and can be lowered with setLevel().
+ *
+ * The vectorized sums accumulate in several lanes, so their results can
+ * differ from the scalar ones in the last bits. All the other kernels
+ * return exactly what the scalar templates return.
+ */
+
+#ifndef NTA_SIMD_HPP
+#define NTA_SIMD_HPP
+
+#include <cstddef>
+
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+namespace simd {
+
+/**
+ * Instruction set levels, in increasing order of vector width.
+ */
+enum Level { NONE = 0, SSE42, AVX2, AVX512 };
+
+/**
+ * The widest level supported by both the CPU and this build.
+ */
+Level getSupportedLevel();
+
+/**
+ * The level used by the Real32 kernels.
+ */
+Level getLevel();
+
+/**
+ * Use the given level, or the supported level if it is lower. Not
+ * thread-safe with respect to running kernels; meant for tests and
+ * benchmarks that compare the code paths.
+ */
+void setLevel(Level level);
+
+const char *getLevelName(Level level);
+
+/**
+ * Sum of x[ind[k]] for k in [0, n).
+ */
+template <typename T, typename I>
+inline T sumAtIndices(const T *x, const I *ind, I n) {
+  I n4 = 4 * (n / 4), k = 0;
+  T sum = 0;
+
+  for (; k != n4; k += 4)
+    sum += x[ind[k]] + x[ind[k + 1]] + x[ind[k + 2]] + x[ind[k + 3]];
+
+  for (; k != n; ++k)
+    sum += x[ind[k]];
+
+  return sum;
+}
+
+Real32 sumAtIndices(const Real32 *x, const UInt32 *ind, UInt32 n);
+
+/**
+ * Sum of x[ind[k]] for k in [0, n) such that nz[k] > threshold.
+ */
+template <typename T, typename I>
+inline T sumAtIndicesGtThreshold(const T *x, const I *ind, const T *nz, I n,
+                                 T threshold) {
+  T sum = 0;
+
+  for (I k = 0; k != n; ++k)
+    if (nz[k] > threshold)
+      sum += x[ind[k]];
+
+  return sum;
+}
+
+Real32 sumAtIndicesGtThreshold(const Real32 *x, const UInt32 *ind,
+                               const Real32 *nz, UInt32 n, Real32 threshold);
+
+/**
+ * Keeps the (ind[k], nz[k]) pairs such that nz[k] >= threshold, in order,
+ * at the front of ind and nz. Returns the number of pairs kept.
+ */
+template <typename T, typename I>
+inline I filterGreaterEqual(I *ind, T *nz, I n, T threshold) {
+  I kept = 0;
+
+  for (I k = 0; k != n; ++k)
+    if (nz[k] >= threshold) {
+      ind[kept] = ind[k];
+      nz[kept] = nz[k];
+      ++kept;
+    }
+
+  return kept;
+}
+
+UInt32 filterGreaterEqual(UInt32 *ind, Real32 *nz, UInt32 n,
+                          Real32 threshold);
+
+/**
+ * Writes the (index, value) pairs in dense: dense[ind[k]] = nz[k].
+ * The indices must be distinct.
+ */
+template <typename T, typename I>
+inline void scatter(const I *ind, const T *nz, I n, T *dense) {
+  for (I k = 0; k != n; ++k)
+    dense[ind[k]] = nz[k];
+}
+
+void scatter(const UInt32 *ind, const Real32 *nz, UInt32 n, Real32 *dense);
+
+/**
+ * dense[ind[k]] += a * nz[k] for k in [0, n). The indices must be
+ * distinct.
+ */
+template <typename T, typename I>
+inline void scatterAddScaled(T a, const I *ind, const T *nz, I n, T *dense) {
+  for (I k = 0; k != n; ++k)
+    dense[ind[k]] += a * nz[k];
+}
+
+void scatterAddScaled(Real32 a, const UInt32 *ind, const Real32 *nz,
+                      UInt32 n, Real32 *dense);
+
+/**
+ * y[i] = a * x[i] for i in [0, n). x and y can be the same array.
+ */
+template <typename T> inline void scale(T a, const T *x, size_t n, T *y) {
+  for (size_t i = 0; i != n; ++i)
+    y[i] = a * x[i];
+}
+
+void scale(Real32 a, const Real32 *x, size_t n, Real32 *y);
+
+/**
+ * Writes the indices and values of dense[0..n) whose magnitude is greater
+ * than epsilon to ind and nz, in increasing order of indices, and returns
+ * their number. nz can be dense itself: the compaction works in place.
+ */
+template <typename T, typename I>
+inline I compactNonZeros(const T *dense, I n, T epsilon, I *ind, T *nz) {
+  I count = 0;
+
+  for (I i = 0; i != n; ++i) {
+    T val = dense[i];
+    if (!((val >= 0 ? val : -val) <= epsilon)) {
+      ind[count] = i;
+      nz[count] = val;
+      ++count;
+    }
+  }
+
+  return count;
+}
+
+UInt32 compactNonZeros(const Real32 *dense, UInt32 n, Real32 epsilon,
+                       UInt32 *ind, Real32 *nz);
+
+/**
+ * Number of values in x[0..n) greater than threshold.
+ */
+template <typename T>
+inline size_t countGreater(const T *x, size_t n, T threshold) {
+  size_t count = 0;
+
+  for (size_t i = 0; i != n; ++i)
+    if (x[i] > threshold)
+      ++count;
+
+  return count;
+}
+
+size_t countGreater(const Real32 *x, size_t n, Real32 threshold);
+
+/**
+ * z[i] = x[i] && y[i] for i in [0, n), on 0/1 values. z can be x or y.
+ */
+template <typename T>
+inline void logicalAnd(const T *x, const T *y, size_t n, T *z) {
+  for (size_t i = 0; i != n; ++i)
+    z[i] = x[i] && y[i];
+}
+
+void logicalAnd(const Real32 *x, const Real32 *y, size_t n, Real32 *z);
+
+/**
+ * Whether all the bits of the nbytes bytes at x are zero.
+ */
+bool isZero(const void *x, size_t nbytes);
+
+} // end namespace simd
+} // end namespace nupic
+
+#endif // NTA_SIMD_HPP
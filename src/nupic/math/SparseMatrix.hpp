@@ -31,12 +31,14 @@
 
 #include <cstdio> // sprintf
 #include <iomanip>
+#include <type_traits>
 #include <vector>
 
 #include <boost/unordered_set.hpp>
 
 #include <nupic/math/ArrayAlgo.hpp>
 #include <nupic/math/Math.hpp>
+#include <nupic/math/Simd.hpp>
 #include <nupic/math/StlIo.hpp>
 #include <nupic/math/Utils.hpp>
 #include <nupic/ntypes/MemParser.hpp>
@@ -553,6 +555,43 @@ protected:
     }
   }
 
+  /**
+   * Contiguous views of iterator arguments, for the nupic::simd kernels.
+   * Pointers and std::vector iterators on value_type map to a pointer,
+   * other iterators map to nullptr and take the generic loops. The
+   * iterator has to be dereferenceable.
+   */
+  template <typename It> static inline const value_type *contiguous_(It) {
+    return nullptr;
+  }
+
+  static inline const value_type *contiguous_(const value_type *it) {
+    return it;
+  }
+
+  static inline const value_type *contiguous_(value_type *it) { return it; }
+
+  static inline const value_type *
+  contiguous_(typename std::vector<value_type>::const_iterator it) {
+    return &*it;
+  }
+
+  static inline const value_type *
+  contiguous_(typename std::vector<value_type>::iterator it) {
+    return &*it;
+  }
+
+  template <typename It> static inline value_type *contiguousOut_(It) {
+    return nullptr;
+  }
+
+  static inline value_type *contiguousOut_(value_type *it) { return it; }
+
+  static inline value_type *
+  contiguousOut_(typename std::vector<value_type>::iterator it) {
+    return &*it;
+  }
+
   /**
    * Compacts a row from a buffer to (nzr_[r], ind_[r], nz_[r]).
    * This will weed out the zeros in the buffer, if any, and keep
@@ -590,26 +629,38 @@ protected:
           << " - Should be less than number of columns: " << nCols();
     } // End pre-conditions
 
-    size_type *indb_it = indb_;
-    InputIterator nz_it = nz_begin;
-    value_type *nzb_it = nzb_;
+    size_type nnzr = 0;
+    const value_type *dense =
+        nz_begin != nz_end ? contiguous_(nz_begin) : nullptr;
 
     // First, compact row in place in indb_, nzb_,
     // and figure out number of non-zeros
     // Keep increasing order of non-zero indices
     // Non-zeros might move, or change in number
-    while (nz_it != nz_end) {
-      value_type val = *nz_it;
-      if (!isZero_(val)) {
-        *indb_it = size_type(nz_it - nz_begin);
-        *nzb_it = val;
-        ++indb_it;
-        ++nzb_it;
+    if (dense && std::is_same<DTZ, DistanceToZero<value_type>>::value) {
+
+      nnzr = simd::compactNonZeros(dense, size_type(nz_end - nz_begin),
+                                   value_type(nupic::Epsilon), indb_, nzb_);
+
+    } else {
+
+      size_type *indb_it = indb_;
+      InputIterator nz_it = nz_begin;
+      value_type *nzb_it = nzb_;
+
+      while (nz_it != nz_end) {
+        value_type val = *nz_it;
+        if (!isZero_(val)) {
+          *indb_it = size_type(nz_it - nz_begin);
+          *nzb_it = val;
+          ++indb_it;
+          ++nzb_it;
+        }
+        ++nz_it;
       }
-      ++nz_it;
-    }
 
-    size_type nnzr = size_type(indb_it - indb_);
+      nnzr = size_type(indb_it - indb_);
+    }
 
     if (nnzr > nnzr_[row]) {
 
@@ -649,11 +700,7 @@ protected:
 
     std::fill(nzb_, nzb_ + nCols(), (value_type)0);
 
-    size_type *ind = ind_begin_(row), *ind_end = ind_end_(row);
-    value_type *nz = nz_begin_(row);
-
-    for (; ind != ind_end; ++ind, ++nz)
-      *(nzb_ + *ind) = *nz;
+    simd::scatter(ind_begin_(row), nz_begin_(row), nnzr_[row], nzb_);
   }
 
   /**
@@ -5730,6 +5777,13 @@ public:
 
     std::fill(it, it + nCols(), (value_type)0);
 
+    value_type *dense = nCols() > 0 ? contiguousOut_(it) : nullptr;
+
+    if (dense) {
+      simd::scatter(ind_[row], nz_[row], nnzr_[row], dense);
+      return;
+    }
+
     ITERATE_ON_ROW { *(it + *ind) = *nz; }
   }
 
@@ -5739,11 +5793,9 @@ public:
       assert_valid_row_(row, "getRowToDense");
     } // End pre-conditions
 
-    auto it = dense.begin();
-
-    std::fill(it, it + nCols(), (value_type)0);
+    std::fill(dense.begin(), dense.begin() + nCols(), (value_type)0);
 
-    ITERATE_ON_ROW { *(it + *ind) = *nz; }
+    simd::scatter(ind_[row], nz_[row], nnzr_[row], dense.data());
   }
 
   /**
@@ -7484,8 +7536,9 @@ public:
    *  @li None.
    */
   inline void threshold(const value_type &threshold = nupic::Epsilon) {
-    filter(std::bind(std::greater_equal<value_type>(), std::placeholders::_1,
-                     threshold));
+    ITERATE_ON_ALL_ROWS
+    nnzr_[row] = simd::filterGreaterEqual(ind_[row], nz_[row], nnzr_[row],
+                                          threshold);
   }
 
   template <typename OutputIterator1, typename OutputIterator2>
@@ -9164,6 +9217,24 @@ public:
     } // End pre-conditions
 
     size_type nnzr = nnzr_[row], *ind = ind_[row], ncols = nCols();
+    const value_type *px = ncols > 0 ? contiguous_(x) : nullptr;
+
+    if (px) {
+
+      // Same operations as the loops below: with a == 1, nzb_ starts as
+      // a copy of x, and receives the non-zeros added or subtracted.
+      if (a == 1.0 && (b == 1.0 || b == -1.0)) {
+        std::copy(px, px + ncols, nzb_);
+        simd::scatterAddScaled(b, ind, nz_[row], nnzr, nzb_);
+      } else {
+        simd::scale(b, px, ncols, nzb_);
+        simd::scatterAddScaled(a, ind, nz_[row], nnzr, nzb_);
+      }
+
+      set_row_(row, nzb_, nzb_ + ncols);
+      return;
+    }
+
     size_type *end1 = ind + 4 * (nnzr / 4), *end2 = ind + nnzr;
     value_type *nz = nzb_;
     InputIterator end_x1 = x + 4 * (ncols / 4), end_x2 = x + ncols;
@@ -10245,6 +10316,14 @@ public:
   template <typename InputIterator, typename OutputIterator>
   inline void rightVecSumAtNZ(InputIterator x, OutputIterator y) const {
 
+    const value_type *px = nCols() > 0 ? contiguous_(x) : nullptr;
+
+    if (px) {
+      ITERATE_ON_ALL_ROWS
+      *y++ = simd::sumAtIndices(px, ind_[row], nnzr_[row]);
+      return;
+    }
+
     ITERATE_ON_ALL_ROWS {
 
       size_type nnzr = nnzr_[row];
@@ -10321,6 +10400,15 @@ public:
   inline void rightVecSumAtNZGtThreshold(InputIterator x, OutputIterator y,
                                          value_type threshold) const {
 
+    const value_type *px = nCols() > 0 ? contiguous_(x) : nullptr;
+
+    if (px) {
+      ITERATE_ON_ALL_ROWS
+      *y++ = simd::sumAtIndicesGtThreshold(px, ind_[row], nz_[row],
+                                           nnzr_[row], threshold);
+      return;
+    }
+
     ITERATE_ON_ALL_ROWS {
 
       size_type nnzr = nnzr_[row];
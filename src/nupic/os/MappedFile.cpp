@@ -0,0 +1,118 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of the MappedFile class
+ */
+
+#include <nupic/os/MappedFile.hpp>
+#include <nupic/utils/Log.hpp>
+
+#if defined(NTA_OS_WINDOWS)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace nupic;
+
+#if defined(NTA_OS_WINDOWS)
+
+MappedFile::MappedFile(const std::string &path)
+    : data_(nullptr), size_(0), file_(INVALID_HANDLE_VALUE),
+      mapping_(nullptr) {
+  file_ = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  NTA_CHECK(file_ != INVALID_HANDLE_VALUE) << "Unable to open " << path;
+
+  LARGE_INTEGER size;
+  if (!::GetFileSizeEx(file_, &size)) {
+    ::CloseHandle(file_);
+    NTA_THROW << "Unable to get the size of " << path;
+  }
+  size_ = (std::size_t)size.QuadPart;
+  if (size_ == 0) {
+    return;
+  }
+
+  mapping_ =
+      ::CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping_ == nullptr) {
+    ::CloseHandle(file_);
+    NTA_THROW << "Unable to map " << path;
+  }
+
+  data_ = (const char *)::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+  if (data_ == nullptr) {
+    ::CloseHandle(mapping_);
+    ::CloseHandle(file_);
+    NTA_THROW << "Unable to map " << path;
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    ::UnmapViewOfFile(data_);
+  }
+  if (mapping_ != nullptr) {
+    ::CloseHandle(mapping_);
+  }
+  ::CloseHandle(file_);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path) : data_(nullptr), size_(0) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  NTA_CHECK(fd >= 0) << "Unable to open " << path;
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    NTA_THROW << "Unable to stat " << path;
+  }
+  size_ = (std::size_t)st.st_size;
+  if (size_ == 0) {
+    ::close(fd);
+    return;
+  }
+
+  void *p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+  NTA_CHECK(p != MAP_FAILED) << "Unable to map " << path;
+
+  // Snapshots are parsed front to back.
+  ::madvise(p, size_, MADV_SEQUENTIAL);
+  data_ = (const char *)p;
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    ::munmap((void *)data_, size_);
+  }
+}
+
+#endif
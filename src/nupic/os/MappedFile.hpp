@@ -0,0 +1,73 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definitions for the MappedFile class
+ */
+
+#ifndef NTA_MAPPED_FILE_HPP
+#define NTA_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace nupic {
+
+/**
+ * @Responsibility
+ * Read-only memory mapping of a whole file
+ *
+ * @Description
+ * The file is mapped on construction and unmapped on destruction. Pages are
+ * only read from disk when they are first touched, so opening a large
+ * snapshot is cheap and many processes loading the same file share the page
+ * cache. An empty file maps to a null pointer with size zero.
+ */
+class MappedFile {
+public:
+  /**
+   * Map a file read-only. Throws if the file can't be opened or mapped.
+   *
+   * @param path Path to the file
+   */
+  explicit MappedFile(const std::string &path);
+
+  ~MappedFile();
+
+  const char *data() const { return data_; }
+  std::size_t size() const { return size_; }
+
+private:
+  MappedFile(const MappedFile &);
+  MappedFile &operator=(const MappedFile &);
+
+  const char *data_;
+  std::size_t size_;
+#if defined(NTA_OS_WINDOWS)
+  void *file_;
+  void *mapping_;
+#endif
+}; // class MappedFile
+
+} // namespace nupic
+
+#endif // NTA_MAPPED_FILE_HPP
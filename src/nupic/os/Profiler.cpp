@@ -0,0 +1,363 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Profiler implementation
+ */
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+
+#include <nupic/os/Profiler.hpp>
+#include <nupic/utils/Log.hpp>
+
+#if defined(NTA_COMPILER_MSVC)
+#include <intrin.h> // _BitScanReverse64
+#endif
+
+namespace nupic {
+
+std::atomic<bool> Profiler::enabled_(false);
+
+namespace {
+
+// Intervals are recorded in nanoseconds. Values below 16 get a bucket each,
+// larger ones are split into 16 buckets per power of two.
+const UInt32 SUB_BUCKETS = 16;
+const UInt32 NUM_BUCKETS = SUB_BUCKETS + (64 - 4) * SUB_BUCKETS;
+
+inline UInt32 bucketForNanos(UInt64 nanos) {
+  if (nanos < SUB_BUCKETS) {
+    return (UInt32)nanos;
+  }
+#if defined(NTA_COMPILER_MSVC)
+  unsigned long msb;
+  _BitScanReverse64(&msb, nanos);
+#else
+  const UInt32 msb = 63 - __builtin_clzll(nanos);
+#endif
+  const UInt32 shift = msb - 4;
+  return SUB_BUCKETS + shift * SUB_BUCKETS +
+         (UInt32)((nanos >> shift) & (SUB_BUCKETS - 1));
+}
+
+// The middle of a bucket, in nanoseconds
+inline Real64 nanosForBucket(UInt32 bucket) {
+  if (bucket < SUB_BUCKETS) {
+    return bucket;
+  }
+  const UInt32 shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+  const UInt64 lower = (UInt64)(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+  return lower + ((UInt64)1 << shift) / 2.0;
+}
+
+inline UInt64 nowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Counters of one probe on one thread. Only the owning thread writes them,
+// snapshots read them from any thread.
+struct ProbeData {
+  ProbeData() : count(0), total(0), startNanos(0) {
+    for (auto &bucket : buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic<UInt64> count;
+  std::atomic<UInt64> total;
+  std::atomic<UInt64> buckets[NUM_BUCKETS];
+
+  // Owning thread only
+  UInt64 startNanos;
+};
+
+// The sums of ProbeData over a set of threads
+struct ProbeTotals {
+  ProbeTotals() : count(0), total(0), buckets(NUM_BUCKETS, 0) {}
+
+  void add(const ProbeData &data) {
+    count += data.count.load(std::memory_order_relaxed);
+    total += data.total.load(std::memory_order_relaxed);
+    for (UInt32 i = 0; i < NUM_BUCKETS; i++) {
+      buckets[i] += data.buckets[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  Real64 percentileNanos(Real64 q) const {
+    const UInt64 rank = (UInt64)(q * (count - 1)) + 1;
+    UInt64 seen = 0;
+    for (UInt32 i = 0; i < NUM_BUCKETS; i++) {
+      seen += buckets[i];
+      if (seen >= rank) {
+        return nanosForBucket(i);
+      }
+    }
+    return 0;
+  }
+
+  UInt64 count;
+  UInt64 total;
+  std::vector<UInt64> buckets;
+};
+
+struct ThreadData;
+
+// Probe names and the live threads. The mutex is only taken to register or
+// release a probe, to register or retire a thread and to take a snapshot,
+// never to record.
+struct Registry {
+  std::mutex mutex;
+  // Indexed by probe id. Released ids have an empty name and no references.
+  std::vector<std::string> names;
+  std::vector<bool> isCounter;
+  std::vector<UInt32> references;
+  std::vector<UInt32> releasedIds;
+  std::map<std::string, UInt32> ids;
+  std::set<ThreadData *> threads;
+  // Counters of threads that have exited
+  std::vector<ProbeTotals> retired;
+};
+
+// Never destroyed, since threads may retire during static destruction
+Registry &registry() {
+  static Registry *registry = new Registry();
+  return *registry;
+}
+
+struct ThreadData {
+  ThreadData() {
+    for (auto &probe : probes) {
+      probe.store(nullptr, std::memory_order_relaxed);
+    }
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.threads.insert(this);
+  }
+
+  ~ThreadData() {
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.threads.erase(this);
+    for (UInt32 i = 0; i < Profiler::MAX_PROBES; i++) {
+      ProbeData *data = probes[i].load(std::memory_order_relaxed);
+      if (data != nullptr) {
+        r.retired[i].add(*data);
+        delete data;
+      }
+    }
+  }
+
+  ProbeData &get(UInt32 probe) {
+    NTA_ASSERT(probe < Profiler::MAX_PROBES);
+    ProbeData *data = probes[probe].load(std::memory_order_relaxed);
+    if (data == nullptr) {
+      data = new ProbeData();
+      probes[probe].store(data, std::memory_order_release);
+    }
+    return *data;
+  }
+
+  std::atomic<ProbeData *> probes[Profiler::MAX_PROBES];
+};
+
+ProbeData &threadProbe(UInt32 probe) {
+  static thread_local ThreadData threadData;
+  return threadData.get(probe);
+}
+
+inline void increment(std::atomic<UInt64> &counter, UInt64 amount) {
+  // Single writer, so a relaxed load and store don't lose updates
+  counter.store(counter.load(std::memory_order_relaxed) + amount,
+                std::memory_order_relaxed);
+}
+
+// Zero the counters of a probe on every thread. Called with the mutex held.
+void resetLocked(Registry &r, UInt32 probe) {
+  r.retired[probe] = ProbeTotals();
+  for (ThreadData *thread : r.threads) {
+    ProbeData *data = thread->probes[probe].load(std::memory_order_acquire);
+    if (data == nullptr) {
+      continue;
+    }
+    data->count.store(0, std::memory_order_relaxed);
+    data->total.store(0, std::memory_order_relaxed);
+    for (auto &bucket : data->buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+UInt32 getProbe(const std::string &name, bool isCounter) {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  auto it = r.ids.find(name);
+  if (it != r.ids.end()) {
+    NTA_CHECK(r.isCounter[it->second] == isCounter)
+        << "Profiler probe '" << name
+        << "' is already registered with another kind";
+    r.references[it->second]++;
+    return it->second;
+  }
+
+  UInt32 id;
+  if (!r.releasedIds.empty()) {
+    id = r.releasedIds.back();
+    r.releasedIds.pop_back();
+  } else {
+    NTA_CHECK(r.names.size() < Profiler::MAX_PROBES)
+        << "Too many profiler probes, can't register '" << name << "'";
+    id = r.names.size();
+    r.names.emplace_back();
+    r.isCounter.push_back(false);
+    r.references.push_back(0);
+    r.retired.emplace_back();
+  }
+  r.names[id] = name;
+  r.isCounter[id] = isCounter;
+  r.references[id] = 1;
+  r.ids[name] = id;
+  return id;
+}
+
+} // namespace
+
+void Profiler::enable() { enabled_.store(true, std::memory_order_relaxed); }
+
+void Profiler::disable() { enabled_.store(false, std::memory_order_relaxed); }
+
+UInt32 Profiler::getTimingProbe(const std::string &name) {
+  return getProbe(name, false);
+}
+
+UInt32 Profiler::getCounterProbe(const std::string &name) {
+  return getProbe(name, true);
+}
+
+void Profiler::releaseProbe(UInt32 probe) {
+  if (probe == NO_PROBE) {
+    return;
+  }
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  NTA_CHECK(probe < r.names.size() && r.references[probe] > 0)
+      << "Releasing profiler probe " << probe << ", which isn't registered";
+  if (--r.references[probe] > 0) {
+    return;
+  }
+
+  // The owner has stopped recording, so the counters can be zeroed here
+  resetLocked(r, probe);
+  r.ids.erase(r.names[probe]);
+  r.names[probe].clear();
+  r.releasedIds.push_back(probe);
+}
+
+void Profiler::start_(UInt32 probe) {
+  threadProbe(probe).startNanos = nowNanos();
+}
+
+void Profiler::stop_(UInt32 probe) {
+  ProbeData &data = threadProbe(probe);
+  if (data.startNanos == 0) {
+    return;
+  }
+  const UInt64 nanos = nowNanos() - data.startNanos;
+  data.startNanos = 0;
+
+  increment(data.count, 1);
+  increment(data.total, nanos);
+  increment(data.buckets[bucketForNanos(nanos)], 1);
+}
+
+void Profiler::add_(UInt32 probe, UInt64 amount) {
+  ProbeData &data = threadProbe(probe);
+  increment(data.count, 1);
+  increment(data.total, amount);
+}
+
+void Profiler::reset(const std::string &prefix) {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (UInt32 i = 0; i < r.names.size(); i++) {
+    if (r.references[i] > 0 &&
+        r.names[i].compare(0, prefix.size(), prefix) == 0) {
+      resetLocked(r, i);
+    }
+  }
+}
+
+void Profiler::resetProbe(UInt32 probe) {
+  if (probe == NO_PROBE) {
+    return;
+  }
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  NTA_CHECK(probe < r.names.size()) << "Unknown profiler probe " << probe;
+  resetLocked(r, probe);
+}
+
+std::vector<ProfileEntry> Profiler::getSnapshot(const std::string &prefix) {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+
+  std::vector<ProfileEntry> snapshot;
+  for (UInt32 i = 0; i < r.names.size(); i++) {
+    if (r.references[i] == 0 ||
+        r.names[i].compare(0, prefix.size(), prefix) != 0) {
+      continue;
+    }
+    ProbeTotals totals = r.retired[i];
+    for (ThreadData *thread : r.threads) {
+      ProbeData *data = thread->probes[i].load(std::memory_order_acquire);
+      if (data != nullptr) {
+        totals.add(*data);
+      }
+    }
+    if (totals.count == 0) {
+      continue;
+    }
+
+    ProfileEntry entry;
+    entry.name = r.names[i];
+    entry.isCounter = r.isCounter[i];
+    entry.count = totals.count;
+    if (entry.isCounter) {
+      entry.total = (Real64)totals.total;
+      entry.p50 = entry.p99 = entry.p999 = 0;
+    } else {
+      entry.total = totals.total * 1e-9;
+      entry.p50 = totals.percentileNanos(0.5) * 1e-9;
+      entry.p99 = totals.percentileNanos(0.99) * 1e-9;
+      entry.p999 = totals.percentileNanos(0.999) * 1e-9;
+    }
+    snapshot.push_back(entry);
+  }
+  return snapshot;
+}
+
+} // namespace nupic
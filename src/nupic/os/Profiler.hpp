@@ -0,0 +1,185 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Profiler interface
+ */
+
+#ifndef NTA_PROFILER_HPP
+#define NTA_PROFILER_HPP
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+
+/**
+ * One probe in a profiling snapshot.
+ */
+struct ProfileEntry {
+  std::string name;
+
+  // True for probes that count an amount, e.g. bytes, rather than time
+  bool isCounter;
+
+  // Number of recorded intervals, or of additions to a counter
+  UInt64 count;
+
+  // Total seconds for a timing probe, total amount for a counter
+  Real64 total;
+
+  // Interval percentiles in seconds, zero for counters. Intervals are
+  // bucketed with a relative error below 1/16.
+  Real64 p50;
+  Real64 p99;
+  Real64 p999;
+};
+
+/**
+ * @Responsibility
+ * Process-wide, low overhead latency histograms and counters
+ *
+ * @Description
+ * Code is instrumented with named probes. A timing probe records intervals
+ * between start() and stop() into a log-scaled histogram; a counter probe
+ * sums the amounts passed to add(). Algorithms register their probes up
+ * front, and recording is skipped with a single relaxed load while the
+ * profiler is disabled, which is the default.
+ *
+ * Probes can also be owned by an object that decides when to record, like
+ * the regions and links of a Network. Those register their probes only once
+ * profiling is asked for, record with the unchecked variants regardless of
+ * enable(), and release the probes when they are destroyed, so that the ids
+ * are reused.
+ *
+ * Each thread records into its own counters, so recording takes no lock and
+ * regions computing concurrently don't contend. getSnapshot() merges the
+ * counters of all threads, including threads that have exited.
+ *
+ * Different probes nest freely. Starting a probe again before stopping it
+ * restarts its interval, and stopping a probe that isn't started does
+ * nothing.
+ */
+class Profiler {
+public:
+  // The number of probes that can be registered at the same time
+  static const UInt32 MAX_PROBES = 1024;
+
+  // An id that no probe has, ignored by releaseProbe() and resetProbe()
+  static const UInt32 NO_PROBE = 0xffffffff;
+
+  static void enable();
+  static void disable();
+  static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  /**
+   * Zero the probes whose name starts with prefix, all of them by default.
+   * Recording that happens concurrently may survive the reset.
+   */
+  static void reset(const std::string &prefix = "");
+
+  /**
+   * Zero a single probe.
+   */
+  static void resetProbe(UInt32 probe);
+
+  /**
+   * Get the id of a timing or counter probe, registering it if needed. Each
+   * name maps to the same id until every getter has released it.
+   */
+  static UInt32 getTimingProbe(const std::string &name);
+  static UInt32 getCounterProbe(const std::string &name);
+
+  /**
+   * Drop one reference to a probe. Once the last reference is released the
+   * probe is zeroed and its id reused by the next registration.
+   */
+  static void releaseProbe(UInt32 probe);
+
+  /**
+   * Merge the counters of all threads, in probe id order, for the probes
+   * whose name starts with prefix. Probes that have recorded nothing are
+   * left out.
+   */
+  static std::vector<ProfileEntry>
+  getSnapshot(const std::string &prefix = "");
+
+  static void start(UInt32 probe) {
+    if (isEnabled())
+      start_(probe);
+  }
+
+  static void stop(UInt32 probe) {
+    if (isEnabled())
+      stop_(probe);
+  }
+
+  static void add(UInt32 probe, UInt64 amount) {
+    if (isEnabled())
+      add_(probe, amount);
+  }
+
+  // Record whether or not the profiler is enabled, for owned probes
+  static void startUnchecked(UInt32 probe) { start_(probe); }
+  static void stopUnchecked(UInt32 probe) { stop_(probe); }
+  static void addUnchecked(UInt32 probe, UInt64 amount) {
+    add_(probe, amount);
+  }
+
+private:
+  static void start_(UInt32 probe);
+  static void stop_(UInt32 probe);
+  static void add_(UInt32 probe, UInt64 amount);
+
+  static std::atomic<bool> enabled_;
+};
+
+/**
+ * Records the lifetime of a scope into a timing probe, if record is true.
+ * By default it records while the Profiler is enabled.
+ */
+class ProfileScope {
+public:
+  explicit ProfileScope(UInt32 probe, bool record = Profiler::isEnabled())
+      : probe_(probe), record_(record) {
+    if (record_)
+      Profiler::startUnchecked(probe_);
+  }
+  ~ProfileScope() {
+    if (record_)
+      Profiler::stopUnchecked(probe_);
+  }
+
+private:
+  ProfileScope(const ProfileScope &);
+  ProfileScope &operator=(const ProfileScope &);
+
+  UInt32 probe_;
+  bool record_;
+};
+
+} // namespace nupic
+
+#endif // NTA_PROFILER_HPP
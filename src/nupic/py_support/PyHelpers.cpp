@@ -597,6 +597,17 @@ PyObject *Instance::createInstance_(PyObject *pClass, PyObject *args,
   return pInstance;
 }
 
+// ---
+// Implementation of ReleaseGIL and AcquireGIL classes
+// ---
+ReleaseGIL::ReleaseGIL() : state_(PyEval_SaveThread()) {}
+
+ReleaseGIL::~ReleaseGIL() { PyEval_RestoreThread(state_); }
+
+AcquireGIL::AcquireGIL() : state_(PyGILState_Ensure()) {}
+
+AcquireGIL::~AcquireGIL() { PyGILState_Release(state_); }
+
 //// ---
 //// Raise a Python RuntimeError exception from C++ with
 //// an error message and an optional stack trace. The
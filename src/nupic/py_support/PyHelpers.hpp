@@ -86,6 +86,12 @@
 //   Types for working with the Python object system. Module is for importing
 //   modules. Class is for invoking class methods and Instance is for
 //   instantiating objects and invoking their methods.
+//
+// ReleaseGIL, AcquireGIL:
+//   Scoped locks for the Python global interpreter lock (GIL). ReleaseGIL
+//   lets other Python threads run while C++ code works on its own data.
+//   AcquireGIL takes the GIL back for a call into Python from within such
+//   a block.
 // ===
 
 // Nested namespace nupic::py
@@ -362,6 +368,37 @@ private:
   PyObject *createInstance_(PyObject *pClass, PyObject *args, PyObject *kwargs);
 };
 
+// ReleaseGIL
+//
+// Releases the GIL held by the calling thread for the lifetime of the
+// object and takes it back when destroyed, also during stack unwinding.
+// No Python object may be used in between, including the buffers of numpy
+// arrays that another thread could resize.
+class ReleaseGIL {
+public:
+  ReleaseGIL();
+  ~ReleaseGIL();
+
+private:
+  ReleaseGIL(const ReleaseGIL &);
+  PyThreadState *state_;
+};
+
+// AcquireGIL
+//
+// Makes the calling thread hold the GIL for the lifetime of the object.
+// Works whether or not the thread already holds it, so code that calls
+// into Python can use it without knowing if a caller released the GIL.
+class AcquireGIL {
+public:
+  AcquireGIL();
+  ~AcquireGIL();
+
+private:
+  AcquireGIL(const AcquireGIL &);
+  PyGILState_STATE state_;
+};
+
 //// ---
 //// Raise a Python RuntimeError exception from C++ with
 //// an error message and an optional stack trace. The
@@ -831,6 +831,16 @@ size_t PyRegion::getParameterArrayCount(const std::string &name, Int64 index) {
   return size_t(result);
 }
 
+bool PyRegion::computeModifiesState() {
+  // Regions written against older bindings don't define the method
+  if (!node_.hasAttr("computeModifiesState"))
+    return true;
+
+  py::Bool result(node_.invoke("computeModifiesState", py::Tuple()));
+
+  return bool(result);
+}
+
 size_t PyRegion::getNodeOutputElementCount(const std::string &outputName) {
   py::Tuple args(1);
   args.setItem(0, py::String(outputName));
@@ -862,10 +872,19 @@ std::string PyRegion::executeCommand(const std::vector<std::string> &args,
   return ss;
 }
 
-void PyRegion::compute() {
+void PyRegion::prepareComputeArgs_() {
+  inputs_.reset(new py::Dict());
+  outputs_.reset(new py::Dict());
+  inputViews_.clear();
+  outputViews_.clear();
+
+  computeArgs_.reset(new py::Tuple(2));
+  computeArgs_->setItem(0, *inputs_);
+  computeArgs_->setItem(1, *outputs_);
+}
+
+void PyRegion::updateInputs_() {
   const Spec &ns = getSpec();
-  // Prepare the inputs dict
-  py::Dict inputs;
   for (size_t i = 0; i < ns.inputs.getCount(); ++i) {
     // Get the current InputSpec object
     const std::pair<std::string, InputSpec> &p = ns.inputs.getByIndex(i);
@@ -874,29 +893,31 @@ void PyRegion::compute() {
     Input *inp = region_->getInput(p.first);
     NTA_CHECK(inp);
 
-    // Skip unlinked inputs
-    if (inp->getLinks().empty())
-      continue;
-
     // Set pa to point to the original input array
     const Array *pa = &(inp->getData());
 
-    // Skip dense inputs of size 0
-    if (!inp->isSparse() && pa->getCount() == 0)
+    // Skip unlinked inputs and dense inputs of size 0
+    if (inp->getLinks().empty() || (!inp->isSparse() && pa->getCount() == 0)) {
+      if (inputViews_.erase(p.first)) {
+        NTA_CHECK(PyDict_DelItemString(*inputs_, p.first.c_str()) == 0);
+      }
       continue;
+    }
 
     // If the input requires a splitter map then
     // Copy the original input array to the stored input array, which is larger
     // by one element and put 0 in the extra element. This is needed for
     // splitter map access.
     if (p.second.requireSplitterMap) {
-      // Verify that this input has a stored input array
-      NTA_ASSERT(inputArrays_.find(p.first) != inputArrays_.end());
-      Array &a = *(inputArrays_[p.first]);
-
-      // Verify that the stored input array is larger by 1  then the original
-      // input
-      NTA_ASSERT(a.getCount() == pa->getCount() + 1);
+      // Allocate the stored input array on first use, and again whenever
+      // the original input changes size
+      Array *&stored = inputArrays_[p.first];
+      if (stored == nullptr || stored->getCount() != pa->getCount() + 1) {
+        delete stored;
+        stored = new Array(p.second.dataType);
+        stored->allocateBuffer(pa->getCount() + 1);
+      }
+      Array &a = *stored;
 
       // Work at the char * level because there is no good way
       // to work with the actual data type of the input (since the buffer is
@@ -919,13 +940,23 @@ void PyRegion::compute() {
 
     // Create a numpy array from pa, which wil be either
     // the original input array or a stored input array
-    // (if a splitter map is needed)
-    py::Ptr numpyArray(array2numpy(*pa));
-    inputs.setItem(p.first, numpyArray);
+    // (if a splitter map is needed), unless the current one still fits
+    BufferView &view = inputViews_[p.first];
+    if (!view.array || view.buffer != pa->getBuffer() ||
+        view.count != pa->getCount()) {
+      view.array = std::make_shared<py::Ptr>(array2numpy(*pa));
+      view.buffer = pa->getBuffer();
+      view.count = pa->getCount();
+    }
+
+    // Set the entry on every compute, since Python code may have replaced
+    // or deleted it
+    inputs_->setItem(p.first, *view.array);
   }
+}
 
-  // Prepare the outputs dict
-  py::Dict outputs;
+void PyRegion::updateOutputs_() {
+  const Spec &ns = getSpec();
   for (size_t i = 0; i < ns.outputs.getCount(); ++i) {
     // Get the current OutputSpec object
     const std::pair<std::string, OutputSpec> &p = ns.outputs.getByIndex(i);
@@ -945,10 +976,18 @@ void PyRegion::compute() {
       Array &data = const_cast<Array &>(out->getData());
       data.setCount(data.getMaxElementsCount());
     }
-    py::Ptr numpyArray(array2numpy(data));
 
-    // Insert the buffer to the outputs py::Dict
-    outputs.setItem(p.first, numpyArray);
+    BufferView &view = outputViews_[p.first];
+    if (!view.array || view.buffer != data.getBuffer() ||
+        view.count != data.getCount()) {
+      view.array = std::make_shared<py::Ptr>(array2numpy(data));
+      view.buffer = data.getBuffer();
+      view.count = data.getCount();
+    }
+
+    // Insert the buffer to the outputs py::Dict on every compute, since
+    // Python code may have replaced or deleted the entry
+    outputs_->setItem(p.first, *view.array);
 
     // Add sparse output len placeholder field
     if (out->isSparse()) {
@@ -959,21 +998,33 @@ void PyRegion::compute() {
       name << "__" << p.first << "_len__";
 
       // The outputs dict is immutable. Use a list to enable update from python
-      py::List len;
-      len.append(py::Int(0l));
-      outputs.setItem(name.str(), len);
+      if (!view.length) {
+        view.length = std::make_shared<py::List>();
+        view.length->append(py::Int(0l));
+      } else {
+        py::Int zero(0l);
+        view.length->setItem(0, zero);
+      }
+      outputs_->setItem(name.str(), *view.length);
     }
   }
+}
 
-  // Call the Python compute() method
-  py::Tuple args(2);
-  args.setItem(0, inputs);
-  args.setItem(1, outputs);
+void PyRegion::compute() {
+  // The Python bindings release the GIL for Network::run()
+  py::AcquireGIL gil;
+
+  if (!computeArgs_) {
+    prepareComputeArgs_();
+  }
+  updateInputs_();
+  updateOutputs_();
 
   // Need to put the None result in py::Ptr to decrement the ref count
-  py::Ptr none(node_.invoke("guardedCompute", args));
+  py::Ptr none(node_.invoke("guardedCompute", *computeArgs_));
 
   // Resize sparse outputs
+  const Spec &ns = getSpec();
   for (size_t i = 0; i < ns.outputs.getCount(); ++i) {
     const std::pair<std::string, OutputSpec> &p = ns.outputs.getByIndex(i);
     // Get the corresponding output buffer
@@ -985,7 +1036,7 @@ void PyRegion::compute() {
     if (out->isSparse()) {
       std::stringstream name;
       name << "__" << p.first << "_len__";
-      py::List len(outputs.getItem(name.str()));
+      py::List len(outputs_->getItem(name.str()));
 
       // Remove 'const' to update the variable length array
       Array &data = const_cast<Array &>(out->getData());
@@ -1278,6 +1329,11 @@ void PyRegion::initialize() {
   // Call the Python initialize() method
   // Need to put the None result in py::Ptr, so decrement the ref count
   py::Ptr none(node_.invoke("initialize", py::Tuple()));
+
+  // The input and output buffers are in place now; wrap them once
+  prepareComputeArgs_();
+  updateInputs_();
+  updateOutputs_();
 }
 
 } // end namespace nupic
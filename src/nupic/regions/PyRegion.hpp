@@ -25,6 +25,8 @@
 
 #include <nupic/py_support/PyArray.hpp>
 
+#include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -116,6 +118,8 @@ public:
 
   size_t getParameterArrayCount(const std::string &name, Int64 index) override;
 
+  bool computeModifiesState() override;
+
   virtual Byte getParameterByte(const std::string &name, Int64 index);
   virtual Int32 getParameterInt32(const std::string &name,
                                   Int64 index) override;
@@ -172,6 +176,19 @@ private:
   PyRegion();
   PyRegion(const Region &);
 
+  // A numpy array of the compute() dicts, kept while it still points to the
+  // region buffer, and the length list of a sparse output
+  struct BufferView {
+    const void *buffer;
+    size_t count;
+    std::shared_ptr<py::Ptr> array;
+    std::shared_ptr<py::List> length;
+  };
+
+  void prepareComputeArgs_();
+  void updateInputs_();
+  void updateOutputs_();
+
 private:
   static SpecMap specs_;
   std::string module_;
@@ -181,6 +198,15 @@ private:
   // pointers rather than objects because Array doesnt
   // have a default constructor
   std::map<std::string, Array *> inputArrays_;
+
+  // The arguments of the Python compute(), built once and reused. Their
+  // numpy arrays alias the Input and Output buffers, so an entry is only
+  // rebuilt when its buffer moves or changes size.
+  std::unique_ptr<py::Dict> inputs_;
+  std::unique_ptr<py::Dict> outputs_;
+  std::unique_ptr<py::Tuple> computeArgs_;
+  std::map<std::string, BufferView> inputViews_;
+  std::map<std::string, BufferView> outputViews_;
 };
 } // namespace nupic
 
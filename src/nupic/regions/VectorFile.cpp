@@ -24,13 +24,16 @@
  * Implementation for VectorFile class
  */
 
+#include <algorithm>
 #include <cstring> // memset
 #include <iostream>
 #include <math.h>
 #include <nupic/math/Utils.hpp> // For isSystemLittleEndian and utils::swapBytesInPlace.
 #include <nupic/os/FStream.hpp>
+#include <nupic/os/MappedFile.hpp>
 #include <nupic/os/Path.hpp>
 #include <nupic/regions/VectorFile.hpp>
+#include <nupic/utils/BinaryStream.hpp>
 #include <nupic/utils/Log.hpp>
 #include <sstream>
 #include <stdexcept>
@@ -40,8 +43,10 @@
 using namespace std;
 using namespace nupic;
 
+static const UInt32 VECTOR_FILE_BINARY_VERSION = 1;
+
 //----------------------------------------------------------------------------
-VectorFile::VectorFile() {}
+VectorFile::VectorFile() : mappedCount_(0) {}
 
 //----------------------------------------------------------------------------
 VectorFile::~VectorFile() { clear(); }
@@ -60,6 +65,8 @@ void VectorFile::clear(bool clearScaling) {
   }
   fileVectors_.clear();
   own_.clear();
+  mappedVectors_.clear();
+  mappedCount_ = 0;
 
   elementLabels_.clear();
   vectorLabels_.clear();
@@ -86,6 +93,10 @@ void VectorFile::appendFile(const string &fileName,
     appendIDXFile(fileName, int(expectedElementCount), true);
     handled = true;
     break;
+  case 7:
+    appendMappedFile(fileName, expectedElementCount);
+    handled = true;
+    break;
   }
 
   if (!handled) {
@@ -143,6 +154,10 @@ void VectorFile::appendFile(const string &fileName,
           }
         }
 
+        // Keep a label per vector, giving the vectors of earlier binary files
+        // empty labels
+        vectorLabels_.resize(vectorCount());
+
         // Read each vector in, including labels if so indicated
         while (!inFile.eof()) {
           string vectorLabel;
@@ -171,7 +186,7 @@ void VectorFile::appendFile(const string &fileName,
     }
   }
 
-  NTA_CHECK(fileVectors_.size() > 0)
+  NTA_CHECK(vectorCount() > 0)
       << "VectorFile::appendFile - no vectors were read in.";
 
   // Reset scaling only if the vector lengths changed
@@ -205,15 +220,14 @@ static bool dosEndings(IFStream &inFile) {
 
 void VectorFile::saveVectors(ostream &out, Size nColumns, UInt32 fileFormat,
                              Int64 begin, const char *lineEndings) {
-  saveVectors(out, nColumns, fileFormat, begin, fileVectors_.size(),
-              lineEndings);
+  saveVectors(out, nColumns, fileFormat, begin, vectorCount(), lineEndings);
 }
 
 void VectorFile::saveVectors(ostream &out, Size nColumns, UInt32 fileFormat,
                              Int64 begin, Int64 end, const char *lineEndings) {
   out.exceptions(ios_base::failbit | ios_base::badbit);
 
-  Size n = fileVectors_.size();
+  Size n = vectorCount();
   if (begin < 0)
     begin += n;
   if (end < 0)
@@ -231,9 +245,7 @@ void VectorFile::saveVectors(ostream &out, Size nColumns, UInt32 fileFormat,
   if (end < begin)
     end = begin;
 
-  // Setup iterators for the rows.
-  vector<Real *>::const_iterator i = (fileVectors_.begin() + size_t(begin));
-  auto iend = i + size_t(end - begin);
+  vector<Real> row(nColumns);
 
   switch (fileFormat) {
   case 0:
@@ -256,7 +268,6 @@ void VectorFile::saveVectors(ostream &out, Size nColumns, UInt32 fileFormat,
 
     // Decide if each row should be labelled in the output.
     bool hasRowLabels = false;
-    vector<string>::const_iterator iRowLabel;
     switch (fileFormat) {
     case 1:
       // case 3: // Could be supported, but is not.
@@ -310,18 +321,17 @@ void VectorFile::saveVectors(ostream &out, Size nColumns, UInt32 fileFormat,
     }
 
     // Output the rows.
-    for (; i != iend; ++i) {
+    for (Int64 v = begin; v < end; ++v) {
       if (hasRowLabels) {
-        out << *(iRowLabel++);
+        out << vectorLabels_[size_t(v)];
         if (nColumns)
           out << sep;
       }
-      const Real *p = *i;
       if (nColumns) {
-        const Real *pEnd = p + nColumns;
-        out << *(p++);
-        for (; p < pEnd;)
-          out << sep << *(p++);
+        copyVector(Size(v), 0, nColumns, row.data());
+        out << row[0];
+        for (Size j = 1; j < nColumns; ++j)
+          out << sep << row[j];
       }
       out << lineSep;
     }
@@ -335,29 +345,29 @@ void VectorFile::saveVectors(ostream &out, Size nColumns, UInt32 fileFormat,
     const Size rowBytes = nColumns * sizeof(Real32);
     const bool bigEndian = (fileFormat == 5);
     const bool needSwap = (nupic::isSystemLittleEndian() == bigEndian);
-    const bool needConversion = (sizeof(Real32) == sizeof(Real));
 
-    if (needSwap || needConversion) {
-      auto buffer = new Real32[nColumns];
-      try {
-        for (; i != iend; ++i) {
-          if (needConversion) {
-            const Real *p = *i;
-            for (Size j = 0; j < nColumns; ++j)
-              buffer[j] = *(p++);
-          }
-          if (needSwap)
-            nupic::swapBytesInPlace(buffer, nColumns);
-          out.write((char *)buffer, streamsize(rowBytes));
-        }
-      } catch (...) {
-        delete[] buffer;
-        throw;
-      }
-      delete[] buffer;
-    } else {
-      for (; i != iend; ++i)
-        out.write((char *)(*i), streamsize(rowBytes));
+    vector<Real32> buffer(nColumns);
+    for (Int64 v = begin; v < end; ++v) {
+      copyVector(Size(v), 0, nColumns, row.data());
+      std::copy(row.begin(), row.end(), buffer.begin());
+      if (needSwap)
+        nupic::swapBytesInPlace(buffer.data(), nColumns);
+      out.write((char *)buffer.data(), streamsize(rowBytes));
+    }
+    break;
+  }
+  case 7: {
+    util::BinaryWriter writer(out);
+    writer.writeMarker("NTAVECTR");
+    writer.write<UInt32>(VECTOR_FILE_BINARY_VERSION);
+    writer.write<UInt32>(UInt32(nColumns));
+    writer.write<UInt64>(UInt64(end - begin));
+
+    vector<Real32> buffer(nColumns);
+    for (Int64 v = begin; v < end; ++v) {
+      copyVector(Size(v), 0, nColumns, row.data());
+      std::copy(row.begin(), row.end(), buffer.begin());
+      writer.writeArray(buffer.data(), nColumns);
     }
     break;
   }
@@ -418,7 +428,7 @@ void VectorFile::appendFloat32File(const string &filename,
     throw logic_error("Invalid ownership flags.");
   }
   Size nRowLabels = vectorLabels_.size();
-  if (nRowLabels && (nRowLabels != offset)) {
+  if (nRowLabels && (nRowLabels != vectorCount())) {
     throw logic_error("Invalid number of row labels.");
   }
 
@@ -430,7 +440,7 @@ void VectorFile::appendFloat32File(const string &filename,
     own_[offset] = true; // The first vector pointer points to the whole block.
 
     if (nRowLabels)
-      vectorLabels_.resize(offset + nRows);
+      vectorLabels_.resize(nRowLabels + nRows);
 
     block = new Real[nRows * expectedElements];
 
@@ -458,7 +468,7 @@ void VectorFile::appendFloat32File(const string &filename,
     fileVectors_.resize(offset);
     own_.resize(offset);
     if (nRowLabels)
-      vectorLabels_.resize(offset);
+      vectorLabels_.resize(nRowLabels);
     throw;
   }
 }
@@ -478,6 +488,10 @@ void VectorFile::appendFloat32File(const string &filename,
 //    23,"42,d",55
 
 void VectorFile::appendCSVFile(IFStream &inFile, Size expectedElements) {
+  // Keep a label per vector, giving the vectors of earlier binary files
+  // empty labels
+  vectorLabels_.resize(vectorCount());
+
   // Read in csv file one line at a time. If that line contains any errors,
   // skip it and move onto the next one.
   try {
@@ -593,7 +607,7 @@ void VectorFile::appendIDXFile(const string &filename, int expectedElements,
     throw logic_error("Invalid ownership flags.");
   }
   Size nRowLabels = vectorLabels_.size();
-  if (nRowLabels && (nRowLabels != offset)) {
+  if (nRowLabels && (nRowLabels != vectorCount())) {
     throw logic_error("Invalid number of row labels.");
   }
 
@@ -692,7 +706,7 @@ void VectorFile::appendIDXFile(const string &filename, int expectedElements,
     own_[offset] = true; // The first vector pointer points to the whole block.
 
     if (nRowLabels)
-      vectorLabels_.resize(offset + nRows);
+      vectorLabels_.resize(nRowLabels + nRows);
 
     // Set all the row pointers.
     fileVectors_.resize(offset + nRows);
@@ -706,7 +720,7 @@ void VectorFile::appendIDXFile(const string &filename, int expectedElements,
     fileVectors_.resize(offset);
     own_.resize(offset);
     if (nRowLabels)
-      vectorLabels_.resize(offset);
+      vectorLabels_.resize(nRowLabels);
     throw;
   }
 
@@ -715,6 +729,74 @@ void VectorFile::appendIDXFile(const string &filename, int expectedElements,
   // Don't delete block, as it is owned by fileVectors_ now.
 }
 
+void VectorFile::appendMappedFile(const string &filename,
+                                  Size expectedElements) {
+  auto file = make_shared<MappedFile>(filename);
+  util::BinaryReader reader(file->data(), file->size());
+
+  reader.readMarker("NTAVECTR");
+  const UInt32 version = reader.read<UInt32>();
+  NTA_CHECK(version <= VECTOR_FILE_BINARY_VERSION)
+      << "VectorFile::appendFile - unsupported binary vector file version "
+      << version << " in " << filename;
+  const UInt32 elementCount = reader.read<UInt32>();
+  const UInt64 nRows = reader.read<UInt64>();
+
+  if (elementCount != expectedElements) {
+    NTA_THROW << "VectorFile::appendFile - number of elements"
+              << " in file (" << elementCount << ") does not match"
+              << " output element count (" << expectedElements << ")";
+  }
+  const Size rowBytes = elementCount * sizeof(Real32);
+  NTA_CHECK(elementCount > 0 && reader.remaining() % rowBytes == 0 &&
+            reader.remaining() / rowBytes == nRows)
+      << "VectorFile::appendFile - binary vector file " << filename
+      << " does not hold " << nRows << " vectors of " << elementCount
+      << " elements.";
+  if (nRows == 0)
+    return; // Early exit when there are no new vectors.
+
+  // Nothing is read here: rows are paged in by copyVector() on first use.
+  MappedVectors mapped;
+  mapped.rows = file->data() + (file->size() - reader.remaining());
+  mapped.file = file;
+  mapped.first = vectorCount();
+  mapped.count = Size(nRows);
+  mapped.elements = elementCount;
+
+  // Vector labels are either empty or one per vector
+  if (!vectorLabels_.empty())
+    vectorLabels_.resize(vectorLabels_.size() + mapped.count);
+  mappedVectors_.push_back(mapped);
+  mappedCount_ += mapped.count;
+}
+
+void VectorFile::copyVector(Size v, Size offset, Size count, Real *out) const {
+  // Vectors that are not in a mapped file are numbered in fileVectors_
+  // without the mapped rows in front of them.
+  Size heapIndex = v;
+  for (const MappedVectors &mapped : mappedVectors_) {
+    if (v < mapped.first)
+      break;
+    if (v < mapped.first + mapped.count) {
+      NTA_CHECK(offset + count <= mapped.elements);
+      const Real32 *row = reinterpret_cast<const Real32 *>(mapped.rows) +
+                          (v - mapped.first) * mapped.elements + offset;
+      if (util::kHostIsLittleEndian) {
+        std::copy(row, row + count, out);
+      } else {
+        for (Size i = 0; i < count; i++)
+          out[i] = util::byteSwap(row[i]);
+      }
+      return;
+    }
+    heapIndex -= mapped.count;
+  }
+
+  const Real *vec = fileVectors_[heapIndex] + offset;
+  std::copy(vec, vec + count, out);
+}
+
 /// Reset scaling to have no effect (unitary scaling vector and zero offset
 /// vector)
 void VectorFile::resetScaling(UInt nElements) {
@@ -744,10 +826,7 @@ void VectorFile::getRawVector(const UInt v, Real *out, UInt offset,
     NTA_THROW << "Wrong offset/count: the sum " << offset << "+" << count
               << " = " << offset + count
               << ", must be smaller than element count: " << getElementCount();
-  // Get the pointers and copy over the vector
-  Real *vec = fileVectors_[v];
-  for (Size i = 0; i < count; i++)
-    out[i] = vec[offset + i];
+  copyVector(v, offset, count, out);
 }
 
 /// Retrieve i'th vector, apply scaling and copy result into output
@@ -759,10 +838,10 @@ void VectorFile::getScaledVector(const UInt v, Real *out, UInt offset,
 
   NTA_CHECK(getElementCount() <= offset + count);
 
-  // Get the pointers and copy over the vector
-  Real *vec = fileVectors_[v];
+  // Copy the vector over and scale it in place
+  copyVector(v, offset, count, out);
   for (Size i = 0; i < count; i++) {
-    out[i] = scaleVector_[i] * (vec[i + offset] + offsetVector_[i]);
+    out[i] = scaleVector_[i] * (out[i] + offsetVector_[i]);
   }
 }
 
@@ -796,24 +875,36 @@ void VectorFile::setStandardScaling() {
     NTA_THROW << "Error in setting standard scaling: insufficient vectors "
                  "loaded in memory.";
 
+  // Walk the vectors one row at a time, so that mapped files are read
+  // sequentially, accumulating per-element sums as doubles.
   Size nv = vectorCount();
-  for (UInt e = 0; e < getElementCount(); e++) {
-    double sum = 0, sum2 = 0; // Accumulate sums as doubles
-
-    // First compute the mean and offset
-    for (Size i = 0; i < nv; i++)
-      sum += fileVectors_[i][e];
-    double mean = sum / nv;
-    offsetVector_[e] = (Real)(-mean);
-
-    // Now compute the squared term for stdev
-    for (Size i = 0; i < nv; i++) {
-      double s = (fileVectors_[i][e] - mean);
-      sum2 += s * s;
+  Size ne = getElementCount();
+  vector<Real> row(ne);
+  vector<double> mean(ne, 0), sum2(ne, 0);
+
+  // First compute the mean and offset
+  for (Size i = 0; i < nv; i++) {
+    copyVector(i, 0, ne, row.data());
+    for (Size e = 0; e < ne; e++)
+      mean[e] += row[e];
+  }
+  for (Size e = 0; e < ne; e++) {
+    mean[e] /= nv;
+    offsetVector_[e] = (Real)(-mean[e]);
+  }
+
+  // Now compute the squared term for stdev
+  for (Size i = 0; i < nv; i++) {
+    copyVector(i, 0, ne, row.data());
+    for (Size e = 0; e < ne; e++) {
+      double s = (row[e] - mean[e]);
+      sum2[e] += s * s;
     }
+  }
 
+  for (Size e = 0; e < ne; e++) {
     // Now compute the "unbiased" or "n-1" form of standard deviation
-    double stdev = sqrt(sum2 / (nv - 1));
+    double stdev = sqrt(sum2[e] / (nv - 1));
     if (fabs(stdev) < 0.00000001)
       NTA_THROW << "Error setting standard form, stdeviation is almost zero "
                    "for some component.";
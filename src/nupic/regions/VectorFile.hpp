@@ -31,11 +31,14 @@
 
 //----------------------------------------------------------------------
 
+#include <memory>
 #include <nupic/os/FStream.hpp>
 #include <nupic/types/Types.hpp>
 #include <vector>
 
 namespace nupic {
+class MappedFile;
+
 /**
  *  VectorFile is a simple container class for lists of numerical vectors. Its
  * only purpose is to support the needs of the VectorFileSensor. Key features of
@@ -47,7 +50,7 @@ public:
   VectorFile();
   virtual ~VectorFile();
 
-  static Int32 maxFormat() { return 6; }
+  static Int32 maxFormat() { return 7; }
 
   /// Read in vectors from the given filename. All vectors are expected to
   /// have the same size (i.e. same number of elements).
@@ -62,7 +65,13 @@ public:
   ///           count 3        # Reads in a csv file 4        # Reads in a
   ///           little-endian float32 binary file 5        # Reads in a
   ///           big-endian float32 binary file 6        # Reads in a big-endian
-  ///           IDX binary file
+  ///           IDX binary file 7        # Maps a binary vector file written
+  ///           by saveVectors in format 7
+  ///
+  /// Format 7 files are not read into memory: the file is mapped read-only
+  /// and each vector is converted when it is requested, so appending one is
+  /// constant time and resident memory is bounded by the pages in use. Any
+  /// other format can be converted to it with saveVectors.
   void appendFile(const std::string &fileName, NTA_Size expectedElementCount,
                   UInt32 fileFormat);
 
@@ -75,7 +84,7 @@ public:
   void getRawVector(const UInt i, Real *out, UInt offset, Size count);
 
   /// Return the number of stored vectors
-  size_t vectorCount() const { return fileVectors_.size(); }
+  size_t vectorCount() const { return fileVectors_.size() + mappedCount_; }
 
   /// Return the size of each vevtor (number of elements per vector)
   size_t getElementCount() const;
@@ -117,6 +126,9 @@ public:
   void readState(std::istream &state);
 
   /// Save vectors, unscaled, to a file with the specified format.
+  /// Format 7 writes a little-endian header ("NTAVECTR", UInt32 version,
+  /// UInt32 element count, UInt64 vector count) followed by the vectors as
+  /// consecutive rows of little-endian Real32 values.
   void saveVectors(std::ostream &out, Size nColumns, UInt32 fileFormat,
                    Int64 begin = 0, const char *lineEndings = nullptr);
   void saveVectors(std::ostream &out, Size nColumns, UInt32 fileFormat,
@@ -128,6 +140,18 @@ private:
   std::vector<Real> scaleVector_;   // the scaling vector
   std::vector<Real> offsetVector_;  // the offset vector
 
+  /// The rows of a format 7 file, which occupy indices
+  /// [first, first + count) of the vector list.
+  struct MappedVectors {
+    std::shared_ptr<MappedFile> file;
+    const char *rows;
+    Size first;
+    Size count;
+    Size elements;
+  };
+  std::vector<MappedVectors> mappedVectors_;
+  Size mappedCount_; // total number of rows in mappedVectors_
+
   std::vector<std::string>
       elementLabels_; // string denoting the meaning of each element
   std::vector<std::string> vectorLabels_; // a string label for each vector
@@ -143,6 +167,12 @@ private:
   void appendIDXFile(const std::string &filename, int expectedElements,
                      bool bigEndian);
 
+  /// Map a binary vector file (format 7).
+  void appendMappedFile(const std::string &filename, Size expectedElements);
+
+  /// Copy elements [offset, offset + count) of vector v into out.
+  void copyVector(Size v, Size offset, Size count, Real *out) const;
+
 }; // end class VectorFile
 
 //----------------------------------------------------------------------
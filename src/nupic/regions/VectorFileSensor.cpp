@@ -267,11 +267,13 @@ VectorFileSensor::executeCommand(const std::vector<std::string> &args,
 
     NTA_CHECK(argCount <= 5) << "VectorFileSensor: too many arguments";
 
-    OFStream f(filename.c_str());
+    const ios_base::openmode mode =
+        (format >= 4) ? ios_base::out | ios_base::binary : ios_base::out;
+    OFStream f(filename.c_str(), mode);
     if (hasEnd)
       vectorFile_.saveVectors(f, dataOut_.getCount(), format, begin, end);
     else
-      vectorFile_.saveVectors(f, dataOut_.getCount(), format, begin, end);
+      vectorFile_.saveVectors(f, dataOut_.getCount(), format, begin);
   }
 
   else {
@@ -666,7 +668,8 @@ Spec *VectorFileSensor::createSpec() {
           "element count (deprecated)\n"
           "       2        # Reads in unlabeled file without element count "
           "(default)\n"
-          "       3        # Reads in a csv file\n"));
+          "       3        # Reads in a csv file\n"
+          "       7        # Maps a binary vector file written by saveFile\n"));
 
   ns->commands.add(
       "appendFile",
@@ -680,13 +683,17 @@ Spec *VectorFileSensor::createSpec() {
                   "= element count (deprecated)\n"
                   "       2        # Reads in unlabeled file without element "
                   "count (default)\n"
-                  "       3        # Reads in a csv file\n"));
+                  "       3        # Reads in a csv file\n"
+                  "       7        # Maps a binary vector file written by "
+                  "saveFile\n"));
 
   ns->commands.add(
       "saveFile", CommandSpec("saveFile filename [format [begin [end]]]\n"
                               "Save the currently loaded vectors to a file. "
                               "Typically used for debugging\n"
-                              "but may be used to convert between formats.\n"));
+                              "but may be used to convert between formats.\n"
+                              "Format 7 files are memory-mapped by loadFile\n"
+                              "instead of being read into memory.\n"));
 
   ns->commands.add("dump", CommandSpec("Displays some debugging info."));
 
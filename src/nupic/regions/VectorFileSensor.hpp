@@ -94,7 +94,9 @@ class ValueMap;
  *
  *  Whitespace between numbers is ignored.
  *  The full list of vectors is read into memory when the loadFile command
- *  is executed.
+ *  is executed, except for binary vector files (format 7), which are mapped
+ *  and read one vector at a time. Use saveFile with format 7 to convert a
+ *  large data set once.
  *
  */
 
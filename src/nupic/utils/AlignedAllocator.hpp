@@ -0,0 +1,112 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definitions for the AlignedAllocator class
+ */
+
+#ifndef NUPIC_UTIL_ALIGNED_ALLOCATOR_HPP
+#define NUPIC_UTIL_ALIGNED_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(NTA_OS_WINDOWS)
+#include <malloc.h>
+#endif
+
+namespace nupic {
+
+namespace util {
+
+/**
+ * An STL allocator that returns storage aligned to a given boundary.
+ *
+ * @b Description
+ * Dense kernels that walk rows with SIMD loads use this to keep the start of
+ * their buffers on a cache line. Rows whose stride is a multiple of the
+ * alignment then start on a cache line as well.
+ *
+ * @param T The element type.
+ * @param Alignment The alignment in bytes. Must be a power of two and a
+ *        multiple of sizeof(void*).
+ */
+template <typename T, std::size_t Alignment = 64> class AlignedAllocator {
+public:
+  typedef T value_type;
+
+  template <typename U> struct rebind {
+    typedef AlignedAllocator<U, Alignment> other;
+  };
+
+  AlignedAllocator() noexcept {}
+
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+  T *allocate(std::size_t n) {
+    if (n == 0) {
+      return nullptr;
+    }
+
+    void *p = nullptr;
+#if defined(NTA_OS_WINDOWS)
+    p = _aligned_malloc(n * sizeof(T), Alignment);
+#else
+    if (posix_memalign(&p, Alignment, n * sizeof(T)) != 0) {
+      p = nullptr;
+    }
+#endif
+    if (p == nullptr) {
+      throw std::bad_alloc();
+    }
+
+    return static_cast<T *>(p);
+  }
+
+  void deallocate(T *p, std::size_t) noexcept {
+#if defined(NTA_OS_WINDOWS)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+  }
+};
+
+template <typename T, typename U, std::size_t Alignment>
+inline bool operator==(const AlignedAllocator<T, Alignment> &,
+                       const AlignedAllocator<U, Alignment> &) {
+  return true;
+}
+
+template <typename T, typename U, std::size_t Alignment>
+inline bool operator!=(const AlignedAllocator<T, Alignment> &,
+                       const AlignedAllocator<U, Alignment> &) {
+  return false;
+}
+
+} // namespace util
+
+} // namespace nupic
+
+#endif // NUPIC_UTIL_ALIGNED_ALLOCATOR_HPP
@@ -0,0 +1,169 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definitions for the BinaryWriter and BinaryReader classes
+ */
+
+#ifndef NUPIC_UTIL_BINARY_STREAM_HPP
+#define NUPIC_UTIL_BINARY_STREAM_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nupic/types/Types.hpp>
+#include <nupic/utils/Log.hpp>
+
+namespace nupic {
+
+namespace util {
+
+/**
+ * Snapshots are always little-endian. Big-endian hosts swap each element on
+ * the way in and out, everyone else copies whole arrays.
+ */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+static const bool kHostIsLittleEndian = false;
+#else
+static const bool kHostIsLittleEndian = true;
+#endif
+
+template <typename T> inline T byteSwap(T v) {
+  char *bytes = reinterpret_cast<char *>(&v);
+  for (std::size_t i = 0; i < sizeof(T) / 2; i++) {
+    std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+  }
+  return v;
+}
+
+/**
+ * Writes fixed-width scalars and flat arrays to an ostream in the
+ * little-endian layout read back by BinaryReader.
+ *
+ * Markers are eight characters wide so that the arrays following them keep
+ * their natural alignment relative to the start of the snapshot.
+ */
+class BinaryWriter {
+public:
+  explicit BinaryWriter(std::ostream &outStream) : outStream_(outStream) {}
+
+  void writeMarker(const char (&marker)[9]) { outStream_.write(marker, 8); }
+
+  template <typename T> void write(T v) { writeArray(&v, 1); }
+
+  template <typename T> void writeArray(const T *data, std::size_t n) {
+    if (kHostIsLittleEndian) {
+      outStream_.write(reinterpret_cast<const char *>(data), n * sizeof(T));
+    } else {
+      for (std::size_t i = 0; i < n; i++) {
+        const T v = byteSwap(data[i]);
+        outStream_.write(reinterpret_cast<const char *>(&v), sizeof(T));
+      }
+    }
+  }
+
+  /**
+   * Writes the element count as a UInt64 followed by the elements.
+   */
+  template <typename T> void writeVector(const std::vector<T> &v) {
+    write<UInt64>(v.size());
+    writeArray(v.data(), v.size());
+  }
+
+  void writeString(const std::string &s) {
+    write<UInt64>(s.size());
+    outStream_.write(s.data(), s.size());
+  }
+
+private:
+  std::ostream &outStream_;
+};
+
+/**
+ * Reads a snapshot written by BinaryWriter out of a contiguous buffer,
+ * typically a read-only MappedFile. The buffer is not copied and must
+ * outlive the reader. Every read is bounds checked, so a truncated or
+ * corrupted snapshot throws instead of reading past the end.
+ */
+class BinaryReader {
+public:
+  BinaryReader(const char *data, std::size_t size)
+      : data_(data), size_(size), offset_(0) {}
+
+  void readMarker(const char (&marker)[9]) {
+    NTA_CHECK(remaining() >= 8 && std::memcmp(data_ + offset_, marker, 8) == 0)
+        << "Expected marker '" << marker << "' at offset " << offset_;
+    offset_ += 8;
+  }
+
+  template <typename T> T read() {
+    T v;
+    readArray(&v, 1);
+    return v;
+  }
+
+  template <typename T> void readArray(T *out, std::size_t n) {
+    NTA_CHECK(n <= remaining() / sizeof(T))
+        << "Binary snapshot truncated at offset " << offset_;
+    std::memcpy(out, data_ + offset_, n * sizeof(T));
+    offset_ += n * sizeof(T);
+    if (!kHostIsLittleEndian) {
+      for (std::size_t i = 0; i < n; i++) {
+        out[i] = byteSwap(out[i]);
+      }
+    }
+  }
+
+  template <typename T> void readVector(std::vector<T> &v) {
+    const UInt64 n = read<UInt64>();
+    NTA_CHECK(n <= remaining() / sizeof(T))
+        << "Binary snapshot truncated at offset " << offset_;
+    v.resize(n);
+    readArray(v.data(), n);
+  }
+
+  std::string readString() {
+    const UInt64 n = read<UInt64>();
+    NTA_CHECK(n <= remaining())
+        << "Binary snapshot truncated at offset " << offset_;
+    std::string s(data_ + offset_, n);
+    offset_ += n;
+    return s;
+  }
+
+  std::size_t remaining() const { return size_ - offset_; }
+
+private:
+  const char *data_;
+  std::size_t size_;
+  std::size_t offset_;
+};
+
+} // end namespace util
+
+} // end namespace nupic
+
+#endif // NUPIC_UTIL_BINARY_STREAM_HPP
@@ -24,50 +24,122 @@
 #include "nupic/utils/Log.hpp"
 
 #include <algorithm>
-#include <iterator>
-#include <numeric>
+#include <iomanip>
+#include <limits>
 
 using namespace std;
 using namespace ::nupic;
 using namespace nupic::util;
 
 MovingAverage::MovingAverage(UInt wSize, const vector<Real32> &historicalValues)
-    : windowSize_(wSize) {
-  if (historicalValues.size() != 0) {
-    copy(historicalValues.begin() + historicalValues.size() - wSize,
-         historicalValues.end(), back_inserter(slidingWindow_));
+    : MovingAverage(wSize) {
+  const size_t first = historicalValues.size() > windowSize_
+                           ? historicalValues.size() - windowSize_
+                           : 0;
+  for (size_t i = first; i < historicalValues.size(); i++) {
+    add_(historicalValues[i]);
   }
-  total_ = Real32(accumulate(slidingWindow_.begin(), slidingWindow_.end(), 0));
 }
 
-MovingAverage::MovingAverage(UInt wSize) : windowSize_(wSize), total_(0) {}
+MovingAverage::MovingAverage(UInt wSize)
+    : windowSize_(wSize), oldest_(0), total_(0), mean_(0), m2_(0) {
+  NTA_CHECK(wSize > 0) << "MovingAverage needs a window of at least 1";
+}
+
+void MovingAverage::add_(Real32 value) {
+  slidingWindow_.push_back(value);
+  total_ += value;
+  const Real64 delta = value - mean_;
+  mean_ += delta / slidingWindow_.size();
+  m2_ += delta * (value - mean_);
+}
+
+void MovingAverage::replace_(Real32 oldValue, Real32 newValue) {
+  const Real64 delta = Real64(newValue) - oldValue;
+  const Real64 oldMean = mean_;
+  total_ += delta;
+  mean_ += delta / slidingWindow_.size();
+  m2_ += delta * (newValue - mean_ + oldValue - oldMean);
+  m2_ = max(m2_, 0.0);
+}
 
 Real32 MovingAverage::compute(Real32 newVal) {
-  if (windowSize_ == slidingWindow_.size()) {
-    total_ -= slidingWindow_.front();
-    slidingWindow_.erase(slidingWindow_.begin()); // pop front element
+  if (slidingWindow_.size() < windowSize_) {
+    add_(newVal);
+  } else {
+    const Real32 oldVal = slidingWindow_[oldest_];
+    slidingWindow_[oldest_] = newVal;
+    replace_(oldVal, newVal);
+    oldest_ = (oldest_ + 1) % windowSize_;
   }
-
-  slidingWindow_.push_back(newVal);
-  total_ += newVal;
   return getCurrentAvg();
 }
 
 std::vector<Real32> MovingAverage::getSlidingWindow() const {
-  return slidingWindow_;
+  vector<Real32> window(slidingWindow_.begin() + oldest_,
+                        slidingWindow_.end());
+  window.insert(window.end(), slidingWindow_.begin(),
+                slidingWindow_.begin() + oldest_);
+  return window;
 }
 
 Real32 MovingAverage::getCurrentAvg() const {
-  return Real32(total_) / Real32(slidingWindow_.size());
+  return Real32(total_ / Real64(slidingWindow_.size()));
+}
+
+Real64 MovingAverage::getCurrentVariance() const {
+  if (slidingWindow_.empty()) {
+    return 0;
+  }
+  return m2_ / slidingWindow_.size();
+}
+
+void MovingAverage::save(ostream &outStream) const {
+  outStream << "MovingAverage" << endl;
+  const std::streamsize precision = outStream.precision();
+  outStream << std::setprecision(std::numeric_limits<Real64>::max_digits10);
+  outStream << windowSize_ << " " << total_ << " " << mean_ << " " << m2_
+            << endl;
+
+  const vector<Real32> window = getSlidingWindow();
+  outStream << std::setprecision(std::numeric_limits<Real32>::max_digits10);
+  outStream << window.size() << " ";
+  for (Real32 value : window) {
+    outStream << value << " ";
+  }
+  outStream << endl;
+  outStream << "~MovingAverage" << endl;
+  outStream.precision(precision);
+}
+
+void MovingAverage::load(istream &inStream) {
+  string marker;
+  inStream >> marker;
+  NTA_CHECK(marker == "MovingAverage");
+
+  inStream >> windowSize_ >> total_ >> mean_ >> m2_;
+  NTA_CHECK(windowSize_ > 0);
+
+  size_t size;
+  inStream >> size;
+  NTA_CHECK(size <= windowSize_);
+  slidingWindow_.resize(size);
+  for (Real32 &value : slidingWindow_) {
+    inStream >> value;
+  }
+  oldest_ = 0;
+
+  inStream >> marker;
+  NTA_CHECK(marker == "~MovingAverage");
 }
 
 bool MovingAverage::operator==(const MovingAverage &r2) const {
   return (windowSize_ == r2.windowSize_ &&
-          slidingWindow_ == r2.slidingWindow_ && total_ == r2.total_);
+          getSlidingWindow() == r2.getSlidingWindow() && total_ == r2.total_);
 }
 
 bool MovingAverage::operator!=(const MovingAverage &r2) const {
   return !operator==(r2);
 }
 
-Real32 MovingAverage::getTotal() const { return total_; }
+Real32 MovingAverage::getTotal() const { return Real32(total_); }
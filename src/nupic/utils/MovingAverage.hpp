@@ -23,6 +23,7 @@
 #ifndef NUPIC_UTIL_MOVING_AVERAGE_HPP
 #define NUPIC_UTIL_MOVING_AVERAGE_HPP
 
+#include <iostream>
 #include <vector>
 
 #include <nupic/types/Types.hpp>
@@ -31,21 +32,48 @@ namespace nupic {
 
 namespace util {
 
+/**
+ * Mean and variance of the last wSize values of a stream.
+ *
+ * The window is a ring buffer and the statistics are updated as values
+ * enter and leave it, so compute() is O(1) whatever the window size. The
+ * variance uses Welford's updates, in double precision, which stay
+ * accurate when the values are large compared to their spread.
+ */
 class MovingAverage {
 public:
   MovingAverage(UInt wSize, const std::vector<Real32> &historicalValues);
   MovingAverage(UInt wSize);
+
+  /**
+   * The values in the window, oldest first.
+   */
   std::vector<Real32> getSlidingWindow() const;
   Real32 getCurrentAvg() const;
+
+  /**
+   * Population variance of the values in the window, 0 when it is empty.
+   */
+  Real64 getCurrentVariance() const;
   Real32 compute(Real32 newValue);
   Real32 getTotal() const;
+
+  void save(std::ostream &outStream) const;
+  void load(std::istream &inStream);
+
   bool operator==(const MovingAverage &r2) const;
   bool operator!=(const MovingAverage &r2) const;
 
 private:
+  void add_(Real32 value);
+  void replace_(Real32 oldValue, Real32 newValue);
+
   UInt32 windowSize_;
   std::vector<Real32> slidingWindow_;
-  Real32 total_;
+  UInt32 oldest_; // position of the oldest value once the window is full
+  Real64 total_;
+  Real64 mean_;
+  Real64 m2_; // sum of the squared deviations from mean_
 };
 } // namespace util
 } // namespace nupic
@@ -0,0 +1,145 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of ThreadPool
+ */
+
+#include <nupic/utils/Log.hpp>
+#include <nupic/utils/ThreadPool.hpp>
+
+using namespace std;
+using namespace nupic;
+using namespace nupic::util;
+
+ThreadPool::ThreadPool(UInt numThreads)
+    : fn_(nullptr), size_(0), generation_(0), numPending_(0),
+      stopping_(false) {
+  if (numThreads < 1) {
+    numThreads = 1;
+  }
+
+  for (UInt worker = 1; worker < numThreads; ++worker) {
+    workers_.emplace_back(&ThreadPool::workerLoop_, this, worker);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    lock_guard<mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  workReady_.notify_all();
+
+  for (thread &worker : workers_) {
+    worker.join();
+  }
+}
+
+UInt ThreadPool::getNumThreads() const { return workers_.size() + 1; }
+
+void ThreadPool::blockRange(UInt size, UInt numBlocks, UInt block, UInt &begin,
+                            UInt &end) {
+  NTA_ASSERT(block < numBlocks);
+
+  const UInt blockSize = size / numBlocks;
+  const UInt remainder = size % numBlocks;
+
+  // The first `remainder` blocks get one extra item.
+  begin = block * blockSize + min(block, remainder);
+  end = begin + blockSize + (block < remainder ? 1 : 0);
+}
+
+void ThreadPool::runBlock_(UInt block) {
+  UInt begin, end;
+  blockRange(size_, getNumThreads(), block, begin, end);
+  if (begin == end) {
+    return;
+  }
+
+  try {
+    (*fn_)(begin, end);
+  } catch (...) {
+    lock_guard<mutex> lock(mutex_);
+    if (!exception_) {
+      exception_ = current_exception();
+    }
+  }
+}
+
+void ThreadPool::run_(UInt size, const RangeFunction &fn) {
+  lock_guard<mutex> callLock(callMutex_);
+
+  {
+    lock_guard<mutex> lock(mutex_);
+    fn_ = &fn;
+    size_ = size;
+    numPending_ = workers_.size();
+    exception_ = nullptr;
+    ++generation_;
+  }
+  workReady_.notify_all();
+
+  runBlock_(0);
+
+  exception_ptr exception;
+  {
+    unique_lock<mutex> lock(mutex_);
+    workDone_.wait(lock, [this] { return numPending_ == 0; });
+    fn_ = nullptr;
+    exception = exception_;
+    exception_ = nullptr;
+  }
+
+  if (exception) {
+    rethrow_exception(exception);
+  }
+}
+
+void ThreadPool::workerLoop_(UInt worker) {
+  UInt64 seenGeneration = 0;
+
+  while (true) {
+    {
+      unique_lock<mutex> lock(mutex_);
+      workReady_.wait(lock, [&] {
+        return stopping_ || generation_ != seenGeneration;
+      });
+
+      if (stopping_) {
+        return;
+      }
+      seenGeneration = generation_;
+    }
+
+    runBlock_(worker);
+
+    bool done;
+    {
+      lock_guard<mutex> lock(mutex_);
+      done = (--numPending_ == 0);
+    }
+    if (done) {
+      workDone_.notify_one();
+    }
+  }
+}
@@ -0,0 +1,133 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definitions for the ThreadPool class
+ */
+
+#ifndef NUPIC_UTIL_THREAD_POOL_HPP
+#define NUPIC_UTIL_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+
+namespace util {
+
+/**
+ * A fixed set of worker threads for data-parallel loops.
+ *
+ * @b Description
+ * The algorithms use a ThreadPool to split a loop over columns, cells or
+ * streams into contiguous blocks that run concurrently. The calling thread
+ * runs the first block itself, so a pool with one thread starts no workers
+ * and runs everything inline.
+ *
+ * Blocks are assigned deterministically: for a given size and thread count,
+ * block i always covers the same range. Callers that write only to their own
+ * block's outputs therefore get results identical to a serial loop.
+ *
+ * Only one parallelFor runs at a time. Concurrent callers are serialized.
+ */
+class ThreadPool {
+public:
+  typedef std::function<void(UInt begin, UInt end)> RangeFunction;
+
+  /**
+   * ThreadPool constructor.
+   *
+   * @param numThreads Total number of threads, including the caller.
+   *                   Values below 1 are treated as 1.
+   */
+  ThreadPool(UInt numThreads = 1);
+
+  virtual ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * Gets the number of threads, including the calling thread.
+   */
+  UInt getNumThreads() const;
+
+  /**
+   * Splits [0, size) into one contiguous block per thread and calls
+   * `fn(begin, end)` on each block. Returns once every block is done.
+   *
+   * If a block throws, the first exception is rethrown here after all
+   * blocks have finished.
+   *
+   * With a single thread, `fn` is called directly, so the call does not
+   * allocate.
+   *
+   * @param size Number of items.
+   * @param fn   Function to call on each non-empty block.
+   */
+  template <typename F> void parallelFor(UInt size, F fn) {
+    if (workers_.empty()) {
+      if (size > 0) {
+        fn(0, size);
+      }
+      return;
+    }
+    run_(size, RangeFunction(fn));
+  }
+
+  /**
+   * Gets the range of block `block` when [0, size) is split into
+   * `numBlocks` contiguous blocks.
+   */
+  static void blockRange(UInt size, UInt numBlocks, UInt block, UInt &begin,
+                         UInt &end);
+
+private:
+  void run_(UInt size, const RangeFunction &fn);
+  void workerLoop_(UInt worker);
+  void runBlock_(UInt block);
+
+  std::vector<std::thread> workers_;
+
+  std::mutex callMutex_;
+  std::mutex mutex_;
+  std::condition_variable workReady_;
+  std::condition_variable workDone_;
+
+  const RangeFunction *fn_;
+  UInt size_;
+  UInt64 generation_;
+  UInt numPending_;
+  bool stopping_;
+  std::exception_ptr exception_;
+};
+
+} // namespace util
+} // namespace nupic
+
+#endif // NUPIC_UTIL_THREAD_POOL_HPP
@@ -0,0 +1,249 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Benchmarks of the core algorithms
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include <nupic/algorithms/Anomaly.hpp>
+#include <nupic/algorithms/Cells4.hpp>
+#include <nupic/algorithms/ClassifierResult.hpp>
+#include <nupic/algorithms/SDRClassifier.hpp>
+#include <nupic/algorithms/SpatialPooler.hpp>
+#include <nupic/algorithms/TemporalMemory.hpp>
+#include <nupic/utils/Random.hpp>
+
+#include "Benchmark.hpp"
+
+using namespace std;
+using namespace nupic;
+using namespace nupic::benchmark;
+using namespace nupic::algorithms::anomaly;
+using nupic::algorithms::ClassifierResult;
+using nupic::algorithms::Cells4::Cells4;
+using nupic::algorithms::sdr_classifier::SDRClassifier;
+using nupic::algorithms::spatial_pooler::SpatialPooler;
+using nupic::algorithms::temporal_memory::TemporalMemory;
+
+#define SEED 42
+
+// Inputs are cycled through, so learning sees repeating sequences
+static const UInt NUM_INPUTS = 100;
+
+static vector<vector<UInt>> randomSDRs(Random &rng, UInt n, UInt w) {
+  vector<vector<UInt>> sdrs(NUM_INPUTS);
+  vector<UInt> all(n);
+  for (UInt i = 0; i < n; i++) {
+    all[i] = i;
+  }
+  for (auto &sdr : sdrs) {
+    sdr.resize(w);
+    rng.sample(all.data(), n, sdr.data(), w);
+    std::sort(sdr.begin(), sdr.end());
+  }
+  return sdrs;
+}
+
+/**
+ * SpatialPooler::compute with learning, on sparse inputs.
+ * Args: input size, column count, input bits per thousand.
+ */
+static void SpatialPoolerCompute(State &state) {
+  const UInt numInputs = (UInt)state.range(0);
+  const UInt numColumns = (UInt)state.range(1);
+  Random rng(SEED);
+  const vector<vector<UInt>> inputs =
+      randomSDRs(rng, numInputs, numInputs * (UInt)state.range(2) / 1000);
+
+  SpatialPooler sp({numInputs}, {numColumns});
+  sp.setGlobalInhibition(true);
+  vector<UInt> active(numColumns);
+
+  UInt i = 0;
+  while (state.keepRunning()) {
+    const vector<UInt> &input = inputs[i++ % NUM_INPUTS];
+    sp.compute(input.size(), input.data(), true, active.data());
+  }
+  state.setItemsProcessed(state.iterations());
+}
+NTA_BENCHMARK(SpatialPoolerCompute)
+    ->args({1024, 2048, 20})
+    ->args({1024, 2048, 100})
+    ->args({4096, 2048, 20})
+    ->args({16384, 4096, 20});
+
+/**
+ * TemporalMemory::compute with learning.
+ * Args: column count, cells per column.
+ */
+static void TemporalMemoryCompute(State &state) {
+  const UInt numColumns = (UInt)state.range(0);
+  Random rng(SEED);
+  const vector<vector<UInt>> inputs = randomSDRs(rng, numColumns, 40);
+
+  TemporalMemory tm({numColumns}, (UInt)state.range(1));
+
+  UInt i = 0;
+  while (state.keepRunning()) {
+    const vector<UInt> &input = inputs[i++ % NUM_INPUTS];
+    tm.compute(input.size(), input.data(), true);
+  }
+  state.setItemsProcessed(state.iterations());
+}
+NTA_BENCHMARK(TemporalMemoryCompute)->args({2048, 32})->args({16384, 8});
+
+/**
+ * Cells4::compute with inference and learning.
+ * Args: column count, cells per column.
+ */
+static void Cells4Compute(State &state) {
+  const UInt numColumns = (UInt)state.range(0);
+  const UInt cellsPerColumn = (UInt)state.range(1);
+  Random rng(SEED);
+  vector<vector<Real>> inputs(NUM_INPUTS, vector<Real>(numColumns, 0));
+  const vector<vector<UInt>> sdrs = randomSDRs(rng, numColumns, 40);
+  for (UInt i = 0; i < NUM_INPUTS; i++) {
+    for (UInt column : sdrs[i]) {
+      inputs[i][column] = 1;
+    }
+  }
+
+  Cells4 cells(numColumns, cellsPerColumn, 12, 9, 20, 1, 0.21, 0.5, 1.0, 0.1,
+               0.1, 0.0, false, SEED, true, false);
+  vector<Real> output(numColumns * cellsPerColumn);
+
+  UInt i = 0;
+  while (state.keepRunning()) {
+    cells.compute(inputs[i++ % NUM_INPUTS].data(), output.data(), true, true);
+  }
+  state.setItemsProcessed(state.iterations());
+}
+NTA_BENCHMARK(Cells4Compute)->args({2048, 32});
+
+/**
+ * SDRClassifier::compute with learning and inference on 1 and 5 steps.
+ * Args: pattern size, bucket count, 1 for Real32 weights.
+ */
+static void SDRClassifierCompute(State &state) {
+  const UInt patternSize = (UInt)state.range(0);
+  const UInt numBuckets = (UInt)state.range(1);
+  Random rng(SEED);
+  const vector<vector<UInt>> patterns = randomSDRs(rng, patternSize, 40);
+
+  SDRClassifier classifier({1, 5}, 0.1, 0.3, 0, state.range(2) != 0);
+
+  UInt i = 0;
+  while (state.keepRunning()) {
+    // A result can't be reused
+    ClassifierResult result;
+    const UInt bucket = i % numBuckets;
+    classifier.compute(i, patterns[i % NUM_INPUTS], {bucket},
+                       {(Real64)bucket}, false, true, true, &result);
+    i++;
+  }
+  state.setItemsProcessed(state.iterations());
+}
+NTA_BENCHMARK(SDRClassifierCompute)
+    ->args({2048, 100, 0})
+    ->args({2048, 100, 1})
+    ->args({16384, 1000, 0});
+
+static vector<UInt64> toBits(const vector<UInt> &sdr, UInt n) {
+  vector<UInt64> bits((n + 63) / 64, 0);
+  for (UInt column : sdr) {
+    bits[column / 64] |= 1ULL << (column % 64);
+  }
+  return bits;
+}
+
+/**
+ * Raw anomaly score of 40 active columns against 40 predicted ones.
+ * Args: column count; 0 for unsorted vectors, which go through std::set as
+ * every call used to, 1 for sorted vectors, 2 for bitmasks.
+ */
+static void RawAnomalyScore(State &state) {
+  const UInt numColumns = (UInt)state.range(0);
+  Random rng(SEED);
+  vector<vector<UInt>> sdrs = randomSDRs(rng, numColumns, 40);
+  if (state.range(1) == 0) {
+    for (auto &sdr : sdrs) {
+      std::reverse(sdr.begin(), sdr.end());
+    }
+  }
+  vector<vector<UInt64>> bits;
+  for (const auto &sdr : sdrs) {
+    bits.push_back(toBits(sdr, numColumns));
+  }
+  const UInt numWords = (UInt)bits[0].size();
+
+  UInt i = 0;
+  while (state.keepRunning()) {
+    const UInt active = i % NUM_INPUTS;
+    const UInt predicted = (i + 1) % NUM_INPUTS;
+    if (state.range(1) == 2) {
+      computeRawAnomalyScoreDense(bits[active].data(), bits[predicted].data(),
+                                  numWords);
+    } else {
+      computeRawAnomalyScore(sdrs[active], sdrs[predicted]);
+    }
+    i++;
+  }
+  state.setItemsProcessed(state.iterations());
+}
+NTA_BENCHMARK(RawAnomalyScore)
+    ->args({2048, 0})
+    ->args({2048, 1})
+    ->args({2048, 2});
+
+/**
+ * Raw anomaly scores of many streams in one call, on sorted indices.
+ * Args: stream count, column count.
+ */
+static void RawAnomalyScoreBatch(State &state) {
+  const UInt numStreams = (UInt)state.range(0);
+  const UInt numColumns = (UInt)state.range(1);
+  Random rng(SEED);
+  const vector<vector<UInt>> sdrs = randomSDRs(rng, numColumns, 40);
+
+  vector<UInt> active, predicted;
+  vector<UInt> activeOffsets = {0}, predictedOffsets = {0};
+  for (UInt s = 0; s < numStreams; s++) {
+    const vector<UInt> &a = sdrs[s % NUM_INPUTS];
+    const vector<UInt> &p = sdrs[(s + 1) % NUM_INPUTS];
+    active.insert(active.end(), a.begin(), a.end());
+    predicted.insert(predicted.end(), p.begin(), p.end());
+    activeOffsets.push_back((UInt)active.size());
+    predictedOffsets.push_back((UInt)predicted.size());
+  }
+  vector<Real32> scores(numStreams);
+
+  while (state.keepRunning()) {
+    computeRawAnomalyScores(numStreams, active.data(), activeOffsets.data(),
+                            predicted.data(), predictedOffsets.data(),
+                            scores.data());
+  }
+  state.setItemsProcessed(state.iterations() * numStreams);
+}
+NTA_BENCHMARK(RawAnomalyScoreBatch)->args({1000, 2048})->args({10000, 2048});
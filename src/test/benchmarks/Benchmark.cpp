@@ -0,0 +1,402 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of the nupic_benchmarks harness
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <thread>
+
+#include <nupic/os/Regex.hpp>
+#include <nupic/utils/Log.hpp>
+
+#include "Benchmark.hpp"
+
+using namespace std;
+
+// Count every allocation of the process. The deletes are replaced too so
+// they match the replaced news.
+
+static std::atomic<nupic::UInt64> allocationCount(0);
+
+void *operator new(size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  void *p = ::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new[](size_t size) { return ::operator new(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return ::malloc(size == 0 ? 1 : size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &tag) noexcept {
+  return ::operator new(size, tag);
+}
+
+void operator delete(void *p) noexcept { ::free(p); }
+
+void operator delete[](void *p) noexcept { ::free(p); }
+
+void operator delete(void *p, const std::nothrow_t &) noexcept { ::free(p); }
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  ::free(p);
+}
+
+namespace nupic {
+namespace benchmark {
+
+UInt64 getAllocationCount() {
+  return allocationCount.load(std::memory_order_relaxed);
+}
+
+State::State(UInt64 maxIterations, const std::vector<Int64> &args)
+    : maxIterations_(maxIterations), iterations_(0), args_(args),
+      running_(false), cpuStart_(0), allocationsStart_(0), realSeconds_(0),
+      cpuSeconds_(0), allocations_(0), itemsProcessed_(0) {}
+
+void State::start_() {
+  NTA_CHECK(!running_);
+  running_ = true;
+  allocationsStart_ = getAllocationCount();
+  cpuStart_ = std::clock();
+  realStart_ = std::chrono::steady_clock::now();
+}
+
+void State::stop_() {
+  NTA_CHECK(running_);
+  const auto realEnd = std::chrono::steady_clock::now();
+  const std::clock_t cpuEnd = std::clock();
+  realSeconds_ +=
+      std::chrono::duration<Real64>(realEnd - realStart_).count();
+  cpuSeconds_ += (Real64)(cpuEnd - cpuStart_) / CLOCKS_PER_SEC;
+  allocations_ += getAllocationCount() - allocationsStart_;
+  running_ = false;
+}
+
+void State::pauseTiming() { stop_(); }
+
+void State::resumeTiming() { start_(); }
+
+Int64 State::range(size_t i) const {
+  NTA_CHECK(i < args_.size())
+      << "Benchmark argument " << i << " is out of range (" << args_.size()
+      << " arguments)";
+  return args_[i];
+}
+
+Benchmark::Benchmark(std::string name, Function function)
+    : name_(std::move(name)), function_(function) {}
+
+Benchmark *Benchmark::args(const std::vector<Int64> &args) {
+  args_.push_back(args);
+  return this;
+}
+
+static std::vector<Benchmark *> &benchmarks() {
+  static std::vector<Benchmark *> benchmarks;
+  return benchmarks;
+}
+
+Benchmark *registerBenchmark(const std::string &name, Function function) {
+  auto benchmark = new Benchmark(name, function);
+  benchmarks().push_back(benchmark);
+  return benchmark;
+}
+
+namespace {
+
+// One repetition, or an aggregate of the repetitions of a run
+struct Result {
+  std::string name;
+  std::string aggregate;
+  UInt64 iterations;
+  Real64 realNanos;
+  Real64 cpuNanos;
+  Real64 allocations;
+  Real64 itemsPerSecond;
+  std::string error; // why the run was skipped, if it was
+};
+
+struct Options {
+  Options()
+      : filter(".*"), minTime(0.5), repetitions(1), out("") {}
+
+  std::string filter;
+  Real64 minTime;
+  UInt32 repetitions;
+  std::string out;
+};
+
+Options parseOptions(int argc, char *argv[]) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const size_t eq = arg.find('=');
+    const std::string flag = arg.substr(0, eq);
+    const std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+    if (flag == "--benchmark_filter") {
+      options.filter = value;
+    } else if (flag == "--benchmark_min_time") {
+      options.minTime = std::atof(value.c_str());
+    } else if (flag == "--benchmark_repetitions") {
+      options.repetitions = std::max(1, std::atoi(value.c_str()));
+    } else if (flag == "--benchmark_out") {
+      options.out = value;
+    } else {
+      NTA_THROW << "Unknown argument '" << arg << "'";
+    }
+  }
+  return options;
+}
+
+Result toResult(const std::string &name, const State &state) {
+  Result result;
+  result.name = name;
+  result.iterations = state.iterations();
+  result.realNanos = state.realSeconds() * 1e9 / state.iterations();
+  result.cpuNanos = state.cpuSeconds() * 1e9 / state.iterations();
+  result.allocations = (Real64)state.allocations() / state.iterations();
+  result.itemsPerSecond = state.realSeconds() > 0
+                              ? state.itemsProcessed() / state.realSeconds()
+                              : 0;
+  return result;
+}
+
+// Run with more and more iterations until the loop takes minTime
+Result runCalibrated(const std::string &name, const Benchmark &benchmark,
+                     const std::vector<Int64> &args, Real64 minTime,
+                     UInt64 &iterations) {
+  const UInt64 maxIterations = 1000000000;
+  iterations = 1;
+  while (true) {
+    State state(iterations, args);
+    benchmark.getFunction()(state);
+    if (!state.getError().empty()) {
+      Result result;
+      result.name = name;
+      result.error = state.getError();
+      return result;
+    }
+    NTA_CHECK(state.iterations() == iterations)
+        << "Benchmark " << name << " stopped before keepRunning() did";
+    if (state.realSeconds() >= minTime || iterations >= maxIterations) {
+      return toResult(name, state);
+    }
+
+    // Aim 40% past minTime, growing at most 10 times per step
+    Real64 multiplier = 10;
+    if (state.realSeconds() > 0) {
+      multiplier = std::min(10.0, minTime * 1.4 / state.realSeconds());
+    }
+    iterations = std::min(
+        maxIterations,
+        std::max(iterations + 1, (UInt64)(iterations * multiplier)));
+  }
+}
+
+Result aggregate(const std::vector<Result> &results, const std::string &kind) {
+  Result result = results.front();
+  result.aggregate = kind;
+  result.name += "_" + kind;
+  const Real64 n = (Real64)results.size();
+
+  auto statistic = [&](Real64 Result::*field) {
+    std::vector<Real64> values;
+    for (const Result &r : results) {
+      values.push_back(r.*field);
+    }
+    Real64 mean = 0;
+    for (Real64 v : values) {
+      mean += v / n;
+    }
+    if (kind == "mean") {
+      return mean;
+    }
+    if (kind == "median") {
+      std::sort(values.begin(), values.end());
+      const size_t mid = values.size() / 2;
+      return values.size() % 2 ? values[mid]
+                               : (values[mid - 1] + values[mid]) / 2;
+    }
+    Real64 sumSquares = 0;
+    for (Real64 v : values) {
+      sumSquares += (v - mean) * (v - mean);
+    }
+    return n > 1 ? std::sqrt(sumSquares / (n - 1)) : 0.0;
+  };
+
+  result.realNanos = statistic(&Result::realNanos);
+  result.cpuNanos = statistic(&Result::cpuNanos);
+  result.allocations = statistic(&Result::allocations);
+  result.itemsPerSecond = statistic(&Result::itemsPerSecond);
+  return result;
+}
+
+void printResult(const Result &result) {
+  std::cout << std::left << std::setw(56) << result.name << std::right
+            << std::fixed << std::setprecision(0) << std::setw(14)
+            << result.realNanos << " ns" << std::setw(14) << result.cpuNanos
+            << " ns" << std::setw(11) << result.iterations
+            << std::setprecision(2) << std::setw(12) << result.allocations
+            << " allocs";
+  if (result.itemsPerSecond > 0) {
+    std::cout << std::setprecision(0) << std::setw(14)
+              << result.itemsPerSecond << " items/s";
+  }
+  std::cout << std::endl;
+}
+
+std::string jsonString(const std::string &s) {
+  std::string quoted = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+void writeJson(const std::string &path, const std::vector<Result> &results) {
+  std::ofstream out(path.c_str());
+  NTA_CHECK(out.good()) << "Unable to open " << path;
+
+  char date[32];
+  const std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S",
+                std::localtime(&now));
+
+  out << std::setprecision(17);
+  out << "{\n  \"context\": {\n";
+  out << "    \"date\": " << jsonString(date) << ",\n";
+  out << "    \"executable\": \"nupic_benchmarks\",\n";
+  out << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+#ifdef NTA_ASSERTIONS_ON
+  out << "    \"library_build_type\": \"debug\"\n";
+#else
+  out << "    \"library_build_type\": \"release\"\n";
+#endif
+  out << "  },\n  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result &r = results[i];
+    out << (i ? "," : "") << "\n    {\n";
+    out << "      \"name\": " << jsonString(r.name) << ",\n";
+    if (r.aggregate.empty()) {
+      out << "      \"run_type\": \"iteration\",\n";
+    } else {
+      out << "      \"run_type\": \"aggregate\",\n";
+      out << "      \"aggregate_name\": " << jsonString(r.aggregate) << ",\n";
+    }
+    out << "      \"iterations\": " << r.iterations << ",\n";
+    out << "      \"real_time\": " << r.realNanos << ",\n";
+    out << "      \"cpu_time\": " << r.cpuNanos << ",\n";
+    out << "      \"time_unit\": \"ns\",\n";
+    out << "      \"allocs_per_iteration\": " << r.allocations << ",\n";
+    out << "      \"items_per_second\": " << r.itemsPerSecond << "\n";
+    out << "    }";
+  }
+  out << "\n  ]\n}\n";
+}
+
+} // namespace
+
+int runBenchmarks(int argc, char *argv[]) {
+  const Options options = parseOptions(argc, argv);
+
+  std::vector<Result> results;
+  for (const Benchmark *benchmark : benchmarks()) {
+    std::vector<std::vector<Int64>> argLists = benchmark->getArgs();
+    if (argLists.empty()) {
+      argLists.emplace_back();
+    }
+
+    for (const std::vector<Int64> &args : argLists) {
+      std::stringstream name;
+      name << benchmark->getName();
+      for (Int64 arg : args) {
+        name << "/" << arg;
+      }
+      if (!regex::match(".*(" + options.filter + ").*", name.str())) {
+        continue;
+      }
+
+      UInt64 iterations;
+      std::vector<Result> repetitions;
+      repetitions.push_back(runCalibrated(name.str(), *benchmark, args,
+                                          options.minTime, iterations));
+      if (!repetitions.back().error.empty()) {
+        std::cout << std::left << std::setw(56) << name.str()
+                  << " skipped: " << repetitions.back().error << std::endl;
+        continue;
+      }
+      printResult(repetitions.back());
+      while (repetitions.size() < options.repetitions) {
+        State state(iterations, args);
+        benchmark->getFunction()(state);
+        repetitions.push_back(toResult(name.str(), state));
+        printResult(repetitions.back());
+      }
+      results.insert(results.end(), repetitions.begin(), repetitions.end());
+
+      if (repetitions.size() > 1) {
+        for (const char *kind : {"mean", "median", "stddev"}) {
+          results.push_back(aggregate(repetitions, kind));
+          printResult(results.back());
+        }
+      }
+    }
+  }
+
+  if (!options.out.empty()) {
+    writeJson(options.out, results);
+  }
+  return 0;
+}
+
+} // namespace benchmark
+} // namespace nupic
+
+int main(int argc, char *argv[]) {
+  try {
+    return nupic::benchmark::runBenchmarks(argc, argv);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+}
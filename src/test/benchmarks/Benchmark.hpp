@@ -0,0 +1,174 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definitions for the nupic_benchmarks harness
+ */
+
+#ifndef NTA_BENCHMARK_HPP
+#define NTA_BENCHMARK_HPP
+
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+namespace benchmark {
+
+/**
+ * Controls the timed loop of one benchmark run.
+ *
+ * A benchmark function does its setup, then runs the code under test while
+ * keepRunning() returns true. Only the loop is timed, and allocations are
+ * counted over the same span.
+ *
+ *   static void SomeBenchmark(State &state) {
+ *     Thing thing(state.range(0));
+ *     while (state.keepRunning()) {
+ *       thing.compute();
+ *     }
+ *     state.setItemsProcessed(state.iterations() * state.range(0));
+ *   }
+ *   NTA_BENCHMARK(SomeBenchmark)->args({1024})->args({4096});
+ */
+class State {
+public:
+  State(UInt64 maxIterations, const std::vector<Int64> &args);
+
+  bool keepRunning() {
+    if (iterations_ == 0) {
+      start_();
+    }
+    if (iterations_ < maxIterations_) {
+      iterations_++;
+      return true;
+    }
+    stop_();
+    return false;
+  }
+
+  /**
+   * Exclude per-iteration setup from the timings and allocation counts.
+   */
+  void pauseTiming();
+  void resumeTiming();
+
+  Int64 range(size_t i) const;
+  UInt64 iterations() const { return iterations_; }
+
+  /**
+   * Report throughput, e.g. records or synapses, as items per second.
+   */
+  void setItemsProcessed(UInt64 items) { itemsProcessed_ = items; }
+
+  /**
+   * Give up on this run, e.g. when something it needs is not installed.
+   * The benchmark function must then return without calling keepRunning().
+   */
+  void skipWithError(const std::string &message) { error_ = message; }
+  const std::string &getError() const { return error_; }
+
+  Real64 realSeconds() const { return realSeconds_; }
+  Real64 cpuSeconds() const { return cpuSeconds_; }
+  UInt64 allocations() const { return allocations_; }
+  UInt64 itemsProcessed() const { return itemsProcessed_; }
+
+private:
+  void start_();
+  void stop_();
+
+  UInt64 maxIterations_;
+  UInt64 iterations_;
+  std::vector<Int64> args_;
+
+  bool running_;
+  std::chrono::steady_clock::time_point realStart_;
+  std::clock_t cpuStart_;
+  UInt64 allocationsStart_;
+
+  Real64 realSeconds_;
+  Real64 cpuSeconds_;
+  UInt64 allocations_;
+  UInt64 itemsProcessed_;
+  std::string error_;
+};
+
+typedef void (*Function)(State &state);
+
+/**
+ * A registered benchmark function and the argument lists to run it with.
+ */
+class Benchmark {
+public:
+  Benchmark(std::string name, Function function);
+
+  /**
+   * Add a run with these arguments, available as State::range(i). The run
+   * is named after the function and the arguments, e.g. "SpatialPooler/1024".
+   */
+  Benchmark *args(const std::vector<Int64> &args);
+
+  const std::string &getName() const { return name_; }
+  Function getFunction() const { return function_; }
+  const std::vector<std::vector<Int64>> &getArgs() const { return args_; }
+
+private:
+  std::string name_;
+  Function function_;
+  std::vector<std::vector<Int64>> args_;
+};
+
+Benchmark *registerBenchmark(const std::string &name, Function function);
+
+/**
+ * Number of allocations made with operator new so far, by any thread.
+ */
+UInt64 getAllocationCount();
+
+/**
+ * Run the registered benchmarks selected by the command line. Flags:
+ *
+ *   --benchmark_filter=<regex>     run the benchmarks whose name matches
+ *   --benchmark_min_time=<s>       minimum timed seconds per repetition
+ *   --benchmark_repetitions=<n>    repetitions, summarized by mean, median
+ *                                  and stddev
+ *   --benchmark_out=<file>         also write the results as JSON
+ *
+ * @returns The process exit code
+ */
+int runBenchmarks(int argc, char *argv[]);
+
+} // namespace benchmark
+} // namespace nupic
+
+#define NTA_BENCHMARK_CONCAT_(a, b) a##b
+#define NTA_BENCHMARK_CONCAT(a, b) NTA_BENCHMARK_CONCAT_(a, b)
+
+#define NTA_BENCHMARK(function)                                                \
+  static ::nupic::benchmark::Benchmark *NTA_BENCHMARK_CONCAT(                 \
+      benchmark_, __LINE__) =                                                  \
+      ::nupic::benchmark::registerBenchmark(#function, function)
+
+#endif // NTA_BENCHMARK_HPP
@@ -0,0 +1,164 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Benchmarks of the network engine
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <nupic/engine/Link.hpp>
+#include <nupic/engine/Network.hpp>
+#include <nupic/engine/Region.hpp>
+#include <nupic/ntypes/Dimensions.hpp>
+#include <nupic/utils/Random.hpp>
+
+#include "Benchmark.hpp"
+
+using namespace std;
+using namespace nupic;
+using namespace nupic::benchmark;
+
+#define SEED 42
+
+static Region *addSensor(Network &net, const string &name, UInt width) {
+  stringstream params;
+  params << "{activeOutputCount: " << width << "}";
+  Region *region = net.addRegion(name, "VectorFileSensor", params.str());
+  Dimensions dims(1);
+  region->setDimensions(dims);
+  return region;
+}
+
+/**
+ * Link::compute of the links into one input.
+ * Args: source width, link count. A single link shares the source buffer,
+ * more links copy.
+ */
+static void LinkCompute(State &state) {
+  const UInt width = (UInt)state.range(0);
+  const UInt numLinks = (UInt)state.range(1);
+
+  Network net;
+  net.addRegion("effector", "VectorFileEffector", "");
+  for (UInt i = 0; i < numLinks; i++) {
+    const string name = "sensor" + to_string(i);
+    addSensor(net, name, width);
+    net.link(name, "effector", "UniformLink", "", "dataOut", "dataIn");
+  }
+  net.initialize();
+
+  vector<Link *> links;
+  for (size_t i = 0; i < net.getLinks().getCount(); i++) {
+    links.push_back(net.getLinks().getByIndex(i).second);
+  }
+
+  while (state.keepRunning()) {
+    for (Link *link : links) {
+      link->compute();
+    }
+  }
+  state.setItemsProcessed(state.iterations() * numLinks * width);
+}
+NTA_BENCHMARK(LinkCompute)
+    ->args({2048, 1})
+    ->args({2048, 2})
+    ->args({65536, 2});
+
+/**
+ * Network::run of the HelloRegions example: a VectorFileSensor cycling
+ * through a text file.
+ * Args: vector width, vector count.
+ */
+static void NetworkRunHelloRegions(State &state) {
+  const UInt width = (UInt)state.range(0);
+  const UInt numVectors = (UInt)state.range(1);
+  const string path = "NetworkRunHelloRegions.txt";
+
+  Random rng(SEED);
+  {
+    ofstream f(path.c_str());
+    for (UInt i = 0; i < numVectors; i++) {
+      for (UInt j = 0; j < width; j++) {
+        f << (j ? " " : "") << rng.getReal64();
+      }
+      f << "\n";
+    }
+  }
+
+  Network net;
+  Region *region = addSensor(net, "region", width);
+  region->executeCommand({"loadFile", path, "2"});
+  net.initialize();
+
+  while (state.keepRunning()) {
+    net.run(1);
+  }
+  state.setItemsProcessed(state.iterations());
+
+  ::remove(path.c_str());
+}
+NTA_BENCHMARK(NetworkRunHelloRegions)->args({1, 10})->args({2048, 100});
+
+/**
+ * Region::compute of a Python region whose compute() does nothing, fed by a
+ * sensor. Measures what PyRegion adds around the Python call.
+ * Args: input width. Skipped unless the nupic Python package is installed.
+ */
+static void PyRegionCompute(State &state) {
+  const UInt width = (UInt)state.range(0);
+  const string path = "PyRegionCompute.txt";
+  {
+    ofstream f(path.c_str());
+    for (UInt j = 0; j < width; j++) {
+      f << (j ? " " : "") << j % 2;
+    }
+    f << "\n";
+  }
+
+  Network net;
+  Region *sensor = addSensor(net, "sensor", width);
+  sensor->executeCommand({"loadFile", path, "2"});
+  Region *region;
+  try {
+    region = net.addRegion("region", "py.TestNode", "");
+  } catch (const exception &e) {
+    ::remove(path.c_str());
+    state.skipWithError(e.what());
+    return;
+  }
+  net.link("sensor", "region", "UniformLink", "", "dataOut", "bottomUpIn");
+  net.initialize();
+  net.run(1);
+
+  while (state.keepRunning()) {
+    region->compute();
+  }
+  state.setItemsProcessed(state.iterations());
+
+  ::remove(path.c_str());
+}
+NTA_BENCHMARK(PyRegionCompute)->args({2048});
@@ -0,0 +1,200 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Benchmarks of the SparseMatrix kernels
+ */
+
+#include <vector>
+
+#include <nupic/math/SparseMatrix.hpp>
+#include <nupic/utils/Random.hpp>
+
+#include "Benchmark.hpp"
+
+using namespace std;
+using namespace nupic;
+using namespace nupic::benchmark;
+
+#define SEED 42
+
+// The matrix type of the SpatialPooler permanences
+typedef SparseMatrix<UInt, Real, Int, Real64> Matrix;
+
+/**
+ * Fill m from the args: row count, column count, non-zeros per thousand.
+ */
+static void randomMatrix(State &state, Matrix &m, vector<Real> &x,
+                         vector<UInt> &xOnes) {
+  const UInt nrows = (UInt)state.range(0);
+  const UInt ncols = (UInt)state.range(1);
+  const Real64 density = state.range(2) / 1000.0;
+  Random rng(SEED);
+
+  m.resize(nrows, ncols);
+  for (UInt row = 0; row < nrows; row++) {
+    for (UInt col = 0; col < ncols; col++) {
+      if (rng.getReal64() < density) {
+        m.setNonZero(row, col, (Real)rng.getReal64());
+      }
+    }
+  }
+
+  // A binary input vector with 2% active bits, as the SpatialPooler sees
+  x.assign(ncols, 0);
+  xOnes.clear();
+  for (UInt col = 0; col < ncols; col++) {
+    if (rng.getReal64() < 0.02) {
+      x[col] = 1;
+      xOnes.push_back(col);
+    }
+  }
+}
+
+static void SparseMatrixRightVecSumAtNZ(State &state) {
+  Matrix m;
+  vector<Real> x, y(state.range(0));
+  vector<UInt> xOnes;
+  randomMatrix(state, m, x, xOnes);
+
+  while (state.keepRunning()) {
+    m.rightVecSumAtNZ(x.begin(), y.begin());
+  }
+  state.setItemsProcessed(state.iterations() * m.nNonZeros());
+}
+NTA_BENCHMARK(SparseMatrixRightVecSumAtNZ)
+    ->args({2048, 1024, 500})
+    ->args({2048, 16384, 20});
+
+static void SparseMatrixRightVecSumAtNZSparse(State &state) {
+  Matrix m;
+  vector<Real> x, y(state.range(0));
+  vector<UInt> xOnes;
+  randomMatrix(state, m, x, xOnes);
+
+  while (state.keepRunning()) {
+    m.rightVecSumAtNZSparse(xOnes.begin(), xOnes.end(), y.begin());
+  }
+  state.setItemsProcessed(state.iterations() * m.nNonZeros());
+}
+NTA_BENCHMARK(SparseMatrixRightVecSumAtNZSparse)
+    ->args({2048, 1024, 500})
+    ->args({2048, 16384, 20});
+
+static void SparseMatrixRightVecSumAtNZGtThreshold(State &state) {
+  Matrix m;
+  vector<Real> x, y(state.range(0));
+  vector<UInt> xOnes;
+  randomMatrix(state, m, x, xOnes);
+
+  while (state.keepRunning()) {
+    m.rightVecSumAtNZGtThreshold(x.begin(), y.begin(), (Real)0.5);
+  }
+  state.setItemsProcessed(state.iterations() * m.nNonZeros());
+}
+NTA_BENCHMARK(SparseMatrixRightVecSumAtNZGtThreshold)
+    ->args({2048, 1024, 500})
+    ->args({2048, 16384, 20});
+
+static void SparseMatrixRightVecProd(State &state) {
+  Matrix m;
+  vector<Real> x, y(state.range(0));
+  vector<UInt> xOnes;
+  randomMatrix(state, m, x, xOnes);
+
+  while (state.keepRunning()) {
+    m.rightVecProd(x.begin(), y.begin());
+  }
+  state.setItemsProcessed(state.iterations() * m.nNonZeros());
+}
+NTA_BENCHMARK(SparseMatrixRightVecProd)
+    ->args({2048, 1024, 500})
+    ->args({2048, 16384, 20});
+
+static void SparseMatrixThreshold(State &state) {
+  Matrix m, work;
+  vector<Real> x;
+  vector<UInt> xOnes;
+  randomMatrix(state, m, x, xOnes);
+
+  while (state.keepRunning()) {
+    state.pauseTiming();
+    work = m;
+    state.resumeTiming();
+    work.threshold((Real)0.5);
+  }
+  state.setItemsProcessed(state.iterations() * m.nNonZeros());
+}
+NTA_BENCHMARK(SparseMatrixThreshold)
+    ->args({2048, 1024, 500})
+    ->args({2048, 16384, 20});
+
+static void SparseMatrixGetRowToDense(State &state) {
+  Matrix m;
+  vector<Real> x, dense(state.range(1));
+  vector<UInt> xOnes;
+  randomMatrix(state, m, x, xOnes);
+
+  while (state.keepRunning()) {
+    for (UInt row = 0; row < m.nRows(); row++) {
+      m.getRowToDense(row, dense.begin());
+    }
+  }
+  state.setItemsProcessed(state.iterations() * m.nRows() * m.nCols());
+}
+NTA_BENCHMARK(SparseMatrixGetRowToDense)
+    ->args({2048, 1024, 500})
+    ->args({2048, 16384, 20});
+
+static void SparseMatrixAxby(State &state) {
+  Matrix m;
+  vector<Real> x;
+  vector<UInt> xOnes;
+  randomMatrix(state, m, x, xOnes);
+
+  while (state.keepRunning()) {
+    for (UInt row = 0; row < m.nRows(); row++) {
+      m.axby(row, (Real)0.9, (Real)0.1, x.begin());
+    }
+  }
+  state.setItemsProcessed(state.iterations() * m.nRows() * m.nCols());
+}
+NTA_BENCHMARK(SparseMatrixAxby)
+    ->args({2048, 1024, 500})
+    ->args({2048, 16384, 20});
+
+static void SparseMatrixElementRowApply(State &state) {
+  Matrix m;
+  vector<Real> x;
+  vector<UInt> xOnes;
+  randomMatrix(state, m, x, xOnes);
+
+  while (state.keepRunning()) {
+    for (UInt row = 0; row < m.nRows(); row++) {
+      m.elementRowApply(row, std::plus<Real>(), x.begin());
+    }
+  }
+  state.setItemsProcessed(state.iterations() * m.nRows() * m.nCols());
+}
+NTA_BENCHMARK(SparseMatrixElementRowApply)
+    ->args({2048, 1024, 500})
+    ->args({2048, 16384, 20});
@@ -0,0 +1,199 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of performance tests for Cells4
+ */
+
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <time.h>
+
+#include <nupic/algorithms/Cells4.hpp>
+#include <nupic/utils/Log.hpp>
+
+#include "Cells4PerformanceTest.hpp"
+
+using namespace std;
+using namespace nupic;
+using namespace nupic::algorithms::Cells4;
+
+#define SEED 42
+
+namespace nupic {
+
+void Cells4PerformanceTest::RunTests() {
+  srand(SEED);
+
+  testSequenceLearning();
+  testLargeSequenceLearning();
+  testStateScan();
+}
+
+/**
+ * Tests typical backtracking TM usage: learn a few sequences, then infer.
+ */
+void Cells4PerformanceTest::testSequenceLearning() {
+  runSequenceTest(2048, 32, 40, 5, 20, 5, "cells4");
+}
+
+/**
+ * Tests a backtracking TM with many more learned segments.
+ */
+void Cells4PerformanceTest::testLargeSequenceLearning() {
+  runSequenceTest(2048, 32, 40, 10, 30, 6, "cells4 (large)");
+}
+
+/**
+ * Compares enumerating the On cells of a CState through a mask of the nonzero
+ * bytes against testing the bytes of each nonzero word in turn.
+ */
+void Cells4PerformanceTest::testStateScan() {
+  runStateScanTest(65536, 0.02, 5000);
+  runStateScanTest(65536, 0.2, 5000);
+}
+
+void Cells4PerformanceTest::runSequenceTest(UInt numColumns,
+                                            UInt cellsPerColumn, UInt w,
+                                            UInt numSequences,
+                                            UInt numElements, UInt numPasses,
+                                            string label) {
+  clock_t timer = clock();
+
+  // Initialize
+
+  Cells4 cells(numColumns, cellsPerColumn, 12, 9, 20, 1, 0.21, 0.5, 1.0, 0.1,
+               0.1, 0.0, false, SEED, true, false);
+  vector<Real> output(numColumns * cellsPerColumn);
+
+  vector<vector<vector<Real>>> sequences(numSequences);
+  for (auto &sequence : sequences) {
+    for (UInt i = 0; i < numElements; i++) {
+      sequence.push_back(randomInput(numColumns, w));
+    }
+  }
+
+  checkpoint(timer, label + ": initialize");
+
+  // Learn
+
+  for (UInt pass = 0; pass < numPasses; pass++) {
+    for (auto &sequence : sequences) {
+      for (auto &input : sequence) {
+        cells.compute(input.data(), output.data(), true, true);
+      }
+      cells.reset();
+    }
+  }
+
+  checkpoint(timer, label + ": initialize + learn");
+
+  // Test
+
+  for (auto &sequence : sequences) {
+    for (auto &input : sequence) {
+      cells.compute(input.data(), output.data(), true, false);
+    }
+    cells.reset();
+  }
+
+  checkpoint(timer, label + ": initialize + learn + test");
+
+  // Save and load
+
+  timer = clock();
+
+  stringstream ss;
+  cells.save(ss);
+  Cells4 loaded;
+  loaded.load(ss);
+
+  checkpoint(timer, label + ": save + load");
+
+  cout << "  " << cells.nSegments() << " segments, " << cells.nSynapses()
+       << " synapses" << endl;
+}
+
+void Cells4PerformanceTest::runStateScanTest(UInt numCells, Real density,
+                                             UInt numIterations) {
+  NTA_CHECK(numCells % 8 == 0);
+
+  CState state;
+  state.initialize(numCells);
+  for (UInt i = 0; i < numCells; i++) {
+    if ((Real)rand() / RAND_MAX < density) {
+      state.set(i);
+    }
+  }
+
+  stringstream label;
+  label << "state scan (" << numCells << " cells, density " << density << ", "
+        << numIterations << " iterations)";
+
+  UInt64 expected = 0;
+  clock_t timer = clock();
+  for (UInt n = 0; n < numIterations; n++) {
+    // Word-at-a-time zero test, then byte by byte, as forward propagation
+    // used to scan its state.
+    for (UInt i = 0; i < numCells; i += 8) {
+      UInt64 eightStates = *(UInt64 *)(state.arrayPtr() + i);
+      for (int k = 0; eightStates != 0 && k < 8; eightStates >>= 8, k++) {
+        if ((eightStates & 0xff) != 0) {
+          expected += i + k;
+        }
+      }
+    }
+  }
+  checkpoint(timer, label.str() + ": byte scan");
+
+  UInt64 actual = 0;
+  timer = clock();
+  for (UInt n = 0; n < numIterations; n++) {
+    state.forEachOn([&](UInt i) { actual += i; });
+  }
+  checkpoint(timer, label.str() + ": forEachOn");
+
+  NTA_CHECK(actual == expected) << "State scan results differ";
+}
+
+vector<Real> Cells4PerformanceTest::randomInput(UInt numColumns, UInt w) {
+  vector<Real> input(numColumns, 0);
+
+  for (UInt i = 0; i < w; i++) {
+    input[rand() % numColumns] = 1;
+  }
+
+  return input;
+}
+
+void Cells4PerformanceTest::checkpoint(clock_t timer, string text) {
+  float duration = (float)(clock() - timer) / CLOCKS_PER_SEC;
+  cout << duration << " in " << text << endl;
+}
+
+} // end namespace nupic
+
+int main(int argc, char *argv[]) {
+  Cells4PerformanceTest test = Cells4PerformanceTest();
+  test.RunTests();
+}
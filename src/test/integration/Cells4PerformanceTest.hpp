@@ -0,0 +1,66 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definitions for Cells4PerformanceTest
+ */
+
+//----------------------------------------------------------------------
+
+#ifndef NTA_CELLS4_PERFORMANCE_TEST
+#define NTA_CELLS4_PERFORMANCE_TEST
+
+#include <string>
+#include <vector>
+
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+
+class Cells4PerformanceTest {
+public:
+  Cells4PerformanceTest() {}
+  virtual ~Cells4PerformanceTest() {}
+
+  // Run all appropriate tests
+  virtual void RunTests();
+
+  void testSequenceLearning();
+  void testLargeSequenceLearning();
+  void testStateScan();
+
+private:
+  void runSequenceTest(UInt numColumns, UInt cellsPerColumn, UInt w,
+                       UInt numSequences, UInt numElements, UInt numPasses,
+                       std::string label);
+
+  void runStateScanTest(UInt numCells, Real density, UInt numIterations);
+
+  std::vector<Real> randomInput(UInt numColumns, UInt w);
+
+  void checkpoint(clock_t timer, std::string text);
+
+}; // end class Cells4PerformanceTest
+
+} // end namespace nupic
+
+#endif // NTA_CELLS4_PERFORMANCE_TEST
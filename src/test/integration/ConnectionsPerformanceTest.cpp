@@ -48,8 +48,10 @@ void ConnectionsPerformanceTest::RunTests() {
 
   testTemporalMemoryUsage();
   testLargeTemporalMemoryUsage();
+  testTemporalMemoryManySegments();
   testSpatialPoolerUsage();
   testTemporalPoolerUsage();
+  testTemporalMemorySerialization();
 }
 
 /**
@@ -66,6 +68,120 @@ void ConnectionsPerformanceTest::testLargeTemporalMemoryUsage() {
   runTemporalMemoryTest(16384, 328, 3, 40, "temporal memory (large)");
 }
 
+/**
+ * Tests Temporal Memory inference when there are many more segments than a
+ * sparse input touches.
+ */
+void ConnectionsPerformanceTest::testTemporalMemoryManySegments() {
+  const UInt numColumns = 2048;
+  const UInt cellsPerColumn = 32;
+  const UInt numCells = numColumns * cellsPerColumn;
+  const string label = "temporal memory (many segments)";
+
+  clock_t timer = clock();
+
+  TemporalMemory tm;
+  vector<UInt> columnDim;
+  columnDim.push_back(numColumns);
+  tm.initialize(columnDim, cellsPerColumn);
+
+  // 8 segments per cell, each with 2 synapses to random cells
+  for (CellIdx cell = 0; cell < numCells; cell++) {
+    for (int i = 0; i < 8; i++) {
+      const Segment segment = tm.createSegment(cell);
+      for (int j = 0; j < 2; j++) {
+        tm.connections.createSynapse(segment, rand() % numCells, 0.6);
+      }
+    }
+  }
+
+  checkpoint(timer, label + ": initialize");
+
+  // Test
+
+  for (int i = 0; i < 500; i++) {
+    feedTM(tm, randomSDR(numColumns, 40), false);
+  }
+
+  checkpoint(timer, label + ": initialize + test");
+}
+
+/**
+ * Compares save and load times of the text, capnp and binary snapshot
+ * formats on a Temporal Memory with about a million synapses.
+ */
+void ConnectionsPerformanceTest::testTemporalMemorySerialization() {
+  const UInt numColumns = 2048;
+  const UInt cellsPerColumn = 32;
+  const UInt numCells = numColumns * cellsPerColumn;
+  const string label = "temporal memory serialization";
+  const char *filename = "ConnectionsPerformanceTest.tmp";
+
+  TemporalMemory tm;
+  vector<UInt> columnDim;
+  columnDim.push_back(numColumns);
+  tm.initialize(columnDim, cellsPerColumn);
+
+  for (CellIdx cell = 0; cell < numCells; cell++) {
+    for (int i = 0; i < 2; i++) {
+      const Segment segment = tm.createSegment(cell);
+      for (int j = 0; j < 8; j++) {
+        tm.connections.createSynapse(segment, rand() % numCells,
+                                     (Permanence)rand() / RAND_MAX);
+      }
+    }
+  }
+  for (int i = 0; i < 10; i++) {
+    feedTM(tm, randomSDR(numColumns, 40), false);
+  }
+
+  clock_t timer = clock();
+  {
+    ofstream os(filename, ios::binary);
+    tm.save(os);
+  }
+  checkpoint(timer, label + ": save (text)");
+
+  timer = clock();
+  {
+    TemporalMemory loaded;
+    ifstream is(filename, ios::binary);
+    loaded.load(is);
+  }
+  checkpoint(timer, label + ": load (text)");
+
+  timer = clock();
+  {
+    ofstream os(filename, ios::binary);
+    tm.write(os);
+  }
+  checkpoint(timer, label + ": save (capnp)");
+
+  timer = clock();
+  {
+    TemporalMemory loaded;
+    ifstream is(filename, ios::binary);
+    loaded.read(is);
+  }
+  checkpoint(timer, label + ": load (capnp)");
+
+  timer = clock();
+  {
+    ofstream os(filename, ios::binary);
+    tm.saveBinary(os);
+  }
+  checkpoint(timer, label + ": save (binary)");
+
+  timer = clock();
+  {
+    TemporalMemory loaded;
+    loaded.loadBinary(filename);
+  }
+  checkpoint(timer, label + ": load (binary)");
+
+  ::remove(filename);
+}
+
 /**
  * Tests typical usage of Connections with Spatial Pooler.
  */
@@ -55,8 +55,10 @@ public:
 
   void testTemporalMemoryUsage();
   void testLargeTemporalMemoryUsage();
+  void testTemporalMemoryManySegments();
   void testSpatialPoolerUsage();
   void testTemporalPoolerUsage();
+  void testTemporalMemorySerialization();
 
 private:
   void runTemporalMemoryTest(UInt numColumns, UInt w, int numSequences,
@@ -0,0 +1,187 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of performance tests for SDRClassifier
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <time.h>
+
+#include <nupic/algorithms/SDRClassifier.hpp>
+#include <nupic/utils/Log.hpp>
+#include <nupic/utils/Random.hpp>
+
+#include "SDRClassifierPerformanceTest.hpp"
+
+using namespace std;
+using namespace nupic;
+using namespace nupic::algorithms::sdr_classifier;
+using nupic::algorithms::ClassifierResult;
+
+#define SEED 42
+
+namespace nupic {
+
+void SDRClassifierPerformanceTest::RunTests() {
+  testSinePrecision();
+  testNoisySinePrecision();
+}
+
+/**
+ * Compares the Real32 and Real64 classifiers on a clean sine wave.
+ */
+void SDRClassifierPerformanceTest::testSinePrecision() {
+  runPrecisionTest(100, 0.0, 5000, "sine");
+}
+
+/**
+ * Compares the Real32 and Real64 classifiers on a sine wave with noise.
+ */
+void SDRClassifierPerformanceTest::testNoisySinePrecision() {
+  runPrecisionTest(100, 0.02, 5000, "noisy sine");
+}
+
+void SDRClassifierPerformanceTest::runPrecisionTest(UInt numBuckets,
+                                                    Real64 noise,
+                                                    UInt numRecords,
+                                                    string label) {
+  const vector<UInt> steps = {1, 5};
+  const UInt period = 100;
+
+  // Generate the dataset
+  Random rng(SEED);
+  vector<UInt> buckets;
+  vector<vector<UInt>> patterns;
+  for (UInt i = 0; i < numRecords; i++) {
+    const Real64 phase = 2 * M_PI * i / period;
+    const Real64 value =
+        sin(phase) + noise * (2 * rng.getReal64() - 1) * sqrt(3.0);
+    const Real64 scaled = (value + 1.2) / 2.4 * (numBuckets - 1);
+    const UInt bucket =
+        (UInt)max(0.0, min((Real64)numBuckets - 1, round(scaled)));
+    buckets.push_back(bucket);
+    patterns.push_back(encode(bucket, cos(phase) >= 0, numBuckets));
+  }
+
+  // Run each precision over the whole dataset, keeping the likelihoods of
+  // the second half
+  vector<vector<vector<Real64>>> predictions[2];
+  for (UInt mode = 0; mode < 2; mode++) {
+    const bool useFloat32 = mode == 1;
+    SDRClassifier classifier(steps, 0.1, 0.3, 0, useFloat32);
+
+    clock_t timer = clock();
+    for (UInt i = 0; i < numRecords; i++) {
+      ClassifierResult result;
+      classifier.compute(i, patterns[i], {buckets[i]}, {(Real64)buckets[i]},
+                         false, true, true, &result);
+      if (i >= numRecords / 2) {
+        vector<vector<Real64>> likelihoods;
+        for (auto it = result.begin(); it != result.end(); ++it) {
+          if (it->first >= 0) {
+            likelihoods.push_back(*it->second);
+          }
+        }
+        predictions[mode].push_back(likelihoods);
+      }
+    }
+    checkpoint(timer, label + (useFloat32 ? ": Real32" : ": Real64") +
+                          " learn + infer");
+
+    stringstream ss;
+    classifier.write(ss);
+    cout << "  " << ss.str().size() << " bytes serialized" << endl;
+  }
+
+  // Compare the predictions of both precisions with the data and with each
+  // other
+  for (UInt s = 0; s < steps.size(); s++) {
+    UInt numScored = 0;
+    UInt correct[2] = {0, 0};
+    UInt agree = 0;
+    Real64 maxDiff = 0.0;
+    for (UInt r = 0; r < predictions[0].size(); r++) {
+      const UInt record = numRecords / 2 + r;
+      if (record + steps[s] >= numRecords) {
+        break;
+      }
+
+      UInt best[2];
+      for (UInt mode = 0; mode < 2; mode++) {
+        const vector<Real64> &likelihoods = predictions[mode][r][s];
+        best[mode] = (UInt)(max_element(likelihoods.begin(),
+                                        likelihoods.end()) -
+                            likelihoods.begin());
+        if (best[mode] == buckets[record + steps[s]]) {
+          correct[mode]++;
+        }
+      }
+      if (best[0] == best[1]) {
+        agree++;
+      }
+      for (UInt j = 0; j < predictions[0][r][s].size(); j++) {
+        maxDiff = max(maxDiff, fabs(predictions[0][r][s][j] -
+                                    predictions[1][r][s][j]));
+      }
+      numScored++;
+    }
+
+    cout << "  " << label << ", " << steps[s] << " step: Real64 accuracy "
+         << (Real64)correct[0] / numScored << ", Real32 accuracy "
+         << (Real64)correct[1] / numScored << ", same best bucket "
+         << (Real64)agree / numScored << ", max likelihood difference "
+         << maxDiff << endl;
+  }
+}
+
+vector<UInt> SDRClassifierPerformanceTest::encode(UInt bucket, bool rising,
+                                                  UInt numBuckets) {
+  // A scalar encoding of the bucket, in one half of the input for rising
+  // values and in the other for falling ones, so that the input carries the
+  // context a temporal memory would.
+  const UInt halfWidth = 1024;
+  const UInt w = 21;
+  const UInt start = bucket * (halfWidth - w) / (numBuckets - 1) +
+                     (rising ? 0 : halfWidth);
+
+  vector<UInt> pattern;
+  for (UInt i = 0; i < w; i++) {
+    pattern.push_back(start + i);
+  }
+  return pattern;
+}
+
+void SDRClassifierPerformanceTest::checkpoint(clock_t timer, string text) {
+  float duration = (float)(clock() - timer) / CLOCKS_PER_SEC;
+  cout << duration << " in " << text << endl;
+}
+
+} // end namespace nupic
+
+int main(int argc, char *argv[]) {
+  SDRClassifierPerformanceTest test = SDRClassifierPerformanceTest();
+  test.RunTests();
+}
@@ -0,0 +1,62 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definitions for SDRClassifierPerformanceTest
+ */
+
+//----------------------------------------------------------------------
+
+#ifndef NTA_SDR_CLASSIFIER_PERFORMANCE_TEST
+#define NTA_SDR_CLASSIFIER_PERFORMANCE_TEST
+
+#include <string>
+#include <vector>
+
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+
+class SDRClassifierPerformanceTest {
+public:
+  SDRClassifierPerformanceTest() {}
+  virtual ~SDRClassifierPerformanceTest() {}
+
+  // Run all appropriate tests
+  virtual void RunTests();
+
+  void testSinePrecision();
+  void testNoisySinePrecision();
+
+private:
+  void runPrecisionTest(UInt numBuckets, Real64 noise, UInt numRecords,
+                        std::string label);
+
+  std::vector<UInt> encode(UInt bucket, bool rising, UInt numBuckets);
+
+  void checkpoint(clock_t timer, std::string text);
+
+}; // end class SDRClassifierPerformanceTest
+
+} // end namespace nupic
+
+#endif // NTA_SDR_CLASSIFIER_PERFORMANCE_TEST
@@ -0,0 +1,183 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of performance tests for SpatialPooler
+ */
+
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <time.h>
+
+#include <nupic/algorithms/SpatialPooler.hpp>
+#include <nupic/utils/Log.hpp>
+#include <nupic/utils/Random.hpp>
+
+#include "SpatialPoolerPerformanceTest.hpp"
+
+using namespace std;
+using namespace nupic;
+using namespace nupic::algorithms::spatial_pooler;
+
+#define SEED 42
+
+namespace nupic {
+
+void SpatialPoolerPerformanceTest::RunTests() {
+  testGlobalInhibition();
+  testSparseCompute();
+}
+
+/**
+ * Compares global inhibition against the winner list it replaced, across
+ * column counts and densities.
+ */
+void SpatialPoolerPerformanceTest::testGlobalInhibition() {
+  for (UInt numColumns : {2048u, 16384u, 65536u}) {
+    for (Real density : {0.02, 0.1}) {
+      runGlobalInhibitionTest(numColumns, density, 4194304 / numColumns);
+    }
+  }
+}
+
+/**
+ * Compares compute on a dense input array against compute on the list of
+ * active input bits.
+ */
+void SpatialPoolerPerformanceTest::testSparseCompute() {
+  runSparseComputeTest(1024, 2048, 0.02, 200);
+  runSparseComputeTest(16384, 2048, 0.02, 200);
+}
+
+void SpatialPoolerPerformanceTest::runGlobalInhibitionTest(UInt numColumns,
+                                                           Real density,
+                                                           UInt numIterations) {
+  SpatialPooler sp({32}, {numColumns});
+  Random rng(SEED);
+
+  // Overlaps drawn from a small range, as with sparse inputs, so there are
+  // plenty of ties.
+  vector<vector<Real>> overlaps(16, vector<Real>(numColumns));
+  for (auto &overlap : overlaps) {
+    for (UInt i = 0; i < numColumns; i++) {
+      overlap[i] = (Real)rng.getUInt32(40);
+    }
+  }
+
+  stringstream label;
+  label << "global inhibition (" << numColumns << " columns, density "
+        << density << ", " << numIterations << " iterations)";
+
+  vector<UInt> activeColumns;
+  vector<UInt> expected;
+
+  clock_t timer = clock();
+  for (UInt i = 0; i < numIterations; i++) {
+    sp.inhibitColumnsGlobal_(overlaps[i % overlaps.size()], density,
+                             activeColumns);
+  }
+  checkpoint(timer, label.str() + ": bounded heap");
+
+  timer = clock();
+  for (UInt i = 0; i < numIterations; i++) {
+    globalInhibitionWinnerList(sp, overlaps[i % overlaps.size()], density,
+                               expected);
+  }
+  checkpoint(timer, label.str() + ": sorted winner list");
+
+  NTA_CHECK(activeColumns == expected) << "Global inhibition results differ";
+}
+
+void SpatialPoolerPerformanceTest::runSparseComputeTest(UInt numInputs,
+                                                        UInt numColumns,
+                                                        Real sparsity,
+                                                        UInt numIterations) {
+  SpatialPooler dense({numInputs}, {numColumns});
+  dense.setGlobalInhibition(true);
+  SpatialPooler sparse = dense;
+  Random rng(SEED);
+
+  vector<vector<UInt>> inputs(16, vector<UInt>(numInputs));
+  vector<vector<UInt>> activeInputs(16);
+  for (UInt i = 0; i < inputs.size(); i++) {
+    for (UInt j = 0; j < numInputs; j++) {
+      if (rng.getReal64() < sparsity) {
+        inputs[i][j] = 1;
+        activeInputs[i].push_back(j);
+      }
+    }
+  }
+
+  stringstream label;
+  label << "compute (" << numInputs << " inputs, " << numColumns
+        << " columns, sparsity " << sparsity << ", " << numIterations
+        << " iterations)";
+
+  vector<UInt> activeDense(numColumns);
+  vector<UInt> activeSparse(numColumns);
+
+  clock_t timer = clock();
+  for (UInt i = 0; i < numIterations; i++) {
+    dense.compute(inputs[i % inputs.size()].data(), true, activeDense.data());
+  }
+  checkpoint(timer, label.str() + ": dense input");
+
+  timer = clock();
+  for (UInt i = 0; i < numIterations; i++) {
+    const vector<UInt> &input = activeInputs[i % activeInputs.size()];
+    sparse.compute(input.size(), input.data(), true, activeSparse.data());
+  }
+  checkpoint(timer, label.str() + ": sparse input");
+
+  NTA_CHECK(activeDense == activeSparse) << "Sparse compute results differ";
+}
+
+void SpatialPoolerPerformanceTest::globalInhibitionWinnerList(
+    SpatialPooler &sp, const vector<Real> &overlaps, Real density,
+    vector<UInt> &activeColumns) {
+  activeColumns.clear();
+  const UInt numDesired = (UInt)(density * overlaps.size());
+  vector<pair<UInt, Real>> winners;
+  for (UInt i = 0; i < overlaps.size(); i++) {
+    if (sp.isWinner_(overlaps[i], winners, numDesired)) {
+      sp.addToWinners_(i, overlaps[i], winners);
+    }
+  }
+
+  const UInt numActual = min(numDesired, (UInt)winners.size());
+  for (UInt i = 0; i < numActual; i++) {
+    activeColumns.push_back(winners[i].first);
+  }
+}
+
+void SpatialPoolerPerformanceTest::checkpoint(clock_t timer, string text) {
+  float duration = (float)(clock() - timer) / CLOCKS_PER_SEC;
+  cout << duration << " in " << text << endl;
+}
+
+} // end namespace nupic
+
+int main(int argc, char *argv[]) {
+  SpatialPoolerPerformanceTest test = SpatialPoolerPerformanceTest();
+  test.RunTests();
+}
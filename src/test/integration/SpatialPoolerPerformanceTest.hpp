@@ -0,0 +1,74 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Definitions for SpatialPoolerPerformanceTest
+ */
+
+//----------------------------------------------------------------------
+
+#ifndef NTA_SPATIAL_POOLER_PERFORMANCE_TEST
+#define NTA_SPATIAL_POOLER_PERFORMANCE_TEST
+
+#include <string>
+#include <vector>
+
+#include <nupic/types/Types.hpp>
+
+namespace nupic {
+
+namespace algorithms {
+namespace spatial_pooler {
+class SpatialPooler;
+}
+} // namespace algorithms
+
+class SpatialPoolerPerformanceTest {
+public:
+  SpatialPoolerPerformanceTest() {}
+  virtual ~SpatialPoolerPerformanceTest() {}
+
+  // Run all appropriate tests
+  virtual void RunTests();
+
+  void testGlobalInhibition();
+  void testSparseCompute();
+
+private:
+  void runGlobalInhibitionTest(UInt numColumns, Real density,
+                               UInt numIterations);
+
+  void runSparseComputeTest(UInt numInputs, UInt numColumns, Real sparsity,
+                            UInt numIterations);
+
+  void globalInhibitionWinnerList(
+      algorithms::spatial_pooler::SpatialPooler &sp,
+      const std::vector<Real> &overlaps, Real density,
+      std::vector<UInt> &activeColumns);
+
+  void checkpoint(clock_t timer, std::string text);
+
+}; // end class SpatialPoolerPerformanceTest
+
+} // end namespace nupic
+
+#endif // NTA_SPATIAL_POOLER_PERFORMANCE_TEST
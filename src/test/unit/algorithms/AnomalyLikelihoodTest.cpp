@@ -0,0 +1,147 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of unit tests for AnomalyLikelihood
+ */
+
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "nupic/algorithms/AnomalyLikelihood.hpp"
+#include "nupic/types/Types.hpp"
+
+using namespace nupic::algorithms::anomaly;
+using namespace nupic;
+
+namespace {
+
+// A stream with low raw scores and a varying input.
+Real64 quietScore(UInt i) { return (i % 5) * 0.02; }
+Real64 quietValue(UInt i) { return (i % 7) * 1.5; }
+
+TEST(AnomalyLikelihood, ProbationaryPeriod) {
+  AnomalyLikelihood al{10, 5};
+  ASSERT_EQ(15, al.getProbationaryPeriod());
+
+  for (UInt i = 0; i < 15; i++) {
+    ASSERT_EQ(0.5, al.anomalyProbability(quietScore(i), quietValue(i)));
+  }
+  ASSERT_EQ(15, al.getIteration());
+  ASSERT_NE(0.5, al.anomalyProbability(1.0, quietValue(15)));
+}
+
+TEST(AnomalyLikelihood, MatchesNormalTail) {
+  AnomalyLikelihood al{2, 2, 100, 100, 1};
+  const std::vector<Real64> scores = {0.9, 0.8, 0.2, 0.4};
+  for (UInt i = 0; i < scores.size(); i++) {
+    al.anomalyProbability(scores[i], quietValue(i));
+  }
+
+  // Only the records after the learning period shape the distribution.
+  const Real64 mean = 0.3;
+  const Real64 stdev = std::sqrt(0.01);
+  const Real64 z = (0.7 - mean) / stdev;
+  const Real64 expected = 1.0 - 0.5 * std::erfc(z / 1.4142);
+  ASSERT_NEAR(expected, al.anomalyProbability(0.7, quietValue(4)), 1e-6);
+}
+
+TEST(AnomalyLikelihood, FlatMetricUsesNullDistribution) {
+  AnomalyLikelihood al{10, 10, 100, 10};
+  for (UInt i = 0; i < 100; i++) {
+    const Real64 likelihood = al.anomalyProbability(i < 50 ? 0.0 : 1.0, 3.0);
+    ASSERT_NEAR(0.5, likelihood, 1e-3);
+  }
+}
+
+TEST(AnomalyLikelihood, DetectsAnomaly) {
+  AnomalyLikelihood al{50, 50, 1000, 20};
+  for (UInt i = 0; i < 300; i++) {
+    ASSERT_LT(al.anomalyProbability(quietScore(i), quietValue(i)), 0.99);
+  }
+
+  Real64 likelihood = 0;
+  for (UInt i = 300; i < 305; i++) {
+    likelihood = al.anomalyProbability(1.0, quietValue(i));
+  }
+  ASSERT_GT(likelihood, 0.99);
+}
+
+TEST(AnomalyLikelihood, DampsConsecutiveAnomalies) {
+  AnomalyLikelihood al{50, 50, 1000, 1000, 1};
+  for (UInt i = 0; i < 300; i++) {
+    al.anomalyProbability(quietScore(i), quietValue(i));
+  }
+
+  // Every record is far in the tail, but only the first one is reported
+  // above the yellow threshold
+  ASSERT_GT(al.anomalyProbability(1.0, quietValue(300)), 1.0 - 1e-3);
+  for (UInt i = 301; i < 306; i++) {
+    ASSERT_EQ(1.0 - 1e-3, al.anomalyProbability(1.0, quietValue(i)));
+  }
+}
+
+TEST(AnomalyLikelihood, SaveLoad) {
+  AnomalyLikelihood al{20, 20, 100, 10, 5};
+  for (UInt i = 0; i < 150; i++) {
+    al.anomalyProbability(quietScore(i), quietValue(i));
+  }
+
+  std::stringstream ss;
+  al.save(ss);
+  AnomalyLikelihood loaded;
+  loaded.load(ss);
+  ASSERT_EQ(al, loaded);
+
+  for (UInt i = 150; i < 250; i++) {
+    const Real64 score = i % 30 == 0 ? 1.0 : quietScore(i);
+    ASSERT_EQ(al.anomalyProbability(score, quietValue(i)),
+              loaded.anomalyProbability(score, quietValue(i)));
+  }
+  ASSERT_EQ(al, loaded);
+}
+
+TEST(AnomalyLikelihood, BatchMatchesStreams) {
+  const UInt numStreams = 4;
+  std::vector<AnomalyLikelihood> batch(numStreams, AnomalyLikelihood{5, 5});
+  std::vector<AnomalyLikelihood> single(numStreams, AnomalyLikelihood{5, 5});
+
+  std::vector<Real64> rawScores(numStreams), values(numStreams);
+  std::vector<Real64> likelihoods;
+  for (UInt i = 0; i < 50; i++) {
+    for (UInt s = 0; s < numStreams; s++) {
+      rawScores[s] = quietScore(i + s);
+      values[s] = quietValue(i * s);
+    }
+    computeAnomalyLikelihoods(batch, rawScores, values, likelihoods);
+    ASSERT_EQ(numStreams, likelihoods.size());
+    for (UInt s = 0; s < numStreams; s++) {
+      ASSERT_EQ(single[s].anomalyProbability(rawScores[s], values[s]),
+                likelihoods[s]);
+    }
+  }
+}
+
+} // end namespace
@@ -21,6 +21,7 @@
  */
 
 #include <algorithm>
+#include <sstream>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -61,6 +62,63 @@ TEST(ComputeRawAnomalyScore, PartialMatch) {
   ASSERT_FLOAT_EQ(computeRawAnomalyScore(active, predicted), 2.0 / 3.0);
 };
 
+TEST(ComputeRawAnomalyScore, UnsortedMatchesSorted) {
+  std::vector<UInt> active = {6, 2, 3, 3};
+  std::vector<UInt> predicted = {7, 3, 5, 2};
+  const Real32 unsorted = computeRawAnomalyScore(active, predicted);
+  std::sort(active.begin(), active.end());
+  std::sort(predicted.begin(), predicted.end());
+  ASSERT_FLOAT_EQ(computeRawAnomalyScore(active, predicted), unsorted);
+  ASSERT_FLOAT_EQ(unsorted, 2.0 / 4.0);
+};
+
+TEST(ComputeRawAnomalyScore, SortedArrays) {
+  const UInt active[] = {2, 3, 6};
+  const UInt predicted[] = {3, 5, 7};
+  ASSERT_FLOAT_EQ(computeRawAnomalyScore(active, 3, predicted, 3), 2.0 / 3.0);
+  ASSERT_FLOAT_EQ(computeRawAnomalyScore(active, 3, predicted, 0), 1.0);
+  ASSERT_FLOAT_EQ(computeRawAnomalyScore(active, 0, predicted, 3), 0.0);
+};
+
+TEST(ComputeRawAnomalyScore, Dense) {
+  std::vector<UInt64> active(2, 0), predicted(2, 0);
+  ASSERT_FLOAT_EQ(computeRawAnomalyScoreDense(active.data(),
+                                              predicted.data(), 2),
+                  0.0);
+
+  // Columns 2, 3 and 70 are active, 3, 5 and 70 predicted.
+  active[0] = (1ULL << 2) | (1ULL << 3);
+  active[1] = 1ULL << 6;
+  predicted[0] = (1ULL << 3) | (1ULL << 5);
+  predicted[1] = 1ULL << 6;
+  ASSERT_FLOAT_EQ(computeRawAnomalyScoreDense(active.data(),
+                                              predicted.data(), 2),
+                  1.0 / 3.0);
+};
+
+TEST(ComputeRawAnomalyScore, Batch) {
+  // Three streams: partial match, no active columns, no match.
+  const std::vector<UInt> active = {2, 3, 6, 2, 4, 6};
+  const std::vector<UInt> activeOffsets = {0, 3, 3, 6};
+  const std::vector<UInt> predicted = {3, 5, 7, 1, 3, 5, 7};
+  const std::vector<UInt> predictedOffsets = {0, 3, 4, 7};
+  std::vector<Real32> scores(3);
+  computeRawAnomalyScores(3, active.data(), activeOffsets.data(),
+                          predicted.data(), predictedOffsets.data(),
+                          scores.data());
+  ASSERT_FLOAT_EQ(scores[0], 2.0 / 3.0);
+  ASSERT_FLOAT_EQ(scores[1], 0.0);
+  ASSERT_FLOAT_EQ(scores[2], 1.0);
+
+  const std::vector<UInt64> activeBits = {0x0F, 0x00, 0xF0};
+  const std::vector<UInt64> predictedBits = {0x03, 0xFF, 0x00};
+  computeRawAnomalyScoresDense(3, 1, activeBits.data(), predictedBits.data(),
+                               scores.data());
+  ASSERT_FLOAT_EQ(scores[0], 0.5);
+  ASSERT_FLOAT_EQ(scores[1], 0.0);
+  ASSERT_FLOAT_EQ(scores[2], 1.0);
+};
+
 TEST(Anomaly, ComputeScoreNoActiveOrPredicted) {
   std::vector<UInt> active;
   std::vector<UInt> predicted;
@@ -120,3 +178,70 @@ TEST(Anomaly, SelectModePure) {
   std::vector<UInt> predicted = {3, 5, 7};
   ASSERT_FLOAT_EQ(a.compute(active, predicted), 2.0 / 3.0);
 };
+
+TEST(Anomaly, SelectModeLikelihood) {
+  Anomaly a{0, AnomalyMode::LIKELIHOOD, 0};
+  std::vector<UInt> active = {2, 3, 6};
+  std::vector<UInt> predicted = {3, 5, 7};
+  // Still in the probationary period of the likelihood.
+  ASSERT_FLOAT_EQ(a.compute(active, predicted, 1.0), 0.5);
+};
+
+TEST(Anomaly, LikelihoodReportsAnomalyAfterProbation) {
+  Anomaly a{0, AnomalyMode::LIKELIHOOD, 0};
+  Anomaly noValues{0, AnomalyMode::LIKELIHOOD, 0};
+  std::vector<UInt> predicted = {0, 1, 2, 3, 5, 7};
+  // Well past the default probationary period of 388 records, with columns
+  // that are mostly predicted and a metric that varies.
+  for (UInt i = 0; i < 600; i++) {
+    std::vector<UInt> active = {i % 4, 5, i % 7 == 0 ? 9u : 7u};
+    a.compute(active, predicted, 10.0 + i % 11);
+    noValues.compute(active, predicted);
+  }
+
+  std::vector<UInt> active = {10, 11, 12};
+  ASSERT_GT(a.compute(active, predicted, 10.0), 0.9);
+
+  // Without the metric values the likelihood falls back to the null
+  // distribution and cannot tell the anomaly apart.
+  ASSERT_LT(noValues.compute(active, predicted), 0.51);
+};
+
+TEST(Anomaly, SelectModeWeighted) {
+  Anomaly a{0, AnomalyMode::WEIGHTED, 0};
+  std::vector<UInt> active = {2, 3, 6};
+  std::vector<UInt> predicted = {3, 5, 7};
+  ASSERT_FLOAT_EQ(a.compute(active, predicted, 1.0), 2.0 / 3.0 * 0.5);
+};
+
+TEST(Anomaly, SaveKeepsStreamPrecision) {
+  // Anomaly, its moving average and its likelihood each save at full
+  // precision, and must leave the caller's stream as they found it.
+  Anomaly a{3, AnomalyMode::WEIGHTED, 0};
+  std::stringstream ss;
+  ss.precision(3);
+  a.save(ss);
+  ASSERT_EQ(3, ss.precision());
+};
+
+TEST(Anomaly, SaveLoad) {
+  Anomaly a{3, AnomalyMode::WEIGHTED, 0};
+  std::vector<UInt> predicted = {3, 5, 7};
+  for (UInt i = 0; i < 500; i++) {
+    std::vector<UInt> active = {i % 4, 5, 7};
+    a.compute(active, predicted, i % 11);
+  }
+
+  std::stringstream ss;
+  a.save(ss);
+  Anomaly loaded;
+  ASSERT_NE(a, loaded);
+  loaded.load(ss);
+  ASSERT_EQ(a, loaded);
+
+  for (UInt i = 500; i < 600; i++) {
+    std::vector<UInt> active = {i % 6, 5, 7};
+    ASSERT_EQ(a.compute(active, predicted, i % 11),
+              loaded.compute(active, predicted, i % 11));
+  }
+}
@@ -25,6 +25,8 @@
  */
 
 #include <set>
+#include <sstream>
+#include <string>
 #include <vector>
 
 #include <capnp/message.h>
@@ -36,6 +38,7 @@
 #include <nupic/algorithms/Segment.hpp>
 #include <nupic/math/ArrayAlgo.hpp> // is_in
 #include <nupic/proto/Cells4.capnp.h>
+#include <nupic/utils/Random.hpp>
 
 using namespace nupic::algorithms::Cells4;
 
@@ -646,4 +649,153 @@ TEST(Cells4Test, testEqualsOperator) {
     cells2.reset();
     ASSERT_TRUE(cells1 == cells2);
   }
-}
\ No newline at end of file
+}
+/**
+ * Test that CState::forEachOn visits exactly the nonzero cells, in order,
+ * including any tail past the last multiple of 8 and bytes other than 1.
+ */
+TEST(Cells4Test, CStateForEachOn) {
+  CState state;
+  state.initialize(29);
+  std::vector<UInt> expected = {0, 7, 8, 15, 16, 21, 27, 28};
+  for (UInt cellIdx : expected) {
+    state.set(cellIdx);
+  }
+  state.arrayPtr()[21] = 0x80; // as written by Python
+
+  std::vector<UInt> visited;
+  state.forEachOn([&](UInt cellIdx) { visited.push_back(cellIdx); });
+  ASSERT_EQ(expected, visited);
+
+  state.resetAll();
+  visited.clear();
+  state.forEachOn([&](UInt cellIdx) { visited.push_back(cellIdx); });
+  ASSERT_TRUE(visited.empty());
+}
+
+/**
+ * Test that backtracking with several threads picks the same start offsets
+ * as the serial loop, so outputs, states and segments stay identical.
+ */
+TEST(Cells4Test, parallelBacktrackMatchesSerial) {
+  const UInt nColumns = 64, nCellsPerCol = 4, w = 6;
+  Cells4 serial(nColumns, nCellsPerCol, 3, 2, 4, 1, 0.21, 0.5, 1.0, 0.1, 0.1,
+                0.0, false, 42, true, false);
+  Cells4 parallel(nColumns, nCellsPerCol, 3, 2, 4, 1, 0.21, 0.5, 1.0, 0.1,
+                  0.1, 0.0, false, 42, true, false);
+  parallel.setNumThreads(4);
+  ASSERT_EQ(4u, parallel.getNumThreads());
+
+  // Learn a short sequence, at first without resets and then from its start
+  // cells, with a random pattern after each repeat. Then infer it with the
+  // odd element replaced by a random pattern, so that inference has to
+  // backtrack to lock on again, sometimes from an earlier start offset.
+  nupic::Random rng(2);
+  std::vector<std::vector<Real>> patterns(16, std::vector<Real>(nColumns));
+  for (auto &pattern : patterns) {
+    for (UInt i = 0; i < w; i++) {
+      pattern[rng.getUInt32(nColumns)] = 1.0;
+    }
+  }
+
+  std::vector<Real> output1(nColumns * nCellsPerCol);
+  std::vector<Real> output2(nColumns * nCellsPerCol);
+  for (UInt i = 0; i < 600; i++) {
+    const UInt step = i % 5;
+    const bool learn = (i < 300);
+    if (learn && step == 4 && i > 150) {
+      serial.reset();
+      parallel.reset();
+      continue;
+    }
+    UInt patternIdx = step < 4 ? step : 8 + rng.getUInt32(8);
+    if (!learn && step < 4 && rng.getUInt32(8) == 0)
+      patternIdx = rng.getUInt32(16);
+    const std::vector<Real> &input = patterns[patternIdx];
+    serial.compute((Real *)input.data(), output1.data(), true, learn);
+    parallel.compute((Real *)input.data(), output2.data(), true, learn);
+    ASSERT_EQ(output1, output2) << "at step " << i;
+    ASSERT_TRUE(serial == parallel) << "at step " << i;
+  }
+}
+
+/**
+ * Test that a backtracking time limit is accepted, and that an exhausted
+ * limit still leaves a consistent state.
+ */
+TEST(Cells4Test, backtrackTimeLimit) {
+  const UInt nColumns = 32, nCellsPerCol = 4;
+  Cells4 cells(nColumns, nCellsPerCol, 3, 2, 4, 1, 0.21, 0.5, 1.0, 0.1, 0.1,
+               0.0, false, 42, true, false);
+  ASSERT_EQ(0, cells.getMaxBacktrackTime());
+  EXPECT_THROW(cells.setMaxBacktrackTime(-1), std::exception);
+
+  // A limit far below one replay means no start offset is ever tried.
+  cells.setMaxBacktrackTime(1e-9);
+  ASSERT_FLOAT_EQ(1e-9, cells.getMaxBacktrackTime());
+
+  nupic::Random rng(11);
+  std::vector<Real> input(nColumns), output(nColumns * nCellsPerCol);
+  for (UInt i = 0; i < 50; i++) {
+    std::fill(input.begin(), input.end(), 0.0);
+    for (UInt j = 0; j < 4; j++) {
+      input[rng.getUInt32(nColumns)] = 1.0;
+    }
+    cells.compute(input.data(), output.data(), true, i < 30);
+  }
+  ASSERT_TRUE(cells.invariants());
+}
+
+/**
+ * Test that under a time limit, backtracking with several threads only
+ * picks the start offset that it picks without a limit, or none. A later
+ * offset that stays in sequence is never taken while an earlier one is
+ * left unevaluated.
+ */
+TEST(Cells4Test, backtrackTimeLimitOffset) {
+  const UInt nColumns = 64, nCellsPerCol = 4, w = 6;
+  Cells4 cells(nColumns, nCellsPerCol, 3, 2, 4, 1, 0.21, 0.5, 1.0, 0.1, 0.1,
+               0.0, false, 42, true, false);
+  cells.setMaxLrnBacktrack(8);
+
+  nupic::Random rng(5);
+  std::vector<std::vector<Real>> patterns(16, std::vector<Real>(nColumns));
+  for (auto &pattern : patterns) {
+    for (UInt i = 0; i < w; i++) {
+      pattern[rng.getUInt32(nColumns)] = 1.0;
+    }
+  }
+
+  // learnBacktrack() from a copy of the current state
+  auto backtrack = [](const std::string &state, UInt numThreads,
+                      Real limit) {
+    Cells4 copy;
+    std::istringstream in(state);
+    copy.load(in);
+    copy.setNumThreads(numThreads);
+    copy.setMaxBacktrackTime(limit);
+    return copy.learnBacktrack();
+  };
+
+  std::vector<Real> output(nColumns * nCellsPerCol);
+  for (UInt i = 0; i < 120; i++) {
+    const UInt step = i % 5;
+    const UInt patternIdx = step < 4 ? step : 8 + rng.getUInt32(8);
+    cells.compute(patterns[patternIdx].data(), output.data(), true, true);
+    if (i < 100)
+      continue;
+
+    std::ostringstream out;
+    cells.save(out);
+    const std::string state = out.str();
+    const UInt steps = backtrack(state, 1, 0);
+    ASSERT_EQ(steps, backtrack(state, 4, 0)) << "at step " << i;
+    ASSERT_EQ(0u, backtrack(state, 4, 1e-9)) << "at step " << i;
+    for (Real limit : {5e-6, 2e-5}) {
+      const UInt limited = backtrack(state, 4, limit);
+      ASSERT_TRUE(limited == 0 || limited == steps)
+          << "at step " << i << ", chose " << limited << " instead of "
+          << steps;
+    }
+  }
+}
@@ -25,9 +25,11 @@
  */
 
 #include "gtest/gtest.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <nupic/algorithms/Connections.hpp>
+#include <nupic/utils/BinaryStream.hpp>
 
 using namespace std;
 using namespace nupic;
@@ -343,6 +345,42 @@ TEST(ConnectionsTest, testComputeActivity) {
   ASSERT_EQ(3, numActivePotentialSynapsesForSegment[segment2_1]);
 }
 
+/**
+ * Compute activity while tracking touched segments. Only segments that
+ * receive input are listed, and the counts match the untracked overload.
+ */
+TEST(ConnectionsTest, testComputeActivityTouchedSegments) {
+  Connections connections(1024);
+
+  const Segment segment1 = connections.createSegment(10);
+  connections.createSynapse(segment1, 150, 0.85);
+  connections.createSynapse(segment1, 151, 0.15);
+
+  const Segment segment2 = connections.createSegment(20);
+  connections.createSynapse(segment2, 80, 0.85);
+  connections.createSynapse(segment2, 81, 0.15);
+
+  const Segment segment3 = connections.createSegment(30);
+  connections.createSynapse(segment3, 90, 0.85);
+
+  vector<UInt32> numActiveConnectedSynapsesForSegment(
+      connections.segmentFlatListLength(), 0);
+  vector<UInt32> numActivePotentialSynapsesForSegment(
+      connections.segmentFlatListLength(), 0);
+  vector<Segment> touchedSegments = {segment3};
+  connections.computeActivity(numActiveConnectedSynapsesForSegment,
+                              numActivePotentialSynapsesForSegment,
+                              touchedSegments, {80, 81, 150, 151}, 0.5);
+
+  std::sort(touchedSegments.begin(), touchedSegments.end());
+  ASSERT_EQ(vector<Segment>({segment1, segment2}), touchedSegments);
+  ASSERT_EQ(1, numActiveConnectedSynapsesForSegment[segment1]);
+  ASSERT_EQ(2, numActivePotentialSynapsesForSegment[segment1]);
+  ASSERT_EQ(1, numActiveConnectedSynapsesForSegment[segment2]);
+  ASSERT_EQ(2, numActivePotentialSynapsesForSegment[segment2]);
+  ASSERT_EQ(0, numActivePotentialSynapsesForSegment[segment3]);
+}
+
 /**
  * Test the mapSegmentsToCells method.
  */
@@ -513,4 +551,76 @@ TEST(ConnectionsTest, testSaveLoad) {
   ASSERT_EQ(c1, c2);
 }
 
+/**
+ * Saves connections with destroyed segments/synapses as a binary snapshot,
+ * then maps the file back in and checks that nothing was lost.
+ */
+TEST(ConnectionsTest, testSaveLoadBinary) {
+  const char *filename = "ConnectionsBinary.tmp";
+  Connections c1(1024), c2;
+  setupSampleConnections(c1);
+
+  auto segment = c1.createSegment(10);
+
+  c1.createSynapse(segment, 400, 0.5);
+  c1.destroySegment(segment);
+
+  computeSampleActivity(c1);
+
+  ofstream os(filename, ios::binary);
+  c1.saveBinary(os);
+  os.close();
+
+  c2.loadBinary(filename);
+
+  ASSERT_EQ(c1, c2);
+
+  // Loading over existing connections replaces them.
+  c2.createSegment(20);
+  c2.loadBinary(filename);
+  ASSERT_EQ(c1, c2);
+
+  int ret = ::remove(filename);
+  NTA_CHECK(ret == 0) << "Failed to delete " << filename;
+}
+
+/**
+ * A truncated snapshot throws rather than reading past the buffer.
+ */
+TEST(ConnectionsTest, testLoadBinaryTruncated) {
+  Connections c1(1024), c2;
+  setupSampleConnections(c1);
+
+  stringstream ss;
+  c1.saveBinary(ss);
+  const string snapshot = ss.str();
+
+  util::BinaryReader reader(snapshot.data(), snapshot.size() - 1);
+  EXPECT_THROW(c2.loadBinary(reader), std::exception);
+}
+
+/**
+ * A snapshot with a presynaptic cell beyond the stored cell count throws
+ * rather than indexing out of range.
+ */
+TEST(ConnectionsTest, testLoadBinaryCorruptPresynapticCell) {
+  for (CellIdx presynapticCell : {4u, 0xFFFFFFFFu}) {
+    stringstream ss;
+    util::BinaryWriter writer(ss);
+    writer.writeMarker("NTACONNS");
+    writer.write<UInt32>(Connections::BINARY_VERSION);
+    writer.write<UInt32>(4);
+    writer.writeVector(vector<SegmentIdx>{1, 0, 0, 0});
+    writer.writeVector(vector<SynapseIdx>{1});
+    writer.writeVector(vector<CellIdx>{presynapticCell});
+    writer.writeVector(vector<Permanence>{0.5});
+    writer.writeMarker("~NTACONN");
+    const string snapshot = ss.str();
+
+    Connections c;
+    util::BinaryReader reader(snapshot.data(), snapshot.size());
+    EXPECT_THROW(c.loadBinary(reader), std::exception) << presynapticCell;
+  }
+}
+
 } // namespace
@@ -33,6 +33,7 @@
 #include <vector>
 
 #include <gtest/gtest.h>
+#include <capnp/message.h>
 #include <kj/std/iostream.h>
 
 #include <nupic/algorithms/ClassifierResult.hpp>
@@ -430,6 +431,144 @@ TEST_F(SDRClassifierTest, WriteRead) {
   ASSERT_TRUE(result1 == result2);
 }
 
+TEST_F(SDRClassifierTest, GrowBuckets) {
+  SDRClassifier c1 = SDRClassifier({0}, 0.5, 0.5, 0);
+  SDRClassifier c2 = SDRClassifier({0}, 0.5, 0.5, 0);
+
+  // Learn a pattern while there are only a few buckets
+  const vector<UInt> input1 = {1, 5, 9};
+  UInt recordNum = 0;
+  for (UInt i = 0; i < 10; i++) {
+    ClassifierResult result;
+    c1.compute(recordNum++, input1, {1}, {10.0}, false, true, false,
+               &result);
+  }
+
+  // Then see larger inputs and enough buckets to widen the weight rows
+  // several times
+  for (UInt bucket = 2; bucket <= 100; bucket++) {
+    ClassifierResult result;
+    c1.compute(recordNum++, {bucket + 10, bucket + 300}, {bucket},
+               {10.0 * bucket}, false, true, false, &result);
+  }
+
+  ClassifierResult result;
+  c1.compute(recordNum, input1, {}, {0.0}, false, false, true, &result);
+  for (auto it = result.begin(); it != result.end(); ++it) {
+    if (it->first == 0) {
+      ASSERT_EQ(101, it->second->size());
+      ASSERT_EQ(1, max_element(it->second->begin(), it->second->end()) -
+                       it->second->begin())
+          << "The pattern learned before growing should still predict "
+          << "bucket 1";
+    }
+  }
+
+  {
+    stringstream ss;
+    c1.write(ss);
+    c2.read(ss);
+  }
+
+  ASSERT_TRUE(c1 == c2);
+
+  ClassifierResult result1, result2;
+  c1.compute(recordNum, input1, {120}, {1200.0}, false, true, true,
+             &result1);
+  c2.compute(recordNum, input1, {120}, {1200.0}, false, true, true,
+             &result2);
+
+  ASSERT_TRUE(result1 == result2);
+  ASSERT_TRUE(c1 == c2);
+}
+
+TEST_F(SDRClassifierTest, Float32) {
+  SDRClassifier c64 = SDRClassifier({1, 2}, 0.1, 0.1, 0);
+  SDRClassifier c32 = SDRClassifier({1, 2}, 0.1, 0.1, 0, true);
+  ASSERT_FALSE(c64.getUseFloat32());
+  ASSERT_TRUE(c32.getUseFloat32());
+
+  // Learn a repeating sequence of patterns with both precisions
+  const vector<vector<UInt>> inputs = {{1, 5, 9}, {0, 8, 9}, {2, 6, 12}};
+  UInt recordNum = 0;
+  for (UInt i = 0; i < 30; i++) {
+    const UInt bucket = i % inputs.size();
+    ClassifierResult result64, result32;
+    c64.compute(recordNum, inputs[bucket], {bucket}, {10.0 * bucket}, false,
+                true, true, &result64);
+    c32.compute(recordNum, inputs[bucket], {bucket}, {10.0 * bucket}, false,
+                true, true, &result32);
+    recordNum++;
+
+    auto it32 = result32.begin();
+    for (auto it = result64.begin(); it != result64.end(); ++it, ++it32) {
+      ASSERT_EQ(it->first, it32->first);
+      ASSERT_EQ(it->second->size(), it32->second->size());
+      for (UInt j = 0; j < it->second->size(); j++) {
+        ASSERT_NEAR(it->second->at(j), it32->second->at(j), 1e-5);
+      }
+    }
+  }
+
+  // The float weights survive serialization
+  SDRClassifier c2;
+  {
+    stringstream ss;
+    c32.write(ss);
+    c2.read(ss);
+  }
+  ASSERT_TRUE(c2.getUseFloat32());
+  ASSERT_TRUE(c32 == c2);
+  ASSERT_FALSE(c64 == c2);
+
+  ClassifierResult result1, result2;
+  c32.compute(recordNum, inputs[0], {0}, {0.0}, false, true, true, &result1);
+  c2.compute(recordNum, inputs[0], {0}, {0.0}, false, true, true, &result2);
+  ASSERT_TRUE(result1 == result2);
+}
+
+TEST_F(SDRClassifierTest, Float32SaveLoad) {
+  SDRClassifier c1 = SDRClassifier({1}, 0.1, 0.1, 0, true);
+  const vector<vector<UInt>> inputs = {{1, 5, 9}, {0, 8, 9}};
+  for (UInt i = 0; i < 10; i++) {
+    ClassifierResult result;
+    c1.compute(i, inputs[i % 2], {i % 2}, {10.0 * (i % 2)}, false, true,
+               false, &result);
+  }
+
+  // A model read from a version 1 proto is saved in the current layout
+  SDRClassifier legacy;
+  {
+    capnp::MallocMessageBuilder message;
+    SdrClassifierProto::Builder builder =
+        message.initRoot<SdrClassifierProto>();
+    c1.write(builder);
+    builder.setVersion(1);
+    SdrClassifierProto::Reader reader = builder.asReader();
+    legacy.read(reader);
+  }
+  ASSERT_EQ(sdrClassifierVersion, legacy.version());
+
+  for (SDRClassifier *c : {&c1, &legacy}) {
+    SDRClassifier c2;
+    {
+      stringstream ss;
+      ss.precision(3);
+      c->save(ss);
+      // The caller's formatting is left as it was.
+      ASSERT_EQ(3, ss.precision());
+      c2.load(ss);
+    }
+    ASSERT_TRUE(c2.getUseFloat32());
+    ASSERT_TRUE(*c == c2);
+
+    ClassifierResult result1, result2;
+    c->compute(10, inputs[0], {0}, {0.0}, false, true, true, &result1);
+    c2.compute(10, inputs[0], {0}, {0.0}, false, true, true, &result2);
+    ASSERT_TRUE(result1 == result2);
+  }
+}
+
 TEST_F(SDRClassifierTest, testSoftmaxOverflow) {
   SDRClassifier c = SDRClassifier({1}, 0.5, 0.5, 0);
   std::vector<Real64> values = {numeric_limits<Real64>::max()};
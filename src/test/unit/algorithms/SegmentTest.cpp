@@ -157,4 +157,75 @@ TEST(SegmentTest, testEqualsOperator) {
   setUpSegment(segment2, inactiveSegmentIndices, activeSegmentIndices,
                activeSynapseIndices, inactiveSynapseIndices);
   ASSERT_TRUE(segment1 == segment2);
-}
\ No newline at end of file
+}
+/**
+ * Test that synapses stay sorted by source cell as they are added, removed
+ * and moved to a larger slab, and that copies and moves keep them.
+ */
+TEST(SegmentTest, testSynapseStorage) {
+  Segment segment;
+  vector<UInt> removed;
+
+  segment.addSynapses({10, 30, 50}, 0.6, 0.5);
+  segment.addSynapses({0, 20, 40, 60}, 0.4, 0.5);
+  ASSERT_EQ(7, segment.size());
+  ASSERT_EQ(3, segment.nConnected());
+  for (UInt i = 0; i < segment.size(); i++) {
+    ASSERT_EQ(i * 10, segment.getSrcCellIdx(i));
+    ASSERT_FLOAT_EQ(i % 2 ? 0.6 : 0.4, segment.getPermanence(i));
+  }
+
+  // Grow past the smallest slab, then drop every other synapse.
+  set<UInt> srcCells;
+  for (UInt cell = 5; cell < 100; cell += 10) {
+    srcCells.insert(cell);
+  }
+  segment.addSynapses(srcCells, 0.2, 0.5);
+  ASSERT_EQ(17, segment.size());
+  segment.decaySynapses(0.3, removed, 0.5);
+  ASSERT_EQ(srcCells, set<UInt>(removed.begin(), removed.end()));
+  ASSERT_EQ(7, segment.size());
+  ASSERT_EQ(0, segment.nConnected());
+  ASSERT_EQ(60, segment.getSrcCellIdx(6));
+  ASSERT_FLOAT_EQ(0.1, segment.getPermanence(6));
+
+  Segment copy(segment);
+  ASSERT_EQ(segment, copy);
+
+  Segment moved(std::move(copy));
+  ASSERT_EQ(segment, moved);
+  ASSERT_TRUE(copy.empty());
+
+  moved.clear();
+  ASSERT_TRUE(moved.empty());
+  ASSERT_NE(segment, moved);
+}
+
+/**
+ * Test that synapses come from the pool they are given, that copies do not
+ * depend on that pool, and that the pool can go away before the copies.
+ */
+TEST(SegmentTest, testSynapsePool) {
+  SegmentSynapses copy;
+  {
+    SynapsePool pool;
+    ASSERT_EQ(0, pool.nChunks());
+
+    SegmentSynapses synapses(&pool);
+    synapses.insert({1, 2, 3}, 0.5);
+    ASSERT_EQ(&pool, synapses.pool());
+    ASSERT_EQ(1, pool.nChunks());
+
+    copy = synapses;
+    ASSERT_EQ(nullptr, copy.pool());
+
+    SegmentSynapses moved(std::move(synapses));
+    ASSERT_EQ(&pool, moved.pool());
+    moved.setPool(nullptr);
+    ASSERT_EQ(nullptr, moved.pool());
+    ASSERT_EQ(copy, moved);
+  }
+  ASSERT_EQ(3, copy.size());
+  ASSERT_EQ(2, copy.srcCellIdx(1));
+  ASSERT_FLOAT_EQ(0.5, copy.permanence(1));
+}
@@ -1353,6 +1353,45 @@ TEST(SpatialPoolerTest, testInhibitColumnsGlobal) {
   ASSERT_TRUE(check_vector_eq(trueActive, active));
 }
 
+TEST(SpatialPoolerTest, testInhibitColumnsGlobalMatchesWinnerList) {
+  // inhibitColumnsGlobal_ must pick the same columns, in the same order, as
+  // building the winner list with isWinner_ / addToWinners_.
+  SpatialPooler sp;
+  UInt numInputs = 10;
+  UInt numColumns = 500;
+  setup(sp, numInputs, numColumns);
+  Random rng(7);
+
+  for (UInt stimulusThreshold : {0u, 3u}) {
+    sp.setStimulusThreshold(stimulusThreshold);
+    for (Real density : {0.02, 0.1, 0.5}) {
+      for (UInt trial = 0; trial < 10; trial++) {
+        // Few distinct values, so there are many ties.
+        vector<Real> overlaps(numColumns);
+        for (UInt i = 0; i < numColumns; i++) {
+          overlaps[i] = (Real)rng.getUInt32(8);
+        }
+
+        const UInt numDesired = (UInt)(density * numColumns);
+        vector<pair<UInt, Real>> winners;
+        for (UInt i = 0; i < numColumns; i++) {
+          if (sp.isWinner_(overlaps[i], winners, numDesired)) {
+            sp.addToWinners_(i, overlaps[i], winners);
+          }
+        }
+        vector<UInt> expected;
+        for (UInt i = 0; i < numDesired && i < winners.size(); i++) {
+          expected.push_back(winners[i].first);
+        }
+
+        vector<UInt> activeColumns;
+        sp.inhibitColumnsGlobal_(overlaps, density, activeColumns);
+        ASSERT_EQ(expected, activeColumns);
+      }
+    }
+  }
+}
+
 TEST(SpatialPoolerTest, testValidateGlobalInhibitionParameters) {
   // With 10 columns the minimum sparsity for global inhibition is 10%
   // Setting sparsity to 2% should throw an exception
@@ -2159,4 +2198,197 @@ TEST(SpatialPoolerTest, testConstructorVsInitialize) {
   check_spatial_eq(sp1, sp2);
 }
 
+TEST(SpatialPoolerTest, testMultithreadedComputeMatchesSerial) {
+  for (bool globalInhibition : {true, false}) {
+    SpatialPooler sp1(
+        /*inputDimensions*/ {32, 32},
+        /*columnDimensions*/ {16, 16},
+        /*potentialRadius*/ 8,
+        /*potentialPct*/ 0.5,
+        /*globalInhibition*/ globalInhibition,
+        /*localAreaDensity*/ -1.0,
+        /*numActiveColumnsPerInhArea*/ 10,
+        /*stimulusThreshold*/ 0,
+        /*synPermInactiveDec*/ 0.008,
+        /*synPermActiveInc*/ 0.05,
+        /*synPermConnected*/ 0.1,
+        /*minPctOverlapDutyCycles*/ 0.001,
+        /*dutyCyclePeriod*/ 20,
+        /*boostStrength*/ 2.0,
+        /*seed*/ 1,
+        /*spVerbosity*/ 0,
+        /*wrapAround*/ true,
+        /*numThreads*/ 1);
+    SpatialPooler sp2 = sp1;
+    sp2.setNumThreads(4);
+    ASSERT_EQ(1u, sp1.getNumThreads());
+    ASSERT_EQ(4u, sp2.getNumThreads());
+
+    UInt numInputs = sp1.getNumInputs();
+    UInt numColumns = sp1.getNumColumns();
+    vector<UInt> input(numInputs);
+    vector<UInt> active1(numColumns);
+    vector<UInt> active2(numColumns);
+    Random rng(42);
+
+    for (UInt i = 0; i < 100; i++) {
+      for (UInt j = 0; j < numInputs; j++) {
+        input[j] = rng.getUInt32(10) == 0 ? 1 : 0;
+      }
+      sp1.compute(input.data(), true, active1.data());
+      sp2.compute(input.data(), true, active2.data());
+      ASSERT_EQ(active1, active2) << "iteration " << i;
+    }
+
+    ASSERT_NO_FATAL_FAILURE(check_spatial_eq(sp1, sp2));
+  }
+}
+
+TEST(SpatialPoolerTest, testMultithreadedLocalInhibitionMatchesSerial) {
+  // A small potential radius keeps the inhibition radius well below the
+  // column dimensions, so every step takes the local inhibition path. The
+  // sparse input leaves many columns tied at zero overlap, which exercises
+  // the tie-breaking. The single-threaded pooler runs the serial loop.
+  for (bool wrapAround : {true, false}) {
+    SpatialPooler sp1(
+        /*inputDimensions*/ {32, 32},
+        /*columnDimensions*/ {32, 32},
+        /*potentialRadius*/ 2,
+        /*potentialPct*/ 0.5,
+        /*globalInhibition*/ false,
+        /*localAreaDensity*/ -1.0,
+        /*numActiveColumnsPerInhArea*/ 3,
+        /*stimulusThreshold*/ 0,
+        /*synPermInactiveDec*/ 0.008,
+        /*synPermActiveInc*/ 0.05,
+        /*synPermConnected*/ 0.1,
+        /*minPctOverlapDutyCycles*/ 0.001,
+        /*dutyCyclePeriod*/ 20,
+        /*boostStrength*/ 2.0,
+        /*seed*/ 1,
+        /*spVerbosity*/ 0,
+        /*wrapAround*/ wrapAround,
+        /*numThreads*/ 1);
+    SpatialPooler sp2 = sp1;
+    sp2.setNumThreads(4);
+
+    UInt numInputs = sp1.getNumInputs();
+    UInt numColumns = sp1.getNumColumns();
+    vector<UInt> input(numInputs);
+    vector<UInt> active1(numColumns);
+    vector<UInt> active2(numColumns);
+    Random rng(42);
+
+    for (UInt i = 0; i < 100; i++) {
+      ASSERT_LE(sp1.getInhibitionRadius(), 3u);
+      ASSERT_EQ(sp1.getInhibitionRadius(), sp2.getInhibitionRadius());
+
+      for (UInt j = 0; j < numInputs; j++) {
+        input[j] = rng.getUInt32(20) == 0 ? 1 : 0;
+      }
+      sp1.compute(input.data(), true, active1.data());
+      sp2.compute(input.data(), true, active2.data());
+      ASSERT_EQ(active1, active2) << "iteration " << i;
+
+      // Global inhibition over the whole layer would pick only a handful.
+      ASSERT_GT(countNonzero(active1), 20u) << "iteration " << i;
+    }
+
+    ASSERT_NO_FATAL_FAILURE(check_spatial_eq(sp1, sp2));
+  }
+}
+
+TEST(SpatialPoolerTest, testSparseComputeMatchesDense) {
+  for (bool globalInhibition : {true, false}) {
+    SpatialPooler sp1(
+        /*inputDimensions*/ {32, 32},
+        /*columnDimensions*/ {16, 16},
+        /*potentialRadius*/ 8,
+        /*potentialPct*/ 0.5,
+        /*globalInhibition*/ globalInhibition,
+        /*localAreaDensity*/ -1.0,
+        /*numActiveColumnsPerInhArea*/ 10,
+        /*stimulusThreshold*/ 2,
+        /*synPermInactiveDec*/ 0.008,
+        /*synPermActiveInc*/ 0.05,
+        /*synPermConnected*/ 0.1,
+        /*minPctOverlapDutyCycles*/ 0.001,
+        /*dutyCyclePeriod*/ 20,
+        /*boostStrength*/ 2.0,
+        /*seed*/ 1,
+        /*spVerbosity*/ 0,
+        /*wrapAround*/ true);
+    SpatialPooler sp2 = sp1;
+
+    UInt numInputs = sp1.getNumInputs();
+    UInt numColumns = sp1.getNumColumns();
+    vector<UInt> input(numInputs);
+    vector<UInt> activeInputs;
+    vector<UInt> active1(numColumns);
+    vector<UInt> active2(numColumns);
+    Random rng(42);
+
+    for (UInt i = 0; i < 100; i++) {
+      activeInputs.clear();
+      for (UInt j = 0; j < numInputs; j++) {
+        input[j] = rng.getUInt32(20) == 0 ? 1 : 0;
+        if (input[j]) {
+          activeInputs.push_back(j);
+        }
+      }
+      bool learn = i % 10 != 9;
+      sp1.compute(input.data(), learn, active1.data());
+      sp2.compute(activeInputs.size(), activeInputs.data(), learn,
+                  active2.data());
+      ASSERT_EQ(active1, active2) << "iteration " << i;
+      ASSERT_EQ(sp1.getOverlaps(), sp2.getOverlaps()) << "iteration " << i;
+    }
+
+    ASSERT_NO_FATAL_FAILURE(check_spatial_eq(sp1, sp2));
+
+    // Permanences outside the potential pool still count as connected.
+    vector<Real> perm(numInputs, 0);
+    perm[0] = 0.5;
+    perm[numInputs - 1] = 0.5;
+    sp1.setPermanence(3, perm.data());
+    sp2.setPermanence(3, perm.data());
+    for (UInt i = 0; i < 20; i++) {
+      activeInputs.clear();
+      for (UInt j = 0; j < numInputs; j++) {
+        input[j] = (j == 0 || j == numInputs - 1 || rng.getUInt32(20) == 0);
+        if (input[j]) {
+          activeInputs.push_back(j);
+        }
+      }
+      sp1.compute(input.data(), true, active1.data());
+      sp2.compute(activeInputs.size(), activeInputs.data(), true,
+                  active2.data());
+      ASSERT_EQ(active1, active2) << "iteration " << i;
+    }
+
+    ASSERT_NO_FATAL_FAILURE(check_spatial_eq(sp1, sp2));
+  }
+}
+
+TEST(SpatialPoolerTest, testSparseComputeRejectsInvalidInput) {
+  SpatialPooler sp;
+  setup(sp, 10, 10);
+  vector<UInt> active(sp.getNumColumns());
+
+  vector<UInt> unsorted = {3, 1};
+  EXPECT_THROW(sp.compute(unsorted.size(), unsorted.data(), true,
+                          active.data()),
+               nupic::LoggingException);
+
+  vector<UInt> duplicate = {1, 1};
+  EXPECT_THROW(sp.compute(duplicate.size(), duplicate.data(), true,
+                          active.data()),
+               nupic::LoggingException);
+
+  vector<UInt> outOfRange = {2, 10};
+  EXPECT_THROW(sp.compute(outOfRange.size(), outOfRange.data(), true,
+                          active.data()),
+               nupic::LoggingException);
+}
+
 } // end anonymous namespace
@@ -0,0 +1,133 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of unit tests for TemporalMemoryBatch
+ */
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include <nupic/algorithms/TemporalMemory.hpp>
+#include <nupic/algorithms/TemporalMemoryBatch.hpp>
+#include <nupic/utils/Random.hpp>
+
+using namespace nupic;
+using namespace nupic::algorithms::temporal_memory;
+using namespace std;
+
+namespace {
+
+TemporalMemory makePrototype() {
+  return TemporalMemory(
+      /*columnDimensions*/ {64},
+      /*cellsPerColumn*/ 4,
+      /*activationThreshold*/ 3,
+      /*initialPermanence*/ 0.21,
+      /*connectedPermanence*/ 0.50,
+      /*minThreshold*/ 2,
+      /*maxNewSynapseCount*/ 4,
+      /*permanenceIncrement*/ 0.10,
+      /*permanenceDecrement*/ 0.10,
+      /*predictedSegmentDecrement*/ 0.02,
+      /*seed*/ 42);
+}
+
+// A repeating sequence of sorted random SDRs for each stream
+vector<vector<vector<UInt>>> makeSequences(UInt numStreams) {
+  Random rng(7);
+  vector<vector<vector<UInt>>> sequences(numStreams);
+  for (auto &sequence : sequences) {
+    for (UInt i = 0; i < 6; i++) {
+      set<UInt> sdr;
+      while (sdr.size() < 5) {
+        sdr.insert(rng.getUInt32(64));
+      }
+      sequence.push_back(vector<UInt>(sdr.begin(), sdr.end()));
+    }
+  }
+  return sequences;
+}
+
+TEST(TemporalMemoryBatchTest, testComputeMatchesStandalone) {
+  const UInt numStreams = 5;
+  const TemporalMemory prototype = makePrototype();
+  const vector<vector<vector<UInt>>> sequences = makeSequences(numStreams);
+
+  TemporalMemoryBatch batch(prototype, numStreams, 3);
+  ASSERT_EQ(numStreams, batch.getBatchSize());
+  ASSERT_EQ(3u, batch.getNumThreads());
+
+  vector<TemporalMemory> standalone(numStreams, prototype);
+  for (UInt stream = 0; stream < numStreams; stream++) {
+    batch.getStream(stream).seed_(stream + 1);
+    standalone[stream].seed_(stream + 1);
+  }
+
+  vector<size_t> sizes(numStreams);
+  vector<const UInt *> columns(numStreams);
+  for (UInt step = 0; step < 60; step++) {
+    for (UInt stream = 0; stream < numStreams; stream++) {
+      const vector<UInt> &sdr = sequences[stream][step % 6];
+      sizes[stream] = sdr.size();
+      columns[stream] = sdr.data();
+      standalone[stream].compute(sdr.size(), sdr.data(), true);
+    }
+    batch.compute(sizes.data(), columns.data(), true);
+
+    for (UInt stream = 0; stream < numStreams; stream++) {
+      const TemporalMemory &tm = batch.getStream(stream);
+      ASSERT_EQ(standalone[stream].getActiveCells(), tm.getActiveCells());
+      ASSERT_EQ(standalone[stream].getPredictiveCells(),
+                tm.getPredictiveCells());
+    }
+  }
+
+  for (UInt stream = 0; stream < numStreams; stream++) {
+    ASSERT_TRUE(standalone[stream] == batch.getStream(stream));
+    ASSERT_GT(batch.getStream(stream).getPredictiveCells().size(), 0u);
+  }
+
+  batch.reset();
+  for (UInt stream = 0; stream < numStreams; stream++) {
+    ASSERT_TRUE(batch.getStream(stream).getActiveCells().empty());
+  }
+}
+
+TEST(TemporalMemoryBatchTest, testInvalidArguments) {
+  TemporalMemoryBatch batch(makePrototype(), 2);
+  ASSERT_EQ(1u, batch.getNumThreads());
+  EXPECT_THROW(batch.getStream(2), exception);
+  EXPECT_THROW(batch.setNumThreads(0), exception);
+
+  // Errors from a stream reach the caller
+  const UInt unsorted[] = {3, 1};
+  const UInt sorted[] = {1, 3};
+  const size_t sizes[] = {2, 2};
+  const UInt *const columns[] = {sorted, unsorted};
+  batch.setNumThreads(2);
+  EXPECT_THROW(batch.compute(sizes, columns), exception);
+}
+
+} // end namespace
@@ -28,6 +28,7 @@
 #include <fstream>
 #include <nupic/math/StlIo.hpp>
 #include <nupic/types/Types.hpp>
+#include <nupic/utils/BinaryStream.hpp>
 #include <nupic/utils/Log.hpp>
 #include <stdio.h>
 
@@ -135,6 +136,62 @@ TEST(TemporalMemoryTest, ActivateCorrectlyPredictiveCells) {
   EXPECT_EQ(expectedActiveCells, tm.getActiveCells());
 }
 
+/**
+ * Active and matching segments are listed in cell order and are recomputed
+ * from scratch each step, including when activationThreshold has been set
+ * below minThreshold.
+ */
+TEST(TemporalMemoryTest, ActiveAndMatchingSegmentsInCellOrder) {
+  TemporalMemory tm(
+      /*columnDimensions*/ {32},
+      /*cellsPerColumn*/ 4,
+      /*activationThreshold*/ 3,
+      /*initialPermanence*/ 0.21,
+      /*connectedPermanence*/ 0.50,
+      /*minThreshold*/ 2,
+      /*maxNewSynapseCount*/ 3,
+      /*permanenceIncrement*/ 0.10,
+      /*permanenceDecrement*/ 0.10,
+      /*predictedSegmentDecrement*/ 0.0,
+      /*seed*/ 42);
+
+  const UInt numActiveColumns = 1;
+  const UInt column0[1] = {0};
+  const UInt column3[1] = {3};
+
+  // Created out of cell order
+  Segment segment9 = tm.createSegment(9);
+  tm.connections.createSynapse(segment9, 0, 0.5);
+  tm.connections.createSynapse(segment9, 1, 0.5);
+  tm.connections.createSynapse(segment9, 2, 0.5);
+  Segment segment4 = tm.createSegment(4);
+  tm.connections.createSynapse(segment4, 0, 0.5);
+  tm.connections.createSynapse(segment4, 1, 0.5);
+  tm.connections.createSynapse(segment4, 2, 0.2);
+  Segment segment6 = tm.createSegment(6);
+  tm.connections.createSynapse(segment6, 1, 0.5);
+  tm.connections.createSynapse(segment6, 2, 0.5);
+  tm.connections.createSynapse(segment6, 3, 0.5);
+
+  tm.compute(numActiveColumns, column0, false);
+  EXPECT_EQ(vector<Segment>({segment6, segment9}), tm.getActiveSegments());
+  EXPECT_EQ(vector<Segment>({segment4, segment6, segment9}),
+            tm.getMatchingSegments());
+
+  tm.compute(numActiveColumns, column3, false);
+  EXPECT_TRUE(tm.getActiveSegments().empty());
+  EXPECT_TRUE(tm.getMatchingSegments().empty());
+
+  tm.setActivationThreshold(2);
+  tm.setMinThreshold(3);
+  tm.compute(numActiveColumns, column0, false);
+  EXPECT_EQ(vector<Segment>({segment4, segment6, segment9}),
+            tm.getActiveSegments());
+  EXPECT_EQ(vector<Segment>({segment4, segment6, segment9}),
+            tm.getMatchingSegments());
+  EXPECT_EQ(vector<CellIdx>({4, 6, 9}), tm.getPredictiveCells());
+}
+
 /**
  * When an unpredicted column is activated, every cell in the column should
  * become active.
@@ -1515,6 +1572,78 @@ TEST(TemporalMemoryTest, testSaveLoad) {
   serializationTestVerify(tm2);
 }
 
+TEST(TemporalMemoryTest, testSaveLoadBinary) {
+  const char *filename = "TemporalMemoryBinary.tmp";
+  TemporalMemory tm1(
+      /*columnDimensions*/ {32},
+      /*cellsPerColumn*/ 4,
+      /*activationThreshold*/ 3,
+      /*initialPermanence*/ 0.21,
+      /*connectedPermanence*/ 0.50,
+      /*minThreshold*/ 2,
+      /*maxNewSynapseCount*/ 3,
+      /*permanenceIncrement*/ 0.10,
+      /*permanenceDecrement*/ 0.10,
+      /*predictedSegmentDecrement*/ 0.0,
+      /*seed*/ 42);
+
+  serializationTestPrepare(tm1);
+
+  ofstream os(filename, ios::binary);
+  tm1.saveBinary(os);
+  os.close();
+
+  TemporalMemory tm2;
+  tm2.loadBinary(filename);
+
+  ASSERT_TRUE(tm1 == tm2);
+
+  serializationTestVerify(tm2);
+
+  // The loaded TM keeps learning exactly like the original.
+  serializationTestVerify(tm1);
+  ASSERT_TRUE(tm1 == tm2);
+
+  int ret = ::remove(filename);
+  NTA_CHECK(ret == 0) << "Failed to delete " << filename;
+}
+
+/**
+ * A snapshot whose cell count disagrees with its dimensions throws.
+ */
+TEST(TemporalMemoryTest, testLoadBinaryCellCountMismatch) {
+  TemporalMemory tm1(
+      /*columnDimensions*/ {32},
+      /*cellsPerColumn*/ 4,
+      /*activationThreshold*/ 3,
+      /*initialPermanence*/ 0.21,
+      /*connectedPermanence*/ 0.50,
+      /*minThreshold*/ 2,
+      /*maxNewSynapseCount*/ 3,
+      /*permanenceIncrement*/ 0.10,
+      /*permanenceDecrement*/ 0.10,
+      /*predictedSegmentDecrement*/ 0.0,
+      /*seed*/ 42);
+  serializationTestPrepare(tm1);
+
+  stringstream ss;
+  tm1.saveBinary(ss);
+  string snapshot = ss.str();
+
+  // cellsPerColumn follows the marker, the version and the one-element
+  // columnDimensions vector.
+  const size_t offset = 8 + sizeof(UInt32) + sizeof(UInt64) + sizeof(UInt32);
+  UInt32 cellsPerColumn;
+  memcpy(&cellsPerColumn, &snapshot[offset], sizeof(UInt32));
+  ASSERT_EQ(4u, cellsPerColumn);
+  cellsPerColumn = 2;
+  memcpy(&snapshot[offset], &cellsPerColumn, sizeof(UInt32));
+
+  TemporalMemory tm2;
+  nupic::util::BinaryReader reader(snapshot.data(), snapshot.size());
+  EXPECT_THROW(tm2.loadBinary(reader), std::exception);
+}
+
 TEST(TemporalMemoryTest, testWrite) {
   TemporalMemory tm1(
       /*columnDimensions*/ {32},
@@ -1543,6 +1672,51 @@ TEST(TemporalMemoryTest, testWrite) {
   serializationTestVerify(tm2);
 }
 
+/**
+ * A segment with a few active synapses, but fewer than minThreshold, is
+ * neither active nor matching. After a write/read round trip it must still
+ * become matching once enough of its synapses are active.
+ */
+TEST(TemporalMemoryTest, testWriteSubThresholdSegment) {
+  TemporalMemory tm1(
+      /*columnDimensions*/ {32},
+      /*cellsPerColumn*/ 4,
+      /*activationThreshold*/ 3,
+      /*initialPermanence*/ 0.21,
+      /*connectedPermanence*/ 0.50,
+      /*minThreshold*/ 2,
+      /*maxNewSynapseCount*/ 3,
+      /*permanenceIncrement*/ 0.10,
+      /*permanenceDecrement*/ 0.10,
+      /*predictedSegmentDecrement*/ 0.0,
+      /*seed*/ 42);
+
+  // Cell 4 is in column 1, cells 0-3 in column 0 and 8-11 in column 2.
+  Segment segment = tm1.createSegment(4);
+  tm1.connections.createSynapse(segment, 0, 0.3);
+  tm1.connections.createSynapse(segment, 8, 0.3);
+
+  const UInt column0[1] = {0};
+  tm1.compute(1, column0, false);
+  ASSERT_TRUE(tm1.getMatchingSegments().empty());
+
+  stringstream ss;
+  tm1.write(ss);
+  TemporalMemory tm2;
+  tm2.read(ss);
+
+  const UInt columns02[2] = {0, 2};
+  tm1.compute(2, columns02, false);
+  tm2.compute(2, columns02, false);
+  tm1.compute(2, columns02, false);
+  tm2.compute(2, columns02, false);
+
+  ASSERT_EQ(1, tm1.getMatchingSegments().size());
+  EXPECT_EQ(tm1.getMatchingSegments().size(),
+            tm2.getMatchingSegments().size());
+  ASSERT_TRUE(tm1 == tm2);
+}
+
 // Uncomment these tests individually to save/load from a file.
 // This is useful for ad-hoc testing of backwards-compatibility.
 
@@ -116,31 +116,24 @@ TEST(InputTest, SplitterMap) {
   ASSERT_EQ(0u, in1->evaluateLinks());
   ASSERT_EQ(0u, in2->evaluateLinks());
 
+  // a single undelayed link shares the output buffer
+  ASSERT_FALSE(in1->isZeroCopy());
+  ASSERT_TRUE(in2->isZeroCopy());
+  ASSERT_EQ(out1->getData().getBuffer(), in2->getData().getBuffer());
+  ASSERT_EQ(1u, net.getZeroCopyLinkCount());
+
   // test prepare
   {
-    // set in2 to all zeroes
-    const ArrayBase *ai2 = &(in2->getData());
-    Real64 *idata = (Real64 *)(ai2->getBuffer());
-    for (UInt i = 0; i < 64; i++)
-      idata[i] = 0;
-
     // set out1 to all 10's
     const ArrayBase *ao1 = &(out1->getData());
-    idata = (Real64 *)(ao1->getBuffer());
+    Real64 *idata = (Real64 *)(ao1->getBuffer());
     for (UInt i = 0; i < 64; i++)
       idata[i] = 10;
 
-    // confirm that in2 is still all zeroes
-    ai2 = &(in2->getData());
-    idata = (Real64 *)(ai2->getBuffer());
-    // only test 4 instead of 64 to cut down on number of tests
-    for (UInt i = 0; i < 4; i++)
-      ASSERT_EQ(0, idata[i]);
-
     in2->prepare();
 
     // confirm that in2 is now all 10's
-    ai2 = &(in2->getData());
+    const ArrayBase *ai2 = &(in2->getData());
     idata = (Real64 *)(ai2->getBuffer());
     // only test 4 instead of 64 to cut down on number of tests
     for (UInt i = 0; i < 4; i++)
@@ -201,6 +194,10 @@ TEST(InputTest, LinkTwoRegionsOneInput) {
   Dimensions d3 = region3->getDimensions();
   Input *in3 = region3->getInput("bottomUpIn");
 
+  // two links are concatenated into a buffer of the input's own
+  ASSERT_FALSE(in3->isZeroCopy());
+  ASSERT_EQ(0u, net.getZeroCopyLinkCount());
+
   ASSERT_EQ(2u, d3.size());
   ASSERT_EQ(4u, d3[0]);
   ASSERT_EQ(2u, d3[1]);
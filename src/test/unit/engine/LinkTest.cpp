@@ -163,6 +163,9 @@ TEST(LinkTest, DelayedLink) {
   ASSERT_EQ(0u, in1->evaluateLinks());
   ASSERT_EQ(0u, in2->evaluateLinks());
 
+  // delayed links always copy
+  ASSERT_FALSE(in2->isZeroCopy());
+
   // set in2 to all 1's, to detect if net.run fails to update the input.
   {
     const ArrayBase *ai2 = &(in2->getData());
@@ -1084,3 +1087,246 @@ TEST(LinkTest, SingleL4RegionWithDelayedLoopbackInAndPhaseOnOffOn) {
   ASSERT_EQ(2u, r1OutBuf[1]); // feedbackIn from R3; delay=1
   ASSERT_EQ(3u, r1OutBuf[0]); // out (1 + feedbackIn)
 }
+
+/*
+ * Region with region-level sparse and dense inputs and outputs of eight
+ * elements. Its compute() does nothing so tests can set the outputs.
+ */
+class SparseTestRegion : public TestRegionBase {
+public:
+  SparseTestRegion(const ValueMap &params, Region *region)
+      : TestRegionBase(params, region) {}
+
+  SparseTestRegion(BundleIO &bundle, Region *region)
+      : TestRegionBase(bundle, region) {}
+
+  SparseTestRegion(capnp::AnyPointer::Reader &proto, Region *region)
+      : TestRegionBase(proto, region) {}
+
+  virtual ~SparseTestRegion() {}
+
+  std::string getNodeType() { return "SparseTestRegion"; }
+
+  // Used by RegionImplFactory to create and cache
+  // a nodespec. Ownership is transferred to the caller.
+  static Spec *createSpec() {
+    auto ns = new Spec;
+
+    /* ----- inputs ------- */
+    ns->inputs.add("sparseIn", InputSpec("Sparse input", NTA_BasicType_UInt32,
+                                         0,     // count
+                                         false, // required?
+                                         true,  // isRegionLevel
+                                         false, // isDefaultInput
+                                         false, // requireSplitterMap
+                                         true   // sparse
+                                         ));
+
+    ns->inputs.add("denseIn", InputSpec("Dense input", NTA_BasicType_Real32,
+                                        0,     // count
+                                        false, // required?
+                                        true,  // isRegionLevel
+                                        false, // isDefaultInput
+                                        false  // requireSplitterMap
+                                        ));
+
+    /* ----- outputs ------ */
+    ns->outputs.add("sparseOut", OutputSpec("Sparse output",
+                                            NTA_BasicType_UInt32,
+                                            8,     // count
+                                            true,  // isRegionLevel
+                                            false, // isDefaultOutput
+                                            true   // sparse
+                                            ));
+
+    ns->outputs.add("denseOut", OutputSpec("Dense output",
+                                           NTA_BasicType_Real32,
+                                           8,     // count
+                                           true,  // isRegionLevel
+                                           false  // isDefaultOutput
+                                           ));
+
+    return ns;
+  }
+
+  void initialize() override {}
+
+  void compute() override {}
+
+private:
+  SparseTestRegion();
+};
+
+static void setSparseOutput(Region *region,
+                            const std::vector<UInt32> &indices) {
+  Array &data =
+      const_cast<Array &>(region->getOutput("sparseOut")->getData());
+  std::copy(indices.begin(), indices.end(), (UInt32 *)data.getBuffer());
+  data.setCount(indices.size());
+}
+
+static std::vector<UInt32> getSparseInput(Region *region) {
+  const Array &data = region->getInput("sparseIn")->getData();
+  const UInt32 *buffer = (const UInt32 *)data.getBuffer();
+  return std::vector<UInt32>(buffer, buffer + data.getCount());
+}
+
+TEST(LinkTest, SparseLinks) {
+  Network net;
+
+  RegionImplFactory::registerCPPRegion(
+      "SparseTestRegion", new RegisteredRegionImpl<SparseTestRegion>());
+  Region *src1 = net.addRegion("src1", "SparseTestRegion", "");
+  Region *src2 = net.addRegion("src2", "SparseTestRegion", "");
+  Region *single = net.addRegion("single", "SparseTestRegion", "");
+  Region *merged = net.addRegion("merged", "SparseTestRegion", "");
+  RegionImplFactory::unregisterCPPRegion("SparseTestRegion");
+
+  Dimensions d;
+  d.push_back(1);
+  src1->setDimensions(d);
+  src2->setDimensions(d);
+  single->setDimensions(d);
+  merged->setDimensions(d);
+
+  // single: sparse -> sparse and sparse -> dense
+  net.link("src1", "single", "UniformLink", "", "sparseOut", "sparseIn");
+  net.link("src1", "single", "UniformLink", "", "sparseOut", "denseIn");
+
+  // merged: two sparse links into each input, one converted from dense
+  net.link("src1", "merged", "UniformLink", "", "sparseOut", "sparseIn");
+  net.link("src2", "merged", "UniformLink", "", "denseOut", "sparseIn");
+  net.link("src1", "merged", "UniformLink", "", "sparseOut", "denseIn");
+  net.link("src2", "merged", "UniformLink", "", "sparseOut", "denseIn");
+
+  net.initialize();
+
+  ASSERT_TRUE(single->getInput("sparseIn")->isZeroCopy());
+  ASSERT_FALSE(single->getInput("denseIn")->isZeroCopy());
+  ASSERT_EQ(1u, net.getZeroCopyLinkCount());
+
+  setSparseOutput(src1, {1, 5});
+  setSparseOutput(src2, {2});
+  Real32 *src2Dense = (Real32 *)src2->getOutput("denseOut")->getData().getBuffer();
+  std::fill(src2Dense, src2Dense + 8, 0.0f);
+  src2Dense[0] = 0.5f;
+  src2Dense[7] = -3.0f;
+
+  net.run(1);
+
+  ASSERT_EQ(std::vector<UInt32>({1, 5}), getSparseInput(single));
+  ASSERT_EQ(std::vector<UInt32>({1, 5, 8, 15}), getSparseInput(merged));
+
+  const Array &singleDense = single->getInput("denseIn")->getData();
+  ASSERT_EQ(8u, singleDense.getCount());
+  const Real32 *buffer = (const Real32 *)singleDense.getBuffer();
+  ASSERT_EQ(std::vector<Real32>({0, 1, 0, 0, 0, 1, 0, 0}),
+            std::vector<Real32>(buffer, buffer + 8));
+
+  const Array &mergedDense = merged->getInput("denseIn")->getData();
+  ASSERT_EQ(16u, mergedDense.getCount());
+  buffer = (const Real32 *)mergedDense.getBuffer();
+  ASSERT_EQ(std::vector<Real32>({0, 1, 0, 0, 0, 1, 0, 0,
+                                 0, 0, 1, 0, 0, 0, 0, 0}),
+            std::vector<Real32>(buffer, buffer + 16));
+
+  // Every run rebuilds the inputs rather than accumulating
+  setSparseOutput(src1, {});
+  setSparseOutput(src2, {6});
+  src2Dense[0] = 0;
+
+  net.run(1);
+
+  ASSERT_EQ(std::vector<UInt32>(), getSparseInput(single));
+  ASSERT_EQ(std::vector<UInt32>({15}), getSparseInput(merged));
+  buffer = (const Real32 *)mergedDense.getBuffer();
+  ASSERT_EQ(std::vector<Real32>({0, 0, 0, 0, 0, 0, 0, 0,
+                                 0, 0, 0, 0, 0, 0, 1, 0}),
+            std::vector<Real32>(buffer, buffer + 16));
+}
+
+/*
+ * A delayed sparse -> dense link keeps the dense width of its source after
+ * a capnp round trip, although its deserialized delay buffers only hold the
+ * saved indices.
+ */
+TEST(LinkTest, DelayedSparseLinkCapnpSerialization) {
+  RegionImplFactory::registerCPPRegion(
+      "SparseTestRegion", new RegisteredRegionImpl<SparseTestRegion>());
+
+  Network net;
+  Region *src = net.addRegion("src", "SparseTestRegion", "");
+  Region *dest = net.addRegion("dest", "SparseTestRegion", "");
+  Dimensions d;
+  d.push_back(1);
+  src->setDimensions(d);
+  dest->setDimensions(d);
+  net.link("src", "dest", "UniformLink", "", "sparseOut", "denseIn",
+           1 /*propagationDelay*/);
+  net.initialize();
+
+  setSparseOutput(src, {1, 5});
+  net.run(1);
+
+  std::stringstream ss;
+  net.write(ss);
+  Network net2;
+  net2.read(ss);
+  net2.initialize();
+  setSparseOutput(net2.getRegions().getByName("src"), {});
+  net2.run(1);
+
+  RegionImplFactory::unregisterCPPRegion("SparseTestRegion");
+
+  const Array &dense =
+      net2.getRegions().getByName("dest")->getInput("denseIn")->getData();
+  ASSERT_EQ(8u, dense.getCount());
+  const Real32 *buffer = (const Real32 *)dense.getBuffer();
+  ASSERT_EQ(std::vector<Real32>({0, 1, 0, 0, 0, 1, 0, 0}),
+            std::vector<Real32>(buffer, buffer + 8));
+}
+
+/*
+ * ScalarSensor's sparse output carries the same encoding as its dense one,
+ * whether it reaches a sparse or a dense input.
+ */
+TEST(LinkTest, ScalarSensorSparseEncoded) {
+  RegionImplFactory::registerCPPRegion(
+      "SparseTestRegion", new RegisteredRegionImpl<SparseTestRegion>());
+
+  Network net;
+  Region *sensor = net.addRegion(
+      "sensor", "ScalarSensor", "{n: 8, w: 3, minValue: 0, maxValue: 10}");
+  Region *dest = net.addRegion("dest", "SparseTestRegion", "");
+  RegionImplFactory::unregisterCPPRegion("SparseTestRegion");
+
+  Dimensions d;
+  d.push_back(1);
+  dest->setDimensions(d);
+  net.link("sensor", "dest", "UniformLink", "", "sparseEncoded", "sparseIn");
+  net.link("sensor", "dest", "UniformLink", "", "sparseEncoded", "denseIn");
+  net.initialize();
+
+  for (Real64 value : {0.0, 4.0, 10.0}) {
+    sensor->setParameterReal64("sensedValue", value);
+    net.run(1);
+
+    const Array &encoded = sensor->getOutput("encoded")->getData();
+    const Real32 *expected = (const Real32 *)encoded.getBuffer();
+    ASSERT_EQ(8u, encoded.getCount());
+
+    const Array &dense = dest->getInput("denseIn")->getData();
+    const Real32 *actual = (const Real32 *)dense.getBuffer();
+    ASSERT_EQ(std::vector<Real32>(expected, expected + 8),
+              std::vector<Real32>(actual, actual + 8));
+
+    std::vector<UInt32> indices;
+    for (UInt32 i = 0; i < 8; i++) {
+      if (expected[i] != 0) {
+        indices.push_back(i);
+      }
+    }
+    ASSERT_EQ(3u, indices.size());
+    ASSERT_EQ(indices, getSparseInput(dest));
+  }
+}
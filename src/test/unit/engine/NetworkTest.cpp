@@ -24,12 +24,18 @@
  * Implementation of Network test
  */
 
+#include <fstream>
+#include <iterator>
+#include <map>
+
 #include "gtest/gtest.h"
 
 #include <nupic/engine/Network.hpp>
 #include <nupic/engine/NuPIC.hpp>
 #include <nupic/engine/Region.hpp>
+#include <nupic/ntypes/ArrayRef.hpp>
 #include <nupic/ntypes/Dimensions.hpp>
+#include <nupic/os/Path.hpp>
 #include <nupic/utils/Log.hpp>
 
 using namespace nupic;
@@ -578,3 +584,331 @@ TEST(NetworkTest, testEqualsOperator) {
   n2.run(1);
   ASSERT_TRUE(n1 == n2);
 }
+
+/**
+ * Incremental checkpoints append only the dirty regions, and loading one
+ * restores the latest state of every region, before and after compaction.
+ */
+TEST(NetworkTest, IncrementalCheckpoint) {
+  const std::string path = "NetworkTest_checkpoint.ntc";
+  if (Path::exists(path))
+    Path::remove(path);
+
+  Network net;
+  Dimensions d;
+  d.push_back(4);
+  d.push_back(4);
+  Region *l1 = net.addRegion("level1", "TestNode", "");
+  Region *l2 = net.addRegion("level2", "TestNode", "");
+  l1->setDimensions(d);
+  net.link("level1", "level2", "TestFanIn2", "");
+  net.initialize();
+  EXPECT_TRUE(l1->isStateDirty());
+  EXPECT_TRUE(l2->isStateDirty());
+
+  net.checkpoint(path);
+  EXPECT_FALSE(l1->isStateDirty());
+  EXPECT_FALSE(l2->isStateDirty());
+  const Size baseSize = Path::getFileSize(path);
+
+  // Only level2 is saved
+  l2->setParameterInt32("int32Param", 42);
+  EXPECT_FALSE(l1->isStateDirty());
+  EXPECT_TRUE(l2->isStateDirty());
+  net.checkpoint(path);
+  EXPECT_FALSE(l2->isStateDirty());
+  const Size deltaSize = Path::getFileSize(path) - baseSize;
+  EXPECT_LT(deltaSize, baseSize);
+
+  // Nothing is dirty, so the record is empty
+  net.checkpoint(path);
+  EXPECT_LT(Path::getFileSize(path) - baseSize - deltaSize, deltaSize);
+
+  net.run(2);
+  EXPECT_TRUE(l1->isStateDirty());
+  EXPECT_TRUE(l2->isStateDirty());
+  l1->setParameterInt32("int32Param", 7);
+  net.checkpoint(path);
+
+  {
+    Network loaded;
+    loaded.loadCheckpoint(path);
+    ASSERT_EQ(2, loaded.getRegions().getCount());
+    Region *r1 = loaded.getRegions().getByName("level1");
+    Region *r2 = loaded.getRegions().getByName("level2");
+    EXPECT_EQ(7, r1->getParameterInt32("int32Param"));
+    EXPECT_EQ(42, r2->getParameterInt32("int32Param"));
+    EXPECT_EQ(1, loaded.getLinks().getCount());
+    EXPECT_FALSE(r1->isStateDirty());
+  }
+
+  const Size uncompactedSize = Path::getFileSize(path);
+  Network::compactCheckpoint(path);
+  EXPECT_LT(Path::getFileSize(path), uncompactedSize);
+
+  {
+    Network loaded;
+    loaded.loadCheckpoint(path);
+    Region *r1 = loaded.getRegions().getByName("level1");
+    EXPECT_EQ(7, r1->getParameterInt32("int32Param"));
+    EXPECT_EQ(42, loaded.getRegions().getByName("level2")->getParameterInt32(
+                      "int32Param"));
+
+    // Keep appending to the file the network was loaded from
+    r1->setParameterInt32("int32Param", 9);
+    loaded.checkpoint(path);
+  }
+
+  {
+    Network loaded;
+    loaded.loadCheckpoint(path);
+    EXPECT_EQ(9, loaded.getRegions().getByName("level1")->getParameterInt32(
+                     "int32Param"));
+  }
+
+  // A structural change starts a new base record
+  net.addRegion("level3", "TestNode", "");
+  net.checkpoint(path);
+  {
+    Network loaded;
+    loaded.loadCheckpoint(path);
+    EXPECT_EQ(3, loaded.getRegions().getCount());
+    EXPECT_EQ(7, loaded.getRegions().getByName("level1")->getParameterInt32(
+                     "int32Param"));
+  }
+
+  Path::remove(path);
+}
+
+static void expectSameLevel2Output(Network &expected, Network &actual) {
+  ArrayRef e =
+      expected.getRegions().getByName("level2")->getOutputData("bottomUpOut");
+  ArrayRef a =
+      actual.getRegions().getByName("level2")->getOutputData("bottomUpOut");
+  ASSERT_EQ(e.getCount(), a.getCount());
+  for (size_t i = 0; i < e.getCount(); i++) {
+    ASSERT_EQ(((const Real64 *)e.getBuffer())[i],
+              ((const Real64 *)a.getBuffer())[i])
+        << "[" << i << "]";
+  }
+}
+
+/**
+ * Delay buffers change on every run without dirtying a region, so delta
+ * records carry them. A last record cut short by a crash is dropped when
+ * the checkpoint is loaded.
+ */
+TEST(NetworkTest, CheckpointDelayedLink) {
+  const std::string path = "NetworkTest_delayed.ntc";
+  if (Path::exists(path))
+    Path::remove(path);
+
+  Network net;
+  Dimensions d;
+  d.push_back(4);
+  d.push_back(4);
+  net.addRegion("level1", "TestNode", "")->setDimensions(d);
+  net.addRegion("level2", "TestNode", "");
+  net.link("level1", "level2", "TestFanIn2", "", "", "",
+           /*propagationDelay*/ 2);
+  net.initialize();
+
+  net.checkpoint(path);
+  net.run(3);
+  net.checkpoint(path);
+
+  Network loaded;
+  loaded.loadCheckpoint(path);
+  net.run(1);
+  loaded.run(1);
+  expectSameLevel2Output(net, loaded);
+
+  net.checkpoint(path);
+  const Size completeSize = Path::getFileSize(path);
+  net.run(1);
+  net.checkpoint(path);
+  std::string contents;
+  {
+    std::ifstream f(path.c_str(), std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(f),
+                    std::istreambuf_iterator<char>());
+  }
+  {
+    const size_t tornSize = (completeSize + contents.size()) / 2 + 3;
+    std::ofstream f(path.c_str(), std::ios::binary | std::ios::trunc);
+    f.write(contents.data(), tornSize);
+  }
+
+  Network torn;
+  torn.loadCheckpoint(path);
+  loaded.run(1);
+  torn.run(1);
+  expectSameLevel2Output(loaded, torn);
+
+  // The rewritten file takes new records again
+  torn.run(1);
+  torn.checkpoint(path);
+  {
+    Network reloaded;
+    reloaded.loadCheckpoint(path);
+    reloaded.run(1);
+    torn.run(1);
+    expectSameLevel2Output(torn, reloaded);
+  }
+
+  Path::remove(path);
+}
+
+// Six independent level1 -> level2 -> level3 stacks, one phase per level,
+// optionally plus a region linked to level2_0 within phase 1. Regions in a
+// phase run in an order that differs between networks, so only networks
+// without the sibling compute the same outputs.
+static void buildStacks(Network &net, bool withSibling) {
+  for (UInt32 stack = 0; stack < 6; stack++) {
+    Dimensions d;
+    d.push_back(4 * (stack + 1));
+    d.push_back(4);
+    const std::string suffix = "_" + std::to_string(stack);
+    for (UInt32 level = 1; level <= 3; level++) {
+      const std::string name = "level" + std::to_string(level) + suffix;
+      Region *r = net.addRegion(name, "TestNode", "");
+      std::set<UInt32> phases;
+      phases.insert(level - 1);
+      net.setPhases(name, phases);
+      if (level == 1) {
+        r->setDimensions(d);
+      } else {
+        net.link("level" + std::to_string(level - 1) + suffix, name,
+                 "TestFanIn2", "");
+      }
+    }
+  }
+
+  if (!withSibling) {
+    return;
+  }
+
+  net.addRegion("sibling", "TestNode", "");
+  std::set<UInt32> phases;
+  phases.insert(1);
+  net.setPhases("sibling", phases);
+  net.link("level2_0", "sibling", "TestFanIn2", "");
+}
+
+TEST(NetworkTest, MultithreadedRun) {
+  Network serial;
+  Network parallel;
+  buildStacks(serial, false);
+  buildStacks(parallel, false);
+
+  ASSERT_EQ((UInt32)1, parallel.getNumThreads());
+  parallel.setNumThreads(4);
+  ASSERT_EQ((UInt32)4, parallel.getNumThreads());
+  EXPECT_THROW(parallel.setNumThreads(0), std::exception);
+
+  serial.run(5);
+  parallel.run(5);
+
+  const Collection<Region *> &regions = serial.getRegions();
+  for (size_t i = 0; i < regions.getCount(); i++) {
+    const std::string &name = regions.getByIndex(i).first;
+    ArrayRef expected = regions.getByIndex(i).second->getOutputData(
+        "bottomUpOut");
+    ArrayRef actual =
+        parallel.getRegions().getByName(name)->getOutputData("bottomUpOut");
+    ASSERT_EQ(expected.getCount(), actual.getCount()) << name;
+    const Real64 *expectedBuffer = (const Real64 *)expected.getBuffer();
+    const Real64 *actualBuffer = (const Real64 *)actual.getBuffer();
+    for (size_t j = 0; j < expected.getCount(); j++) {
+      ASSERT_EQ(expectedBuffer[j], actualBuffer[j]) << name << "[" << j << "]";
+    }
+  }
+}
+
+TEST(NetworkTest, MultithreadedRunKeepsLinkedOrder) {
+  Network net;
+  buildStacks(net, true);
+  net.initialize();
+
+  // level2_0 and sibling share phase 1 and a link, so they never run
+  // concurrently and keep their single-threaded order.
+  Region *level2 = net.getRegions().getByName("level2_0");
+  Region *sibling = net.getRegions().getByName("sibling");
+  level2->setParameterUInt64("computeCallback", (UInt64)recordCompute);
+  sibling->setParameterUInt64("computeCallback", (UInt64)recordCompute);
+
+  computeHistory.clear();
+  net.run(2);
+  std::vector<std::string> expected = computeHistory;
+  ASSERT_EQ((size_t)4, expected.size());
+
+  net.setNumThreads(4);
+  computeHistory.clear();
+  net.run(2);
+  ASSERT_EQ(expected, computeHistory);
+  computeHistory.clear();
+}
+
+TEST(NetworkTest, ProfilingSnapshot) {
+  Network net;
+  buildStacks(net, false);
+  net.setNumThreads(4);
+  net.initialize();
+
+  // Nothing is recorded until profiling is enabled
+  net.resetProfiling();
+  net.run(2);
+  EXPECT_TRUE(net.getProfilingSnapshot().empty());
+
+  // A network with the same region names doesn't share the probes
+  Network other;
+  buildStacks(other, false);
+  other.initialize();
+  other.enableProfiling();
+
+  net.enableProfiling();
+  EXPECT_FALSE(Profiler::isEnabled());
+  net.run(3);
+  net.disableProfiling();
+  other.run(1);
+
+  std::map<std::string, ProfileEntry> entries;
+  for (const ProfileEntry &entry : net.getProfilingSnapshot()) {
+    entries[entry.name] = entry;
+  }
+
+  // Region compute runs on the pool threads
+  const ProfileEntry &compute = entries["Region.level2_5.compute"];
+  EXPECT_FALSE(compute.isCounter);
+  EXPECT_EQ(3u, compute.count);
+  EXPECT_LE(compute.p50, compute.p999);
+  EXPECT_EQ(3u, entries["Region.level1_0.prepareInputs"].count);
+
+  // The only link into an input shares the source buffer and copies nothing
+  const ProfileEntry &bytes =
+      entries["Link.level1_0.bottomUpOut-->level2_0.bottomUpIn.bytes"];
+  EXPECT_TRUE(bytes.isCounter);
+  EXPECT_EQ(3u, bytes.count);
+  EXPECT_EQ(0.0, bytes.total);
+
+  for (const ProfileEntry &entry : other.getProfilingSnapshot()) {
+    EXPECT_EQ(1u, entry.count) << entry.name;
+  }
+
+  net.resetProfiling();
+  EXPECT_TRUE(net.getProfilingSnapshot().empty());
+  EXPECT_FALSE(other.getProfilingSnapshot().empty());
+}
+
+TEST(NetworkTest, ProfilingReleasesProbes) {
+  // Each network registers its probes under a new prefix, and releases them
+  // when it is destroyed, so this would run out of probe ids otherwise
+  for (UInt32 i = 0; i < Profiler::MAX_PROBES / 8; i++) {
+    Network net;
+    buildStacks(net, false);
+    net.initialize();
+    net.enableProfiling();
+    net.run(1);
+    EXPECT_FALSE(net.getProfilingSnapshot().empty());
+  }
+}
@@ -0,0 +1,286 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Unit tests for Simd.hpp
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include <nupic/math/Simd.hpp>
+#include <nupic/utils/Random.hpp>
+
+using std::vector;
+using namespace nupic;
+using namespace nupic::simd;
+
+namespace {
+
+// Sizes around every vector width, so that the tails get exercised too
+const vector<UInt32> sizes = {0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 100, 1000};
+
+/**
+ * Runs each test on every level the CPU supports, and compares the
+ * Real32 overloads with the scalar templates.
+ */
+class SimdTest : public ::testing::Test {
+protected:
+  void SetUp() override { initial_ = getLevel(); }
+
+  void TearDown() override { setLevel(initial_); }
+
+  vector<Level> levels() const {
+    vector<Level> levels;
+    for (int level = NONE; level <= getSupportedLevel(); ++level)
+      levels.push_back((Level)level);
+    return levels;
+  }
+
+  vector<Real32> randomValues(UInt32 n, Real32 low, Real32 high) {
+    vector<Real32> x(n);
+    for (UInt32 i = 0; i != n; ++i)
+      x[i] = low + (high - low) * (Real32)rng_.getReal64();
+    return x;
+  }
+
+  // n distinct sorted indices in [0, range)
+  vector<UInt32> randomIndices(UInt32 n, UInt32 range) {
+    vector<UInt32> all(range);
+    std::iota(all.begin(), all.end(), 0);
+    rng_.shuffle(all.begin(), all.end());
+    vector<UInt32> ind(all.begin(), all.begin() + n);
+    std::sort(ind.begin(), ind.end());
+    return ind;
+  }
+
+  Level initial_;
+  Random rng_{42};
+};
+
+TEST_F(SimdTest, SetLevel) {
+  setLevel(NONE);
+  EXPECT_EQ(NONE, getLevel());
+
+  setLevel(AVX512);
+  EXPECT_EQ(getSupportedLevel(), getLevel());
+
+  EXPECT_STREQ("none", getLevelName(NONE));
+  EXPECT_STREQ("AVX-512", getLevelName(AVX512));
+}
+
+TEST_F(SimdTest, SumAtIndices) {
+  const vector<Real32> x = randomValues(2000, -1, 1);
+
+  for (Level level : levels()) {
+    setLevel(level);
+    for (UInt32 n : sizes) {
+      const vector<UInt32> ind = randomIndices(n, 2000);
+      const Real32 expected =
+          sumAtIndices<Real32, UInt32>(x.data(), ind.data(), n);
+      EXPECT_NEAR(expected, sumAtIndices(x.data(), ind.data(), n), 1e-4)
+          << getLevelName(level) << " n=" << n;
+    }
+  }
+}
+
+TEST_F(SimdTest, SumAtIndicesGtThreshold) {
+  const vector<Real32> x = randomValues(2000, -1, 1);
+
+  for (Level level : levels()) {
+    setLevel(level);
+    for (UInt32 n : sizes) {
+      const vector<UInt32> ind = randomIndices(n, 2000);
+      const vector<Real32> nz = randomValues(n, 0, 1);
+      const Real32 expected = sumAtIndicesGtThreshold<Real32, UInt32>(
+          x.data(), ind.data(), nz.data(), n, 0.5f);
+      EXPECT_NEAR(expected,
+                  sumAtIndicesGtThreshold(x.data(), ind.data(), nz.data(), n,
+                                          0.5f),
+                  1e-4)
+          << getLevelName(level) << " n=" << n;
+    }
+  }
+}
+
+TEST_F(SimdTest, FilterGreaterEqual) {
+  for (Level level : levels()) {
+    setLevel(level);
+    for (UInt32 n : sizes) {
+      vector<UInt32> ind = randomIndices(n, 2000), expectedInd = ind;
+      vector<Real32> nz = randomValues(n, 0, 1), expectedNz = nz;
+      // Exercise the runs where everything is kept, and the threshold
+      for (UInt32 i = 0; i < n / 2; ++i)
+        nz[i] = expectedNz[i] = 0.75f;
+      if (n > 0)
+        nz[n - 1] = expectedNz[n - 1] = 0.5f;
+
+      const UInt32 expected = filterGreaterEqual<Real32, UInt32>(
+          expectedInd.data(), expectedNz.data(), n, 0.5f);
+      ASSERT_EQ(expected, filterGreaterEqual(ind.data(), nz.data(), n, 0.5f))
+          << getLevelName(level) << " n=" << n;
+      expectedInd.resize(expected);
+      ind.resize(expected);
+      expectedNz.resize(expected);
+      nz.resize(expected);
+      EXPECT_EQ(expectedInd, ind) << getLevelName(level) << " n=" << n;
+      EXPECT_EQ(expectedNz, nz) << getLevelName(level) << " n=" << n;
+    }
+  }
+}
+
+TEST_F(SimdTest, Scatter) {
+  for (Level level : levels()) {
+    setLevel(level);
+    for (UInt32 n : sizes) {
+      const vector<UInt32> ind = randomIndices(n, 2000);
+      const vector<Real32> nz = randomValues(n, -1, 1);
+      vector<Real32> expected(2000, 0), dense(2000, 0);
+
+      scatter<Real32, UInt32>(ind.data(), nz.data(), n, expected.data());
+      scatter(ind.data(), nz.data(), n, dense.data());
+      EXPECT_EQ(expected, dense) << getLevelName(level) << " n=" << n;
+    }
+  }
+}
+
+TEST_F(SimdTest, ScatterAddScaled) {
+  const vector<Real32> initial = randomValues(2000, -1, 1);
+
+  for (Level level : levels()) {
+    setLevel(level);
+    for (UInt32 n : sizes) {
+      const vector<UInt32> ind = randomIndices(n, 2000);
+      const vector<Real32> nz = randomValues(n, -1, 1);
+      vector<Real32> expected = initial, dense = initial;
+
+      scatterAddScaled<Real32, UInt32>(0.3f, ind.data(), nz.data(), n,
+                                       expected.data());
+      scatterAddScaled(0.3f, ind.data(), nz.data(), n, dense.data());
+      EXPECT_EQ(expected, dense) << getLevelName(level) << " n=" << n;
+    }
+  }
+}
+
+TEST_F(SimdTest, Scale) {
+  for (Level level : levels()) {
+    setLevel(level);
+    for (UInt32 n : sizes) {
+      const vector<Real32> x = randomValues(n, -1, 1);
+      vector<Real32> expected(n), y(n);
+
+      scale<Real32>(0.3f, x.data(), n, expected.data());
+      scale(0.3f, x.data(), n, y.data());
+      EXPECT_EQ(expected, y) << getLevelName(level) << " n=" << n;
+    }
+  }
+}
+
+TEST_F(SimdTest, CompactNonZeros) {
+  for (Level level : levels()) {
+    setLevel(level);
+    for (UInt32 n : sizes) {
+      // Mostly zeros, some values within epsilon, a NaN, which is kept
+      vector<Real32> dense(n, 0);
+      for (UInt32 i : randomIndices(n / 3, n))
+        dense[i] = (Real32)rng_.getReal64() - 0.5f;
+      for (UInt32 i = 0; i < n; i += 5)
+        dense[i] = -1e-7f;
+      if (n > 2)
+        dense[n - 2] = NAN;
+
+      vector<UInt32> expectedInd(n), ind(n);
+      vector<Real32> expectedNz(n), nz(n);
+      const UInt32 expected = compactNonZeros<Real32, UInt32>(
+          dense.data(), n, 1e-6f, expectedInd.data(), expectedNz.data());
+      ASSERT_EQ(expected, compactNonZeros(dense.data(), n, 1e-6f, ind.data(),
+                                          nz.data()))
+          << getLevelName(level) << " n=" << n;
+      for (UInt32 k = 0; k != expected; ++k) {
+        EXPECT_EQ(expectedInd[k], ind[k]);
+        EXPECT_TRUE(expectedNz[k] == nz[k] ||
+                    (std::isnan(expectedNz[k]) && std::isnan(nz[k])));
+      }
+
+      // In place, as SparseMatrix does it with its buffer
+      vector<Real32> inPlace = dense;
+      ASSERT_EQ(expected, compactNonZeros(inPlace.data(), n, 1e-6f,
+                                          ind.data(), inPlace.data()));
+      for (UInt32 k = 0; k != expected; ++k) {
+        EXPECT_TRUE(expectedNz[k] == inPlace[k] ||
+                    (std::isnan(expectedNz[k]) && std::isnan(inPlace[k])));
+      }
+    }
+  }
+}
+
+TEST_F(SimdTest, CountGreater) {
+  for (Level level : levels()) {
+    setLevel(level);
+    for (UInt32 n : sizes) {
+      const vector<Real32> x = randomValues(n, 0, 1);
+      EXPECT_EQ(countGreater<Real32>(x.data(), n, 0.5f),
+                countGreater(x.data(), n, 0.5f))
+          << getLevelName(level) << " n=" << n;
+    }
+  }
+}
+
+TEST_F(SimdTest, LogicalAnd) {
+  for (Level level : levels()) {
+    setLevel(level);
+    for (UInt32 n : sizes) {
+      vector<Real32> x(n), y(n), expected(n), z(n);
+      for (UInt32 i = 0; i != n; ++i) {
+        x[i] = (Real32)(rng_.getUInt32(2));
+        y[i] = (Real32)(rng_.getUInt32(2));
+      }
+
+      logicalAnd<Real32>(x.data(), y.data(), n, expected.data());
+      logicalAnd(x.data(), y.data(), n, z.data());
+      EXPECT_EQ(expected, z) << getLevelName(level) << " n=" << n;
+
+      logicalAnd(x.data(), y.data(), n, y.data());
+      EXPECT_EQ(expected, y) << getLevelName(level) << " n=" << n;
+    }
+  }
+}
+
+TEST_F(SimdTest, IsZero) {
+  for (Level level : levels()) {
+    setLevel(level);
+    for (UInt32 n : sizes) {
+      vector<Byte> x(n, 0);
+      EXPECT_TRUE(isZero(x.data(), n)) << getLevelName(level) << " n=" << n;
+      for (UInt32 i = 0; i < n; i += 7) {
+        x[i] = 1;
+        EXPECT_FALSE(isZero(x.data(), n)) << getLevelName(level) << " n=" << n;
+        x[i] = 0;
+      }
+    }
+  }
+}
+
+} // end namespace
@@ -0,0 +1,170 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of unit tests for Profiler
+ */
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+#include <nupic/os/Profiler.hpp>
+
+using namespace nupic;
+
+namespace {
+
+const ProfileEntry *findEntry(const std::vector<ProfileEntry> &snapshot,
+                              const std::string &name) {
+  for (const ProfileEntry &entry : snapshot) {
+    if (entry.name == name) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+TEST(ProfilerTest, DisabledRecordsNothing) {
+  Profiler::disable();
+  const UInt32 timing = Profiler::getTimingProbe("ProfilerTest.disabled");
+  const UInt32 counter = Profiler::getCounterProbe("ProfilerTest.disabled.n");
+
+  Profiler::start(timing);
+  Profiler::stop(timing);
+  Profiler::add(counter, 10);
+
+  const std::vector<ProfileEntry> snapshot = Profiler::getSnapshot();
+  EXPECT_EQ(nullptr, findEntry(snapshot, "ProfilerTest.disabled"));
+  EXPECT_EQ(nullptr, findEntry(snapshot, "ProfilerTest.disabled.n"));
+}
+
+TEST(ProfilerTest, SameNameSameProbe) {
+  EXPECT_EQ(Profiler::getTimingProbe("ProfilerTest.same"),
+            Profiler::getTimingProbe("ProfilerTest.same"));
+  EXPECT_NE(Profiler::getTimingProbe("ProfilerTest.same"),
+            Profiler::getTimingProbe("ProfilerTest.other"));
+  EXPECT_ANY_THROW(Profiler::getCounterProbe("ProfilerTest.same"));
+}
+
+TEST(ProfilerTest, TimingPercentiles) {
+  const UInt32 probe = Profiler::getTimingProbe("ProfilerTest.timing");
+  Profiler::reset("ProfilerTest.");
+  Profiler::enable();
+
+  for (int i = 0; i < 10; i++) {
+    ProfileScope scope(probe);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  // Stopping a probe that isn't started is ignored
+  Profiler::stop(probe);
+  Profiler::disable();
+
+  const std::vector<ProfileEntry> snapshot = Profiler::getSnapshot();
+  const ProfileEntry *entry = findEntry(snapshot, "ProfilerTest.timing");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_FALSE(entry->isCounter);
+  EXPECT_EQ(10u, entry->count);
+  EXPECT_GE(entry->total, 0.02);
+  EXPECT_GE(entry->p50, 0.002 * 15 / 16);
+  EXPECT_LE(entry->p50, entry->p99);
+  EXPECT_LE(entry->p99, entry->p999);
+  EXPECT_LE(entry->p999, entry->total);
+}
+
+TEST(ProfilerTest, CountersFromManyThreads) {
+  const UInt32 probe = Profiler::getCounterProbe("ProfilerTest.bytes");
+  Profiler::reset("ProfilerTest.");
+  Profiler::enable();
+
+  // Includes threads that exit before the snapshot
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([probe]() {
+      for (int i = 0; i < 1000; i++) {
+        Profiler::add(probe, 3);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  Profiler::add(probe, 5);
+  Profiler::disable();
+
+  std::vector<ProfileEntry> snapshot = Profiler::getSnapshot();
+  const ProfileEntry *entry = findEntry(snapshot, "ProfilerTest.bytes");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_TRUE(entry->isCounter);
+  EXPECT_EQ(4001u, entry->count);
+  EXPECT_EQ(12005.0, entry->total);
+  EXPECT_EQ(0.0, entry->p50);
+
+  Profiler::reset("ProfilerTest.bytes");
+  snapshot = Profiler::getSnapshot();
+  EXPECT_EQ(nullptr, findEntry(snapshot, "ProfilerTest.bytes"));
+}
+
+TEST(ProfilerTest, ReleasedProbesAreReused) {
+  const UInt32 probe = Profiler::getCounterProbe("ProfilerTest.released");
+  EXPECT_EQ(probe, Profiler::getCounterProbe("ProfilerTest.released"));
+  Profiler::addUnchecked(probe, 7);
+
+  // The probe stays until its last reference is released
+  Profiler::releaseProbe(probe);
+  EXPECT_NE(nullptr,
+            findEntry(Profiler::getSnapshot(), "ProfilerTest.released"));
+  Profiler::releaseProbe(probe);
+  EXPECT_EQ(nullptr,
+            findEntry(Profiler::getSnapshot(), "ProfilerTest.released"));
+  EXPECT_ANY_THROW(Profiler::releaseProbe(probe));
+
+  // Its id is reused, without the old counts
+  const UInt32 timing = Profiler::getTimingProbe("ProfilerTest.reused");
+  EXPECT_EQ(probe, timing);
+  EXPECT_EQ(nullptr, findEntry(Profiler::getSnapshot(), "ProfilerTest.reused"));
+  Profiler::releaseProbe(timing);
+
+  // Registering and releasing never runs out of ids
+  for (UInt32 i = 0; i < 2 * Profiler::MAX_PROBES; i++) {
+    Profiler::releaseProbe(
+        Profiler::getTimingProbe("ProfilerTest.many." + std::to_string(i)));
+  }
+}
+
+TEST(ProfilerTest, SnapshotPrefix) {
+  const UInt32 a = Profiler::getCounterProbe("ProfilerTest.prefix.a");
+  const UInt32 b = Profiler::getCounterProbe("ProfilerTest.other.b");
+  Profiler::addUnchecked(a, 1);
+  Profiler::addUnchecked(b, 1);
+
+  const std::vector<ProfileEntry> snapshot =
+      Profiler::getSnapshot("ProfilerTest.prefix.");
+  ASSERT_EQ(1u, snapshot.size());
+  EXPECT_EQ("ProfilerTest.prefix.a", snapshot[0].name);
+
+  Profiler::releaseProbe(a);
+  Profiler::releaseProbe(b);
+}
+
+} // end anonymous namespace
@@ -26,6 +26,7 @@
 
 #include <gtest/gtest.h>
 #include <limits>
+#include <thread>
 #include <nupic/py_support/PyHelpers.hpp>
 
 using namespace nupic;
@@ -445,3 +446,31 @@ TEST_F(PyHelpersTest, pyCustomException) {
     NTA_DEBUG << e.getMessage();
   }
 }
+
+TEST_F(PyHelpersTest, pyReleaseGIL) {
+  PyEval_InitThreads();
+  {
+    py::ReleaseGIL releaseGIL;
+
+    // Another thread can use Python while this one has released the GIL
+    long result = 0;
+    std::thread thread([&result]() {
+      py::AcquireGIL gil;
+      py::Int n(42);
+      result = long(n);
+    });
+    thread.join();
+    ASSERT_EQ(42, result);
+
+    // This thread can take the GIL back, even more than once
+    {
+      py::AcquireGIL gil;
+      py::AcquireGIL nested;
+      py::String s(std::string("with the GIL"));
+    }
+  }
+
+  // The GIL is held again once releaseGIL is gone
+  py::Int n(7);
+  ASSERT_EQ(7, long(n));
+}
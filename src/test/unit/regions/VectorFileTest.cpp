@@ -0,0 +1,212 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of unit tests for VectorFile
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "nupic/regions/VectorFile.hpp"
+#include "nupic/types/Exception.hpp"
+
+using namespace nupic;
+using namespace std;
+
+namespace {
+void writeCSV(const char *filename) {
+  ofstream f(filename);
+  f << "1,2,3\n"
+    << "4,5,6\n"
+    << "7,8,9\n"
+    << "10,11,12\n";
+}
+
+vector<Real> scaled(VectorFile &vf, UInt v) {
+  vector<Real> out(vf.getElementCount());
+  vf.getScaledVector(v, out.data(), 0, out.size());
+  return out;
+}
+
+/**
+ * Converting to format 7 and mapping the result gives back the same vectors,
+ * with the same scaling.
+ */
+TEST(VectorFileTest, BinaryRoundTrip) {
+  const char *csvFile = "VectorFileTest.csv";
+  const char *binFile = "VectorFileTest.nvf";
+  writeCSV(csvFile);
+
+  VectorFile text;
+  text.appendFile(csvFile, 3, 3);
+  ASSERT_EQ(4u, text.vectorCount());
+  {
+    ofstream out(binFile, ios::binary);
+    text.saveVectors(out, 3, 7);
+  }
+
+  VectorFile mapped;
+  mapped.appendFile(binFile, 3, 7);
+  ASSERT_EQ(text.vectorCount(), mapped.vectorCount());
+  ASSERT_EQ(3u, mapped.getElementCount());
+
+  text.setStandardScaling();
+  mapped.setStandardScaling();
+  for (UInt v = 0; v < text.vectorCount(); v++) {
+    vector<Real> raw(2);
+    mapped.getRawVector(v, raw.data(), 1, 2);
+    EXPECT_EQ(Real(3 * v + 2), raw[0]);
+    EXPECT_EQ(Real(3 * v + 3), raw[1]);
+    EXPECT_EQ(scaled(text, v), scaled(mapped, v));
+  }
+
+  // Writing the mapped vectors back out gives the original file.
+  stringstream a, b;
+  text.saveVectors(a, 3, 3);
+  mapped.saveVectors(b, 3, 3);
+  EXPECT_EQ(a.str(), b.str());
+
+  ::remove(csvFile);
+  ::remove(binFile);
+}
+
+/**
+ * Mapped files can be appended before and after vectors held in memory and
+ * keep their place in the list.
+ */
+TEST(VectorFileTest, AppendMixed) {
+  const char *csvFile = "VectorFileTest.csv";
+  const char *binFile = "VectorFileTest.nvf";
+  writeCSV(csvFile);
+  {
+    VectorFile vf;
+    vf.appendFile(csvFile, 3, 3);
+    ofstream out(binFile, ios::binary);
+    vf.saveVectors(out, 3, 7, 1, 3);
+  }
+
+  VectorFile vf;
+  vf.appendFile(binFile, 3, 7);
+  vf.appendFile(csvFile, 3, 3);
+  vf.appendFile(binFile, 3, 7);
+  ASSERT_EQ(8u, vf.vectorCount());
+
+  const Real expected[] = {4, 7, 1, 4, 7, 10, 4, 7};
+  for (UInt v = 0; v < vf.vectorCount(); v++) {
+    EXPECT_EQ(expected[v], scaled(vf, v)[0]);
+  }
+
+  vf.clear();
+  EXPECT_EQ(0u, vf.vectorCount());
+
+  ::remove(csvFile);
+  ::remove(binFile);
+}
+
+/**
+ * Vector labels stay with their vectors when labeled text files are mixed
+ * with mapped files, which have no labels.
+ */
+TEST(VectorFileTest, AppendMixedLabels) {
+  const char *csvFile = "VectorFileTest.csv";
+  const char *binFile = "VectorFileTest.nvf";
+  const char *labeledFile = "VectorFileTest.txt";
+  writeCSV(csvFile);
+  {
+    VectorFile vf;
+    vf.appendFile(csvFile, 3, 3);
+    ofstream out(binFile, ios::binary);
+    vf.saveVectors(out, 3, 7, 1, 3);
+  }
+  {
+    ofstream f(labeledFile);
+    f << "3\n"
+      << "x y z\n"
+      << "a 1 2 3\n"
+      << "b 4 5 6\n";
+  }
+
+  VectorFile vf;
+  vf.appendFile(binFile, 3, 7);
+  vf.appendFile(labeledFile, 3, 1);
+  vf.appendFile(binFile, 3, 7);
+  ASSERT_EQ(6u, vf.vectorCount());
+  ASSERT_TRUE(vf.isLabeled());
+
+  stringstream out;
+  vf.saveVectors(out, 3, 1);
+  EXPECT_EQ("3\n"
+            " x y z\n"
+            " 4 5 6\n"
+            " 7 8 9\n"
+            "a 1 2 3\n"
+            "b 4 5 6\n"
+            " 4 5 6\n"
+            " 7 8 9\n",
+            out.str());
+
+  ::remove(csvFile);
+  ::remove(binFile);
+  ::remove(labeledFile);
+}
+
+/**
+ * A binary vector file with the wrong element count or a truncated body is
+ * rejected.
+ */
+TEST(VectorFileTest, BinaryInvalid) {
+  const char *csvFile = "VectorFileTest.csv";
+  const char *binFile = "VectorFileTest.nvf";
+  writeCSV(csvFile);
+  string contents;
+  {
+    VectorFile vf;
+    vf.appendFile(csvFile, 3, 3);
+    stringstream out;
+    vf.saveVectors(out, 3, 7);
+    contents = out.str();
+  }
+
+  {
+    ofstream out(binFile, ios::binary);
+    out << contents;
+  }
+  VectorFile vf;
+  EXPECT_THROW(vf.appendFile(binFile, 4, 7), exception);
+  EXPECT_EQ(0u, vf.vectorCount());
+
+  {
+    ofstream out(binFile, ios::binary);
+    out << contents.substr(0, contents.size() - 1);
+  }
+  EXPECT_THROW(vf.appendFile(binFile, 3, 7), exception);
+  EXPECT_EQ(0u, vf.vectorCount());
+
+  ::remove(csvFile);
+  ::remove(binFile);
+}
+} // namespace
@@ -20,6 +20,7 @@
  * ---------------------------------------------------------------------
  */
 
+#include <sstream>
 #include <tuple>
 
 #include "gtest/gtest.h"
@@ -97,3 +98,44 @@ TEST(MovingAverage, EqualsOperator) {
   mb.compute(6);
   ASSERT_EQ(mb, mbP);
 }
+
+TEST(MovingAverage, Variance) {
+  MovingAverage m{3};
+  ASSERT_EQ(m.getCurrentVariance(), 0.0);
+
+  m.compute(2);
+  ASSERT_EQ(m.getCurrentVariance(), 0.0);
+  m.compute(4);
+  ASSERT_DOUBLE_EQ(m.getCurrentVariance(), 1.0);
+  m.compute(6);
+  ASSERT_DOUBLE_EQ(m.getCurrentVariance(), 8.0 / 3.0);
+
+  // The window is now {4, 6, 12}.
+  m.compute(12);
+  ASSERT_FLOAT_EQ(m.getCurrentAvg(), 22.0 / 3.0);
+  ASSERT_NEAR(m.getCurrentVariance(), 104.0 / 9.0, 1e-9);
+
+  // Large values with a small spread.
+  MovingAverage big{4};
+  for (int i = 0; i < 1000; i++) {
+    big.compute(100000 + (i % 2));
+  }
+  ASSERT_NEAR(big.getCurrentVariance(), 0.25, 1e-6);
+}
+
+TEST(MovingAverage, SaveLoad) {
+  MovingAverage m{3, {1.5, 2.5, 3.5, 4.5}};
+  m.compute(7.25);
+
+  std::stringstream ss;
+  m.save(ss);
+  MovingAverage loaded{1};
+  loaded.load(ss);
+  ASSERT_EQ(m, loaded);
+  ASSERT_EQ(m.getCurrentVariance(), loaded.getCurrentVariance());
+
+  m.compute(1);
+  loaded.compute(1);
+  ASSERT_EQ(m, loaded);
+  ASSERT_EQ(m.getCurrentAvg(), loaded.getCurrentAvg());
+}
@@ -0,0 +1,115 @@
+/* ---------------------------------------------------------------------
+ * Numenta Platform for Intelligent Computing (NuPIC)
+ * Copyright (C) 2017, Numenta, Inc.  Unless you have an agreement
+ * with Numenta, Inc., for a separate license for this software code, the
+ * following terms and conditions apply:
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ *
+ * http://numenta.org/licenses/
+ * ---------------------------------------------------------------------
+ */
+
+/** @file
+ * Implementation of unit tests for ThreadPool
+ */
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include <nupic/types/Types.hpp>
+#include <nupic/utils/ThreadPool.hpp>
+
+using namespace nupic;
+using namespace nupic::util;
+
+namespace {
+
+TEST(ThreadPoolTest, BlockRangeCoversAll) {
+  for (UInt size : {0u, 1u, 7u, 100u, 1001u}) {
+    for (UInt numBlocks : {1u, 2u, 3u, 8u}) {
+      UInt expectedBegin = 0;
+      for (UInt block = 0; block < numBlocks; block++) {
+        UInt begin, end;
+        ThreadPool::blockRange(size, numBlocks, block, begin, end);
+        ASSERT_EQ(expectedBegin, begin);
+        ASSERT_LE(begin, end);
+        ASSERT_LE(end - begin, size / numBlocks + 1);
+        expectedBegin = end;
+      }
+      ASSERT_EQ(size, expectedBegin);
+    }
+  }
+}
+
+TEST(ThreadPoolTest, VisitsEachIndexOnce) {
+  for (UInt numThreads : {1u, 2u, 4u}) {
+    ThreadPool pool(numThreads);
+    ASSERT_EQ(numThreads, pool.getNumThreads());
+
+    for (UInt size : {0u, 1u, 3u, 1000u}) {
+      std::vector<UInt> visits(size, 0);
+      pool.parallelFor(size, [&](UInt begin, UInt end) {
+        for (UInt i = begin; i < end; i++) {
+          visits[i]++;
+        }
+      });
+      for (UInt i = 0; i < size; i++) {
+        ASSERT_EQ(1u, visits[i]);
+      }
+    }
+  }
+}
+
+TEST(ThreadPoolTest, ReusableAcrossCalls) {
+  ThreadPool pool(3);
+  std::atomic<UInt> total(0);
+  for (UInt i = 0; i < 200; i++) {
+    pool.parallelFor(10, [&](UInt begin, UInt end) { total += end - begin; });
+  }
+  ASSERT_EQ(2000u, total.load());
+}
+
+TEST(ThreadPoolTest, ZeroThreadsIsOneThread) {
+  ThreadPool pool(0);
+  ASSERT_EQ(1u, pool.getNumThreads());
+
+  UInt calls = 0;
+  pool.parallelFor(5, [&](UInt begin, UInt end) {
+    ASSERT_EQ(0u, begin);
+    ASSERT_EQ(5u, end);
+    calls++;
+  });
+  ASSERT_EQ(1u, calls);
+}
+
+TEST(ThreadPoolTest, RethrowsBlockException) {
+  ThreadPool pool(4);
+  EXPECT_THROW(pool.parallelFor(100,
+                                [](UInt begin, UInt end) {
+                                  if (begin > 0) {
+                                    throw std::runtime_error("block failed");
+                                  }
+                                }),
+               std::runtime_error);
+
+  // The pool remains usable.
+  std::atomic<UInt> total(0);
+  pool.parallelFor(100, [&](UInt begin, UInt end) { total += end - begin; });
+  ASSERT_EQ(100u, total.load());
+}
+
+} // end anonymous namespace